@@ -0,0 +1,346 @@
+/** @file bench.js
+ *  @brief Throughput and latency benchmarks of the exported classes,
+ *         printing results in the Google Benchmark JSON format and
+ *         optionally comparing them against a saved baseline.
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Invoked as:
+ *  'node bench/bench.js [--filter=regex] [--min-time=seconds]
+ *                       [--baseline=file.json] [--threshold=fraction]'
+ *  The results are written to stdout as JSON, progress to stderr. With a
+ *  baseline the process exits with 1 when any benchmark present in both is
+ *  slower than the baseline by more than the threshold (0.1 by default).
+ */
+
+"use strict";
+
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+
+const seifnode = require("..");
+const pkg = require("../package.json");
+
+
+// -------
+// options
+// -------
+const options = {
+    filter: null,
+    minTime: 0.5,
+    baseline: null,
+    threshold: 0.1
+};
+
+process.argv.slice(2).forEach(function(arg) {
+    const match = /^--([a-z-]+)=(.*)$/.exec(arg);
+    if (match === null) {
+        console.error("Unknown argument: " + arg);
+        process.exit(2);
+    }
+
+    switch (match[1]) {
+        case "filter":
+            options.filter = new RegExp(match[2]);
+            break;
+        case "min-time":
+            options.minTime = parseFloat(match[2]);
+            break;
+        case "baseline":
+            options.baseline = match[2];
+            break;
+        case "threshold":
+            options.threshold = parseFloat(match[2]);
+            break;
+        default:
+            console.error("Unknown argument: " + arg);
+            process.exit(2);
+    }
+});
+
+// message sizes of the throughput benchmarks
+const SIZES = [16, 1024, 64 * 1024, 1024 * 1024];
+
+// request sizes of the RNG benchmarks
+const RNG_SIZES = [16, 256, 4096, 64 * 1024];
+
+const results = [];
+
+
+// ----------
+// sizeSuffix
+// ----------
+/**
+ * @brief Formats the message size the way benchmark names carry it.
+ *
+ * @param size number of bytes
+ */
+function sizeSuffix(size) {
+    if (size >= 1024 * 1024) {
+        return (size / (1024 * 1024)) + "m";
+    }
+    if (size >= 1024) {
+        return (size / 1024) + "k";
+    }
+    return String(size);
+}
+
+
+// -------
+// seconds
+// -------
+/**
+ * @brief Returns the seconds elapsed since the given process.hrtime().
+ *
+ * @param start start time
+ */
+function seconds(start) {
+    const diff = process.hrtime(start);
+    return diff[0] + diff[1] / 1e9;
+}
+
+
+// ---
+// run
+// ---
+/**
+ * @brief Runs the operation with a doubling number of iterations until it
+ *        took at least 'minTime' seconds and records the time per
+ *        iteration along with the median and 99th percentile latency of
+ *        individual calls.
+ *
+ * @param name name of the benchmark
+ * @param bytes bytes processed per call, 0 if not a throughput benchmark
+ * @param operation operation to be measured
+ */
+function run(name, bytes, operation) {
+    if (options.filter !== null && !options.filter.test(name)) {
+        return;
+    }
+
+    // Warm up the key cache and the JIT.
+    operation();
+
+    let iterations = 1;
+    let elapsed = 0;
+    for (;;) {
+        const start = process.hrtime();
+        for (let i = 0; i < iterations; ++i) {
+            operation();
+        }
+        elapsed = seconds(start);
+
+        if (elapsed >= options.minTime || iterations >= (1 << 30)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    // Sample individual calls for the latency distribution.
+    const samples = [];
+    const sampleCount = Math.min(iterations, 1000);
+    for (let i = 0; i < sampleCount; ++i) {
+        const start = process.hrtime();
+        operation();
+        samples.push(seconds(start) * 1e9);
+    }
+    samples.sort(function(a, b) {
+        return a - b;
+    });
+
+    const result = {
+        name: name,
+        iterations: iterations,
+        real_time: elapsed * 1e9 / iterations,
+        time_unit: "ns",
+        p50_time: samples[Math.floor(samples.length * 0.5)],
+        p99_time: samples[Math.min(samples.length - 1,
+            Math.floor(samples.length * 0.99))]
+    };
+    if (bytes > 0) {
+        result.bytes_per_second = bytes * iterations / elapsed;
+    }
+    results.push(result);
+
+    console.error(name + " " + Math.round(result.real_time) + " ns");
+}
+
+
+// -----------
+// benchAESXOR
+// -----------
+/**
+ * @brief Benchmarks AESXOR256 encrypt/decrypt across message sizes.
+ */
+function benchAESXOR() {
+    const cipher = seifnode.AESXOR256(Buffer.alloc(16, 0xff));
+    const key = Buffer.alloc(32, 0xff);
+
+    SIZES.forEach(function(size) {
+        const message = Buffer.alloc(size, 0x41);
+        const encrypted = cipher.encrypt(key, message);
+
+        run("AESXOR256/encrypt/" + sizeSuffix(size), size, function() {
+            cipher.encrypt(key, message);
+        });
+        run("AESXOR256/decrypt/" + sizeSuffix(size), size, function() {
+            cipher.decrypt(key, encrypted);
+        });
+    });
+}
+
+
+// ------------
+// benchSEIFECC
+// ------------
+/**
+ * @brief Benchmarks SEIFECC key generation, encryption and decryption on
+ *        each supported curve, with keys in a temporary folder.
+ */
+function benchSEIFECC() {
+    const folder = fs.mkdtempSync(path.join(os.tmpdir(), "seifnode-bench-"));
+    const diskKey = Buffer.alloc(32, 0x5a);
+
+    try {
+        ["secp256r1", "secp384r1", "secp521r1"].forEach(function(curve) {
+            const ecc = new seifnode.SEIFECC(diskKey, folder, {curve: curve});
+            const prefix = "SEIFECC/" + curve;
+            let keys = ecc.generateKeys();
+
+            run(prefix + "/generateKeys", 0, function() {
+                keys = ecc.generateKeys();
+            });
+
+            const message = Buffer.alloc(1024, 0x41);
+            const encrypted = ecc.encrypt(keys.enc, message);
+
+            run(prefix + "/encrypt/1k", message.length, function() {
+                ecc.encrypt(keys.enc, message);
+            });
+            run(prefix + "/decrypt/1k", message.length, function() {
+                ecc.decrypt(keys.dec, encrypted);
+            });
+        });
+    } finally {
+        fs.readdirSync(folder).forEach(function(file) {
+            fs.unlinkSync(path.join(folder, file));
+        });
+        fs.rmdirSync(folder);
+    }
+}
+
+
+// --------
+// benchRNG
+// --------
+/**
+ * @brief Benchmarks RNG getBytes at different request sizes, with the
+ *        state in a temporary folder.
+ */
+function benchRNG() {
+    const folder = fs.mkdtempSync(path.join(os.tmpdir(), "seifnode-bench-"));
+    const rng = new seifnode.RNG();
+
+    try {
+        rng.initialize(Buffer.alloc(32, 0x5a), path.join(folder, "rng"));
+
+        RNG_SIZES.forEach(function(size) {
+            run("RNG/getBytes/" + sizeSuffix(size), size, function() {
+                rng.getBytes(size);
+            });
+        });
+    } finally {
+        rng.destroy();
+        fs.readdirSync(folder).forEach(function(file) {
+            fs.unlinkSync(path.join(folder, file));
+        });
+        fs.rmdirSync(folder);
+    }
+}
+
+
+// -------------
+// benchSEIFSHA3
+// -------------
+/**
+ * @brief Benchmarks SEIFSHA3 hash of buffers across message sizes.
+ */
+function benchSEIFSHA3() {
+    const sha3 = new seifnode.SEIFSHA3();
+
+    SIZES.forEach(function(size) {
+        const message = Buffer.alloc(size, 0x41);
+
+        run("SEIFSHA3/hash/" + sizeSuffix(size), size, function() {
+            sha3.hash(message);
+        });
+    });
+}
+
+
+// -------
+// compare
+// -------
+/**
+ * @brief Compares the results against the baseline file and returns the
+ *        names of the benchmarks that regressed beyond the threshold.
+ *
+ * @param baseline parsed baseline results
+ */
+function compare(baseline) {
+    const previous = {};
+    baseline.benchmarks.forEach(function(b) {
+        previous[b.name] = b.real_time;
+    });
+
+    const regressions = [];
+    results.forEach(function(b) {
+        if (!(b.name in previous)) {
+            return;
+        }
+
+        const change = b.real_time / previous[b.name] - 1;
+        console.error(b.name + " " + (change >= 0 ? "+" : "") +
+            (change * 100).toFixed(1) + "%");
+
+        if (change > options.threshold) {
+            regressions.push(b.name);
+        }
+    });
+    return regressions;
+}
+
+
+benchAESXOR();
+benchSEIFECC();
+benchRNG();
+benchSEIFSHA3();
+
+process.stdout.write(JSON.stringify({
+    context: {
+        date: new Date().toISOString(),
+        seifnode: pkg.version,
+        node: process.version,
+        platform: process.platform,
+        arch: process.arch,
+        num_cpus: os.cpus().length
+    },
+    benchmarks: results
+}, null, 2) + "\n");
+
+if (options.baseline !== null) {
+    const regressions =
+        compare(JSON.parse(fs.readFileSync(options.baseline, "utf8")));
+
+    if (regressions.length > 0) {
+        console.error("Regressed beyond " + (options.threshold * 100) +
+            "%: " + regressions.join(", "));
+        process.exit(1);
+    }
+}
@@ -0,0 +1,403 @@
+/** @file native.cc
+ *  @brief Standalone benchmark of the native kernels behind the exported
+ *         classes, printing results in the Google Benchmark JSON format
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "aes.h"
+#include "eccrypto.h"
+#include "gcm.h"
+#include "oids.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "keccak.h"
+#include "keystream.h"
+#include "threadrng.h"
+#include "xorShift128.hpp"
+
+
+namespace {
+    // minimum time each benchmark runs for, in seconds
+    double minTime = 0.5;
+    // only benchmarks whose name contains this string are run
+    std::string filter;
+
+    // measured benchmark
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double nanoseconds;
+        double bytesPerSecond;
+    };
+
+    std::vector<Result> results;
+
+    // message sizes of the throughput benchmarks
+    const size_t SIZES[] = {16, 1024, 64 * 1024, 1024 * 1024};
+
+
+    // ---
+    // run
+    // ---
+    /**
+     * @brief Runs the operation with a doubling number of iterations until
+     *        it took at least 'minTime' and records the time per iteration.
+     *
+     * @param name name of the benchmark
+     * @param bytes bytes processed per iteration, 0 if not a throughput
+     *        benchmark
+     * @param operation operation to be measured
+     *
+     * @return void
+     */
+    void run(const std::string& name, size_t bytes,
+        const std::function<void()>& operation) {
+
+        if (name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        typedef std::chrono::steady_clock Clock;
+
+        // Warm up caches and lazily built tables.
+        operation();
+
+        uint64_t iterations = 1;
+        double seconds = 0;
+        for (;;) {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                operation();
+            }
+            seconds = std::chrono::duration<double>(
+                Clock::now() - start).count();
+
+            if (seconds >= minTime || iterations >= (1ULL << 40)) {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        result.nanoseconds = seconds * 1e9 / iterations;
+        result.bytesPerSecond = bytes * iterations / seconds;
+        results.push_back(result);
+
+        std::fprintf(stderr, "%-40s %14.0f ns\n", name.c_str(),
+            result.nanoseconds);
+    }
+
+
+    // ----------
+    // sizeSuffix
+    // ----------
+    /**
+     * @brief Formats the message size the way benchmark names carry it.
+     *
+     * @param size number of bytes
+     *
+     * @return size such as "16", "1k" or "1m"
+     */
+    std::string sizeSuffix(size_t size) {
+        if (size >= 1024 * 1024) {
+            return std::to_string(size / (1024 * 1024)) + "m";
+        }
+        if (size >= 1024) {
+            return std::to_string(size / 1024) + "k";
+        }
+        return std::to_string(size);
+    }
+
+
+    // --------------
+    // benchKeystream
+    // --------------
+    /**
+     * @brief Benchmarks the XORShift128 pre-mask of AESXOR256 and seeking
+     *        the generator.
+     *
+     * @return void
+     */
+    void benchKeystream() {
+        XORShift128 rng(std::vector<uint64_t>{0x0123456789ABCDEFULL,
+            0xFEDCBA9876543210ULL});
+
+        for (size_t size : SIZES) {
+            std::vector<uint8_t> data(size);
+            run("Keystream/xorWords/" + sizeSuffix(size), size, [&]() {
+                Keystream::xorWords(rng, data.data(), size / 8);
+            });
+        }
+
+        // Positioning a generator at a segment of a 1GB segmented cipher.
+        run("Keystream/seek/1g", 0, [&]() {
+            XORShift128 mask(rng);
+            mask.seek(16383, 64 * 1024 / 8);
+        });
+    }
+
+
+    // -----------
+    // benchAESGCM
+    // -----------
+    /**
+     * @brief Benchmarks AES-256-GCM as used by AESXOR256 encrypt/decrypt.
+     *
+     * @return void
+     */
+    void benchAESGCM() {
+        const uint8_t key[32] = {0};
+        const uint8_t iv[12] = {0};
+        uint8_t tag[16];
+
+        for (size_t size : SIZES) {
+            std::vector<uint8_t> data(size);
+
+            CryptoPP::GCM<CryptoPP::AES>::Encryption e;
+            e.SetKeyWithIV(key, sizeof(key), iv, sizeof(iv));
+            run("AESGCM/encrypt/" + sizeSuffix(size), size, [&]() {
+                e.EncryptAndAuthenticate(data.data(), tag, sizeof(tag), iv,
+                    sizeof(iv), nullptr, 0, data.data(), size);
+            });
+
+            // Seal once so that verification succeeds.
+            e.EncryptAndAuthenticate(data.data(), tag, sizeof(tag), iv,
+                sizeof(iv), nullptr, 0, data.data(), size);
+            std::vector<uint8_t> plain(size);
+
+            CryptoPP::GCM<CryptoPP::AES>::Decryption d;
+            d.SetKeyWithIV(key, sizeof(key), iv, sizeof(iv));
+            run("AESGCM/decrypt/" + sizeSuffix(size), size, [&]() {
+                if (!d.DecryptAndVerify(plain.data(), tag, sizeof(tag), iv,
+                    sizeof(iv), nullptr, 0, data.data(), size)) {
+                    std::abort();
+                }
+            });
+        }
+    }
+
+
+    // -----------
+    // benchKeccak
+    // -----------
+    /**
+     * @brief Benchmarks SHA3-256 as computed by SEIFSHA3 hash.
+     *
+     * @return void
+     */
+    void benchKeccak() {
+        Keccak sponge(136, 0x06);
+        uint8_t digest[32];
+
+        for (size_t size : SIZES) {
+            std::vector<uint8_t> data(size);
+            run("SHA3/sha3-256/" + sizeSuffix(size), size, [&]() {
+                sponge.update(data.data(), size);
+                sponge.finish(digest, sizeof(digest));
+            });
+        }
+    }
+
+
+    // ----------
+    // benchECIES
+    // ----------
+    /**
+     * @brief Benchmarks ECIES key generation, encryption and decryption as
+     *        done by SEIFECC on each supported curve.
+     *
+     * @return void
+     */
+    void benchECIES() {
+        typedef CryptoPP::ECIES<CryptoPP::ECP> ECIES;
+
+        CryptoPP::RandomNumberGenerator& prng = ThreadRandomPool::instance();
+
+        const struct {
+            const char* name;
+            CryptoPP::OID oid;
+        } curves[] = {
+            {"secp256r1", CryptoPP::ASN1::secp256r1()},
+            {"secp384r1", CryptoPP::ASN1::secp384r1()},
+            {"secp521r1", CryptoPP::ASN1::secp521r1()}
+        };
+
+        std::vector<uint8_t> message(1024);
+
+        for (const auto& curve : curves) {
+            const std::string prefix = std::string("ECIES/") + curve.name;
+
+            run(prefix + "/generateKeys", 0, [&]() {
+                ECIES::Decryptor d(prng, curve.oid);
+                ECIES::Encryptor e(d);
+                e.GetPublicKey().ThrowIfInvalid(prng, 3);
+            });
+
+            ECIES::Decryptor d(prng, curve.oid);
+            ECIES::Encryptor e(d);
+
+            std::vector<uint8_t> cipher(
+                e.CiphertextLength(message.size()));
+            run(prefix + "/encrypt/1k", message.size(), [&]() {
+                e.Encrypt(prng, message.data(), message.size(),
+                    cipher.data());
+            });
+
+            std::vector<uint8_t> plain(
+                d.MaxPlaintextLength(cipher.size()));
+            run(prefix + "/decrypt/1k", message.size(), [&]() {
+                if (!d.Decrypt(prng, cipher.data(), cipher.size(),
+                    plain.data()).isValidCoding) {
+                    std::abort();
+                }
+            });
+        }
+    }
+
+
+    // --------
+    // benchRNG
+    // --------
+    /**
+     * @brief Benchmarks the per-thread generator feeding the ECIES
+     *        ephemeral keys. The ISAAC backed RNG.getBytes needs gathered
+     *        entropy and is measured by bench.js.
+     *
+     * @return void
+     */
+    void benchRNG() {
+        CryptoPP::RandomNumberGenerator& prng = ThreadRandomPool::instance();
+
+        const size_t sizes[] = {16, 256, 4096, 64 * 1024};
+        for (size_t size : sizes) {
+            std::vector<uint8_t> data(size);
+            run("ThreadRandomPool/GenerateBlock/" + sizeSuffix(size), size,
+                [&]() {
+                    prng.GenerateBlock(data.data(), size);
+                });
+        }
+    }
+
+
+    // ------------
+    // printResults
+    // ------------
+    /**
+     * @brief Prints the results to stdout in the Google Benchmark JSON
+     *        format.
+     *
+     * @return void
+     */
+    void printResults() {
+        char date[64];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+            std::localtime(&now));
+
+        std::printf("{\n  \"context\": {\n");
+        std::printf("    \"date\": \"%s\",\n", date);
+        std::printf("    \"num_cpus\": %u,\n",
+            std::thread::hardware_concurrency());
+        std::printf("    \"keystream_kernel\": \"%s\",\n",
+            Keystream::kernelName());
+        std::printf("    \"keccak_kernel\": \"%s\"\n", Keccak::kernelName());
+        std::printf("  },\n  \"benchmarks\": [\n");
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::printf("    {\"name\": \"%s\", \"iterations\": %llu, "
+                "\"real_time\": %.1f, \"time_unit\": \"ns\"",
+                r.name.c_str(), (unsigned long long)r.iterations,
+                r.nanoseconds);
+            if (r.bytesPerSecond > 0) {
+                std::printf(", \"bytes_per_second\": %.0f", r.bytesPerSecond);
+            }
+            std::printf("}%s\n", i + 1 < results.size() ? "," : "");
+        }
+
+        std::printf("  ]\n}\n");
+    }
+}
+
+
+// ----
+// main
+// ----
+/**
+ * @brief Runs the benchmarks selected by the command line.
+ *
+ * Invoked as:
+ * 'seifnode_bench [--filter=substring] [--min-time=seconds]'
+ *
+ * @return 0 on success
+ */
+int main(int argc, char** argv) {
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = arg.substr(9);
+        } else if (arg.compare(0, 11, "--min-time=") == 0) {
+            minTime = std::atof(arg.c_str() + 11);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=substring] "
+                "[--min-time=seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    benchKeystream();
+    benchAESGCM();
+    benchKeccak();
+    benchECIES();
+    benchRNG();
+
+    printResults();
+    return 0;
+}
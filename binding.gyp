@@ -1,71 +1,139 @@
 {
+    "variables": {
+        # set with 'node-gyp rebuild --seifnode_bench=1' to build the
+        # native benchmark binary next to the addon
+        "seifnode_bench%": 0,
+        # set to 1 (or SEIFNODE_OPTIMIZE=1 in the environment, which also
+        # builds Crypto++ with AES-NI/PCLMUL, see installrng.sh) for the
+        # optimized build reported by capabilities()
+        "seifnode_optimize%": "<!(node -e \"console.log(process.env.SEIFNODE_OPTIMIZE || process.env.npm_config_seifnode_optimize || 0)\")",
+        # set to 1 (SEIFNODE_CRYPTOPP_AESNI=1 in the environment, exported by
+        # installrng.sh when it compiles Crypto++ with -maes -mpclmul) when
+        # the linked libcryptopp contains its AES-NI and PCLMUL code; the
+        # addon itself is built without those flags, so Crypto++'s own
+        # config macros cannot tell
+        "seifnode_cryptopp_aesni%": "<!(node -e \"console.log(process.env.SEIFNODE_CRYPTOPP_AESNI || process.env.npm_config_seifnode_cryptopp_aesni || 0)\")"
+    },
+    "target_defaults": {
+        "cflags_cc!": [
+            "-fno-rtti",
+            "-fno-exceptions"
+        ],
+        "conditions": [
+            [ 'seifnode_optimize==1', {
+                "defines": [
+                    "SEIFNODE_OPTIMIZED=1"
+                ],
+                "cflags_cc": [
+                    "-O3"
+                ],
+                "xcode_settings": {
+                    "GCC_OPTIMIZATION_LEVEL": "3"
+                }
+            }],
+            [ 'seifnode_cryptopp_aesni==1', {
+                "defines": [
+                    "SEIFNODE_CRYPTOPP_AESNI=1"
+                ]
+            }],
+            [ 'OS=="mac"', {
+                "xcode_settings": {
+                    'OTHER_CPLUSPLUSFLAGS' : [
+                        '-std=c++11',
+                        '-stdlib=libc++',
+                        '-v'
+                    ],
+                    'OTHER_LDFLAGS': ['-stdlib=libc++'],
+                    'MACOSX_DEPLOYMENT_TARGET': '10.10',
+                    'GCC_ENABLE_CPP_RTTI': 'YES',
+                    'GCC_ENABLE_CPP_EXCEPTIONS': 'YES'
+                },
+                "include_dirs": [
+                    "<!(pwd)/deps/seifrng/3rdParty/cryptopp",
+                    "<!(node -e \"require('nan')\")",
+                    "<!(pwd)/deps/seifrng/isaacRandomPool/include",
+                    "<!(pwd)/deps/seifrng/isaacrng/include",
+                    "<!(pwd)/deps/seifrng/fileCryptopp/include"
+                ],
+                "libraries": [
+                    "<!(pwd)/deps/seifrng/3rdParty/cryptopp/libcryptopp.a",
+                    "<!(pwd)/deps/seifrng/lib/*"
+                ],
+            }],
+            [ 'OS=="linux"', {
+                "include_dirs": [
+                    "deps/seifrng/3rdParty/cryptopp",
+                    "<!(node -e \"require('nan')\")",
+                    "<!(pwd)/deps/seifrng/isaacRandomPool/include",
+                    "<!(pwd)/deps/seifrng/isaacrng/include",
+                    "<!(pwd)/deps/seifrng/fileCryptopp/include"
+                ],
+                "libraries": [
+                    "<!(pwd)/deps/seifrng/3rdParty/cryptopp/libcryptopp.a",
+                    "<!(pwd)/deps/seifrng/lib/*"
+                ],
+            }],
+            [ 'OS=="win"', {
+                # MSVC builds of Crypto++ always contain the AES-NI and
+                # PCLMUL code, as the intrinsics need no compiler flags
+                "defines": [
+                    "SEIFNODE_CRYPTOPP_AESNI=1"
+                ],
+                "include_dirs": [
+                    "C:/cryptopp",
+                    "<!(node -e \"require('nan')\")",
+                    "<!(pwd)/deps/seifrng/isaacRandomPool/include",
+                    "<!(pwd)/deps/seifrng/isaacrng/include",
+                    "<!(pwd)/deps/seifrng/fileCryptopp/include"
+                ],
+                "libraries": [
+                    "C:/cryptopp/x64/Output/Release/cryptlib.lib",
+                    "<!(pwd)/deps/seifrng/lib/*"
+                ],
+            }],
+        ]
+    },
     "targets": [
         {
             "target_name": "seifnode",
             "sources": [
                 "src/addon.cc",
+                "src/capabilities.cc",
                 "src/seifecc.cc",
                 "src/aesxor.cc",
+                "src/aesxorstream.cc",
+                "src/binding.cc",
+                "src/fileutil.cc",
+                "src/keccak.cc",
+                "src/keypool.cc",
+                "src/keystore.cc",
+                "src/keystream.cc",
                 "src/rng.cc",
-                "src/seifsha3.cc"
-            ],
-            "cflags_cc!": [
-                "-fno-rtti",
-                "-fno-exceptions"
-            ],
-            "conditions": [
-                [ 'OS=="mac"', {
-                    "xcode_settings": {
-                        'OTHER_CPLUSPLUSFLAGS' : [
-                            '-std=c++11',
-                            '-stdlib=libc++',
-                            '-v'
-                        ],
-                        'OTHER_LDFLAGS': ['-stdlib=libc++'],
-                        'MACOSX_DEPLOYMENT_TARGET': '10.10',
-                        'GCC_ENABLE_CPP_RTTI': 'YES',
-                        'GCC_ENABLE_CPP_EXCEPTIONS': 'YES'
-                    },
-                    "include_dirs": [
-                        "<!(pwd)/deps/seifrng/3rdParty/cryptopp",
-                        "<!(node -e \"require('nan')\")",
-                        "<!(pwd)/deps/seifrng/isaacRandomPool/include",
-                        "<!(pwd)/deps/seifrng/isaacrng/include",
-                        "<!(pwd)/deps/seifrng/fileCryptopp/include"
-                    ],
-                    "libraries": [
-                        "<!(pwd)/deps/seifrng/3rdParty/cryptopp/libcryptopp.a",
-                        "<!(pwd)/deps/seifrng/lib/*"
-                    ],
-                }],
-                [ 'OS=="linux"', {
-                    "include_dirs": [
-                        "deps/seifrng/3rdParty/cryptopp",
-                        "<!(node -e \"require('nan')\")",
-                        "<!(pwd)/deps/seifrng/isaacRandomPool/include",
-                        "<!(pwd)/deps/seifrng/isaacrng/include",
-                        "<!(pwd)/deps/seifrng/fileCryptopp/include"
-                    ],
-                    "libraries": [
-                        "<!(pwd)/deps/seifrng/3rdParty/cryptopp/libcryptopp.a",
-                        "<!(pwd)/deps/seifrng/lib/*"
+                "src/securearena.cc",
+                "src/seifsha3.cc",
+                "src/shardedrng.cc",
+                "src/stats.cc",
+                "src/threadrng.cc"
+            ]
+        }
+    ],
+    "conditions": [
+        [ 'seifnode_bench==1', {
+            "targets": [
+                {
+                    "target_name": "seifnode_bench",
+                    "type": "executable",
+                    "sources": [
+                        "bench/native.cc",
+                        "src/keccak.cc",
+                        "src/keystream.cc",
+                        "src/threadrng.cc"
                     ],
-                }],
-                [ 'OS=="win"', {
                     "include_dirs": [
-                        "C:/cryptopp",
-                        "<!(node -e \"require('nan')\")",
-                        "<!(pwd)/deps/seifrng/isaacRandomPool/include",
-                        "<!(pwd)/deps/seifrng/isaacrng/include",
-                        "<!(pwd)/deps/seifrng/fileCryptopp/include"
-                    ],
-                    "libraries": [
-                        "C:/cryptopp/x64/Output/Release/cryptlib.lib",
-                        "<!(pwd)/deps/seifrng/lib/*"
-                    ],
-                }],
+                        "src"
+                    ]
+                }
             ]
-
-        }
+        }]
     ]
 }
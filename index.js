@@ -1,3 +1,495 @@
-var addon = require("./build/Release/seifnode");
+/** @file index.js
+ *  @brief Entry point of the module exposing the native addon along with
+ *         javascript conveniences built on top of it.
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ */
 
-module.exports = addon;
\ No newline at end of file
+"use strict";
+
+const crypto = require("crypto");
+const stream = require("stream");
+
+const addon = require("./build/Release/seifnode");
+
+
+// -----------
+// statusError
+// -----------
+/**
+ * @brief Converts a native '{code, message}' status object into an Error
+ *        carrying the status 'code'.
+ *
+ * @param status native status object
+ */
+function statusError(status) {
+    const err = new Error(status.message);
+    err.code = status.code;
+    return err;
+}
+
+
+// ---------
+// promisify
+// ---------
+/**
+ * @brief Wraps a native async method taking a trailing
+ *        'function(status, result)' callback so that a Promise is returned
+ *        when the callback is omitted. Optional arguments may be dropped
+ *        before an explicit callback. The promise is rejected with an Error
+ *        carrying the status 'code' when the status is not success.
+ *
+ * @param proto prototype holding the native method
+ * @param name name of the native method
+ * @param arity number of arguments preceding the callback
+ */
+function promisify(proto, name, arity) {
+    const native = proto[name];
+
+    proto[name] = function() {
+        if (typeof arguments[arguments.length - 1] === "function") {
+            return native.apply(this, arguments);
+        }
+
+        const args = Array.prototype.slice.call(arguments, 0, arity);
+        while (args.length < arity) {
+            args.push(undefined);
+        }
+
+        return new Promise((resolve, reject) => {
+            args.push(function(status, result) {
+                if (status.code === 0) {
+                    resolve(result);
+                    return;
+                }
+
+                reject(statusError(status));
+            });
+
+            native.apply(this, args);
+        });
+    };
+}
+
+promisify(addon.SEIFECC.prototype, "encryptAsync", 2);
+promisify(addon.SEIFECC.prototype, "decryptAsync", 2);
+promisify(addon.SEIFECC.prototype, "encryptManyAsync", 3);
+promisify(addon.SEIFECC.prototype, "generateKeysAsync", 1);
+promisify(addon.RNG.prototype, "initializeAsync", 2);
+promisify(addon.SEIFSHA3.prototype, "hashAsync", 1);
+
+
+// -----------
+// updateChunk
+// -----------
+/**
+ * @brief Processes one chunk with a native cipher/decipher object on the
+ *        libuv thread pool and hands the output to the Transform callback.
+ *
+ * @param native object returned by 'createCipher' or 'createDecipher'
+ * @param chunk chunk to be processed
+ * @param callback Transform stream callback
+ */
+function updateChunk(native, chunk, callback) {
+    native.update(chunk, (status, output) => {
+        if (status.code !== 0) {
+            callback(statusError(status));
+            return;
+        }
+        callback(null, output);
+    });
+}
+
+
+// ----------
+// finalChunk
+// ----------
+/**
+ * @brief Finishes a native cipher/decipher object and hands the remaining
+ *        output to the Transform flush callback.
+ *
+ * @param native object returned by 'createCipher' or 'createDecipher'
+ * @param callback Transform stream callback
+ */
+function finalChunk(native, callback) {
+    let output;
+    try {
+        output = native.final();
+    } catch (err) {
+        callback(err);
+        return;
+    }
+    callback(null, output);
+}
+
+
+// ---------------
+// transformStream
+// ---------------
+/**
+ * @brief Wraps a native AESXOR256 cipher/decipher object in a Transform
+ *        stream. Chunks are processed one at a time on the libuv thread
+ *        pool, so memory use is bounded by the stream's high water marks.
+ *
+ * @param native object returned by 'createCipher' or 'createDecipher'
+ * @param header (optional) buffer emitted ahead of the first output
+ */
+function transformStream(native, header) {
+    return new stream.Transform({
+        transform(chunk, encoding, callback) {
+            if (header !== undefined) {
+                this.push(header);
+                header = undefined;
+            }
+            updateChunk(native, chunk, callback);
+        },
+
+        flush(callback) {
+            if (header !== undefined) {
+                this.push(header);
+                header = undefined;
+            }
+            finalChunk(native, callback);
+        }
+    });
+}
+
+addon.AESXOR256.prototype.createCipherStream = function(key) {
+    return transformStream(this.createCipher(key));
+};
+
+addon.AESXOR256.prototype.createDecipherStream = function(key) {
+    return transformStream(this.createDecipher(key));
+};
+
+
+// magic bytes opening an envelope
+const ENVELOPE_MAGIC = Buffer.from("SEV1");
+
+// length of the fixed part of the envelope header: magic and wrapped key
+// length
+const ENVELOPE_PREFIX_BYTES = 8;
+
+// upper bound of the ECIES wrapped key, so a decipher stream never buffers
+// more than this before failing
+const ENVELOPE_MAX_WRAPPED_BYTES = 1024;
+
+// per-message AES-256 key and AESXOR256 seed wrapped by the envelope
+const ENVELOPE_KEY_BYTES = 32;
+const ENVELOPE_SEED_BYTES = 16;
+
+// length of the GCM tag closing the body
+const ENVELOPE_TAG_BYTES = 16;
+
+
+// ------------
+// sealEnvelope
+// ------------
+/**
+ * @brief Draws a fresh AES key and AESXOR256 seed, wraps them with ECIES
+ *        under the public key and returns the envelope header along with
+ *        an AESXOR256 object seeded for the body. The caller must wipe
+ *        'secret' once the body cipher is keyed.
+ *
+ * @param ecc SEIFECC object
+ * @param publicKey ECC public key of the recipient
+ */
+function sealEnvelope(ecc, publicKey) {
+    const secret = crypto.randomBytes(ENVELOPE_KEY_BYTES + ENVELOPE_SEED_BYTES);
+    const wrapped = ecc.encrypt(publicKey, secret);
+
+    const header = Buffer.allocUnsafe(ENVELOPE_PREFIX_BYTES + wrapped.length);
+    ENVELOPE_MAGIC.copy(header, 0);
+    header.writeUInt32BE(wrapped.length, 4);
+    wrapped.copy(header, ENVELOPE_PREFIX_BYTES);
+
+    return {
+        header: header,
+        secret: secret,
+        key: secret.slice(0, ENVELOPE_KEY_BYTES),
+        aes: addon.AESXOR256(secret.slice(ENVELOPE_KEY_BYTES))
+    };
+}
+
+
+// --------------------
+// envelopeHeaderLength
+// --------------------
+/**
+ * @brief Returns the length of the envelope header at the start of the
+ *        buffer, or -1 if the buffer does not hold the fixed part yet.
+ *
+ * @param envelope buffer starting with the envelope
+ *
+ * @throw Error if the buffer does not start with an envelope header
+ */
+function envelopeHeaderLength(envelope) {
+    if (envelope.length < ENVELOPE_PREFIX_BYTES) {
+        return -1;
+    }
+
+    const wrappedLength = envelope.readUInt32BE(4);
+    if (!envelope.slice(0, 4).equals(ENVELOPE_MAGIC) || wrappedLength === 0 ||
+        wrappedLength > ENVELOPE_MAX_WRAPPED_BYTES) {
+        throw new Error("Invalid envelope header");
+    }
+
+    return ENVELOPE_PREFIX_BYTES + wrappedLength;
+}
+
+
+// ------------
+// openEnvelope
+// ------------
+/**
+ * @brief Unwraps the AES key and AESXOR256 seed of the envelope with the
+ *        private key. The caller must wipe 'secret' once the body
+ *        decipher is keyed.
+ *
+ * @param ecc SEIFECC object
+ * @param privateKey ECC private key of the recipient
+ * @param envelope buffer holding at least the complete header
+ * @param headerLength length of the header
+ *
+ * @throw Error if the wrapped key cannot be decrypted
+ */
+function openEnvelope(ecc, privateKey, envelope, headerLength) {
+    const secret = ecc.decrypt(privateKey,
+        envelope.slice(ENVELOPE_PREFIX_BYTES, headerLength));
+
+    if (secret.length !== ENVELOPE_KEY_BYTES + ENVELOPE_SEED_BYTES) {
+        secret.fill(0);
+        throw new Error("Invalid envelope key");
+    }
+
+    return {
+        secret: secret,
+        key: secret.slice(0, ENVELOPE_KEY_BYTES),
+        aes: addon.AESXOR256(secret.slice(ENVELOPE_KEY_BYTES))
+    };
+}
+
+
+// ---------------
+// encryptEnvelope
+// ---------------
+/**
+ * @brief Encrypts a message of any size with a fresh AES-256 key wrapped
+ *        by ECIES, so the cost of ECIES is paid once per message and the
+ *        body is encrypted by AESXOR256 directly into the returned buffer.
+ *
+ * @param publicKey ECC public key of the recipient
+ * @param message buffer to be encrypted
+ */
+addon.SEIFECC.prototype.encryptEnvelope = function(publicKey, message) {
+    const envelope = sealEnvelope(this, publicKey);
+
+    try {
+        const output = Buffer.allocUnsafe(envelope.header.length +
+            message.length + ENVELOPE_TAG_BYTES);
+        envelope.header.copy(output, 0);
+        envelope.aes.encryptInto(envelope.key, message, output,
+            envelope.header.length);
+        return output;
+    } finally {
+        envelope.secret.fill(0);
+    }
+};
+
+
+// ---------------
+// decryptEnvelope
+// ---------------
+/**
+ * @brief Decrypts an envelope produced by 'encryptEnvelope' or an envelope
+ *        cipher stream.
+ *
+ * @param privateKey ECC private key of the recipient
+ * @param cipher buffer containing the envelope
+ *
+ * @throw Error if the envelope is malformed or was modified
+ */
+addon.SEIFECC.prototype.decryptEnvelope = function(privateKey, cipher) {
+    const headerLength = envelopeHeaderLength(cipher);
+    if (headerLength < 0 ||
+        cipher.length < headerLength + ENVELOPE_TAG_BYTES) {
+        throw new Error("Truncated envelope");
+    }
+
+    const envelope = openEnvelope(this, privateKey, cipher, headerLength);
+
+    try {
+        const output = Buffer.allocUnsafe(
+            cipher.length - headerLength - ENVELOPE_TAG_BYTES);
+        envelope.aes.decryptInto(envelope.key, cipher.slice(headerLength),
+            output, 0);
+        return output;
+    } finally {
+        envelope.secret.fill(0);
+    }
+};
+
+
+// -------------
+// createSession
+// -------------
+/**
+ * @brief Returns a session with the peer, encrypting and decrypting with
+ *        AESXOR256 segmented ciphers under the key material derived by ECDH
+ *        between the private key and the peer public key. The peer creates
+ *        the matching session from its private key and this side's public
+ *        key. Each direction has its own key, so a cipher sent by this side
+ *        cannot be reflected back to it. Every cipher draws a fresh salt
+ *        from which its own GCM key and nonces are derived, so the long
+ *        lived session keys never repeat a nonce. Only the first session
+ *        between two keys, and the first after the cached key material
+ *        expires, pays for ECDH.
+ *
+ * @param privateKey ECC private key of this side
+ * @param peerPublicKey ECC public key of the peer
+ */
+addon.SEIFECC.prototype.createSession = function(privateKey, peerPublicKey) {
+    const secret = this.sessionKey(privateKey, peerPublicKey);
+    const half = secret.length / 2;
+
+    try {
+        const send = addon.AESXOR256(secret.slice(ENVELOPE_KEY_BYTES, half));
+        send.setKey(secret.slice(0, ENVELOPE_KEY_BYTES));
+
+        const receive = addon.AESXOR256(
+            secret.slice(half + ENVELOPE_KEY_BYTES));
+        receive.setKey(secret.slice(half, half + ENVELOPE_KEY_BYTES));
+
+        return {
+            encrypt(message, options) {
+                return send.encryptSegments(null, message, options);
+            },
+
+            decrypt(cipher, threads) {
+                return receive.decryptSegments(null, cipher, threads);
+            },
+
+            decryptRange(cipher, start, end) {
+                return receive.decryptRange(null, cipher, start, end);
+            }
+        };
+    } finally {
+        secret.fill(0);
+    }
+};
+
+
+// --------------------------
+// createEnvelopeCipherStream
+// --------------------------
+/**
+ * @brief Returns a Transform stream encrypting everything written to it
+ *        into an envelope, byte for byte what 'encryptEnvelope' returns
+ *        for the whole input, in bounded memory.
+ *
+ * @param publicKey ECC public key of the recipient
+ */
+addon.SEIFECC.prototype.createEnvelopeCipherStream = function(publicKey) {
+    const envelope = sealEnvelope(this, publicKey);
+
+    try {
+        return transformStream(envelope.aes.createCipher(envelope.key),
+            envelope.header);
+    } finally {
+        envelope.secret.fill(0);
+    }
+};
+
+
+// ----------------------------
+// createEnvelopeDecipherStream
+// ----------------------------
+/**
+ * @brief Returns a Transform stream decrypting an envelope written to it.
+ *        The header is buffered until the wrapped key is complete, the
+ *        body is then decrypted chunk by chunk. As with AESXOR256 decipher
+ *        streams, output must not be trusted before the stream ends
+ *        without an error.
+ *
+ * @param privateKey ECC private key of the recipient
+ */
+addon.SEIFECC.prototype.createEnvelopeDecipherStream = function(privateKey) {
+    const ecc = this;
+    let pending = Buffer.alloc(0);
+    let native = null;
+
+    return new stream.Transform({
+        transform(chunk, encoding, callback) {
+            if (native !== null) {
+                updateChunk(native, chunk, callback);
+                return;
+            }
+
+            pending = Buffer.concat([pending, chunk]);
+
+            let body;
+            try {
+                const headerLength = envelopeHeaderLength(pending);
+                if (headerLength < 0 || pending.length < headerLength) {
+                    callback();
+                    return;
+                }
+
+                const envelope =
+                    openEnvelope(ecc, privateKey, pending, headerLength);
+                try {
+                    native = envelope.aes.createDecipher(envelope.key);
+                } finally {
+                    envelope.secret.fill(0);
+                }
+
+                body = pending.slice(headerLength);
+                pending = null;
+            } catch (err) {
+                callback(err);
+                return;
+            }
+
+            updateChunk(native, body, callback);
+        },
+
+        flush(callback) {
+            if (native === null) {
+                callback(new Error("Truncated envelope"));
+                return;
+            }
+            finalChunk(native, callback);
+        }
+    });
+};
+
+// ----------------
+// createHashStream
+// ----------------
+/**
+ * @brief Returns a Transform stream hashing everything written to it with a
+ *        new SEIFSHA3 object using the same hash function and emitting the
+ *        digest once the input ends, so arbitrarily large input is hashed
+ *        in constant memory.
+ */
+addon.SEIFSHA3.prototype.createHashStream = function() {
+    const hasher = new addon.SEIFSHA3(this.algorithm());
+
+    return new stream.Transform({
+        transform(chunk, encoding, callback) {
+            hasher.update(chunk);
+            callback();
+        },
+
+        flush(callback) {
+            callback(null, hasher.digest());
+        }
+    });
+};
+
+module.exports = addon;
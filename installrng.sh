@@ -17,6 +17,25 @@ if [[ "$unamestr" != "win32" ]]; then
 	fi
 
 	rngCmakeCmd="cmake ../"
+	rngCmakeOptions=""
+	addonCxxFlags="$CXXFLAGS"
+
+	# Optimized build: Crypto++ only contains its AES-NI and PCLMUL (GCM)
+	# code when compiled with them enabled and picks it at runtime. The
+	# resulting library requires SSE4.2, AES-NI and PCLMUL (x86-64 since
+	# 2010); the addon's own kernels dispatch at runtime.
+	if [[ "$SEIFNODE_OPTIMIZE" == "1" || "$npm_config_seifnode_optimize" == "1" ]]; then
+		export SEIFNODE_OPTIMIZE=1
+		if [[ "`uname -m`" == "x86_64" ]]; then
+			export CXXFLAGS="$CXXFLAGS -O3 -DNDEBUG -msse4.2 -maes -mpclmul"
+			# tells binding.gyp the library carries the AES-NI/PCLMUL code
+			export SEIFNODE_CRYPTOPP_AESNI=1
+		else
+			export CXXFLAGS="$CXXFLAGS -O3 -DNDEBUG"
+		fi
+		rngCmakeOptions="-DCMAKE_BUILD_TYPE=Release"
+	fi
+
 	if ! type cmake > /dev/null; then
 		# attempt to install cmake
 		echo "Attempting to install cmake locally....."
@@ -43,8 +62,8 @@ if [[ "$unamestr" != "win32" ]]; then
 	rngBuildCmd="make"
 	rngBuildInstallCmd="make install"
 
-	echo "Runnning $rngCmakeCmd"
-	eval $rngCmakeCmd
+	echo "Runnning $rngCmakeCmd $rngCmakeOptions"
+	eval $rngCmakeCmd $rngCmakeOptions
 
 	echo "Runnning $rngBuildInstallCmd"
 	eval $rngBuildInstallCmd
@@ -72,6 +91,9 @@ if [[ "$unamestr" != "win32" ]]; then
 	fi
 
 	cd ../../../
+
+	# The addon is built portably, see 'seifnode_optimize' in binding.gyp.
+	export CXXFLAGS="$addonCxxFlags"
 	node-gyp rebuild
 else
 	echo "[Error] OS not supported."
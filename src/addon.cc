@@ -31,14 +31,18 @@
 // node.js addon includes
 // ----------------------
 #include <node.h>
+#include <nan.h>
 
 // ----------------
 // library includes
 // ----------------
 #include "seifecc.h"
 #include "aesxor.h"
+#include "binding.h"
+#include "capabilities.h"
 #include "rng.h"
 #include "seifsha3.h"
+#include "stats.h"
 
 
 // ----------
@@ -49,15 +53,22 @@
  *		  native classes being wrapped by this addon.
  * 		  The below function and macro are equivalent to:
  *		  'module.exports = Initialize()'
+ *		  The module is context aware: each worker_thread requiring it
+ *		  gets its own classes, whose constructors are kept in the data
+ *		  of that instance instead of in static storage.
  * @param target refers to the node.js module exports object
  * @return void
  */
-void Initialize(v8::Handle<v8::Object> target) {
-	SEIFECC::Init(target);
-	AESXOR256::Init(target);
-	RNG::Init(target);
-	SEIFSHA3::Init(target);
+NAN_MODULE_INIT(Initialize) {
+	v8::Local<v8::Object> data = Binding::newData();
+
+	SEIFECC::Init(target, data);
+	AESXOR256::Init(target, data);
+	RNG::Init(target, data);
+	SEIFSHA3::Init(target, data);
+	Stats::Init(target);
+	Capabilities::Init(target);
 }
 
 
-NODE_MODULE(seifnode, Initialize)
+NAN_MODULE_WORKER_ENABLED(seifnode, Initialize)
@@ -36,6 +36,9 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstring>
+#include <algorithm>
+#include <exception>
 
 // ----------------------
 // node.js addon includes
@@ -47,56 +50,261 @@
 // cryptopp includes
 // -----------------
 #include "filters.h"
-using CryptoPP::StringSink;
-using CryptoPP::StringSource;
-using CryptoPP::ArraySink;
-using CryptoPP::ArraySource;
 #include "modes.h"
 #include "aes.h"
 #include "gcm.h"
+#include "misc.h"
 
 // ----------------
 // library includes
 // ----------------
 #include "aesxor.h"
+#include "aesxorstream.h"
+#include "binding.h"
+#include "keccak.h"
+#include "keystream.h"
+#include "parallel.hpp"
+#include "stats.h"
+#include "threadrng.h"
 
 
-// javascript object constructor
-Nan::Persistent<v8::Function> AESXOR256::constructor;
 // AES key length
 const int AESXOR256::AESNODE_DEFAULT_KEY_LENGTH_BYTES = 32;
+// AES-GCM authentication tag length
+const int AESXOR256::AESNODE_TAG_LENGTH_BYTES = 16;
+
+// magic bytes opening a segmented cipher
+static const uint8_t SEGMENT_MAGIC[4] = {'S', 'X', 'G', '1'};
+// domain separation of the segmented cipher key derivation
+static const char SEGMENT_DOMAIN[] = "seifnode AESXOR256 segments v1";
+// length of the header opening a segmented cipher: magic, segment size,
+// message length and salt
+static const size_t SEGMENT_HEADER_BYTES = 32;
+// length of the random salt in the header
+static const size_t SEGMENT_SALT_BYTES = 16;
+// length of the per-segment GCM nonce
+static const size_t SEGMENT_NONCE_BYTES = 12;
+// default number of message bytes per segment (64 KB)
+static const size_t DEFAULT_SEGMENT_BYTES = 64 * 1024;
+// segment sizes must be a multiple of this
+static const size_t SEGMENT_ALIGNMENT_BYTES = 1024;
+// largest number of message bytes per segment (16 MB)
+static const size_t MAX_SEGMENT_BYTES = 16 * 1024 * 1024;
+
+
+// --------------
+// writeBigEndian
+// --------------
+/**
+ * @brief Writes the low 'length' bytes of the value in big endian order.
+ *
+ * @param output container of 'length' bytes
+ * @param value value to be written
+ * @param length number of bytes
+ *
+ * @return void
+ */
+static void writeBigEndian(uint8_t* output, uint64_t value, size_t length) {
+    for (size_t i = length; i > 0; --i) {
+        output[i - 1] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
 
 
 // -------------
-// uInt64toBytes
+// readBigEndian
 // -------------
 /**
- * @brief Convert uint64 array to an array of bytes.
+ * @brief Reads a big endian value of 'length' bytes.
+ *
+ * @param input container of 'length' bytes
+ * @param length number of bytes
  *
- * We traverse the input container from 'begin' to 'end' and store the
- * extracted bytes into 'out'
+ * @return value read
+ */
+static uint64_t readBigEndian(const uint8_t* input, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length; ++i) {
+        value = (value << 8) | input[i];
+    }
+    return value;
+}
+
+
+// -----------------
+// writeLittleEndian
+// -----------------
+/**
+ * @brief Writes the value as 8 bytes in little endian order.
  *
- * @param begin beginning of container of uint64 values
- * @param end end of container of uint64 values
- * @param out beginning of container of resulting byte values
+ * @param output container of 8 bytes
+ * @param value value to be written
  *
  * @return void
  */
-template <typename II, typename OI>
-void uInt64toBytes(II begin, II end, OI out) {
-    // traverse bytes in uint64 values and store in 'out'
-    while (begin != end) {
-        for (int i = 0; i < 8; ++i) {
-            *out = static_cast<uint8_t> (
-                (*begin & (uint64_t(0x00000000000000FF) << (8 * i))) >> (8 * i)
-            );
-            ++out;
-        }
-        ++begin;
+static void writeLittleEndian(uint8_t* output, uint64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        output[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+
+// ----------------
+// readLittleEndian
+// ----------------
+/**
+ * @brief Reads a little endian value of 8 bytes.
+ *
+ * @param input container of 8 bytes
+ *
+ * @return value read
+ */
+static uint64_t readLittleEndian(const uint8_t* input) {
+    uint64_t value = 0;
+    for (size_t i = 8; i > 0; --i) {
+        value = (value << 8) | input[i - 1];
+    }
+    return value;
+}
+
+
+// ------------
+// segmentNonce
+// ------------
+/**
+ * @brief Builds the GCM nonce of a segment as in the STREAM construction:
+ *        zeros, the big endian segment index and a flag marking the last
+ *        segment, so segments can be neither reordered nor dropped. Nonces
+ *        only repeat across ciphers of different salts, which derive
+ *        different keys.
+ *
+ * @param nonce output of SEGMENT_NONCE_BYTES bytes
+ * @param index index of the segment
+ * @param last whether it is the last segment
+ *
+ * @return void
+ */
+static void segmentNonce(uint8_t* nonce, size_t index, bool last) {
+    std::memset(nonce, 0, SEGMENT_NONCE_BYTES);
+    writeBigEndian(nonce + SEGMENT_NONCE_BYTES - 5, index, 4);
+    nonce[SEGMENT_NONCE_BYTES - 1] = last ? 1 : 0;
+}
+
+
+// -----------
+// sealSegment
+// -----------
+/**
+ * @brief Seals one masked segment in place, authenticating the header
+ *        along with it, and appends the tag.
+ *
+ * @param e GCM encryption context keyed with the segment key
+ * @param header header of the segmented cipher
+ * @param index index of the segment
+ * @param last whether it is the last segment
+ * @param segment masked message bytes followed by room for the tag
+ * @param length number of message bytes
+ * @param tagLength length of the authentication tag
+ *
+ * @throw Cryptopp:Exception in case of encryption errors
+ *
+ * @return void
+ */
+static void sealSegment(CryptoPP::GCM<AES>::Encryption& e,
+    const uint8_t* header, size_t index, bool last, uint8_t* segment,
+    size_t length, size_t tagLength) {
+
+    uint8_t nonce[SEGMENT_NONCE_BYTES];
+    segmentNonce(nonce, index, last);
+    e.Resynchronize(nonce, sizeof(nonce));
+
+    e.Update(header, SEGMENT_HEADER_BYTES);
+    e.ProcessData(segment, segment, length);
+    e.TruncatedFinal(segment + length, tagLength);
+}
+
+
+// -----------
+// openSegment
+// -----------
+/**
+ * @brief Verifies and decrypts one segment, authenticating the header
+ *        along with it. The output is wiped if verification fails.
+ *
+ * @param d GCM decryption context keyed with the segment key
+ * @param header header of the segmented cipher
+ * @param index index of the segment
+ * @param last whether it is the last segment
+ * @param output output of 'length' masked message bytes
+ * @param segment cipher bytes followed by the tag
+ * @param length number of message bytes
+ * @param tagLength length of the authentication tag
+ *
+ * @throw Cryptopp:Exception in case of decryption errors
+ *
+ * @return void
+ */
+static void openSegment(CryptoPP::GCM<AES>::Decryption& d,
+    const uint8_t* header, size_t index, bool last, uint8_t* output,
+    const uint8_t* segment, size_t length, size_t tagLength) {
+
+    uint8_t nonce[SEGMENT_NONCE_BYTES];
+    segmentNonce(nonce, index, last);
+    d.Resynchronize(nonce, sizeof(nonce));
+
+    d.Update(header, SEGMENT_HEADER_BYTES);
+    d.ProcessData(output, segment, length);
+
+    if (!d.TruncatedVerify(segment + length, tagLength)) {
+        std::memset(output, 0, length);
+        throw CryptoPP::HashVerificationFilter::HashVerificationFailed();
     }
 }
 
 
+// ------------
+// forEachSlice
+// ------------
+/**
+ * @brief Splits the segments [first, end) into contiguous slices, one per
+ *        thread, and runs the function on each with the mask generator
+ *        seeked to the first segment of the slice. Whole segments are
+ *        a multiple of 8 bytes, so each segment starts on a fresh value of
+ *        the generator.
+ *
+ * @param segmentSize number of message bytes per segment
+ * @param first index of the first segment
+ * @param end index after the last segment
+ * @param maskSeed seed of the mask generator of the cipher
+ * @param threads maximum number of threads to use, capped by the number
+ *        of hardware threads
+ * @param function invoked as function(mask, begin, end)
+ *
+ * @throw the first exception thrown by the function, or
+ *        std::system_error if a thread could not be started
+ *
+ * @return void
+ */
+template<typename Function>
+static void forEachSlice(size_t segmentSize, size_t first, size_t end,
+    const CryptoPP::SecBlock<uint64_t>& maskSeed, unsigned int threads,
+    Function function) {
+
+    const unsigned long long segmentWords = segmentSize / 8;
+
+    Parallel::forEachSlice(end - first, threads, 1,
+        [&](size_t begin, size_t stop) {
+
+        // Jump straight to the slice, in parallel with the others.
+        XORShift128 mask(maskSeed[0], maskSeed[1]);
+        mask.seek(first + begin, segmentWords);
+        function(mask, first + begin, first + stop);
+    });
+}
+
+
+
 // -------------
 // bytesToUInt64
 // -------------
@@ -138,95 +346,120 @@ uint64_t bytesToUInt64(uint8_t* bufferData, size_t bufferLength) {
  * @return
  */
 AESXOR256::AESXOR256(std::vector<uint64_t> seed):
-    _rng(seed) {
+    _rng(seed),
+    _seed(seed.data(), seed.size()) {
 
 }
 
 
 // ---------
-// getRandom
+// sealBlock
 // ---------
 /**
- * @brief Gets random uint64 values from pcg and stores them in a byte
- *        array.
+ * @brief Encrypts the message with the given keyed GCM context re-armed with
+ *        the zero IV, writing the cipher followed by the authentication
+ *        tag.
  *
- * @param random container for resulting random bytes
- * @param len number of random bytes required
+ * @param e keyed GCM encryption context
+ * @param cipher output of length + tagLength bytes
+ * @param message message to be encrypted
+ * @param length length of the message
+ * @param tagLength length of the authentication tag
+ *
+ * @throw Cryptopp:Exception in case of encryption errors
  *
  * @return void
  */
-void AESXOR256::getRandom(uint8_t* random, int len) {
-    /* Getting the number of random uint64 values required based on
-     * the number of bytes asked for.
-     */
-    int numRand = len % 8 == 0 ? len / 8 : len / 8 + 1;
-
-    std::vector<uint64_t> randomVector(numRand);
+static void sealBlock(CryptoPP::AuthenticatedSymmetricCipher& e,
+    uint8_t* cipher, const uint8_t* message, size_t length,
+    size_t tagLength) {
 
-    for (int i = 0; i < numRand; ++i) {
-        /* Getting random uint64 value from pcg random number generator
-         * using operator().
-         */
-        randomVector[i] = _rng();
-    }
+    // initial vector (IV) for AES to XOR
+    const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
+    e.Resynchronize(iv);
 
-    // Convert uint64 container to a byte array containing random values.
-    uInt64toBytes(randomVector.begin(), randomVector.end(), random);
+    // Encrypt straight into the output and append the tag.
+    e.ProcessData(cipher, message, length);
+    e.TruncatedFinal(cipher + length, tagLength);
 }
 
 
+// ---------
+// openBlock
+// ---------
+/**
+ * @brief Decrypts the cipher with the given keyed GCM context re-armed with
+ *        the zero IV and verifies the authentication tag, wiping the output
+ *        if verification fails.
+ *
+ * @param d keyed GCM decryption context
+ * @param message output of length bytes
+ * @param cipher cipher to be decrypted
+ * @param length length of the cipher excluding the tag
+ * @param tag authentication tag
+ * @param tagLength length of the authentication tag
+ *
+ * @throw Cryptopp:Exception in case of decryption errors
+ *
+ * @return void
+ */
+static void openBlock(CryptoPP::AuthenticatedSymmetricCipher& d,
+    uint8_t* message, const uint8_t* cipher, size_t length,
+    const uint8_t* tag, size_t tagLength) {
+
+    // initial vector (IV) for AES to XOR
+    const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
+    d.Resynchronize(iv);
+
+    d.ProcessData(message, cipher, length);
+
+    if (!d.TruncatedVerify(tag, tagLength)) {
+        // Do not leave unauthenticated plaintext behind.
+        std::memset(message, 0, length);
+        throw CryptoPP::HashVerificationFilter::HashVerificationFailed();
+    }
+}
+
 
 // ------------
 // encryptBlock
 // ------------
 /**
  * @brief Encrypts the given message using AES in GCM mode to provide
- *        confidentiality and authenticity using the given key resulting
- *        in the cipher block.
+ *        confidentiality and authenticity using the given key, writing the
+ *        cipher followed by the authentication tag into the output. The
+ *        output may alias the message (in place). The bound context is
+ *        used when the key is the bound key.
  *
- * @param cipher byte container for the resulting cipher
- * @param key byte container for the AES key
- * @param message byte container for the message
+ * @param cipher output of length + AESNODE_TAG_LENGTH_BYTES bytes
+ * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or nullptr
+ *        for the bound key
+ * @param message message to be encrypted
+ * @param length length of the message
  *
  * @throw Cryptopp:Exception in case of encryption errors
  *
  * @return void
  */
-void AESXOR256::encryptBlock(std::vector<uint8_t>& cipher,
-    const std::vector<uint8_t>& key, const std::vector<uint8_t>& message) {
+void AESXOR256::encryptBlock(uint8_t* cipher, const uint8_t* key,
+    const uint8_t* message, size_t length) {
 
-    // initial vector (IV) for AES to XOR
-    std::vector<uint8_t> iv(CryptoPP::AES::BLOCKSIZE);
+    Stats::Timer timer(Stats::OPERATION::AES_ENCRYPT, length);
 
-    std::string ciphertext; //store encrypted message
+    if (key == nullptr || isBoundKey(key)) {
+        sealBlock(*_encryption, cipher, message, length,
+            AESNODE_TAG_LENGTH_BYTES);
+        return;
+    }
 
+    // initial vector (IV) for AES to XOR
+    const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
 
-    // Initialize AES with GCM mode
+    // Initialize AES with GCM mode for this message only.
     CryptoPP::GCM<AES>::Encryption e;
+    e.SetKeyWithIV(key, AESNODE_DEFAULT_KEY_LENGTH_BYTES, iv);
 
-    // Set AES Key and load IV.
-    e.SetKeyWithIV(key.data(), key.size(), iv.data());
-
-    /* Apply the Cryptopp AuthenticatedEncryptionFilter to the message buffer
-     * using ArraySource, to transform it into an encrypted string 'ciphertext'.
-     */
-    ArraySource ss1(
-        message.data(),
-        message.size(),
-        true,
-        new CryptoPP::AuthenticatedEncryptionFilter(e,
-            new StringSink( ciphertext )
-        ) // AuthenticatedEncryptionFilter
-    ); // ArraySource
-
-    // Store the string cipher into the cipher byte vector.
-    cipher.resize(ciphertext.size());
-    StringSource ss2(
-        ciphertext,
-        true,
-        new ArraySink(cipher.data(), cipher.size())
-    );
-    return;
+    sealBlock(e, cipher, message, length, AESNODE_TAG_LENGTH_BYTES);
 }
 
 
@@ -234,53 +467,67 @@ void AESXOR256::encryptBlock(std::vector<uint8_t>& cipher,
 // decryptBlock
 // ------------
 /**
- * @brief Decrypts the given cipher using AES in GCM mode to provide
- *        confidentiality and authenticity using the given key resulting
- *        in the message block.
+ * @brief Decrypts the given cipher using AES in GCM mode and verifies its
+ *        authentication tag, writing the message into the output. The
+ *        output may alias the cipher (in place). The output is wiped if
+ *        verification fails. The bound context is used when the key is the
+ *        bound key.
  *
- * @param message byte container for the resulting decrypted message
- * @param cipher byte container for the input cipher
- * @param key byte container for the AES key
+ * @param message output of length - AESNODE_TAG_LENGTH_BYTES bytes
+ * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or nullptr
+ *        for the bound key
+ * @param cipher cipher followed by the authentication tag
+ * @param length length of the cipher including the tag
  *
  * @throw Cryptopp:Exception in case of decryption errors
  *
  * @return void
  */
-void AESXOR256::decryptBlock(std::vector<uint8_t>& message,
-    const std::vector<uint8_t>& key, const std::vector<uint8_t>& cipher) {
+void AESXOR256::decryptBlock(uint8_t* message, const uint8_t* key,
+    const uint8_t* cipher, size_t length) {
 
-    // initial vector (IV) for AES to XOR
-    std::vector<uint8_t> iv(CryptoPP::AES::BLOCKSIZE);
+    Stats::Timer timer(Stats::OPERATION::AES_DECRYPT, length);
 
-    std::string decryptedtext; //store decrypted message
+    if (length < (size_t)AESNODE_TAG_LENGTH_BYTES) {
+        throw CryptoPP::HashVerificationFilter::HashVerificationFailed();
+    }
 
-    // initialize AES
-    CryptoPP::GCM< AES >::Decryption e;
+    const size_t messageLength = length - AESNODE_TAG_LENGTH_BYTES;
 
-    // Set AES Key and load IV.
-    e.SetKeyWithIV(key.data(), key.size(), iv.data());
+    // Keep the tag aside since it may be overwritten when in place.
+    uint8_t tag[AESNODE_TAG_LENGTH_BYTES];
+    std::memcpy(tag, cipher + messageLength, sizeof(tag));
 
-    /* Apply the Cryptopp AuthenticatedDecryptionFilter to the cipher buffer
-     * using ArraySource, to transform it into the decrypted string.
-     */
-    ArraySource ss1(
-        cipher.data(),
-        cipher.size(),
-        true,
-        new CryptoPP::AuthenticatedDecryptionFilter(e,
-            new StringSink( decryptedtext )
-        ) // AuthenticatedDecryptionFilter
-    ); // ArraySource
+    if (key == nullptr || isBoundKey(key)) {
+        openBlock(*_decryption, message, cipher, messageLength,
+            tag, sizeof(tag));
+        return;
+    }
+
+    // initial vector (IV) for AES to XOR
+    const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
+
+    // initialize AES for this message only
+    CryptoPP::GCM< AES >::Decryption d;
+    d.SetKeyWithIV(key, AESNODE_DEFAULT_KEY_LENGTH_BYTES, iv);
+
+    openBlock(d, message, cipher, messageLength, tag, sizeof(tag));
+}
 
-    // Store the decrypted string into the message byte vector.
-    message.resize(decryptedtext.size());
-    StringSource ss2(
-        decryptedtext,
-        true,
-        new ArraySink(message.data(), message.size())
-    );
 
-    return;
+// ----------
+// isBoundKey
+// ----------
+/**
+ * @brief Checks whether the given key is the bound key.
+ *
+ * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+ *
+ * @return true if a key is bound and equal to the given one
+ */
+bool AESXOR256::isBoundKey(const uint8_t* key) const {
+    return _boundKey.size() == (size_t)AESNODE_DEFAULT_KEY_LENGTH_BYTES
+        && CryptoPP::VerifyBufsEqual(key, _boundKey.data(), _boundKey.size());
 }
 
 
@@ -289,27 +536,413 @@ void AESXOR256::decryptBlock(std::vector<uint8_t>& message,
 // xorRandomData
 // -------------
 /**
- * @brief XORs the given input container with requal number of random
- *        bytes obtained using the PCG random number generator.
+ * @brief XORs the given data in place with an equal number of random bytes
+ *        obtained from the xorshift random number generator. One uint64
+ *        value (little endian) is consumed per started 8 bytes of data.
  *
- * @param output byte container for the resulting XOR'd output
- * @param input byte container for the input data to be XOR'd with
- *        random bytes
+ * @param data bytes to be XOR'd with random bytes
+ * @param length number of bytes
  *
  * @return void
  */
-void AESXOR256::xorRandomData(std::vector<uint8_t>& output,
-    const std::vector<uint8_t>& input) {
+void AESXOR256::xorRandomData(uint8_t* data, size_t length) {
+
+    // Each message starts on a fresh value, unused bytes are discarded.
+    uint64_t word = 0;
+    unsigned int used = 8;
+    xorKeystream(_rng, word, used, data, length);
+}
 
-    // Get PCG random bytes based on the size of the input vector.
-    std::vector<uint8_t> random(input.size());
-    getRandom(random.data(), random.size());
 
-    /* XOR the random bytes with the input vector and store the result in the
-     * output vector
-     */
-    std::transform(input.begin(), input.begin() + input.size(),
-        random.data(), output.begin(), std::bit_xor<uint8_t>());
+// ------------
+// xorKeystream
+// ------------
+/**
+ * @brief XORs the given data in place with the keystream of the given
+ *        generator, continuing from the partially used value 'word'. Each
+ *        uint64 value is used in little endian byte order.
+ *
+ * @param rng xorshift random number generator
+ * @param word last value drawn from 'rng'
+ * @param used number of bytes of 'word' already used (8 if none left)
+ * @param data bytes to be XOR'd with random bytes
+ * @param length number of bytes
+ *
+ * @return void
+ */
+void AESXOR256::xorKeystream(XORShift128& rng, uint64_t& word,
+    unsigned int& used, uint8_t* data, size_t length) {
+
+    size_t i = 0;
+
+    // Use up the rest of the current value.
+    for (; i < length && used < 8; ++i, ++used) {
+        data[i] ^= static_cast<uint8_t>(word >> (8 * used));
+    }
+
+    // XOR whole uint64 values in bulk.
+    const size_t words = (length - i) / 8;
+    Keystream::xorWords(rng, data + i, words);
+    i += words * 8;
+
+    // Start a new value for the tail, keeping the rest for later.
+    if (i < length) {
+        word = rng();
+        for (used = 0; i < length; ++i, ++used) {
+            data[i] ^= static_cast<uint8_t>(word >> (8 * used));
+        }
+    }
+}
+
+
+// --------------
+// keystreamWords
+// --------------
+/**
+ * @brief Number of values 'xorKeystream' draws from the generator for the
+ *        given length.
+ *
+ * @param used number of bytes of the current value already used
+ * @param length number of bytes
+ *
+ * @return number of uint64 values
+ */
+size_t AESXOR256::keystreamWords(unsigned int used, size_t length) {
+    const size_t available = 8 - used;
+    return length <= available ? 0 : (length - available + 7) / 8;
+}
+
+
+// ---------------
+// segmentedLength
+// ---------------
+/**
+ * @brief Length of the segmented cipher of a message.
+ *
+ * @param length length of the message
+ * @param segmentSize number of message bytes per segment
+ *
+ * @return cipher length including the header and tags
+ */
+size_t AESXOR256::segmentedLength(size_t length, size_t segmentSize) {
+    // An empty message still has one (empty) segment carrying a tag.
+    const size_t segments = std::max<size_t>(1,
+        (length + segmentSize - 1) / segmentSize);
+    return SEGMENT_HEADER_BYTES + length +
+        segments * AESNODE_TAG_LENGTH_BYTES;
+}
+
+
+// -------------
+// parseSegments
+// -------------
+/**
+ * @brief Reads the geometry of a segmented cipher from its header and
+ *        checks it against the length of the cipher.
+ *
+ * @param cipher segmented cipher
+ * @param length length of the cipher
+ * @param layout resulting geometry
+ *
+ * @return false if the cipher is not a valid segmented cipher
+ */
+bool AESXOR256::parseSegments(const uint8_t* cipher, size_t length,
+    SegmentLayout& layout) {
+
+    if (length < SEGMENT_HEADER_BYTES
+        || std::memcmp(cipher, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+        return false;
+    }
+
+    const uint64_t segmentSize = readBigEndian(cipher + 4, 4);
+    const uint64_t messageLength = readBigEndian(cipher + 8, 8);
+
+    if (segmentSize == 0 || segmentSize > MAX_SEGMENT_BYTES
+        || segmentSize % SEGMENT_ALIGNMENT_BYTES != 0
+        || messageLength > length) {
+        return false;
+    }
+
+    layout.segmentSize = static_cast<size_t>(segmentSize);
+    layout.length = static_cast<size_t>(messageLength);
+    layout.segments = std::max<size_t>(1,
+        (layout.length + layout.segmentSize - 1) / layout.segmentSize);
+
+    return segmentedLength(layout.length, layout.segmentSize) == length;
+}
+
+
+// -----------------
+// deriveSegmentKeys
+// -----------------
+/**
+ * @brief Derives the AES key and the XORShift128 mask seed of one
+ *        segmented cipher from the AES key, the seed of the object and the
+ *        salt of the cipher using SHAKE256.
+ *
+ * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+ * @param salt 16 byte salt from the header
+ * @param segmentKey output of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+ * @param maskSeed output of two values
+ *
+ * @return void
+ */
+void AESXOR256::deriveSegmentKeys(const uint8_t* key, const uint8_t* salt,
+    uint8_t* segmentKey, CryptoPP::SecBlock<uint64_t>& maskSeed) const {
+
+    // SHAKE256
+    Keccak shake(136, 0x1F);
+
+    uint8_t seed[16];
+    writeLittleEndian(seed, _seed[0]);
+    writeLittleEndian(seed + 8, _seed[1]);
+
+    shake.update(reinterpret_cast<const uint8_t*>(SEGMENT_DOMAIN),
+        sizeof(SEGMENT_DOMAIN) - 1);
+    shake.update(key, AESNODE_DEFAULT_KEY_LENGTH_BYTES);
+    shake.update(seed, sizeof(seed));
+    shake.update(salt, SEGMENT_SALT_BYTES);
+
+    uint8_t output[AESNODE_DEFAULT_KEY_LENGTH_BYTES + 16];
+    shake.finish(output, sizeof(output));
+
+    std::memcpy(segmentKey, output, AESNODE_DEFAULT_KEY_LENGTH_BYTES);
+    maskSeed.New(2);
+    maskSeed[0] = readLittleEndian(output + AESNODE_DEFAULT_KEY_LENGTH_BYTES);
+    maskSeed[1] = readLittleEndian(output + AESNODE_DEFAULT_KEY_LENGTH_BYTES
+        + 8);
+
+    // The generator must not be seeded with all zeros.
+    if (maskSeed[0] == 0 && maskSeed[1] == 0) {
+        maskSeed[1] = 1;
+    }
+
+    CryptoPP::SecureWipeBuffer(seed, sizeof(seed));
+    CryptoPP::SecureWipeBuffer(output, sizeof(output));
+}
+
+
+// ------------
+// sealSegments
+// ------------
+/**
+ * @brief Encrypts the message as a segmented cipher: a header followed by
+ *        segments of 'segmentSize' message bytes (the last one possibly
+ *        shorter), each masked and sealed with AES-GCM under its own nonce
+ *        and tag, spread across the given number of threads.
+ *
+ * @param cipher output of 'segmentedLength' bytes
+ * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or nullptr
+ *        for the bound key
+ * @param message message to be encrypted
+ * @param length length of the message
+ * @param segmentSize number of message bytes per segment
+ * @param threads maximum number of threads to use
+ *
+ * @throw Cryptopp:Exception in case of encryption errors
+ *
+ * @return void
+ */
+void AESXOR256::sealSegments(uint8_t* cipher, const uint8_t* key,
+    const uint8_t* message, size_t length, size_t segmentSize,
+    unsigned int threads) {
+
+    Stats::Timer timer(Stats::OPERATION::AES_ENCRYPT, length);
+
+    SegmentLayout layout;
+    layout.segmentSize = segmentSize;
+    layout.length = length;
+    layout.segments = std::max<size_t>(1,
+        (length + segmentSize - 1) / segmentSize);
+
+    // Header: magic, segment size, message length and a fresh salt.
+    uint8_t* header = cipher;
+    std::memcpy(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    writeBigEndian(header + 4, segmentSize, 4);
+    writeBigEndian(header + 8, length, 8);
+    ThreadRandomPool::instance().GenerateBlock(header + 16,
+        SEGMENT_SALT_BYTES);
+
+    CryptoPP::SecByteBlock segmentKey(AESNODE_DEFAULT_KEY_LENGTH_BYTES);
+    CryptoPP::SecBlock<uint64_t> maskSeed;
+    deriveSegmentKeys(key != nullptr ? key : _boundKey.data(), header + 16,
+        segmentKey.data(), maskSeed);
+
+    forEachSlice(segmentSize, 0, layout.segments, maskSeed, threads,
+        [&](XORShift128& mask, size_t begin, size_t end) {
+
+        CryptoPP::GCM<AES>::Encryption e;
+        const uint8_t iv[SEGMENT_NONCE_BYTES] = {0};
+        e.SetKeyWithIV(segmentKey.data(), segmentKey.size(), iv, sizeof(iv));
+
+        for (size_t i = begin; i < end; ++i) {
+            const size_t offset = i * segmentSize;
+            const size_t n = std::min(segmentSize, length - offset);
+            uint8_t* segment = cipher + SEGMENT_HEADER_BYTES +
+                i * (segmentSize + AESNODE_TAG_LENGTH_BYTES);
+
+            // Mask the message bytes in the output and seal them in place.
+            std::memmove(segment, message + offset, n);
+            uint64_t word = 0;
+            unsigned int used = 8;
+            xorKeystream(mask, word, used, segment, n);
+
+            sealSegment(e, header, i, i + 1 == layout.segments, segment, n,
+                AESNODE_TAG_LENGTH_BYTES);
+        }
+    });
+}
+
+
+// ------------
+// openSegments
+// ------------
+/**
+ * @brief Verifies and decrypts the given range of segments of a segmented
+ *        cipher, writing their message bytes one after the other, spread
+ *        across the given number of threads. The output is wiped if any
+ *        segment fails verification.
+ *
+ * @param message output of the message bytes of the segments
+ * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or nullptr
+ *        for the bound key
+ * @param cipher segmented cipher including the header
+ * @param layout geometry of the cipher
+ * @param first index of the first segment
+ * @param count number of segments
+ * @param threads maximum number of threads to use
+ *
+ * @throw Cryptopp:Exception in case of decryption errors
+ *
+ * @return void
+ */
+void AESXOR256::openSegments(uint8_t* message, const uint8_t* key,
+    const uint8_t* cipher, const SegmentLayout& layout, size_t first,
+    size_t count, unsigned int threads) {
+
+    const size_t segmentSize = layout.segmentSize;
+    const size_t end = first + count;
+    const size_t length = std::min(layout.length, end * segmentSize) -
+        first * segmentSize;
+
+    Stats::Timer timer(Stats::OPERATION::AES_DECRYPT, length);
+
+    const uint8_t* header = cipher;
+
+    CryptoPP::SecByteBlock segmentKey(AESNODE_DEFAULT_KEY_LENGTH_BYTES);
+    CryptoPP::SecBlock<uint64_t> maskSeed;
+    deriveSegmentKeys(key != nullptr ? key : _boundKey.data(), header + 16,
+        segmentKey.data(), maskSeed);
+
+    try {
+
+        forEachSlice(segmentSize, first, end, maskSeed, threads,
+            [&](XORShift128& mask, size_t begin, size_t stop) {
+
+            CryptoPP::GCM<AES>::Decryption d;
+            const uint8_t iv[SEGMENT_NONCE_BYTES] = {0};
+            d.SetKeyWithIV(segmentKey.data(), segmentKey.size(), iv,
+                sizeof(iv));
+
+            for (size_t i = begin; i < stop; ++i) {
+                const size_t offset = i * segmentSize;
+                const size_t n = std::min(segmentSize, layout.length - offset);
+                const uint8_t* segment = cipher + SEGMENT_HEADER_BYTES +
+                    i * (segmentSize + AESNODE_TAG_LENGTH_BYTES);
+                uint8_t* output = message + (offset - first * segmentSize);
+
+                openSegment(d, header, i, i + 1 == layout.segments, output,
+                    segment, n, AESNODE_TAG_LENGTH_BYTES);
+
+                uint64_t word = 0;
+                unsigned int used = 8;
+                xorKeystream(mask, word, used, output, n);
+            }
+        });
+
+    } catch (...) {
+        // Do not leave the segments that did verify behind either.
+        std::memset(message, 0, length);
+        throw;
+    }
+}
+
+
+// ---------
+// unwrapKey
+// ---------
+/**
+ * @brief Gets the AES key from the given node.js value, throwing an error
+ *        to node.js if it is a buffer whose length is not the given length,
+ *        or null while no key is bound.
+ *
+ * @param value node.js buffer containing the key, or null for the bound key
+ * @param length required key length
+ * @param bound whether a key is bound
+ * @param key resulting key bytes, nullptr for the bound key
+ *
+ * @return boolean indicating success
+ */
+static bool unwrapKey(v8::Local<v8::Value> value, size_t length, bool bound,
+    const uint8_t*& key) {
+
+    if (value->IsNull() || value->IsUndefined()) {
+        if (!bound) {
+            Nan::ThrowError("Incorrect Arguments. No key bound with setKey");
+            return false;
+        }
+        key = nullptr;
+        return true;
+    }
+
+    v8::Local<v8::Object> bufferObj =
+                Nan::To<v8::Object>(value).ToLocalChecked();
+
+    if (Binding::length(bufferObj) != length) {
+        Nan::ThrowError("Incorrect Arguments. Please provide a key of size "
+                        "32 bytes");
+        return false;
+    }
+
+    key = Binding::data(bufferObj);
+    return true;
+}
+
+
+// ------------
+// unwrapOutput
+// ------------
+/**
+ * @brief Gets the region of the given output buffer to write into,
+ *        throwing an error to node.js if it is too small.
+ *
+ * @param info node.js arguments wrapper with output buffer at index 2 and
+ *        optional offset at index 3
+ * @param required number of bytes to be written
+ *
+ * @return pointer to the output region or nullptr on error
+ */
+static uint8_t* unwrapOutput(
+    const Nan::FunctionCallbackInfo<v8::Value>& info,
+    size_t required
+) {
+
+    v8::Local<v8::Object> bufferObj =
+                Nan::To<v8::Object>(info[2]).ToLocalChecked();
+    uint8_t* output = Binding::data(bufferObj);
+    size_t outputLength = Binding::length(bufferObj);
+
+    size_t offset = 0;
+    if (info[3]->IsNumber()) {
+        offset = Nan::To<uint32_t>(info[3]).FromJust();
+    }
+
+    if (offset > outputLength || outputLength - offset < required) {
+        Nan::ThrowError("Incorrect Arguments. Output buffer too small");
+        return nullptr;
+    }
+
+    return output + offset;
 }
 
 
@@ -336,7 +969,7 @@ NAN_METHOD(AESXOR256::New) {
         // Invoked as constructor: `new AESXOR256(...)`.
 
         // Checking if first argument (seed) is a valid node.js buffer.
-        if (!node::Buffer::HasInstance(info[0])) {
+        if (!Binding::isBytes(info[0])) {
 
             Nan::ThrowError("Incorrect Arguments. Seed buffer not provided");
             return;
@@ -346,8 +979,8 @@ NAN_METHOD(AESXOR256::New) {
         v8::Local<v8::Object> bufferObj =
             Nan::To<v8::Object>(info[0]).ToLocalChecked();
 
-        uint8_t* bufferData = (uint8_t*)node::Buffer::Data(bufferObj);
-        size_t bufferLength = node::Buffer::Length(bufferObj);
+        uint8_t* bufferData = Binding::data(bufferObj);
+        size_t bufferLength = Binding::length(bufferObj);
 
         std::vector<uint64_t> seed(2);
         seed[0] = bytesToUInt64(bufferData, bufferLength);
@@ -371,8 +1004,10 @@ NAN_METHOD(AESXOR256::New) {
             argv.push_back(info[i]);
         }
 
-        v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
-        info.GetReturnValue().Set(cons->NewInstance(argc, argv.data()));
+        v8::Local<v8::Function> cons =
+            Binding::constructor(info.Data(), Binding::CLASS::AESXOR256);
+        info.GetReturnValue().Set(
+            Nan::NewInstance(cons, argc, argv.data()).ToLocalChecked());
 
     }
 }
@@ -390,7 +1025,7 @@ NAN_METHOD(AESXOR256::New) {
  *
  * Invoked as:
  * 'let cipher = obj.encrypt(key, message)'
- * 'key' is the buffer containing the AES key
+ * 'key' is the buffer containing the AES key (null for the bound key)
  * 'message' is the buffer containing the message to be encrypted
  * 'cipher' is the buffer containing the encrypted cipher
  * PreCondition: key buffer size == AESNODE_DEFAULT_KEY_LENGTH_BYTES
@@ -406,8 +1041,8 @@ NAN_METHOD(AESXOR256::encrypt) {
 
     // Checking arguments.
     if (info.Length() < 2
-        || !node::Buffer::HasInstance(info[0])
-        || !node::Buffer::HasInstance(info[1])) {
+        || !(Binding::isBytes(info[0]) || info[0]->IsNull())
+        || !Binding::isBytes(info[1])) {
 
         Nan::ThrowError("Incorrect Arguments. Please provide buffers for 'key' "
                         "and 'message' function encrypt(key, message)'");
@@ -417,37 +1052,33 @@ NAN_METHOD(AESXOR256::encrypt) {
     /* Unwrap the first argument to get the AES key buffer and validate
      * that the key length = AESNODE_DEFAULT_KEY_LENGTH_BYTES.
      */
-    v8::Local<v8::Object> bufferObj0 =
-                Nan::To<v8::Object>(info[0]).ToLocalChecked();
-    uint8_t* keyData = (uint8_t *)node::Buffer::Data(bufferObj0);
-    size_t keyLength = node::Buffer::Length(bufferObj0);
-
-    if (keyLength != AESNODE_DEFAULT_KEY_LENGTH_BYTES) {
-        Nan::ThrowError("Incorrect Arguments. Please provide a key of size "
-                        "32 bytes");
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+            obj->_encryption != nullptr, keyData)) {
         return;
     }
 
     // Unwrap the second argument to get the message buffer.
     v8::Local<v8::Object> bufferObj1 =
                 Nan::To<v8::Object>(info[1]).ToLocalChecked();
-    uint8_t* messageData = (uint8_t *)node::Buffer::Data(bufferObj1);
-    size_t messageLength = node::Buffer::Length(bufferObj1);
+    uint8_t* messageData = Binding::data(bufferObj1);
+    size_t messageLength = Binding::length(bufferObj1);
 
-    // XOR random bytes with the given message buffer before encrypting it.
-    std::vector<uint8_t> temp(messageLength);
-    obj->xorRandomData(temp,
-        std::vector<uint8_t>(messageData, messageData + messageLength)
-    );
+    // Allocate the node.js buffer the cipher is written into.
+    v8::Local<v8::Object> cipherBuffer =
+        Nan::NewBuffer(messageLength + AESNODE_TAG_LENGTH_BYTES)
+        .ToLocalChecked();
+    uint8_t* cipherData = Binding::data(cipherBuffer);
 
+    /* XOR random bytes with the message in the output buffer and encrypt the
+     * XOR'd bytes in place using the given key.
+     */
+    std::memcpy(cipherData, messageData, messageLength);
+    obj->xorRandomData(cipherData, messageLength);
 
-    // Encrypt the XOR'd bytes using the given key and store in ciper data.
-    std::vector<uint8_t> cipherData;
     try {
 
-        obj->encryptBlock(cipherData,
-            std::vector<uint8_t>(keyData, keyData + keyLength), temp
-        );
+        obj->encryptBlock(cipherData, keyData, cipherData, messageLength);
 
     } catch (const CryptoPP::Exception& e) {
 
@@ -456,12 +1087,8 @@ NAN_METHOD(AESXOR256::encrypt) {
         return;
     }
 
-    // Copy cipherData vector into a node.js buffer.
-    auto slowBuffer = Nan::CopyBuffer((const char*)cipherData.data(),
-        cipherData.size()).ToLocalChecked();
-
     // Set node.js buffer as return value of the function
-    info.GetReturnValue().Set(slowBuffer);
+    info.GetReturnValue().Set(cipherBuffer);
 }
 
 
@@ -476,7 +1103,7 @@ NAN_METHOD(AESXOR256::encrypt) {
  *
  * Invoked as:
  * 'let message = obj.decrypt(key, cipher)'
- * 'key' is the buffer containing the AES key
+ * 'key' is the buffer containing the AES key (null for the bound key)
  * 'cipher' is the buffer containing the cipher to be decrypted
  * 'message' is the buffer containing the original decypted message
  * PreCondition: key buffer size == AESNODE_DEFAULT_KEY_LENGTH_BYTES
@@ -492,8 +1119,8 @@ NAN_METHOD(AESXOR256::decrypt) {
 
     // Checking arguments.
     if (info.Length() < 2
-        || !node::Buffer::HasInstance(info[0])
-        || !node::Buffer::HasInstance(info[1])) {
+        || !(Binding::isBytes(info[0]) || info[0]->IsNull())
+        || !Binding::isBytes(info[1])) {
 
         Nan::ThrowError("Incorrect Arguments. Please provide buffers for 'key' "
                         "and 'message' -> 'function encrypt(key, message)'");
@@ -503,32 +1130,30 @@ NAN_METHOD(AESXOR256::decrypt) {
     /* Unwrap the first argument to get the AES key buffer and validate
      * that the key length = AESNODE_DEFAULT_KEY_LENGTH_BYTES.
      */
-    v8::Local<v8::Object> bufferObj0 =
-                Nan::To<v8::Object>(info[0]).ToLocalChecked();
-    uint8_t* keyData = (uint8_t *)node::Buffer::Data(bufferObj0);
-    size_t keyLength = node::Buffer::Length(bufferObj0);
-
-    if (keyLength != AESNODE_DEFAULT_KEY_LENGTH_BYTES) {
-        Nan::ThrowError("Incorrect Arguments. Please provide a key of size "
-                        "32 bytes");
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+            obj->_encryption != nullptr, keyData)) {
         return;
     }
 
     // Unwrap the second argument to get the message buffer.
     v8::Local<v8::Object> bufferObj1 =
                 Nan::To<v8::Object>(info[1]).ToLocalChecked();
-    uint8_t* cipherData = (uint8_t *)node::Buffer::Data(bufferObj1);
-    size_t cipherLength = node::Buffer::Length(bufferObj1);
+    uint8_t* cipherData = Binding::data(bufferObj1);
+    size_t cipherLength = Binding::length(bufferObj1);
 
+    size_t messageLength = cipherLength > (size_t)AESNODE_TAG_LENGTH_BYTES ?
+        cipherLength - AESNODE_TAG_LENGTH_BYTES : 0;
+
+    // Allocate the node.js buffer the message is written into.
+    v8::Local<v8::Object> messageBuffer =
+        Nan::NewBuffer(messageLength).ToLocalChecked();
+    uint8_t* messageData = Binding::data(messageBuffer);
 
     // Decrypt the given cipher buffer using the given key.
-    std::vector<uint8_t> temp;
     try {
 
-        obj->decryptBlock(temp,
-            std::vector<uint8_t>(keyData, keyData + keyLength),
-            std::vector<uint8_t>(cipherData, cipherData + cipherLength)
-        );
+        obj->decryptBlock(messageData, keyData, cipherData, cipherLength);
 
     } catch (const CryptoPP::Exception& e) {
 
@@ -537,16 +1162,626 @@ NAN_METHOD(AESXOR256::decrypt) {
         return;
     }
 
-    // XOR random bytes with the decrypted message buffer.
-    std::vector<uint8_t> messageData(temp.size());
-    obj->xorRandomData(messageData, temp);
-
-    // Copy messageData vector into a node.js buffer.
-    auto slowBuffer = Nan::CopyBuffer((const char*)messageData.data(),
-        messageData.size()).ToLocalChecked();;
+    // XOR random bytes with the decrypted message in place.
+    obj->xorRandomData(messageData, messageLength);
 
     // Set node.js buffer as return value of the function.
-    info.GetReturnValue().Set(slowBuffer);
+    info.GetReturnValue().Set(messageBuffer);
+}
+
+
+
+// ------
+// setKey
+// ------
+/**
+ * @brief Binds the AES key to the object, computing the key schedule and
+ *        GHASH tables once. Calls passing null as the key, or the bound key
+ *        itself, then reuse them.
+ *
+ * Invoked as:
+ * 'obj.setKey(key)'
+ * 'key' is the buffer containing the AES key, or null to unbind
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::setKey) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    if (info[0]->IsNull() || info[0]->IsUndefined()) {
+        obj->_encryption.reset();
+        obj->_decryption.reset();
+        obj->_boundKey.CleanNew(0);
+        return;
+    }
+
+    if (!Binding::isBytes(info[0])) {
+        Nan::ThrowError("Incorrect Arguments. Please provide a buffer for "
+                        "'key' -> 'function setKey(key)'");
+        return;
+    }
+
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES, true, keyData)) {
+        return;
+    }
+
+    try {
+
+        // GCM requires an IV when keyed, it is re-armed per message anyway.
+        const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
+
+        std::unique_ptr<KeyedGCM::Encryption> e(new KeyedGCM::Encryption());
+        std::unique_ptr<KeyedGCM::Decryption> d(new KeyedGCM::Decryption());
+        e->SetKeyWithIV(keyData, AESNODE_DEFAULT_KEY_LENGTH_BYTES, iv);
+        d->SetKeyWithIV(keyData, AESNODE_DEFAULT_KEY_LENGTH_BYTES, iv);
+
+        obj->_encryption = std::move(e);
+        obj->_decryption = std::move(d);
+        obj->_boundKey.Assign(keyData, AESNODE_DEFAULT_KEY_LENGTH_BYTES);
+
+    } catch (const CryptoPP::Exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+}
+
+
+
+// ------------
+// createStream
+// ------------
+/**
+ * @brief Creates a stream object for the given mode, keyed with the key in
+ *        the first argument.
+ *
+ * @param info node.js arguments wrapper containing the key
+ * @param mode operation performed by the stream
+ * @param keyLength required key length
+ * @param boundKey key bound with 'setKey' or nullptr if none
+ *
+ * @return void
+ */
+static void createStream(
+    const Nan::FunctionCallbackInfo<v8::Value>& info,
+    AESXORStream::MODE mode,
+    size_t keyLength,
+    const uint8_t* boundKey
+) {
+
+    // Checking arguments.
+    if (!(Binding::isBytes(info[0]) || info[0]->IsNull())) {
+
+        Nan::ThrowError("Incorrect Arguments. Please provide a buffer for "
+                        "'key' -> 'function createCipher(key)'");
+        return;
+    }
+
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], keyLength, boundKey != nullptr, keyData)) {
+        return;
+    }
+
+    try {
+
+        info.GetReturnValue().Set(AESXORStream::NewInstance(info.Data(),
+            info.Holder(), mode, keyData != nullptr ? keyData : boundKey));
+
+    } catch (const CryptoPP::Exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+}
+
+
+// ------------
+// createCipher
+// ------------
+/**
+ * @brief Creates a stream object encrypting the message chunk by chunk. The
+ *        concatenated output of 'update' and 'final' is the same cipher
+ *        'encrypt' returns for the whole message.
+ *
+ * Invoked as:
+ * 'let cipher = obj.createCipher(key)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::createCipher) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    createStream(info, AESXORStream::MODE::ENCRYPT,
+        AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+        obj->_encryption != nullptr ? obj->_boundKey.data() : nullptr);
+}
+
+
+// --------------
+// createDecipher
+// --------------
+/**
+ * @brief Creates a stream object decrypting the cipher chunk by chunk. The
+ *        authentication tag is checked by 'final'.
+ *
+ * Invoked as:
+ * 'let decipher = obj.createDecipher(key)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::createDecipher) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    createStream(info, AESXORStream::MODE::DECRYPT,
+        AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+        obj->_encryption != nullptr ? obj->_boundKey.data() : nullptr);
+}
+
+
+
+// -----------
+// encryptInto
+// -----------
+/**
+ * @brief Encrypts the message directly into a caller supplied buffer
+ *        without intermediate copies. The message may be a view of the
+ *        output region to encrypt in place.
+ *
+ * Invoked as:
+ * 'let written = obj.encryptInto(key, message, output, offset)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ * 'message' is the buffer containing the message to be encrypted
+ * 'output' is the buffer receiving the cipher
+ * 'offset' (optional) is the position in 'output' to write at
+ * 'written' is the number of bytes written (message length + 16)
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::encryptInto) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    // Checking arguments.
+    if (info.Length() < 3
+        || !(Binding::isBytes(info[0]) || info[0]->IsNull())
+        || !Binding::isBytes(info[1])
+        || !Binding::isBytes(info[2])) {
+
+        Nan::ThrowError("Incorrect Arguments. Please provide buffers for 'key',"
+                        " 'message' and 'output' -> 'function encryptInto(key, "
+                        "message, output, offset)'");
+        return;
+    }
+
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+            obj->_encryption != nullptr, keyData)) {
+        return;
+    }
+
+    v8::Local<v8::Object> bufferObj1 =
+                Nan::To<v8::Object>(info[1]).ToLocalChecked();
+    uint8_t* messageData = Binding::data(bufferObj1);
+    size_t messageLength = Binding::length(bufferObj1);
+
+    uint8_t* cipherData = unwrapOutput(info,
+        messageLength + AESNODE_TAG_LENGTH_BYTES);
+    if (cipherData == nullptr) {
+        return;
+    }
+
+    // Bring the message into the output region (no-op when in place).
+    std::memmove(cipherData, messageData, messageLength);
+    obj->xorRandomData(cipherData, messageLength);
+
+    try {
+
+        obj->encryptBlock(cipherData, keyData, cipherData, messageLength);
+
+    } catch (const CryptoPP::Exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+
+    info.GetReturnValue().Set(Nan::New<v8::Number>(
+        messageLength + AESNODE_TAG_LENGTH_BYTES));
+}
+
+
+
+// -----------
+// decryptInto
+// -----------
+/**
+ * @brief Decrypts the cipher directly into a caller supplied buffer without
+ *        intermediate copies. The cipher may be a view of the output region
+ *        to decrypt in place.
+ *
+ * Invoked as:
+ * 'let written = obj.decryptInto(key, cipher, output, offset)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ * 'cipher' is the buffer containing the cipher to be decrypted
+ * 'output' is the buffer receiving the message
+ * 'offset' (optional) is the position in 'output' to write at
+ * 'written' is the number of bytes written (cipher length - 16)
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::decryptInto) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    // Checking arguments.
+    if (info.Length() < 3
+        || !(Binding::isBytes(info[0]) || info[0]->IsNull())
+        || !Binding::isBytes(info[1])
+        || !Binding::isBytes(info[2])) {
+
+        Nan::ThrowError("Incorrect Arguments. Please provide buffers for 'key',"
+                        " 'cipher' and 'output' -> 'function decryptInto(key, "
+                        "cipher, output, offset)'");
+        return;
+    }
+
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+            obj->_encryption != nullptr, keyData)) {
+        return;
+    }
+
+    v8::Local<v8::Object> bufferObj1 =
+                Nan::To<v8::Object>(info[1]).ToLocalChecked();
+    uint8_t* cipherData = Binding::data(bufferObj1);
+    size_t cipherLength = Binding::length(bufferObj1);
+
+    size_t messageLength = cipherLength > (size_t)AESNODE_TAG_LENGTH_BYTES ?
+        cipherLength - AESNODE_TAG_LENGTH_BYTES : 0;
+
+    uint8_t* messageData = unwrapOutput(info, messageLength);
+    if (messageData == nullptr) {
+        return;
+    }
+
+    try {
+
+        /* Decrypting is only safe in place or into a disjoint region, so
+         * partially overlapping regions are aligned first. The tag is kept
+         * aside by decryptBlock.
+         */
+        if (messageData != cipherData
+            && messageData < cipherData + cipherLength
+            && cipherData < messageData + messageLength) {
+
+            std::vector<uint8_t> copy(cipherData, cipherData + cipherLength);
+            obj->decryptBlock(messageData, keyData, copy.data(),
+                copy.size());
+
+        } else {
+
+            obj->decryptBlock(messageData, keyData, cipherData, cipherLength);
+        }
+
+    } catch (const CryptoPP::Exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+
+    obj->xorRandomData(messageData, messageLength);
+
+    info.GetReturnValue().Set(Nan::New<v8::Number>(messageLength));
+}
+
+
+
+// ---------------
+// encryptSegments
+// ---------------
+/**
+ * @brief Encrypts the message as a segmented cipher whose segments are
+ *        sealed independently, so encryption and decryption can be spread
+ *        across threads and any part of the message can be decrypted on
+ *        its own. Segmented ciphers do not draw from the keystream of the
+ *        object.
+ *
+ * Invoked as:
+ * 'let cipher = obj.encryptSegments(key, message, options)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ * 'message' is the buffer containing the message to be encrypted
+ * 'options' (optional) is of the form:
+ * {segmentSize: [multiple of 1024 up to 16MB, 64KB by default],
+ *  threads: [maximum number of threads, 1 by default]}
+ * 'cipher' is the buffer containing the segmented cipher
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::encryptSegments) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    // Checking arguments.
+    if (info.Length() < 2
+        || !(Binding::isBytes(info[0]) || info[0]->IsNull())
+        || !Binding::isBytes(info[1])) {
+
+        Nan::ThrowError("Incorrect Arguments. Please provide buffers for 'key' "
+                        "and 'message' -> 'function encryptSegments(key, "
+                        "message, options)'");
+        return;
+    }
+
+    const uint8_t* keyData;
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES,
+            obj->_encryption != nullptr, keyData)) {
+        return;
+    }
+
+    v8::Local<v8::Object> bufferObj1 =
+                Nan::To<v8::Object>(info[1]).ToLocalChecked();
+    const uint8_t* messageData = Binding::data(bufferObj1);
+    size_t messageLength = Binding::length(bufferObj1);
+
+    size_t segmentSize = DEFAULT_SEGMENT_BYTES;
+    unsigned int threads = 1;
+
+    if (info[2]->IsObject()) {
+        v8::Local<v8::Object> options =
+            Nan::To<v8::Object>(info[2]).ToLocalChecked();
+
+        v8::Local<v8::Value> size = Nan::Get(options,
+            Nan::New<v8::String>("segmentSize").ToLocalChecked())
+            .ToLocalChecked();
+        if (!size->IsUndefined()) {
+            double value = Nan::To<double>(size).FromJust();
+            if (!(value >= SEGMENT_ALIGNMENT_BYTES
+                  && value <= MAX_SEGMENT_BYTES)
+                || static_cast<size_t>(value) % SEGMENT_ALIGNMENT_BYTES != 0) {
+
+                Nan::ThrowError("Incorrect Arguments. Segment size must be a "
+                                "multiple of 1024 bytes up to 16MB");
+                return;
+            }
+            segmentSize = static_cast<size_t>(value);
+        }
+
+        v8::Local<v8::Value> count = Nan::Get(options,
+            Nan::New<v8::String>("threads").ToLocalChecked())
+            .ToLocalChecked();
+        if (count->IsNumber()) {
+            threads = Nan::To<uint32_t>(count).FromJust();
+        }
+    }
+
+    // Segment indices are carried in 4 bytes of the nonce.
+    if ((messageLength + segmentSize - 1) / segmentSize > 0xFFFFFFFFULL) {
+        Nan::ThrowError("Incorrect Arguments. Too many segments, please use "
+                        "a larger segment size");
+        return;
+    }
+
+    v8::Local<v8::Object> cipherBuffer =
+        Nan::NewBuffer(segmentedLength(messageLength, segmentSize))
+        .ToLocalChecked();
+    uint8_t* cipherData = Binding::data(cipherBuffer);
+
+    try {
+
+        obj->sealSegments(cipherData, keyData, messageData, messageLength,
+            segmentSize, threads);
+
+    } catch (const std::exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+
+    info.GetReturnValue().Set(cipherBuffer);
+}
+
+
+// ---------------------
+// unwrapSegmentedCipher
+// ---------------------
+/**
+ * @brief Gets the key and the segmented cipher from the first two
+ *        arguments, throwing an error to node.js if they are invalid.
+ *
+ * @param info node.js arguments wrapper with the key at index 0 and the
+ *        cipher at index 1
+ * @param bound whether a key is bound
+ * @param usage signature of the invoked function for error messages
+ * @param key resulting key bytes, nullptr for the bound key
+ * @param cipher resulting cipher bytes
+ * @param layout resulting geometry of the cipher
+ *
+ * @return boolean indicating success
+ */
+bool AESXOR256::unwrapSegmentedCipher(
+    const Nan::FunctionCallbackInfo<v8::Value>& info,
+    bool bound,
+    const char* usage,
+    const uint8_t*& key,
+    const uint8_t*& cipher,
+    SegmentLayout& layout
+) {
+
+    if (info.Length() < 2
+        || !(Binding::isBytes(info[0]) || info[0]->IsNull())
+        || !Binding::isBytes(info[1])) {
+
+        Nan::ThrowError((std::string("Incorrect Arguments. Please provide "
+            "buffers for 'key' and 'cipher' -> '") + usage + "'").c_str());
+        return false;
+    }
+
+    if (!unwrapKey(info[0], AESNODE_DEFAULT_KEY_LENGTH_BYTES, bound, key)) {
+        return false;
+    }
+
+    v8::Local<v8::Object> bufferObj1 =
+                Nan::To<v8::Object>(info[1]).ToLocalChecked();
+    cipher = Binding::data(bufferObj1);
+
+    if (!parseSegments(cipher, Binding::length(bufferObj1), layout)) {
+        Nan::ThrowError("Incorrect Arguments. Not a segmented cipher");
+        return false;
+    }
+
+    return true;
+}
+
+
+// ---------------
+// decryptSegments
+// ---------------
+/**
+ * @brief Verifies and decrypts a whole segmented cipher.
+ *
+ * Invoked as:
+ * 'let message = obj.decryptSegments(key, cipher, threads)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ * 'cipher' is the buffer containing the segmented cipher
+ * 'threads' (optional) is the maximum number of threads, 1 by default
+ * 'message' is the buffer containing the decrypted message
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::decryptSegments) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    const uint8_t* keyData;
+    const uint8_t* cipherData;
+    SegmentLayout layout;
+    if (!unwrapSegmentedCipher(info, obj->_encryption != nullptr,
+            "function decryptSegments(key, cipher, threads)", keyData,
+            cipherData, layout)) {
+        return;
+    }
+
+    unsigned int threads = 1;
+    if (info[2]->IsNumber()) {
+        threads = Nan::To<uint32_t>(info[2]).FromJust();
+    }
+
+    v8::Local<v8::Object> messageBuffer =
+        Nan::NewBuffer(layout.length).ToLocalChecked();
+    uint8_t* messageData = Binding::data(messageBuffer);
+
+    try {
+
+        obj->openSegments(messageData, keyData, cipherData, layout, 0,
+            layout.segments, threads);
+
+    } catch (const std::exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+
+    info.GetReturnValue().Set(messageBuffer);
+}
+
+
+// ------------
+// decryptRange
+// ------------
+/**
+ * @brief Verifies and decrypts only the segments holding the given range
+ *        of message bytes and returns those bytes.
+ *
+ * Invoked as:
+ * 'let slice = obj.decryptRange(key, cipher, start, end)'
+ * 'key' is the buffer containing the AES key (null for the bound key)
+ * 'cipher' is the buffer containing the segmented cipher
+ * 'start' is the offset of the first message byte
+ * 'end' (optional) is the offset after the last message byte, the message
+ * length by default
+ * 'slice' is the buffer containing the message bytes [start, end)
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXOR256::decryptRange) {
+
+    AESXOR256* obj = ObjectWrap::Unwrap<AESXOR256>(info.Holder());
+
+    const uint8_t* keyData;
+    const uint8_t* cipherData;
+    SegmentLayout layout;
+    if (!unwrapSegmentedCipher(info, obj->_encryption != nullptr,
+            "function decryptRange(key, cipher, start, end)", keyData,
+            cipherData, layout)) {
+        return;
+    }
+
+    double start = info[2]->IsNumber() ?
+        Nan::To<double>(info[2]).FromJust() : -1;
+    double end = info[3]->IsUndefined() ? layout.length :
+        Nan::To<double>(info[3]).FromJust();
+
+    if (!(start >= 0 && start <= end && end <= layout.length)) {
+        Nan::ThrowError("Incorrect Arguments. Please provide a range within "
+                        "the message -> 'function decryptRange(key, cipher, "
+                        "start, end)'");
+        return;
+    }
+
+    const size_t from = static_cast<size_t>(start);
+    const size_t to = static_cast<size_t>(end);
+
+    v8::Local<v8::Object> sliceBuffer =
+        Nan::NewBuffer(to - from).ToLocalChecked();
+
+    if (from == to) {
+        info.GetReturnValue().Set(sliceBuffer);
+        return;
+    }
+
+    // Decrypt the covering segments and hand out the requested bytes.
+    const size_t first = from / layout.segmentSize;
+    const size_t count = (to - 1) / layout.segmentSize - first + 1;
+    CryptoPP::SecByteBlock segments(
+        std::min(layout.length, (first + count) * layout.segmentSize) -
+        first * layout.segmentSize);
+
+    try {
+
+        obj->openSegments(segments.data(), keyData, cipherData, layout,
+            first, count, 1);
+
+    } catch (const std::exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+
+    std::memcpy(Binding::data(sliceBuffer),
+        segments.data() + (from - first * layout.segmentSize), to - from);
+
+    info.GetReturnValue().Set(sliceBuffer);
 }
 
 
@@ -559,24 +1794,40 @@ NAN_METHOD(AESXOR256::decrypt) {
  *        by the addon.
  *
  * @param exports node.js module exports
+ * @param data module instance data holding the class constructors
  *
  * @return void
  */
-void AESXOR256::Init(v8::Handle<v8::Object> exports) {
+void AESXOR256::Init(v8::Local<v8::Object> exports,
+    v8::Local<v8::Object> data) {
 
     Nan::HandleScope scope;
 
     // Prepare constructor template.
-    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+    v8::Local<v8::FunctionTemplate> tpl =
+        Nan::New<v8::FunctionTemplate>(New, data);
     tpl->SetClassName(Nan::New("AESXOR256").ToLocalChecked());
     tpl->InstanceTemplate()->SetInternalFieldCount(2);
 
     // Prototype
-    Nan::SetPrototypeMethod(tpl, "encrypt", encrypt);
-    Nan::SetPrototypeMethod(tpl, "decrypt", decrypt);
-
-    constructor.Reset(tpl->GetFunction());
+    Nan::SetPrototypeMethod(tpl, "encrypt", encrypt, data);
+    Nan::SetPrototypeMethod(tpl, "decrypt", decrypt, data);
+    Nan::SetPrototypeMethod(tpl, "encryptInto", encryptInto, data);
+    Nan::SetPrototypeMethod(tpl, "decryptInto", decryptInto, data);
+    Nan::SetPrototypeMethod(tpl, "setKey", setKey, data);
+    Nan::SetPrototypeMethod(tpl, "createCipher", createCipher, data);
+    Nan::SetPrototypeMethod(tpl, "createDecipher", createDecipher, data);
+    Nan::SetPrototypeMethod(tpl, "encryptSegments", encryptSegments, data);
+    Nan::SetPrototypeMethod(tpl, "decryptSegments", decryptSegments, data);
+    Nan::SetPrototypeMethod(tpl, "decryptRange", decryptRange, data);
+
+    // Stream objects returned by createCipher/createDecipher.
+    AESXORStream::Init(data);
+
+    v8::Local<v8::Function> constructor =
+        Nan::GetFunction(tpl).ToLocalChecked();
+    Binding::setConstructor(data, Binding::CLASS::AESXOR256, constructor);
 
     // Setting node.js module.exports.
-    exports->Set(Nan::New("AESXOR256").ToLocalChecked(), tpl->GetFunction());
+    Nan::Set(exports, Nan::New("AESXOR256").ToLocalChecked(), constructor);
 }
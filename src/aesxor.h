@@ -38,11 +38,19 @@
 #include <node_object_wrap.h>
 #include <nan.h>
 
+// -----------------
+// standard includes
+// -----------------
+#include <memory>
+#include <vector>
+
 // -----------------
 // cryptopp includes
 // -----------------
 #include "aes.h"
 using CryptoPP::AES;
+#include "gcm.h"
+#include "secblock.h"
 
 // ----------------
 // xor shift 128 includes
@@ -60,14 +68,21 @@ using CryptoPP::AES;
  * 		  The functions exposed to node.js are:
  *		  function encrypt(key, message) -> returns cipher
  *		  function decrypt(key, cipher) -> returns message
+ *		  function encryptInto(key, message, output, offset) -> returns length
+ *		  function decryptInto(key, cipher, output, offset) -> returns length
+ *		  function setKey(key) -> binds the key used when 'key' is null
+ *		  function createCipher(key) -> returns encrypting stream object
+ *		  function createDecipher(key) -> returns decrypting stream object
+ *		  function encryptSegments(key, message, options) -> returns cipher
+ *		  function decryptSegments(key, cipher, threads) -> returns message
+ *		  function decryptRange(key, cipher, start, end) -> returns slice
  */
 class AESXOR256 : public Nan::ObjectWrap {
 
-	private:
-
-		// javascript object constructor
-		static Nan::Persistent<v8::Function> constructor;
+	// streams draw from the keystream of the object that created them
+	friend class AESXORStream;
 
+	private:
 
 		// ----
 		// data
@@ -75,6 +90,20 @@ class AESXOR256 : public Nan::ObjectWrap {
 
 		// xorShift128
 		XORShift128 _rng;
+		// seed of '_rng', keying the masks of segmented ciphers
+		CryptoPP::SecBlock<uint64_t> _seed;
+
+		/* GCM with 64KB GHASH tables for the bound key. The tables are built
+		 * once in 'setKey' so only the IV has to be re-armed per message.
+		 */
+		typedef CryptoPP::GCM<AES, CryptoPP::GCM_64K_Tables> KeyedGCM;
+
+		// key bound with 'setKey', empty if none
+		CryptoPP::SecByteBlock _boundKey;
+		// encryption context keyed with '_boundKey'
+		std::unique_ptr<KeyedGCM::Encryption> _encryption;
+		// decryption context keyed with '_boundKey'
+		std::unique_ptr<KeyedGCM::Decryption> _decryption;
 
 	 	// AES key length
 	 	static const int AESNODE_DEFAULT_KEY_LENGTH_BYTES;
@@ -96,19 +125,156 @@ class AESXOR256 : public Nan::ObjectWrap {
 	    explicit AESXOR256(std::vector<uint64_t> seed);
 
 
-	    // ---------
-		// getRandom
-		// ---------
-	 	/**
-		 * @brief Gets random uint64 values from pcg and stores them in a byte
-		 *		  array.
+	 	// AES-GCM authentication tag length
+	 	static const int AESNODE_TAG_LENGTH_BYTES;
+
+
+		// -------------
+		// SegmentLayout
+		// -------------
+		/*
+		 * @struct Geometry of a segmented cipher read from its header.
+		 */
+		struct SegmentLayout {
+			// number of message bytes per segment
+			size_t segmentSize;
+			// total number of message bytes
+			size_t length;
+			// number of segments, at least one
+			size_t segments;
+		};
+
+
+		// -----------------
+		// deriveSegmentKeys
+		// -----------------
+		/**
+		 * @brief Derives the AES key and the XORShift128 mask seed of one
+		 *		  segmented cipher from the AES key, the seed of the object
+		 *		  and the salt of the cipher using SHAKE256.
 		 *
-		 * @param random container for resulting random bytes
-		 * @param len number of random bytes required
+		 * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+		 * @param salt 16 byte salt from the header
+		 * @param segmentKey output of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+		 * @param maskSeed output of two values
 		 *
 		 * @return void
 		 */
-	 	void getRandom(uint8_t* random, int len);
+		void deriveSegmentKeys(const uint8_t* key, const uint8_t* salt,
+			uint8_t* segmentKey, CryptoPP::SecBlock<uint64_t>& maskSeed) const;
+
+
+		// ------------
+		// sealSegments
+		// ------------
+		/**
+		 * @brief Encrypts the message as a segmented cipher: a header
+		 *		  followed by segments of 'segmentSize' message bytes (the
+		 *		  last one possibly shorter), each masked and sealed with
+		 *		  AES-GCM under its own nonce and tag, spread across the
+		 *		  given number of threads.
+		 *
+		 * @param cipher output of 'segmentedLength' bytes
+		 * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or
+		 *		  nullptr for the bound key
+		 * @param message message to be encrypted
+		 * @param length length of the message
+		 * @param segmentSize number of message bytes per segment
+		 * @param threads maximum number of threads to use
+		 *
+		 * @throw Cryptopp:Exception in case of encryption errors
+		 *
+		 * @return void
+		 */
+		void sealSegments(uint8_t* cipher, const uint8_t* key,
+			const uint8_t* message, size_t length, size_t segmentSize,
+			unsigned int threads);
+
+
+		// ------------
+		// openSegments
+		// ------------
+		/**
+		 * @brief Verifies and decrypts the given range of segments of a
+		 *		  segmented cipher, writing their message bytes one after
+		 *		  the other, spread across the given number of threads. The
+		 *		  output is wiped if any segment fails verification.
+		 *
+		 * @param message output of the message bytes of the segments
+		 * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or
+		 *		  nullptr for the bound key
+		 * @param cipher segmented cipher including the header
+		 * @param layout geometry of the cipher
+		 * @param first index of the first segment
+		 * @param count number of segments
+		 * @param threads maximum number of threads to use
+		 *
+		 * @throw Cryptopp:Exception in case of decryption errors
+		 *
+		 * @return void
+		 */
+		void openSegments(uint8_t* message, const uint8_t* key,
+			const uint8_t* cipher, const SegmentLayout& layout,
+			size_t first, size_t count, unsigned int threads);
+
+
+		// ---------------
+		// segmentedLength
+		// ---------------
+		/**
+		 * @brief Length of the segmented cipher of a message.
+		 *
+		 * @param length length of the message
+		 * @param segmentSize number of message bytes per segment
+		 *
+		 * @return cipher length including the header and tags
+		 */
+		static size_t segmentedLength(size_t length, size_t segmentSize);
+
+
+		// -------------
+		// parseSegments
+		// -------------
+		/**
+		 * @brief Reads the geometry of a segmented cipher from its header
+		 *		  and checks it against the length of the cipher.
+		 *
+		 * @param cipher segmented cipher
+		 * @param length length of the cipher
+		 * @param layout resulting geometry
+		 *
+		 * @return false if the cipher is not a valid segmented cipher
+		 */
+		static bool parseSegments(const uint8_t* cipher, size_t length,
+			SegmentLayout& layout);
+
+
+		// ---------------------
+		// unwrapSegmentedCipher
+		// ---------------------
+		/**
+		 * @brief Gets the key and the segmented cipher from the first two
+		 *		  arguments, throwing an error to node.js if they are
+		 *		  invalid.
+		 *
+		 * @param info node.js arguments wrapper with the key at index 0 and
+		 *		  the cipher at index 1
+		 * @param bound whether a key is bound
+		 * @param usage signature of the invoked function for error messages
+		 * @param key resulting key bytes, nullptr for the bound key
+		 * @param cipher resulting cipher bytes
+		 * @param layout resulting geometry of the cipher
+		 *
+		 * @return boolean indicating success
+		 */
+		static bool unwrapSegmentedCipher(
+			const Nan::FunctionCallbackInfo<v8::Value>& info,
+			bool bound,
+			const char* usage,
+			const uint8_t*& key,
+			const uint8_t*& cipher,
+			SegmentLayout& layout
+		);
 
 
 	 	// ------------
@@ -116,60 +282,77 @@ class AESXOR256 : public Nan::ObjectWrap {
 		// ------------
 		/**
 		 * @brief Encrypts the given message using AES in GCM mode to provide
-		 *        confidentiality and authenticity using the given key resulting
-		 *        in the cipher block.
+		 *        confidentiality and authenticity using the given key,
+		 *        writing the cipher followed by the authentication tag into
+		 *        the output. The output may alias the message (in place).
+		 *        The bound context is used when the key is the bound key.
 		 *
-		 * @param cipher byte container for the resulting cipher
-		 * @param key byte container for the AES key
-		 * @param message byte container for the message
+		 * @param cipher output of length + AESNODE_TAG_LENGTH_BYTES bytes
+		 * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or
+		 *		  nullptr for the bound key
+		 * @param message message to be encrypted
+		 * @param length length of the message
 		 *
 		 * @throw Cryptopp:Exception in case of encryption errors
 		 *
 		 * @return void
 		 */
-	 	void encryptBlock(std::vector<uint8_t>& cipher,
-	 		const std::vector<uint8_t>& key,
-	 		const std::vector<uint8_t>& message);
+	 	void encryptBlock(uint8_t* cipher, const uint8_t* key,
+	 		const uint8_t* message, size_t length);
 
 
 	 	// ------------
 		// decryptBlock
 		// ------------
 		/**
-		 * @brief Decrypts the given cipher using AES in GCM mode to provide
-		 *        confidentiality and authenticity using the given key resulting
-		 *        in the message block.
+		 * @brief Decrypts the given cipher using AES in GCM mode and verifies
+		 *        its authentication tag, writing the message into the
+		 *        output. The output may alias the cipher (in place). The
+		 *        output is wiped if verification fails. The bound context
+		 *        is used when the key is the bound key.
 		 *
-		 * @param message byte container for the resulting decrypted message
-		 * @param cipher byte container for the input cipher
-		 * @param key byte container for the AES key
+		 * @param message output of length - AESNODE_TAG_LENGTH_BYTES bytes
+		 * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes or
+		 *		  nullptr for the bound key
+		 * @param cipher cipher followed by the authentication tag
+		 * @param length length of the cipher including the tag
 		 *
 		 * @throw Cryptopp:Exception in case of decryption errors
 		 *
 		 * @return void
 		 */
-	 	void decryptBlock(std::vector<uint8_t>& message,
-	 		const std::vector<uint8_t>& key,
-	 		const std::vector<uint8_t>& cipher);
+	 	void decryptBlock(uint8_t* message, const uint8_t* key,
+	 		const uint8_t* cipher, size_t length);
+
+
+	 	// ----------
+		// isBoundKey
+		// ----------
+		/**
+		 * @brief Checks whether the given key is the bound key.
+		 *
+		 * @param key AES key of AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+		 *
+		 * @return true if a key is bound and equal to the given one
+		 */
+	 	bool isBoundKey(const uint8_t* key) const;
 
 
 	 	// -------------
 		// xorRandomData
 		// -------------
 		/**
-		 * @brief XORs the given input container with requal number of random
-		 *        bytes obtained using the PCG random number generator.
+		 * @brief XORs the given data in place with an equal number of random
+		 *        bytes obtained from the xorshift random number generator.
+		 *        One uint64 value (little endian) is consumed per started
+		 *        8 bytes of data.
 		 *
-		 * @param output byte container for the resulting XOR'd output
-		 * @param input byte container for the input data to be XOR'd with
-		 *		  random bytes
+		 * @param data bytes to be XOR'd with random bytes
+		 * @param length number of bytes
 		 *
 		 * @return void
 		 */
-	 	void xorRandomData(
-			std::vector<uint8_t>& output,
-			const std::vector<uint8_t>& input
-		);
+	 	void xorRandomData(uint8_t* data, size_t length);
 
 
 		// ---
@@ -202,7 +385,7 @@ class AESXOR256 : public Nan::ObjectWrap {
 		 *
 		 * Invoked as:
 		 * 'let cipher = obj.encrypt(key, message)'
-		 * 'key' is the buffer containing the AES key
+		 * 'key' is the buffer containing the AES key (null for the bound key)
 		 * 'message' is the buffer containing the message to be encrypted
 		 * 'cipher' is the buffer containing the encrypted cipher
  		 * PreCondition: key buffer size == AESNODE_DEFAULT_KEY_LENGTH_BYTES
@@ -225,7 +408,7 @@ class AESXOR256 : public Nan::ObjectWrap {
 		 *
 		 * Invoked as:
 		 * 'let message = obj.decrypt(key, cipher)'
-		 * 'key' is the buffer containing the AES key
+		 * 'key' is the buffer containing the AES key (null for the bound key)
 		 * 'cipher' is the buffer containing the cipher to be decrypted
 		 * 'message' is the buffer containing the original decypted message
  		 * PreCondition: key buffer size == AESNODE_DEFAULT_KEY_LENGTH_BYTES
@@ -237,6 +420,213 @@ class AESXOR256 : public Nan::ObjectWrap {
 		 */
 		static NAN_METHOD(decrypt);
 
+
+		// ------
+		// setKey
+		// ------
+		/**
+		 * @brief Binds the AES key to the object, computing the key schedule
+		 *		  and GHASH tables once. Calls passing null as the key, or the
+		 *		  bound key itself, then reuse them.
+		 *
+		 * Invoked as:
+		 * 'obj.setKey(key)'
+		 * 'key' is the buffer containing the AES key, or null to unbind
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(setKey);
+
+
+		// -----------
+		// encryptInto
+		// -----------
+		/**
+		 * @brief Encrypts the message directly into a caller supplied
+		 *		  buffer without intermediate copies. The message may be a
+		 *		  view of the output region to encrypt in place.
+		 *
+		 * Invoked as:
+		 * 'let written = obj.encryptInto(key, message, output, offset)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 * 'message' is the buffer containing the message to be encrypted
+		 * 'output' is the buffer receiving the cipher
+		 * 'offset' (optional) is the position in 'output' to write at
+		 * 'written' is the number of bytes written (message length + 16)
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(encryptInto);
+
+
+		// -----------
+		// decryptInto
+		// -----------
+		/**
+		 * @brief Decrypts the cipher directly into a caller supplied buffer
+		 *		  without intermediate copies. The cipher may be a view of
+		 *		  the output region to decrypt in place.
+		 *
+		 * Invoked as:
+		 * 'let written = obj.decryptInto(key, cipher, output, offset)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 * 'cipher' is the buffer containing the cipher to be decrypted
+		 * 'output' is the buffer receiving the message
+		 * 'offset' (optional) is the position in 'output' to write at
+		 * 'written' is the number of bytes written (cipher length - 16)
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(decryptInto);
+
+		// ------------
+		// createCipher
+		// ------------
+		/**
+		 * @brief Creates a stream object encrypting the message chunk by
+		 *		  chunk. The concatenated output of 'update' and 'final' is
+		 *		  the same cipher 'encrypt' returns for the whole message.
+		 *
+		 * Invoked as:
+		 * 'let cipher = obj.createCipher(key)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(createCipher);
+
+
+		// --------------
+		// createDecipher
+		// --------------
+		/**
+		 * @brief Creates a stream object decrypting the cipher chunk by
+		 *		  chunk. The authentication tag is checked by 'final'.
+		 *
+		 * Invoked as:
+		 * 'let decipher = obj.createDecipher(key)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(createDecipher);
+
+
+		// ---------------
+		// encryptSegments
+		// ---------------
+		/**
+		 * @brief Encrypts the message as a segmented cipher whose segments
+		 *		  are sealed independently, so encryption and decryption can
+		 *		  be spread across threads and any part of the message can
+		 *		  be decrypted on its own. Segmented ciphers do not draw from
+		 *		  the keystream of the object.
+		 *
+		 * Invoked as:
+		 * 'let cipher = obj.encryptSegments(key, message, options)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 * 'message' is the buffer containing the message to be encrypted
+		 * 'options' (optional) is of the form:
+		 * {segmentSize: [multiple of 1024 up to 16MB, 64KB by default],
+		 *  threads: [maximum number of threads, 1 by default]}
+		 * 'cipher' is the buffer containing the segmented cipher
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(encryptSegments);
+
+
+		// ---------------
+		// decryptSegments
+		// ---------------
+		/**
+		 * @brief Verifies and decrypts a whole segmented cipher.
+		 *
+		 * Invoked as:
+		 * 'let message = obj.decryptSegments(key, cipher, threads)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 * 'cipher' is the buffer containing the segmented cipher
+		 * 'threads' (optional) is the maximum number of threads, 1 by default
+		 * 'message' is the buffer containing the decrypted message
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(decryptSegments);
+
+
+		// ------------
+		// decryptRange
+		// ------------
+		/**
+		 * @brief Verifies and decrypts only the segments holding the given
+		 *		  range of message bytes and returns those bytes.
+		 *
+		 * Invoked as:
+		 * 'let slice = obj.decryptRange(key, cipher, start, end)'
+		 * 'key' is the buffer containing the AES key (null for the bound key)
+		 * 'cipher' is the buffer containing the segmented cipher
+		 * 'start' is the offset of the first message byte
+		 * 'end' (optional) is the offset after the last message byte, the
+		 * message length by default
+		 * 'slice' is the buffer containing the message bytes [start, end)
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(decryptRange);
+
+	public:
+
+		// ------------
+		// xorKeystream
+		// ------------
+		/**
+		 * @brief XORs the given data in place with the keystream of the given
+		 *        generator, continuing from the partially used value
+		 *        'word'. Each uint64 value is used in little endian byte
+		 *        order.
+		 *
+		 * @param rng xorshift random number generator
+		 * @param word last value drawn from 'rng'
+		 * @param used number of bytes of 'word' already used (8 if none left)
+		 * @param data bytes to be XOR'd with random bytes
+		 * @param length number of bytes
+		 *
+		 * @return void
+		 */
+		static void xorKeystream(XORShift128& rng, uint64_t& word,
+			unsigned int& used, uint8_t* data, size_t length);
+
+
+		// --------------
+		// keystreamWords
+		// --------------
+		/**
+		 * @brief Number of values 'xorKeystream' draws from the generator for
+		 *        the given length.
+		 *
+		 * @param used number of bytes of the current value already used
+		 * @param length number of bytes
+		 *
+		 * @return number of uint64 values
+		 */
+		static size_t keystreamWords(unsigned int used, size_t length);
+
 	public:
 
 		// ----
@@ -247,10 +637,12 @@ class AESXOR256 : public Nan::ObjectWrap {
 		 * 		  by the addon.
 		 *
 		 * @param exports node.js module exports
+		 * @param data module instance data holding the class constructors
 		 *
 		 * @return void
 		 */
-    	static void Init(v8::Handle<v8::Object> exports);
+    	static void Init(v8::Local<v8::Object> exports,
+			v8::Local<v8::Object> data);
 
 
 };
@@ -0,0 +1,535 @@
+/** @file aesxorstream.cc
+ *  @brief Definition of the class functions provided in aesxorstream.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <algorithm>
+#include <cstring>
+
+// ----------------------
+// node.js addon includes
+// ----------------------
+#include <node_buffer.h>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "filters.h"
+#include "aes.h"
+#include "gcm.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "aesxorstream.h"
+#include "binding.h"
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initilizes and constructs internal data.
+ *
+ * @param callback callback to be invoked after async operation
+ * @param stream stream the chunk belongs to
+ * @param rng generator positioned at the chunk's keystream
+ * @param input input chunk
+ * @param length length of the input chunk
+ * @param output output of 'outputLength(length)' bytes
+ */
+AESXORStream::Worker::Worker(
+    Nan::Callback* callback,
+    AESXORStream* stream,
+    const XORShift128& rng,
+    const uint8_t* input,
+    size_t length,
+    uint8_t* output
+): Nan::AsyncWorker(callback),
+_stream(stream),
+_rng(rng),
+_input(input),
+_length(length),
+_output(output) {
+
+}
+
+
+
+// ----------------
+// HandleOKCallback
+// ----------------
+/**
+ * @brief Executed when the async work is complete without error, invoking
+ *        the given callback with the status and output buffer as arguments.
+ *
+ * @return void
+ */
+void AESXORStream::Worker::HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    _stream->_busy = false;
+
+    /* Creating js status object with 'code' set as the status code(0) and
+     * 'message' as "Success".
+     */
+    v8::Local<v8::Object> status = Nan::New<v8::Object>();
+    Nan::Set(status,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(0)
+    );
+    Nan::Set(status,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>("Success").ToLocalChecked()
+    );
+
+    v8::Local<v8::Value> argv[] = {status, GetFromPersistent("output")};
+
+    callback->Call(2, argv);
+}
+
+
+
+// -------------------
+// HandleErrorCallback
+// -------------------
+/**
+ * @brief Executed when the async work is complete with error, invoking the
+ *        given callback with the corresponding error.
+ *
+ * The error is returned as the first argument to the callback
+ * {code: [statusCode], message: [errorMessage]}
+ *
+ * @return void
+ */
+void AESXORStream::Worker::HandleErrorCallback() {
+    Nan::HandleScope scope;
+
+    _stream->_busy = false;
+
+    v8::Local<v8::Object> error = Nan::New<v8::Object>();
+    Nan::Set(error,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>((int)STATUS::CIPHER_ERROR)
+    );
+    Nan::Set(error,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>(ErrorMessage()).ToLocalChecked()
+    );
+
+    v8::Local<v8::Value> argv[] = {error, Nan::Undefined()};
+
+    callback->Call(2, argv);
+}
+
+
+
+// -------
+// Execute
+// -------
+/**
+ * @brief Executed in a separate thread, processing the chunk.
+ *
+ * @return void
+ */
+void AESXORStream::Worker::Execute() {
+
+    try {
+
+        _stream->process(_rng, _output, _input, _length);
+
+    } catch (const CryptoPP::Exception& e) {
+
+        SetErrorMessage(e.what());
+    }
+}
+
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initializes an empty stream, set up by 'NewInstance'.
+ */
+AESXORStream::AESXORStream():
+_mode(MODE::ENCRYPT),
+_parent(nullptr),
+_word(0),
+_used(8),
+_heldLength(0),
+_busy(false),
+_finished(false) {
+
+}
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Releases the object providing the keystream.
+ */
+AESXORStream::~AESXORStream() {
+    _parentHandle.Reset();
+}
+
+
+// ------------
+// outputLength
+// ------------
+/**
+ * @brief Number of bytes 'process' outputs for an input chunk of the given
+ *        length.
+ *
+ * @param length length of the input chunk
+ *
+ * @return number of output bytes
+ */
+size_t AESXORStream::outputLength(size_t length) const {
+
+    if (_mode == MODE::ENCRYPT) {
+        return length;
+    }
+
+    // Always hold back the last bytes seen, they may be the tag.
+    const size_t total = _heldLength + length;
+    return total > sizeof(_held) ? total - sizeof(_held) : 0;
+}
+
+
+// -------
+// process
+// -------
+/**
+ * @brief Encrypts or decrypts the chunk, carrying the GCM state, the
+ *        keystream position and the held back bytes over to the next chunk.
+ *
+ * @param rng generator providing the keystream
+ * @param output output of 'outputLength(length)' bytes
+ * @param input input chunk
+ * @param length length of the input chunk
+ *
+ * @throw Cryptopp:Exception in case of encryption errors
+ *
+ * @return void
+ */
+void AESXORStream::process(XORShift128& rng, uint8_t* output,
+    const uint8_t* input, size_t length) {
+
+    if (_mode == MODE::ENCRYPT) {
+        // XOR random bytes with the chunk and then encrypt it in place.
+        std::memcpy(output, input, length);
+        AESXOR256::xorKeystream(rng, _word, _used, output, length);
+        _gcm->ProcessData(output, output, length);
+        return;
+    }
+
+    const size_t emit = outputLength(length);
+
+    // Output the oldest held back bytes first, then the chunk.
+    const size_t fromHeld = std::min(_heldLength, emit);
+    const size_t fromInput = emit - fromHeld;
+
+    _gcm->ProcessData(output, _held, fromHeld);
+    _gcm->ProcessData(output + fromHeld, input, fromInput);
+
+    // Hold back whatever is left of both.
+    std::memmove(_held, _held + fromHeld, _heldLength - fromHeld);
+    _heldLength -= fromHeld;
+    std::memcpy(_held + _heldLength, input + fromInput, length - fromInput);
+    _heldLength += length - fromInput;
+
+    // XOR random bytes with the decrypted bytes.
+    AESXOR256::xorKeystream(rng, _word, _used, output, emit);
+}
+
+
+// -----------
+// NewInstance
+// -----------
+/**
+ * @brief Creates a stream object keyed with the given key.
+ *
+ * @param data module instance data holding the stream constructor
+ * @param parent javascript object of the AESXOR256 object providing the
+ *        keystream
+ * @param mode operation performed by the stream
+ * @param key AES key of AESXOR256::AESNODE_DEFAULT_KEY_LENGTH_BYTES bytes
+ *
+ * @throw Cryptopp:Exception in case of keying errors
+ *
+ * @return javascript stream object
+ */
+v8::Local<v8::Object> AESXORStream::NewInstance(v8::Local<v8::Value> data,
+    v8::Local<v8::Object> parent, MODE mode, const uint8_t* key) {
+
+    Nan::EscapableHandleScope scope;
+
+    // initial vector (IV) for AES to XOR, same as the one-shot functions
+    const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
+
+    std::unique_ptr<CryptoPP::AuthenticatedSymmetricCipher> gcm;
+    if (mode == MODE::ENCRYPT) {
+        gcm.reset(new CryptoPP::GCM<AES>::Encryption());
+    } else {
+        gcm.reset(new CryptoPP::GCM<AES>::Decryption());
+    }
+    gcm->SetKeyWithIV(key, AESXOR256::AESNODE_DEFAULT_KEY_LENGTH_BYTES, iv);
+
+    v8::Local<v8::Function> cons =
+        Binding::constructor(data, Binding::CLASS::AESXOR_STREAM);
+    v8::Local<v8::Object> instance = Nan::NewInstance(cons).ToLocalChecked();
+
+    AESXORStream* obj = ObjectWrap::Unwrap<AESXORStream>(instance);
+    obj->_mode = mode;
+    obj->_parent = ObjectWrap::Unwrap<AESXOR256>(parent);
+    obj->_parentHandle.Reset(parent);
+    obj->_gcm = std::move(gcm);
+
+    return scope.Escape(instance);
+}
+
+
+// ---
+// New
+// ---
+/**
+ * @brief Creates the wrapped object. Only used by 'NewInstance'.
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXORStream::New) {
+
+    if (!info.IsConstructCall()) {
+        Nan::ThrowError("Use AESXOR256 createCipher/createDecipher");
+        return;
+    }
+
+    AESXORStream* obj = new AESXORStream();
+    obj->Wrap(info.This());
+
+    info.GetReturnValue().Set(info.This());
+}
+
+
+
+// ------
+// update
+// ------
+/**
+ * @brief Encrypts or decrypts the next chunk.
+ *
+ * Invoked as:
+ * 'let output = obj.update(chunk)' or
+ * 'obj.update(chunk, function(status, output){})' where
+ * 'chunk' is the buffer containing the next part of the input
+ * 'status' is of the form:
+ * {code: [statusCode], message: [statusMessage]}
+ * 'output' is the buffer containing the corresponding output
+ * The chunk must not be modified until the callback is invoked and no other
+ * call may be made on the stream in the meantime.
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXORStream::update) {
+
+    AESXORStream* obj = ObjectWrap::Unwrap<AESXORStream>(info.Holder());
+
+    if (obj->_parent == nullptr) {
+        Nan::ThrowError("Use AESXOR256 createCipher/createDecipher");
+        return;
+    }
+
+    // Checking arguments.
+    if (info.Length() < 1 || !Binding::isBytes(info[0])) {
+        Nan::ThrowError("Incorrect Arguments. Please provide a buffer for "
+                        "'chunk' -> 'function update(chunk, callback)'");
+        return;
+    }
+
+    if (obj->_busy) {
+        Nan::ThrowError("Previous update still in progress");
+        return;
+    }
+
+    if (obj->_finished) {
+        Nan::ThrowError("Stream already finished");
+        return;
+    }
+
+    v8::Local<v8::Object> chunk = Nan::To<v8::Object>(info[0]).ToLocalChecked();
+    const uint8_t* input = Binding::data(chunk);
+    size_t length = Binding::length(chunk);
+
+    // Allocate the node.js buffer the output is written into.
+    const size_t outLength = obj->outputLength(length);
+    v8::Local<v8::Object> output = Nan::NewBuffer(outLength).ToLocalChecked();
+    uint8_t* outputData = Binding::data(output);
+
+    if (!info[1]->IsFunction()) {
+
+        try {
+
+            obj->process(obj->_parent->_rng, outputData, input, length);
+
+        } catch (const CryptoPP::Exception& e) {
+
+            Nan::ThrowError(e.what());
+            return;
+        }
+
+        info.GetReturnValue().Set(output);
+        return;
+    }
+
+    /* Hand the worker a copy of the generator positioned at this chunk's
+     * keystream and move the shared generator past it, so calls made on the
+     * main thread in the meantime get the bytes that follow.
+     */
+    XORShift128 rng = obj->_parent->_rng;
+    obj->_parent->_rng.discard(
+        AESXOR256::keystreamWords(obj->_used, outLength));
+
+    Nan::Callback* callback = new Nan::Callback(info[1].As<v8::Function>());
+    Worker* worker = new Worker(callback, obj, rng, input, length, outputData);
+
+    // Keep the stream, chunk and output alive until the worker completes.
+    worker->SaveToPersistent("stream", info.Holder());
+    worker->SaveToPersistent("chunk", chunk);
+    worker->SaveToPersistent("output", output);
+
+    obj->_busy = true;
+    Nan::AsyncQueueWorker(worker);
+}
+
+
+
+// -----
+// final
+// -----
+/**
+ * @brief Completes the stream. When encrypting the 16 byte authentication
+ *        tag is returned, when decrypting the tag is verified and an error
+ *        is thrown if it does not match. Output returned by 'update' while
+ *        decrypting must not be trusted before 'final' succeeds.
+ *
+ * Invoked as:
+ * 'let output = obj.final()'
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(AESXORStream::finish) {
+
+    AESXORStream* obj = ObjectWrap::Unwrap<AESXORStream>(info.Holder());
+
+    if (obj->_parent == nullptr) {
+        Nan::ThrowError("Use AESXOR256 createCipher/createDecipher");
+        return;
+    }
+
+    if (obj->_busy) {
+        Nan::ThrowError("Previous update still in progress");
+        return;
+    }
+
+    if (obj->_finished) {
+        Nan::ThrowError("Stream already finished");
+        return;
+    }
+
+    obj->_finished = true;
+
+    try {
+
+        if (obj->_mode == MODE::ENCRYPT) {
+            v8::Local<v8::Object> tag = Nan::NewBuffer(
+                AESXOR256::AESNODE_TAG_LENGTH_BYTES).ToLocalChecked();
+            obj->_gcm->TruncatedFinal(Binding::data(tag),
+                AESXOR256::AESNODE_TAG_LENGTH_BYTES);
+
+            info.GetReturnValue().Set(tag);
+            return;
+        }
+
+        if (obj->_heldLength != sizeof(obj->_held)
+            || !obj->_gcm->TruncatedVerify(obj->_held, obj->_heldLength)) {
+            throw CryptoPP::HashVerificationFilter::HashVerificationFailed();
+        }
+
+    } catch (const CryptoPP::Exception& e) {
+
+        Nan::ThrowError(e.what());
+        return;
+    }
+
+    info.GetReturnValue().Set(Nan::NewBuffer(0).ToLocalChecked());
+}
+
+
+
+// ----
+// Init
+// ----
+/**
+ * @brief Initialization function for the node.js object wrapper. Stream
+ *        objects are only created through AESXOR256, so the constructor is
+ *        not exported.
+ *
+ * @param data module instance data
+ *
+ * @return void
+ */
+void AESXORStream::Init(v8::Local<v8::Object> data) {
+
+    Nan::HandleScope scope;
+
+    // Prepare constructor template.
+    v8::Local<v8::FunctionTemplate> tpl =
+        Nan::New<v8::FunctionTemplate>(New, data);
+    tpl->SetClassName(Nan::New("AESXORStream").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    // Prototype
+    Nan::SetPrototypeMethod(tpl, "update", update, data);
+    Nan::SetPrototypeMethod(tpl, "final", finish, data);
+
+    Binding::setConstructor(data, Binding::CLASS::AESXOR_STREAM,
+        Nan::GetFunction(tpl).ToLocalChecked());
+}
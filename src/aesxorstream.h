@@ -0,0 +1,357 @@
+/** @file aesxorstream.h
+ *  @brief Class header for native object wrapped in javascript object
+ *		   responsible for incremental AESXOR256 encryption and decryption
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef AESXORSTREAM_H
+#define AESXORSTREAM_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <memory>
+
+// ----------------------
+// node.js addon includes
+// ----------------------
+#include <node.h>
+#include <node_object_wrap.h>
+#include <nan.h>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "cryptlib.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "aesxor.h"
+
+// ------------
+// AESXORStream
+// ------------
+
+/*
+ * @class This class represents a C++ object performing AESXOR256 encryption
+ *		  or decryption incrementally, wrapped in a javascript object. It is
+ *		  created by AESXOR256 'createCipher'/'createDecipher' and draws its
+ *		  keystream from the creating object, in call order with that
+ *		  object's other calls.
+ *
+ * 		  The functions exposed to node.js are:
+ *		  function update(chunk) -> returns output
+ *		  function update(chunk, callback) -> processes the chunk off the
+ *		  event loop
+ *		  function final() -> returns the remaining output
+ */
+class AESXORStream : public Nan::ObjectWrap {
+
+	public:
+
+		// operation performed by the stream
+		enum class MODE:int {
+			ENCRYPT,
+			DECRYPT
+		};
+
+		// Status enum for different types of errors
+		enum class STATUS:int {
+			SUCCESS = 0,			// Success
+			CIPHER_ERROR = -1		// Error encrypting/decrypting a chunk
+		};
+
+	private:
+
+		// ----
+		// data
+		// ----
+
+		// operation performed by the stream
+		MODE _mode;
+		// object providing the keystream
+		AESXOR256* _parent;
+		// keeps the object providing the keystream alive
+		Nan::Persistent<v8::Object> _parentHandle;
+		// keyed GCM context carried across chunks
+		std::unique_ptr<CryptoPP::AuthenticatedSymmetricCipher> _gcm;
+		// last keystream value and number of its bytes already used
+		uint64_t _word;
+		unsigned int _used;
+		/* trailing cipher bytes held back while decrypting since they may
+		 * be the authentication tag
+		 */
+		uint8_t _held[16];
+		size_t _heldLength;
+		// whether an async update is in progress
+		bool _busy;
+		// whether 'final' has been called
+		bool _finished;
+
+
+		// ------
+		// Worker
+		// ------
+		/*
+		 * @class This class represents the node.js async worker processing
+		 *		  one chunk of the stream on the libuv thread pool and
+		 *		  invoking the given callback with the status of the
+		 *		  operation and the output.
+		 */
+		class Worker: public Nan::AsyncWorker {
+
+			private:
+				// ----
+				// data
+				// ----
+
+				// stream the chunk belongs to
+				AESXORStream* _stream;
+				// generator positioned at the chunk's keystream
+				XORShift128 _rng;
+				// input chunk, pinned for the lifetime of the worker
+				const uint8_t* _input;
+				// length of the input chunk
+				size_t _length;
+				// output buffer data, pinned for the lifetime of the worker
+				uint8_t* _output;
+
+			public:
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Initilizes and constructs internal data.
+				 *
+				 * @param callback callback to be invoked after async operation
+				 * @param stream stream the chunk belongs to
+				 * @param rng generator positioned at the chunk's keystream
+				 * @param input input chunk
+				 * @param length length of the input chunk
+				 * @param output output of 'outputLength(length)' bytes
+				 */
+				Worker(
+					Nan::Callback* callback,
+					AESXORStream* stream,
+					const XORShift128& rng,
+					const uint8_t* input,
+					size_t length,
+					uint8_t* output
+				);
+
+
+				// ----------------
+				// HandleOKCallback
+				// ----------------
+				/**
+				 * @brief Executed when the async work is complete without
+				 *		  error, invoking the given callback with the status
+				 *		  and output buffer as arguments.
+				 *
+				 * @return void
+				 */
+				void HandleOKCallback();
+
+
+				// -------------------
+				// HandleErrorCallback
+				// -------------------
+				/**
+				 * @brief Executed when the async work is complete with
+				 *		  error, invoking the given callback with the
+				 *		  corresponding error.
+				 *
+				 * @return void
+				 */
+				void HandleErrorCallback();
+
+
+				// -------
+				// Execute
+				// -------
+				/**
+				 * @brief Executed in a separate thread, processing the
+				 *		  chunk.
+				 *
+				 * @return void
+				 */
+				void Execute();
+		};
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Initializes an empty stream, set up by 'NewInstance'.
+		 */
+		AESXORStream();
+
+
+		// ----------
+		// Destructor
+		// ----------
+		/**
+		 * Destructor
+		 * @brief Releases the object providing the keystream.
+		 */
+		~AESXORStream();
+
+
+		// ------------
+		// outputLength
+		// ------------
+		/**
+		 * @brief Number of bytes 'process' outputs for an input chunk of the
+		 *		  given length.
+		 *
+		 * @param length length of the input chunk
+		 *
+		 * @return number of output bytes
+		 */
+		size_t outputLength(size_t length) const;
+
+
+		// -------
+		// process
+		// -------
+		/**
+		 * @brief Encrypts or decrypts the chunk, carrying the GCM state, the
+		 *		  keystream position and the held back bytes over to the
+		 *		  next chunk.
+		 *
+		 * @param rng generator providing the keystream
+		 * @param output output of 'outputLength(length)' bytes
+		 * @param input input chunk
+		 * @param length length of the input chunk
+		 *
+		 * @throw Cryptopp:Exception in case of encryption errors
+		 *
+		 * @return void
+		 */
+		void process(XORShift128& rng, uint8_t* output, const uint8_t* input,
+			size_t length);
+
+
+		// ---
+		// New
+		// ---
+		/**
+		 * @brief Creates the wrapped object. Only used by 'NewInstance'.
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(New);
+
+
+		// ------
+		// update
+		// ------
+		/**
+		 * @brief Encrypts or decrypts the next chunk.
+		 *
+		 * Invoked as:
+		 * 'let output = obj.update(chunk)' or
+		 * 'obj.update(chunk, function(status, output){})' where
+		 * 'chunk' is the buffer containing the next part of the input
+		 * 'status' is of the form:
+		 * {code: [statusCode], message: [statusMessage]}
+		 * 'output' is the buffer containing the corresponding output
+		 * The chunk must not be modified until the callback is invoked and
+		 * no other call may be made on the stream in the meantime.
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(update);
+
+
+		// -----
+		// final
+		// -----
+		/**
+		 * @brief Completes the stream. When encrypting the 16 byte
+		 *		  authentication tag is returned, when decrypting the tag is
+		 *		  verified and an error is thrown if it does not match.
+		 *		  Output returned by 'update' while decrypting must not be
+		 *		  trusted before 'final' succeeds.
+		 *
+		 * Invoked as:
+		 * 'let output = obj.final()'
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(finish);
+
+	public:
+
+		// -----------
+		// NewInstance
+		// -----------
+		/**
+		 * @brief Creates a stream object keyed with the given key.
+		 *
+		 * @param data module instance data holding the stream constructor
+		 * @param parent javascript object of the AESXOR256 object providing
+		 *		  the keystream
+		 * @param mode operation performed by the stream
+		 * @param key AES key of AESXOR256::AESNODE_DEFAULT_KEY_LENGTH_BYTES
+		 *		  bytes
+		 *
+		 * @throw Cryptopp:Exception in case of keying errors
+		 *
+		 * @return javascript stream object
+		 */
+		static v8::Local<v8::Object> NewInstance(v8::Local<v8::Value> data,
+			v8::Local<v8::Object> parent, MODE mode, const uint8_t* key);
+
+
+		// ----
+		// Init
+		// ----
+		/**
+		 * @brief Initialization function for the node.js object wrapper.
+		 *		  Stream objects are only created through AESXOR256, so the
+		 *		  constructor is not exported.
+		 *
+		 * @param data module instance data
+		 *
+		 * @return void
+		 */
+		static void Init(v8::Local<v8::Object> data);
+
+};
+
+#endif
@@ -0,0 +1,163 @@
+/** @file binding.cc
+ *  @brief Definition of the helpers shared by the node.js bindings
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------
+// library includes
+// ----------------
+#include "binding.h"
+
+
+// --------------
+// backingAddress
+// --------------
+/**
+ * @brief Returns the address of the memory of the array buffer.
+ *
+ * @param buffer javascript array buffer
+ *
+ * @return address of the first byte
+ */
+static uint8_t* backingAddress(v8::Local<v8::ArrayBuffer> buffer) {
+#if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >= 8
+    return static_cast<uint8_t*>(buffer->GetBackingStore()->Data());
+#else
+    return static_cast<uint8_t*>(buffer->GetContents().Data());
+#endif
+}
+
+
+// -------
+// newData
+// -------
+/**
+ * @brief Creates the data of a module instance, passed to the Init
+ *        function of each wrapped class.
+ *
+ * @return instance data
+ */
+v8::Local<v8::Object> Binding::newData() {
+    return Nan::New<v8::Array>(static_cast<int>(CLASS::COUNT));
+}
+
+
+// --------------
+// setConstructor
+// --------------
+/**
+ * @brief Records the constructor of the class in the instance data.
+ *
+ * @param data instance data
+ * @param type class of the constructor
+ * @param constructor javascript constructor function
+ *
+ * @return void
+ */
+void Binding::setConstructor(
+    v8::Local<v8::Object> data,
+    CLASS type,
+    v8::Local<v8::Function> constructor
+) {
+    Nan::Set(data, static_cast<uint32_t>(type), constructor);
+}
+
+
+// -----------
+// constructor
+// -----------
+/**
+ * @brief Returns the constructor of the class in the module instance the
+ *        callback data belongs to.
+ *
+ * @param data callback data ('info.Data()') of a bound function
+ * @param type class of the constructor
+ *
+ * @return javascript constructor function
+ */
+v8::Local<v8::Function> Binding::constructor(
+    v8::Local<v8::Value> data,
+    CLASS type
+) {
+    return Nan::Get(data.As<v8::Object>(), static_cast<uint32_t>(type))
+        .ToLocalChecked().As<v8::Function>();
+}
+
+
+// -------
+// isBytes
+// -------
+/**
+ * @brief Checks whether the value is a Buffer, TypedArray, DataView or
+ *        ArrayBuffer.
+ *
+ * @param value javascript value
+ *
+ * @return true if the bytes of the value can be read
+ */
+bool Binding::isBytes(v8::Local<v8::Value> value) {
+    return value->IsArrayBufferView() || value->IsArrayBuffer();
+}
+
+
+// ----
+// data
+// ----
+/**
+ * @brief Returns the address of the bytes viewed by the value.
+ *
+ * @param value value accepted by 'isBytes'
+ *
+ * @return address of the first byte
+ */
+uint8_t* Binding::data(v8::Local<v8::Value> value) {
+    if (value->IsArrayBufferView()) {
+        v8::Local<v8::ArrayBufferView> view = value.As<v8::ArrayBufferView>();
+        return backingAddress(view->Buffer()) + view->ByteOffset();
+    }
+
+    return backingAddress(value.As<v8::ArrayBuffer>());
+}
+
+
+// ------
+// length
+// ------
+/**
+ * @brief Returns the number of bytes viewed by the value.
+ *
+ * @param value value accepted by 'isBytes'
+ *
+ * @return number of bytes
+ */
+size_t Binding::length(v8::Local<v8::Value> value) {
+    if (value->IsArrayBufferView()) {
+        return value.As<v8::ArrayBufferView>()->ByteLength();
+    }
+
+    return value.As<v8::ArrayBuffer>()->ByteLength();
+}
@@ -0,0 +1,213 @@
+/** @file binding.h
+ *  @brief Class header for the helpers shared by the node.js bindings:
+ *		   per module instance data and byte views of javascript values
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BINDING_H
+#define BINDING_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// ----------------------
+// node.js addon includes
+// ----------------------
+#include <node.h>
+#include <nan.h>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "misc.h"
+
+
+// -------
+// Binding
+// -------
+
+/*
+ * @class Helpers shared by the wrapped classes so the addon can be loaded
+ *		  by several worker_threads of a process at once. Nothing refers to
+ *		  javascript objects from static storage: each module instance
+ *		  creates its own data array holding the class constructors, which
+ *		  is handed to every function template as callback data. Input
+ *		  bytes may be any Buffer, TypedArray, DataView or ArrayBuffer.
+ */
+class Binding {
+
+	public:
+
+		// Classes whose constructors are kept in the instance data
+		enum class CLASS {
+			AESXOR256,
+			AESXOR_STREAM,
+			RNG,
+			SEIFECC,
+			SEIFSHA3,
+			COUNT
+		};
+
+
+		// -------
+		// newData
+		// -------
+		/**
+		 * @brief Creates the data of a module instance, passed to the Init
+		 *		  function of each wrapped class.
+		 *
+		 * @return instance data
+		 */
+		static v8::Local<v8::Object> newData();
+
+
+		// --------------
+		// setConstructor
+		// --------------
+		/**
+		 * @brief Records the constructor of the class in the instance data.
+		 *
+		 * @param data instance data
+		 * @param type class of the constructor
+		 * @param constructor javascript constructor function
+		 *
+		 * @return void
+		 */
+		static void setConstructor(
+			v8::Local<v8::Object> data,
+			CLASS type,
+			v8::Local<v8::Function> constructor
+		);
+
+
+		// -----------
+		// constructor
+		// -----------
+		/**
+		 * @brief Returns the constructor of the class in the module instance
+		 *		  the callback data belongs to.
+		 *
+		 * @param data callback data ('info.Data()') of a bound function
+		 * @param type class of the constructor
+		 *
+		 * @return javascript constructor function
+		 */
+		static v8::Local<v8::Function> constructor(
+			v8::Local<v8::Value> data,
+			CLASS type
+		);
+
+
+		// -------
+		// isBytes
+		// -------
+		/**
+		 * @brief Checks whether the value is a Buffer, TypedArray, DataView
+		 *		  or ArrayBuffer.
+		 *
+		 * @param value javascript value
+		 *
+		 * @return true if the bytes of the value can be read
+		 */
+		static bool isBytes(v8::Local<v8::Value> value);
+
+
+		// ----
+		// data
+		// ----
+		/**
+		 * @brief Returns the address of the bytes viewed by the value.
+		 *
+		 * @param value value accepted by 'isBytes'
+		 *
+		 * @return address of the first byte
+		 */
+		static uint8_t* data(v8::Local<v8::Value> value);
+
+
+		// ------
+		// length
+		// ------
+		/**
+		 * @brief Returns the number of bytes viewed by the value.
+		 *
+		 * @param value value accepted by 'isBytes'
+		 *
+		 * @return number of bytes
+		 */
+		static size_t length(v8::Local<v8::Value> value);
+
+
+		// --------------
+		// externalBuffer
+		// --------------
+		/**
+		 * @brief Moves the container to the heap and returns a node.js
+		 *		  buffer over its bytes, released with the buffer. Output
+		 *		  in secure containers stays in the secure arena, and is
+		 *		  not copied, until the buffer is garbage collected. Bytes
+		 *		  kept inline by a short string are wiped on release too.
+		 *
+		 * @param container string or vector of bytes
+		 *
+		 * @return node.js buffer
+		 */
+		template <typename Container>
+		static v8::Local<v8::Object> externalBuffer(Container&& container) {
+			typedef typename std::decay<Container>::type Owned;
+
+			Owned* owned = new Owned(std::move(container));
+			return Nan::NewBuffer(
+				reinterpret_cast<char*>(&(*owned)[0]),
+				owned->size(),
+				[](char* data, void* hint) {
+					Owned* released = static_cast<Owned*>(hint);
+
+					// Small string buffers live inside the object itself.
+					const char* begin = reinterpret_cast<const char*>(released);
+					std::less<const char*> before;
+					if (!before(data, begin) &&
+						before(data, begin + sizeof(Owned))) {
+						CryptoPP::SecureWipeBuffer(
+							reinterpret_cast<uint8_t*>(data), released->size());
+					}
+
+					delete released;
+				},
+				owned
+			).ToLocalChecked();
+		}
+
+};
+
+#endif
@@ -0,0 +1,213 @@
+/** @file capabilities.cc
+ *  @brief Definition of the report of the CPU features and of the
+ *         accelerated kernels in use
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <cpuid.h>
+#define CAPABILITIES_CPUID 1
+#endif
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "config.h"
+#include "cpu.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "capabilities.h"
+#include "keccak.h"
+#include "keystream.h"
+
+
+// detected CPU features
+struct Features {
+    bool sse2;
+    bool ssse3;
+    bool sse4;
+    bool avx2;
+    bool aesni;
+    bool pclmul;
+    bool sha;
+    bool neon;
+};
+
+
+// --------------
+// detectFeatures
+// --------------
+/**
+ * @brief Detects the CPU features relevant to the kernels, using the
+ *        detection of Crypto++ where it has one.
+ *
+ * @return detected features
+ */
+static Features detectFeatures() {
+
+    Features features = Features();
+
+#if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64
+    features.sse2 = CryptoPP::HasSSE2();
+    features.ssse3 = CryptoPP::HasSSSE3();
+    features.sse4 = CryptoPP::HasSSE4();
+    features.aesni = CryptoPP::HasAESNI();
+    features.pclmul = CryptoPP::HasCLMUL();
+#endif
+
+#if defined(CAPABILITIES_CPUID)
+    // Crypto++ 5.6.5 detects neither AVX2 nor the SHA extensions.
+    features.avx2 = __builtin_cpu_supports("avx2");
+
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        features.sha = (ebx & (1u << 29)) != 0;
+    }
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    features.neon = true;
+#endif
+
+    return features;
+}
+
+
+// ------------
+// capabilities
+// ------------
+/**
+ * @brief Returns the detected CPU features, the selected kernels
+ *        and the build configuration.
+ *
+ * Invoked as:
+ * 'let caps = seifnode.capabilities()' where
+ * 'caps' is of the form:
+ * {cpu: {sse2, ssse3, sse4, avx2, aesni, pclmul, sha, neon},
+ *  kernels: {keystream: [avx2, sse2, neon or scalar],
+ *  keccak: [avx2x4 or scalar], aes: [aesni or table],
+ *  gcm: [pclmul or table]},
+ *  build: {optimized: [boolean], cryptopp: [version],
+ *  cryptoppAESNI: [boolean]}}
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(Capabilities::capabilities) {
+
+    static const Features features = detectFeatures();
+
+    /* Crypto++ only contains its AES-NI and carry-less multiplication
+     * (GCM) code when it was compiled with those instructions enabled, and
+     * then uses it when the CPU supports them. Its config macros describe
+     * this translation unit's flags rather than the library's, so the
+     * build records how libcryptopp was compiled, see binding.gyp.
+     */
+#if defined(SEIFNODE_CRYPTOPP_AESNI)
+    const bool cryptoppAESNI = true;
+#else
+    const bool cryptoppAESNI = false;
+#endif
+
+#if defined(SEIFNODE_OPTIMIZED)
+    const bool optimized = true;
+#else
+    const bool optimized = false;
+#endif
+
+    v8::Local<v8::Object> cpu = Nan::New<v8::Object>();
+    Nan::Set(cpu, Nan::New("sse2").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.sse2));
+    Nan::Set(cpu, Nan::New("ssse3").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.ssse3));
+    Nan::Set(cpu, Nan::New("sse4").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.sse4));
+    Nan::Set(cpu, Nan::New("avx2").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.avx2));
+    Nan::Set(cpu, Nan::New("aesni").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.aesni));
+    Nan::Set(cpu, Nan::New("pclmul").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.pclmul));
+    Nan::Set(cpu, Nan::New("sha").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.sha));
+    Nan::Set(cpu, Nan::New("neon").ToLocalChecked(),
+        Nan::New<v8::Boolean>(features.neon));
+
+    v8::Local<v8::Object> kernels = Nan::New<v8::Object>();
+    Nan::Set(kernels, Nan::New("keystream").ToLocalChecked(),
+        Nan::New(Keystream::kernelName()).ToLocalChecked());
+    Nan::Set(kernels, Nan::New("keccak").ToLocalChecked(),
+        Nan::New(Keccak::kernelName()).ToLocalChecked());
+    Nan::Set(kernels, Nan::New("aes").ToLocalChecked(),
+        Nan::New(cryptoppAESNI && features.aesni ?
+            "aesni" : "table").ToLocalChecked());
+    Nan::Set(kernels, Nan::New("gcm").ToLocalChecked(),
+        Nan::New(cryptoppAESNI && features.pclmul ?
+            "pclmul" : "table").ToLocalChecked());
+
+    v8::Local<v8::Object> build = Nan::New<v8::Object>();
+    Nan::Set(build, Nan::New("optimized").ToLocalChecked(),
+        Nan::New<v8::Boolean>(optimized));
+    Nan::Set(build, Nan::New("cryptopp").ToLocalChecked(),
+        Nan::New<v8::Number>(CRYPTOPP_VERSION));
+    Nan::Set(build, Nan::New("cryptoppAESNI").ToLocalChecked(),
+        Nan::New<v8::Boolean>(cryptoppAESNI));
+
+    v8::Local<v8::Object> result = Nan::New<v8::Object>();
+    Nan::Set(result, Nan::New("cpu").ToLocalChecked(), cpu);
+    Nan::Set(result, Nan::New("kernels").ToLocalChecked(), kernels);
+    Nan::Set(result, Nan::New("build").ToLocalChecked(), build);
+
+    info.GetReturnValue().Set(result);
+}
+
+
+// ----
+// Init
+// ----
+/**
+ * @brief Initialization function for the functions exported by the
+ *        addon.
+ *
+ * @param exports node.js module exports
+ *
+ * @return void
+ */
+void Capabilities::Init(v8::Local<v8::Object> exports) {
+
+    Nan::HandleScope scope;
+
+    // Setting node.js module.exports.
+    Nan::SetMethod(exports, "capabilities", capabilities);
+}
@@ -0,0 +1,98 @@
+/** @file capabilities.h
+ *  @brief Class header for the report of the CPU features and of the
+ *		   accelerated kernels in use, exposed to javascript
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CAPABILITIES_H
+#define CAPABILITIES_H
+
+// ----------------------
+// node.js addon includes
+// ----------------------
+#include <node.h>
+#include <nan.h>
+
+
+// ------------
+// Capabilities
+// ------------
+
+/*
+ * @class Reports which CPU features were detected and which kernel each
+ *		  accelerated primitive selected at runtime, along with how the
+ *		  addon and Crypto++ were built, so deployments can check that the
+ *		  fast paths are in use on every host.
+ *
+ *		  The functions exposed to node.js are:
+ *		  function capabilities() -> returns the features and kernels
+ */
+class Capabilities {
+
+	private:
+
+		// ------------
+		// capabilities
+		// ------------
+		/**
+		 * @brief Returns the detected CPU features, the selected kernels
+		 *		  and the build configuration.
+		 *
+		 * Invoked as:
+		 * 'let caps = seifnode.capabilities()' where
+		 * 'caps' is of the form:
+		 * {cpu: {sse2, ssse3, sse4, avx2, aesni, pclmul, sha, neon},
+		 *  kernels: {keystream: [avx2, sse2, neon or scalar],
+		 *  keccak: [avx2x4 or scalar], aes: [aesni or table],
+		 *  gcm: [pclmul or table]},
+		 *  build: {optimized: [boolean], cryptopp: [version],
+		 *  cryptoppAESNI: [boolean]}}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(capabilities);
+
+	public:
+
+		// ----
+		// Init
+		// ----
+		/**
+		 * @brief Initialization function for the functions exported by the
+		 * 		  addon.
+		 *
+		 * @param exports node.js module exports
+		 *
+		 * @return void
+		 */
+		static void Init(v8::Local<v8::Object> exports);
+
+};
+
+#endif
@@ -0,0 +1,247 @@
+/** @file fileutil.cc
+ *  @brief Definition of the class functions provided in fileutil.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ----------------
+// library includes
+// ----------------
+#include "fileutil.h"
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Opens the lock file, creating it if needed, and waits for an
+ *        exclusive lock on it. The lock belongs to the open file, so
+ *        two objects of the same process exclude each other as well.
+ *
+ * @param path path of the lock file
+ */
+FileUtil::Lock::Lock(const std::string& path) {
+#ifdef _WIN32
+    _handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    OVERLAPPED overlapped = {};
+    if (!LockFileEx(_handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD,
+            &overlapped)) {
+        CloseHandle(_handle);
+        _handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd < 0) {
+        return;
+    }
+
+    int locked;
+    while ((locked = flock(_fd, LOCK_EX)) != 0 && errno == EINTR) {
+    }
+    if (locked != 0) {
+        close(_fd);
+        _fd = -1;
+    }
+#endif
+}
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Releases the lock by closing the lock file.
+ */
+FileUtil::Lock::~Lock() {
+#ifdef _WIN32
+    if (_handle != INVALID_HANDLE_VALUE) {
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(_handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+        CloseHandle(_handle);
+    }
+#else
+    if (_fd >= 0) {
+        close(_fd);
+    }
+#endif
+}
+
+
+// ----
+// held
+// ----
+/**
+ * @brief Checks whether the lock was taken.
+ *
+ * @return boolean indicating whether the lock is held
+ */
+bool FileUtil::Lock::held() const {
+#ifdef _WIN32
+    return _handle != INVALID_HANDLE_VALUE;
+#else
+    return _fd >= 0;
+#endif
+}
+
+
+// ------
+// isFile
+// ------
+/**
+ * @brief Checks whether a regular file exists at the given path.
+ *
+ * @param path path of the file
+ *
+ * @return boolean indicating whether the file exists
+ */
+bool FileUtil::isFile(const std::string& path) {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES &&
+        (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
+#else
+    struct stat status;
+    return stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+#endif
+}
+
+
+// -----------
+// replaceFile
+// -----------
+/**
+ * @brief Moves the source file over the destination in one step.
+ *
+ * @param source path of the file to be moved
+ * @param destination path of the file to be replaced
+ *
+ * @return boolean indicating success
+ */
+bool FileUtil::replaceFile(const std::string& source,
+    const std::string& destination) {
+#ifdef _WIN32
+    return MoveFileExA(source.c_str(), destination.c_str(),
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(source.c_str(), destination.c_str()) == 0;
+#endif
+}
+
+
+// --------
+// syncFile
+// --------
+/**
+ * @brief Flushes the written file to the disk.
+ *
+ * @param path path of the file
+ * @param dataOnly whether flushing the data without the metadata
+ *        (fdatasync) is enough
+ *
+ * @return boolean indicating success
+ */
+bool FileUtil::syncFile(const std::string& path, bool dataOnly) {
+#ifdef _WIN32
+    (void)dataOnly;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool synced = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return synced;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+#if defined(__linux__)
+    bool synced = (dataOnly ? fdatasync(fd) : fsync(fd)) == 0;
+#else
+    (void)dataOnly;
+    bool synced = fsync(fd) == 0;
+#endif
+    close(fd);
+    return synced;
+#endif
+}
+
+
+// ----------
+// syncFolder
+// ----------
+/**
+ * @brief Flushes the entries of the folder containing the given file,
+ *        making a rename or removal in it durable. Folder entries are
+ *        not synced separately on Windows.
+ *
+ * @param path path of a file in the folder
+ *
+ * @return boolean indicating success
+ */
+bool FileUtil::syncFolder(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    size_t slash = path.find_last_of('/');
+    std::string folder = slash == std::string::npos ? "." :
+        path.substr(0, slash + 1);
+
+    int fd = open(folder.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#endif
+}
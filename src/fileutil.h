@@ -0,0 +1,173 @@
+/** @file fileutil.h
+ *  @brief Class header for the file helpers used to replace files on disk
+ *		   and make the changes durable
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FILEUTIL_H
+#define FILEUTIL_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <string>
+
+
+// --------
+// FileUtil
+// --------
+
+/*
+ * @class Helpers shared by the code rewriting files through a temporary or
+ *		  backup copy, so a crash leaves either the old or the new contents.
+ */
+class FileUtil {
+
+	public:
+
+		// ----
+		// Lock
+		// ----
+
+		/*
+		 * @class Exclusive advisory lock on a file, held until the object
+		 *		  is destroyed. The lock file is created if needed and left
+		 *		  in place, so writers in other processes and other objects
+		 *		  of this process using the same lock file wait for each
+		 *		  other.
+		 */
+		class Lock {
+
+			private:
+
+				// ----
+				// data
+				// ----
+#ifdef _WIN32
+				// handle of the locked file, INVALID_HANDLE_VALUE if not held
+				void* _handle;
+#else
+				// descriptor of the locked file, -1 if not held
+				int _fd;
+#endif
+
+			public:
+
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Opens the lock file and waits for the lock.
+				 * @param path path of the lock file
+				 */
+				explicit Lock(const std::string& path);
+
+
+				// ----------
+				// Destructor
+				// ----------
+				/**
+				 * Destructor
+				 * @brief Releases the lock.
+				 */
+				~Lock();
+
+
+				// ----
+				// held
+				// ----
+				/**
+				 * @brief Checks whether the lock was taken.
+				 * @return boolean indicating whether the lock is held
+				 */
+				bool held() const;
+
+				Lock(const Lock&) = delete;
+				Lock& operator=(const Lock&) = delete;
+		};
+
+		// ------
+		// isFile
+		// ------
+		/**
+		 * @brief Checks whether a regular file exists at the given path.
+		 *
+		 * @param path path of the file
+		 *
+		 * @return boolean indicating whether the file exists
+		 */
+		static bool isFile(const std::string& path);
+
+
+		// -----------
+		// replaceFile
+		// -----------
+		/**
+		 * @brief Moves the source file over the destination in one step.
+		 *
+		 * @param source path of the file to be moved
+		 * @param destination path of the file to be replaced
+		 *
+		 * @return boolean indicating success
+		 */
+		static bool replaceFile(const std::string& source,
+			const std::string& destination);
+
+
+		// --------
+		// syncFile
+		// --------
+		/**
+		 * @brief Flushes the written file to the disk.
+		 *
+		 * @param path path of the file
+		 * @param dataOnly whether flushing the data without the metadata
+		 *		  (fdatasync) is enough
+		 *
+		 * @return boolean indicating success
+		 */
+		static bool syncFile(const std::string& path, bool dataOnly);
+
+
+		// ----------
+		// syncFolder
+		// ----------
+		/**
+		 * @brief Flushes the entries of the folder containing the given
+		 *		  file, making a rename or removal in it durable. Folder
+		 *		  entries are not synced separately on Windows.
+		 *
+		 * @param path path of a file in the folder
+		 *
+		 * @return boolean indicating success
+		 */
+		static bool syncFolder(const std::string& path);
+
+};
+
+#endif
@@ -0,0 +1,561 @@
+/** @file keccak.cc
+ *  @brief Definition of the class functions provided in keccak.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define KECCAK_AVX2 1
+#endif
+
+// ----------------
+// library includes
+// ----------------
+#include "keccak.h"
+
+
+// size of the sponge state in bytes
+const size_t Keccak::STATE_BYTES;
+
+
+namespace {
+
+    // round constants
+    const uint64_t ROUND_CONSTANTS[24] = {
+        0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+        0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+        0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+        0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+        0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+        0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+        0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+        0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+    };
+
+    // rotation offsets in the order lanes are visited by the pi step
+    const unsigned int ROTATIONS[24] = {
+        1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+        27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+    };
+
+    // lanes visited by the pi step
+    const unsigned int PI_LANES[24] = {
+        10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+        15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+    };
+
+
+    // ----
+    // rotl
+    // ----
+    /**
+     * @brief Rotates the lane left by the given number of bits (1 to 63).
+     */
+    inline uint64_t rotl(uint64_t x, unsigned int n) {
+        return (x << n) | (x >> (64 - n));
+    }
+
+
+    // ------
+    // load64
+    // ------
+    /**
+     * @brief Reads a little endian lane.
+     */
+    inline uint64_t load64(const uint8_t* in) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) {
+            value = (value << 8) | in[i];
+        }
+        return value;
+    }
+
+
+    // -----------
+    // absorbBlock
+    // -----------
+    /**
+     * @brief XORs a full block of 'rate' bytes into the state.
+     */
+    inline void absorbBlock(uint64_t* state, const uint8_t* block,
+        size_t rate) {
+
+        for (size_t i = 0; i < rate / 8; ++i) {
+            state[i] ^= load64(block + 8 * i);
+        }
+    }
+
+
+    // -------
+    // squeeze
+    // -------
+    /**
+     * @brief Writes the first 'length' bytes of the state, little endian.
+     */
+    inline void squeeze(const uint64_t* state, uint8_t* output,
+        size_t length) {
+
+        for (size_t i = 0; i < length; ++i) {
+            output[i] = static_cast<uint8_t>(state[i / 8] >> (8 * (i % 8)));
+        }
+    }
+
+
+    // --------
+    // padBlock
+    // --------
+    /**
+     * @brief Builds the final padded block from the trailing partial block
+     *        of a message.
+     */
+    inline void padBlock(uint8_t* block, const uint8_t* tail, size_t length,
+        size_t rate, uint8_t suffix) {
+
+        std::memset(block, 0, rate);
+        if (length > 0) {
+            std::memcpy(block, tail, length);
+        }
+        block[length] ^= suffix;
+        block[rate - 1] ^= 0x80;
+    }
+
+
+    // ----------
+    // hashSingle
+    // ----------
+    /**
+     * @brief Hashes one message with the scalar permutation.
+     */
+    void hashSingle(size_t rate, uint8_t suffix, const uint8_t* message,
+        size_t messageLength, uint8_t* output, size_t length) {
+
+        Keccak sponge(rate, suffix);
+        sponge.update(message, messageLength);
+        sponge.finish(output, length);
+    }
+
+
+#if defined(KECCAK_AVX2)
+    // -----
+    // rotl4
+    // -----
+    /**
+     * @brief Rotates each of the four lanes left by the given number of bits.
+     */
+    __attribute__((target("avx2")))
+    inline __m256i rotl4(__m256i x, unsigned int n) {
+        return _mm256_or_si256(
+            _mm256_sll_epi64(x, _mm_cvtsi32_si128(n)),
+            _mm256_srl_epi64(x, _mm_cvtsi32_si128(64 - n))
+        );
+    }
+
+
+    // --------
+    // permute4
+    // --------
+    /**
+     * @brief Keccak-f[1600] on four interleaved states, the state of message
+     *        'j' being element 'j' of every lane.
+     */
+    __attribute__((target("avx2")))
+    void permute4(__m256i* a) {
+        __m256i c[5];
+        const __m256i ones = _mm256_set1_epi64x(-1);
+
+        for (int round = 0; round < 24; ++round) {
+            // theta
+            for (int x = 0; x < 5; ++x) {
+                c[x] = _mm256_xor_si256(
+                    _mm256_xor_si256(a[x], a[x + 5]),
+                    _mm256_xor_si256(
+                        _mm256_xor_si256(a[x + 10], a[x + 15]), a[x + 20]
+                    )
+                );
+            }
+            for (int x = 0; x < 5; ++x) {
+                const __m256i d = _mm256_xor_si256(c[(x + 4) % 5],
+                    rotl4(c[(x + 1) % 5], 1));
+                for (int y = 0; y < 25; y += 5) {
+                    a[y + x] = _mm256_xor_si256(a[y + x], d);
+                }
+            }
+
+            // rho and pi
+            __m256i t = a[1];
+            for (int i = 0; i < 24; ++i) {
+                const unsigned int j = PI_LANES[i];
+                const __m256i b = a[j];
+                a[j] = rotl4(t, ROTATIONS[i]);
+                t = b;
+            }
+
+            // chi
+            for (int y = 0; y < 25; y += 5) {
+                for (int x = 0; x < 5; ++x) {
+                    c[x] = a[y + x];
+                }
+                for (int x = 0; x < 5; ++x) {
+                    a[y + x] = _mm256_xor_si256(c[x], _mm256_and_si256(
+                        _mm256_xor_si256(c[(x + 1) % 5], ones),
+                        c[(x + 2) % 5]));
+                }
+            }
+
+            // iota
+            a[0] = _mm256_xor_si256(a[0],
+                _mm256_set1_epi64x((long long)ROUND_CONSTANTS[round]));
+        }
+    }
+
+
+    // -----
+    // hash4
+    // -----
+    /**
+     * @brief Hashes four messages spanning the same number of full blocks
+     *        with the interleaved permutation.
+     */
+    __attribute__((target("avx2")))
+    void hash4(size_t rate, uint8_t suffix, const uint8_t* const* messages,
+        const size_t* lengths, uint8_t* output, size_t length) {
+
+        __m256i a[25];
+        for (int i = 0; i < 25; ++i) {
+            a[i] = _mm256_setzero_si256();
+        }
+
+        const size_t words = rate / 8;
+        const size_t blocks = lengths[0] / rate;
+
+        // Absorb the full blocks four at a time.
+        for (size_t b = 0; b < blocks; ++b) {
+            const size_t offset = b * rate;
+            for (size_t w = 0; w < words; ++w) {
+                const size_t at = offset + 8 * w;
+                a[w] = _mm256_xor_si256(a[w], _mm256_set_epi64x(
+                    (long long)load64(messages[3] + at),
+                    (long long)load64(messages[2] + at),
+                    (long long)load64(messages[1] + at),
+                    (long long)load64(messages[0] + at)));
+            }
+            permute4(a);
+        }
+
+        // Absorb the padded trailing blocks.
+        uint8_t padded[4][Keccak::STATE_BYTES];
+        for (int j = 0; j < 4; ++j) {
+            const size_t tail = lengths[j] - blocks * rate;
+            padBlock(padded[j], messages[j] + blocks * rate, tail, rate,
+                suffix);
+        }
+        for (size_t w = 0; w < words; ++w) {
+            a[w] = _mm256_xor_si256(a[w], _mm256_set_epi64x(
+                (long long)load64(padded[3] + 8 * w),
+                (long long)load64(padded[2] + 8 * w),
+                (long long)load64(padded[1] + 8 * w),
+                (long long)load64(padded[0] + 8 * w)));
+        }
+        permute4(a);
+
+        // Squeeze 'length' bytes out of every state.
+        uint64_t lanes[25][4];
+        for (size_t done = 0; done < length; done += rate) {
+            for (size_t w = 0; w < words; ++w) {
+                _mm256_storeu_si256((__m256i*)lanes[w], a[w]);
+            }
+
+            const size_t n = std::min(rate, length - done);
+            for (int j = 0; j < 4; ++j) {
+                uint64_t state[25];
+                for (size_t w = 0; w < words; ++w) {
+                    state[w] = lanes[w][j];
+                }
+                squeeze(state, output + j * length + done, n);
+            }
+
+            if (done + rate < length) {
+                permute4(a);
+            }
+        }
+    }
+#endif
+
+
+    // -------
+    // hasAVX2
+    // -------
+    /**
+     * @brief Whether the 4-way kernel can be used, checked on first use.
+     */
+    bool hasAVX2() {
+#if defined(KECCAK_AVX2)
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+}
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initializes an empty sponge.
+ *
+ * @param rate number of bytes absorbed per permutation, a multiple
+ *        of 8 below STATE_BYTES
+ * @param suffix domain separation suffix, 0x06 for SHA3 and 0x1F for
+ *        SHAKE
+ */
+Keccak::Keccak(size_t rate, uint8_t suffix): _rate(rate), _suffix(suffix) {
+    restart();
+}
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Wipes the sponge state.
+ */
+Keccak::~Keccak() {
+    volatile uint64_t* wipe = _state;
+    for (int i = 0; i < 25; ++i) {
+        wipe[i] = 0;
+    }
+}
+
+
+// -------
+// restart
+// -------
+/**
+ * @brief Resets the sponge, discarding absorbed data.
+ *
+ * @return void
+ */
+void Keccak::restart() {
+    std::memset(_state, 0, sizeof(_state));
+    _position = 0;
+}
+
+
+// ------
+// update
+// ------
+/**
+ * @brief Absorbs the data into the sponge.
+ *
+ * @param data data to be hashed
+ * @param length length of the data
+ *
+ * @return void
+ */
+void Keccak::update(const uint8_t* data, size_t length) {
+
+    // Complete a partially absorbed block byte by byte.
+    while (_position != 0 && length > 0) {
+        _state[_position / 8] ^= uint64_t(*data++) << (8 * (_position % 8));
+        --length;
+        if (++_position == _rate) {
+            permute(_state);
+            _position = 0;
+        }
+    }
+
+    // Absorb full blocks a lane at a time.
+    while (length >= _rate) {
+        absorbBlock(_state, data, _rate);
+        permute(_state);
+        data += _rate;
+        length -= _rate;
+    }
+
+    for (; length > 0; --length) {
+        _state[_position / 8] ^= uint64_t(*data++) << (8 * (_position % 8));
+        ++_position;
+    }
+}
+
+
+// ------
+// finish
+// ------
+/**
+ * @brief Pads the absorbed data, squeezes the requested number of
+ *        bytes out of the sponge and resets it.
+ *
+ * @param output container of 'length' bytes
+ * @param length number of output bytes
+ *
+ * @return void
+ */
+void Keccak::finish(uint8_t* output, size_t length) {
+
+    _state[_position / 8] ^= uint64_t(_suffix) << (8 * (_position % 8));
+    _state[(_rate - 1) / 8] ^= uint64_t(0x80) << (8 * ((_rate - 1) % 8));
+    permute(_state);
+
+    while (length > 0) {
+        const size_t n = std::min(_rate, length);
+        squeeze(_state, output, n);
+        output += n;
+        length -= n;
+        if (length > 0) {
+            permute(_state);
+        }
+    }
+
+    restart();
+}
+
+
+// --------
+// hashMany
+// --------
+/**
+ * @brief Hashes each message independently, writing the digests one
+ *        after the other. Messages spanning the same number of
+ *        blocks are hashed four at a time when AVX2 is available.
+ *
+ * @param rate number of bytes absorbed per permutation
+ * @param suffix domain separation suffix
+ * @param messages pointers to the messages
+ * @param lengths lengths of the messages
+ * @param count number of messages
+ * @param output container of 'count * length' bytes
+ * @param length number of output bytes per message
+ *
+ * @return void
+ */
+void Keccak::hashMany(size_t rate, uint8_t suffix,
+    const uint8_t* const* messages, const size_t* lengths, size_t count,
+    uint8_t* output, size_t length) {
+
+    size_t i = 0;
+
+#if defined(KECCAK_AVX2)
+    if (hasAVX2()) {
+        while (i + 4 <= count) {
+            const size_t blocks = lengths[i] / rate;
+            if (lengths[i + 1] / rate == blocks &&
+                lengths[i + 2] / rate == blocks &&
+                lengths[i + 3] / rate == blocks) {
+
+                hash4(rate, suffix, messages + i, lengths + i,
+                    output + i * length, length);
+                i += 4;
+                continue;
+            }
+
+            hashSingle(rate, suffix, messages[i], lengths[i],
+                output + i * length, length);
+            ++i;
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        hashSingle(rate, suffix, messages[i], lengths[i],
+            output + i * length, length);
+    }
+}
+
+
+// -------
+// permute
+// -------
+/**
+ * @brief Applies the Keccak-f[1600] permutation to the state.
+ *
+ * @param state 25 lane state
+ *
+ * @return void
+ */
+void Keccak::permute(uint64_t state[25]) {
+    uint64_t c[5];
+
+    for (int round = 0; round < 24; ++round) {
+        // theta
+        for (int x = 0; x < 5; ++x) {
+            c[x] = state[x] ^ state[x + 5] ^ state[x + 10] ^ state[x + 15] ^
+                state[x + 20];
+        }
+        for (int x = 0; x < 5; ++x) {
+            const uint64_t d = c[(x + 4) % 5] ^ rotl(c[(x + 1) % 5], 1);
+            for (int y = 0; y < 25; y += 5) {
+                state[y + x] ^= d;
+            }
+        }
+
+        // rho and pi
+        uint64_t t = state[1];
+        for (int i = 0; i < 24; ++i) {
+            const unsigned int j = PI_LANES[i];
+            const uint64_t b = state[j];
+            state[j] = rotl(t, ROTATIONS[i]);
+            t = b;
+        }
+
+        // chi
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; ++x) {
+                c[x] = state[y + x];
+            }
+            for (int x = 0; x < 5; ++x) {
+                state[y + x] = c[x] ^ (~c[(x + 1) % 5] & c[(x + 2) % 5]);
+            }
+        }
+
+        // iota
+        state[0] ^= ROUND_CONSTANTS[round];
+    }
+}
+
+
+// ----------
+// kernelName
+// ----------
+/**
+ * @brief Name of the batch kernel selected for this CPU.
+ *
+ * @return "avx2x4" or "scalar"
+ */
+const char* Keccak::kernelName() {
+    return hasAVX2() ? "avx2x4" : "scalar";
+}
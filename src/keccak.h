@@ -0,0 +1,188 @@
+/** @file keccak.h
+ *  @brief Class header for the Keccak sponge used by SEIFSHA3 for batched
+ *		   hashing, with a 4-way AVX2 permutation hashing four messages at
+ *		   once
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef KECCAK_H
+#define KECCAK_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstddef>
+#include <cstdint>
+
+
+// ------
+// Keccak
+// ------
+
+/*
+ * @class Keccak-f[1600] sponge (FIPS 202) with a configurable rate and domain
+ *		  separation suffix, e.g. a rate of 136 bytes and suffix 0x06 give
+ *		  SHA3-256. Besides incremental hashing it hashes batches of
+ *		  messages, four at a time with an interleaved AVX2 permutation when
+ *		  the CPU supports it (scalar otherwise).
+ */
+class Keccak {
+
+	private:
+
+		// ----
+		// data
+		// ----
+		// sponge state
+		uint64_t _state[25];
+		// number of bytes absorbed or squeezed per permutation
+		size_t _rate;
+		// domain separation suffix including the first padding bit
+		uint8_t _suffix;
+		// offset into the current block
+		size_t _position;
+
+	public:
+
+		// size of the sponge state in bytes
+		static const size_t STATE_BYTES = 200;
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Initializes an empty sponge.
+		 *
+		 * @param rate number of bytes absorbed per permutation, a multiple
+		 *		  of 8 below STATE_BYTES
+		 * @param suffix domain separation suffix, 0x06 for SHA3 and 0x1F for
+		 *		  SHAKE
+		 */
+		Keccak(size_t rate, uint8_t suffix);
+
+
+		// ----------
+		// Destructor
+		// ----------
+		/**
+		 * Destructor
+		 * @brief Wipes the sponge state.
+		 */
+		~Keccak();
+
+
+		// -------
+		// restart
+		// -------
+		/**
+		 * @brief Resets the sponge, discarding absorbed data.
+		 *
+		 * @return void
+		 */
+		void restart();
+
+
+		// ------
+		// update
+		// ------
+		/**
+		 * @brief Absorbs the data into the sponge.
+		 *
+		 * @param data data to be hashed
+		 * @param length length of the data
+		 *
+		 * @return void
+		 */
+		void update(const uint8_t* data, size_t length);
+
+
+		// ------
+		// finish
+		// ------
+		/**
+		 * @brief Pads the absorbed data, squeezes the requested number of
+		 *		  bytes out of the sponge and resets it.
+		 *
+		 * @param output container of 'length' bytes
+		 * @param length number of output bytes
+		 *
+		 * @return void
+		 */
+		void finish(uint8_t* output, size_t length);
+
+
+		// --------
+		// hashMany
+		// --------
+		/**
+		 * @brief Hashes each message independently, writing the digests one
+		 *		  after the other. Messages spanning the same number of
+		 *		  blocks are hashed four at a time when AVX2 is available.
+		 *
+		 * @param rate number of bytes absorbed per permutation
+		 * @param suffix domain separation suffix
+		 * @param messages pointers to the messages
+		 * @param lengths lengths of the messages
+		 * @param count number of messages
+		 * @param output container of 'count * length' bytes
+		 * @param length number of output bytes per message
+		 *
+		 * @return void
+		 */
+		static void hashMany(size_t rate, uint8_t suffix,
+			const uint8_t* const* messages, const size_t* lengths,
+			size_t count, uint8_t* output, size_t length);
+
+
+		// -------
+		// permute
+		// -------
+		/**
+		 * @brief Applies the Keccak-f[1600] permutation to the state.
+		 *
+		 * @param state 25 lane state
+		 *
+		 * @return void
+		 */
+		static void permute(uint64_t state[25]);
+
+
+		// ----------
+		// kernelName
+		// ----------
+		/**
+		 * @brief Name of the batch kernel selected for this CPU.
+		 *
+		 * @return "avx2x4" or "scalar"
+		 */
+		static const char* kernelName();
+
+};
+
+#endif
@@ -0,0 +1,262 @@
+/** @file keypool.cc
+ *  @brief Definition of the pool of pregenerated and validated ECIES key
+ *         pairs
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+
+// ----------------
+// library includes
+// ----------------
+#include <isaacRandomPool.h>
+
+#include "keypool.h"
+
+
+namespace {
+    // Maximum entropy multiplier tried while seeding the RNG.
+    const int MAX_ENTROPY_GEN_MULTIPLIER = 6;
+}
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Starts the thread filling the pool.
+ *
+ * @param curve curve of the generated pairs
+ * @param fileId file identifier of the rng state on disk
+ * @param depth maximum number of pregenerated pairs
+ * @param rate maximum number of pairs generated per second, 0 for no limit
+ * @param seedMutex lock held while the rng is seeded, shared with other
+ *        users of the state file; it must outlive the thread
+ */
+KeyPool::KeyPool(
+    const CryptoPP::OID& curve,
+    const std::string& fileId,
+    size_t depth,
+    unsigned int rate,
+    std::mutex& seedMutex
+): _curve(curve),
+_depth(depth),
+_shared(std::make_shared<Shared>()) {
+
+    std::chrono::microseconds interval(rate == 0 ? 0 : 1000000 / rate);
+
+    // The thread keeps its own reference to the shared state.
+    std::thread(&KeyPool::run, _shared, curve, fileId, depth, interval,
+        &seedMutex).detach();
+}
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Asks the thread to stop without waiting for it; the remaining
+ *        pairs are wiped once the thread has exited.
+ */
+KeyPool::~KeyPool() {
+    {
+        std::lock_guard<std::mutex> lock(_shared->mutex);
+        _shared->stopping = true;
+    }
+    _shared->wake.notify_all();
+}
+
+
+// ---
+// run
+// ---
+/**
+ * @brief Body of the background thread: seeds the rng, then keeps the pool
+ *        filled until the pool is destroyed or the rng fails.
+ *
+ * @param shared state shared with the pool object
+ * @param curve curve of the generated pairs
+ * @param fileId file identifier of the rng state on disk
+ * @param depth maximum number of pregenerated pairs
+ * @param interval minimum time between two generated pairs
+ * @param seedMutex lock held while the rng is seeded
+ *
+ * @return void
+ */
+void KeyPool::run(
+    std::shared_ptr<Shared> shared,
+    CryptoPP::OID curve,
+    std::string fileId,
+    size_t depth,
+    std::chrono::microseconds interval,
+    std::mutex* seedMutex
+) {
+
+    IsaacRandomPool prng;
+
+    /* Seed the RNG once, collecting more entropy data on each retry the
+     * same way keys generated on demand do.
+     */
+    int multiplier = 0;
+    bool seeded = false;
+    try {
+        std::lock_guard<std::mutex> lock(*seedMutex);
+
+        for (; multiplier < MAX_ENTROPY_GEN_MULTIPLIER; ++multiplier) {
+            if (prng.Initialize(fileId, multiplier)) {
+                seeded = true;
+                break;
+            }
+        }
+    } catch (const std::exception&) {
+        seeded = false;
+    }
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+
+    // Without enough entropy the pool stays empty.
+    if (!seeded) {
+        shared->state = FAILED;
+        return;
+    }
+
+    shared->retries = multiplier;
+    shared->strength = prng.EntropyStrength();
+    shared->state = READY;
+
+    std::chrono::steady_clock::time_point next =
+        std::chrono::steady_clock::now();
+
+    for (;;) {
+        shared->wake.wait(lock, [&shared, depth]() {
+            return shared->stopping || shared->pairs.size() < depth;
+        });
+
+        // Honour the refill rate, waking early only to stop.
+        if (shared->wake.wait_until(lock, next,
+                [&shared]() { return shared->stopping; })) {
+            return;
+        }
+
+        lock.unlock();
+
+        std::unique_ptr<KeyPair> pair;
+        try {
+            pair.reset(new KeyPair(prng, curve));
+            pair->decryptor.GetPrivateKey().ThrowIfInvalid(prng, 3);
+            pair->encryptor.GetPublicKey().ThrowIfInvalid(prng, 3);
+        } catch (...) {
+            pair.reset();
+        }
+        next = std::chrono::steady_clock::now() + interval;
+
+        lock.lock();
+
+        // A pair failing validation is a fault of the RNG, stop using it.
+        if (!pair) {
+            shared->state = FAILED;
+            return;
+        }
+
+        shared->pairs.push_back(std::move(pair));
+        ++shared->generated;
+    }
+}
+
+
+// -----
+// curve
+// -----
+/**
+ * @brief Returns the curve of the generated pairs.
+ *
+ * @return curve object identifier
+ */
+const CryptoPP::OID& KeyPool::curve() const {
+    return _curve;
+}
+
+
+// ----
+// take
+// ----
+/**
+ * @brief Removes the oldest pregenerated pair from the pool and wakes the
+ *        thread to replace it.
+ *
+ * @param retries set to the number of entropy gathering retries of the rng
+ *        which generated the pair
+ * @param strength set to the entropy strength of that rng
+ *
+ * @return validated pair or null if the pool is empty
+ */
+std::unique_ptr<KeyPool::KeyPair> KeyPool::take(unsigned int& retries,
+    std::string& strength) {
+
+    std::unique_ptr<KeyPair> pair;
+    {
+        std::lock_guard<std::mutex> lock(_shared->mutex);
+
+        if (_shared->pairs.empty()) {
+            ++_shared->misses;
+            return pair;
+        }
+
+        pair = std::move(_shared->pairs.front());
+        _shared->pairs.pop_front();
+        ++_shared->taken;
+
+        retries = _shared->retries;
+        strength = _shared->strength;
+    }
+    _shared->wake.notify_all();
+
+    return pair;
+}
+
+
+// -----
+// stats
+// -----
+/**
+ * @brief Returns the counters of the pool.
+ *
+ * @return counters
+ */
+KeyPool::Stats KeyPool::stats() {
+    std::lock_guard<std::mutex> lock(_shared->mutex);
+
+    Stats stats;
+    stats.depth = _depth;
+    stats.available = _shared->pairs.size();
+    stats.generated = _shared->generated;
+    stats.taken = _shared->taken;
+    stats.misses = _shared->misses;
+    stats.state = _shared->state;
+    return stats;
+}
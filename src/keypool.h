@@ -0,0 +1,255 @@
+/** @file keypool.h
+ *  @brief Class header for the pool of pregenerated and validated ECIES
+ *		   key pairs
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef KEYPOOL_H
+#define KEYPOOL_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "asn.h"
+#include "eccrypto.h"
+
+
+// -------
+// KeyPool
+// -------
+
+/*
+ * @class Pool of ECIES key pairs on one curve, generated and validated ahead
+ *		  of time by a background thread so that generating keys for a new
+ *		  tenant only has to save them. The thread seeds one isaac RNG from
+ *		  the folder's state file when the pool is created and keeps using it
+ *		  for every pair, refilling the pool up to its depth whenever pairs
+ *		  are taken, at most 'rate' pairs per second. If the RNG cannot be
+ *		  seeded, or a pair fails validation, the pool is marked as failed
+ *		  and keys are generated on demand. The thread is detached and
+ *		  shares the pool state with the object, so destroying the pool
+ *		  never waits for a seeding or a pair in progress.
+ */
+class KeyPool {
+
+	public:
+
+		typedef CryptoPP::ECIES<CryptoPP::ECP>::Encryptor Encryptor;
+		typedef CryptoPP::ECIES<CryptoPP::ECP>::Decryptor Decryptor;
+
+		// Validated private key and the corresponding public key
+		struct KeyPair {
+			Decryptor decryptor;
+			Encryptor encryptor;
+
+			KeyPair(CryptoPP::RandomNumberGenerator& rng,
+				const CryptoPP::OID& curve):
+			decryptor(rng, curve), encryptor(decryptor) {}
+		};
+
+		// State of the background thread
+		enum STATE {
+			// seeding the rng
+			SEEDING,
+			// generating pairs
+			READY,
+			// stopped after the rng could not be seeded or produced an
+			// invalid pair
+			FAILED
+		};
+
+		// Counters of the pool
+		struct Stats {
+			// maximum number of pregenerated pairs
+			size_t depth;
+			// pairs ready to be taken
+			size_t available;
+			// pairs generated and validated since the pool was created
+			uint64_t generated;
+			// pairs handed out by 'take'
+			uint64_t taken;
+			// calls to 'take' which found the pool empty
+			uint64_t misses;
+			// state of the background thread
+			STATE state;
+		};
+
+	private:
+
+		// State shared by the object and the detached thread
+		struct Shared {
+			// guards the fields below
+			std::mutex mutex;
+			// woken when a pair is taken or the pool is stopped
+			std::condition_variable wake;
+			// validated pairs, oldest first
+			std::deque<std::unique_ptr<KeyPair> > pairs;
+			// number of entropy gathering retries needed to seed the rng
+			unsigned int retries;
+			// entropy strength of the rng
+			std::string strength;
+			// whether the destructor asked the thread to stop
+			bool stopping;
+			// state of the thread
+			STATE state;
+			// counters reported by 'stats'
+			uint64_t generated;
+			uint64_t taken;
+			uint64_t misses;
+
+			Shared(): retries(0), stopping(false), state(SEEDING),
+			generated(0), taken(0), misses(0) {}
+		};
+
+		// ----
+		// data
+		// ----
+		// curve of the generated pairs
+		const CryptoPP::OID _curve;
+		// maximum number of pregenerated pairs
+		const size_t _depth;
+		// state kept alive by the thread until it exits
+		const std::shared_ptr<Shared> _shared;
+
+
+		// ---
+		// run
+		// ---
+		/**
+		 * @brief Body of the background thread: seeds the rng, then keeps
+		 *		  the pool filled until the pool is destroyed or the rng
+		 *		  fails.
+		 *
+		 * @param shared state shared with the pool object
+		 * @param curve curve of the generated pairs
+		 * @param fileId file identifier of the rng state on disk
+		 * @param depth maximum number of pregenerated pairs
+		 * @param interval minimum time between two generated pairs
+		 * @param seedMutex lock held while the rng is seeded
+		 *
+		 * @return void
+		 */
+		static void run(
+			std::shared_ptr<Shared> shared,
+			CryptoPP::OID curve,
+			std::string fileId,
+			size_t depth,
+			std::chrono::microseconds interval,
+			std::mutex* seedMutex
+		);
+
+	public:
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Starts the thread filling the pool.
+		 *
+		 * @param curve curve of the generated pairs
+		 * @param fileId file identifier of the rng state on disk
+		 * @param depth maximum number of pregenerated pairs
+		 * @param rate maximum number of pairs generated per second, 0 for
+		 *		  no limit
+		 * @param seedMutex lock held while the rng is seeded, shared with
+		 *		  other users of the state file; it must outlive the thread
+		 */
+		KeyPool(
+			const CryptoPP::OID& curve,
+			const std::string& fileId,
+			size_t depth,
+			unsigned int rate,
+			std::mutex& seedMutex
+		);
+
+
+		// ----------
+		// Destructor
+		// ----------
+		/**
+		 * Destructor
+		 * @brief Asks the thread to stop without waiting for it; the
+		 *		  remaining pairs are wiped once the thread has exited.
+		 */
+		~KeyPool();
+
+
+		// -----
+		// curve
+		// -----
+		/**
+		 * @brief Returns the curve of the generated pairs.
+		 *
+		 * @return curve object identifier
+		 */
+		const CryptoPP::OID& curve() const;
+
+
+		// ----
+		// take
+		// ----
+		/**
+		 * @brief Removes the oldest pregenerated pair from the pool and
+		 *		  wakes the thread to replace it.
+		 *
+		 * @param retries set to the number of entropy gathering retries
+		 *		  of the rng which generated the pair
+		 * @param strength set to the entropy strength of that rng
+		 *
+		 * @return validated pair or null if the pool is empty
+		 */
+		std::unique_ptr<KeyPair> take(unsigned int& retries,
+			std::string& strength);
+
+
+		// -----
+		// stats
+		// -----
+		/**
+		 * @brief Returns the counters of the pool.
+		 *
+		 * @return counters
+		 */
+		Stats stats();
+
+};
+
+#endif
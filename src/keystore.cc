@@ -0,0 +1,953 @@
+/** @file keystore.cc
+ *  @brief Definition of the class functions provided in keystore.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "aes.h"
+#include "gcm.h"
+#include "misc.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "fileutil.h"
+#include "keccak.h"
+#include "keystore.h"
+#include "threadrng.h"
+
+
+namespace {
+    // identifies keystore files, followed by the format version
+    const uint8_t MAGIC[8] = {'S', 'E', 'I', 'F', 'K', 'S', 0, 1};
+
+    /* Header: magic, number of slots (a power of two), number of records and
+     * a check value of the disk access key, followed by the slots. Each slot
+     * holds the tag of the name, the offset and the length of the sealed
+     * record; a length of 0 marks a free slot. Integers are little endian.
+     */
+    const size_t HEADER_BYTES = 32;
+    const size_t HEADER_CHECK = 16;
+    const size_t SLOT_BYTES = 32;
+    const size_t SLOT_OFFSET = Keystore::TAG_BYTES;
+    const size_t SLOT_LENGTH = Keystore::TAG_BYTES + 8;
+    // minimum number of slots, at most half of the slots are used
+    const uint32_t MIN_SLOTS = 16;
+
+    // sealed record: nonce, encrypted record and GCM authentication tag
+    const size_t NONCE_BYTES = 12;
+    const size_t MAC_BYTES = 16;
+    const size_t KEY_BYTES = 32;
+
+    // SHA3-256 sponge parameters
+    const size_t SHA3_256_RATE = 136;
+    const uint8_t SHA3_SUFFIX = 0x06;
+
+
+    // ----------
+    // loadLittle
+    // ----------
+    /**
+     * @brief Reads a little endian integer of the given number of bytes.
+     *
+     * @param data bytes of the integer
+     * @param bytes number of bytes, at most 8
+     *
+     * @return integer value
+     */
+    uint64_t loadLittle(const uint8_t* data, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = bytes; i > 0; --i) {
+            value = (value << 8) | data[i - 1];
+        }
+        return value;
+    }
+
+
+    // -----------
+    // storeLittle
+    // -----------
+    /**
+     * @brief Writes a little endian integer of the given number of bytes.
+     *
+     * @param data container of 'bytes' bytes
+     * @param value integer value
+     * @param bytes number of bytes, at most 8
+     *
+     * @return void
+     */
+    void storeLittle(uint8_t* data, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            data[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+
+    // ---------
+    // deriveKey
+    // ---------
+    /**
+     * @brief Derives a key from the disk access key for the given use.
+     *
+     * @param label name of the use of the key
+     * @param key disk access key
+     *
+     * @return derived key of KEY_BYTES bytes
+     */
+    std::vector<uint8_t> deriveKey(const char* label,
+        const std::vector<uint8_t>& key) {
+
+        std::vector<uint8_t> derived(KEY_BYTES);
+
+        Keccak sponge(SHA3_256_RATE, SHA3_SUFFIX);
+        sponge.update((const uint8_t*)label, std::strlen(label) + 1);
+        sponge.update(key.data(), key.size());
+        sponge.finish(derived.data(), derived.size());
+
+        return derived;
+    }
+
+
+    // ------
+    // FileId
+    // ------
+    // identity of a file, changing when the file is replaced or modified
+    struct FileId {
+        uint64_t device;
+        uint64_t inode;
+        uint64_t size;
+        uint64_t time;
+
+        bool operator==(const FileId& other) const {
+            return device == other.device && inode == other.inode &&
+                size == other.size && time == other.time;
+        }
+    };
+
+
+#ifdef _WIN32
+    // --------
+    // identify
+    // --------
+    /**
+     * @brief Reads the identity of the open file.
+     *
+     * @param file open file handle
+     * @param id set to the identity of the file
+     *
+     * @return boolean indicating success
+     */
+    bool identify(HANDLE file, FileId& id) {
+        BY_HANDLE_FILE_INFORMATION information;
+        if (!GetFileInformationByHandle(file, &information)) {
+            return false;
+        }
+
+        id.device = information.dwVolumeSerialNumber;
+        id.inode = (uint64_t(information.nFileIndexHigh) << 32) |
+            information.nFileIndexLow;
+        id.size = (uint64_t(information.nFileSizeHigh) << 32) |
+            information.nFileSizeLow;
+        id.time = (uint64_t(information.ftLastWriteTime.dwHighDateTime) << 32)
+            | information.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+
+
+    // --------
+    // openFile
+    // --------
+    /**
+     * @brief Opens the file for reading, allowing it to be replaced while
+     *        open.
+     *
+     * @param path path of the file
+     *
+     * @return file handle or INVALID_HANDLE_VALUE
+     */
+    HANDLE openFile(const std::string& path) {
+        return CreateFileA(path.c_str(), GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    }
+#else
+    // --------
+    // identify
+    // --------
+    /**
+     * @brief Converts the file status to the identity of the file.
+     *
+     * @param status file status
+     * @param id set to the identity of the file
+     *
+     * @return void
+     */
+    void identify(const struct stat& status, FileId& id) {
+        id.device = status.st_dev;
+        id.inode = status.st_ino;
+        id.size = status.st_size;
+        id.time = status.st_mtime;
+    }
+#endif
+
+
+    // --------
+    // identify
+    // --------
+    /**
+     * @brief Reads the identity of the file at the given path.
+     *
+     * @param path path of the file
+     * @param id set to the identity of the file
+     *
+     * @return boolean indicating whether the file exists
+     */
+    bool identify(const std::string& path, FileId& id) {
+#ifdef _WIN32
+        HANDLE file = openFile(path);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        bool found = identify(file, id);
+        CloseHandle(file);
+        return found;
+#else
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) {
+            return false;
+        }
+        identify(status, id);
+        return true;
+#endif
+    }
+
+
+    // -------------
+    // temporaryPath
+    // -------------
+    /**
+     * @brief Returns a path next to the given file that no other writer
+     *        uses, for writing the new contents before they replace it.
+     *
+     * @param path path of the file to be replaced
+     *
+     * @return path of the temporary file
+     */
+    std::string temporaryPath(const std::string& path) {
+        static const char digits[] = "0123456789abcdef";
+
+        uint8_t suffix[8];
+        ThreadRandomPool::instance().GenerateBlock(suffix, sizeof(suffix));
+
+        std::string temporary = path + ".tmp.";
+        for (size_t i = 0; i < sizeof(suffix); ++i) {
+            temporary += digits[suffix[i] >> 4];
+            temporary += digits[suffix[i] & 0x0f];
+        }
+        return temporary;
+    }
+
+
+    // guards 'stores'
+    std::mutex storesMutex;
+    /* stores in use keyed by the path followed by the check value of their
+     * disk access key, released along with their derived keys once unused
+     */
+    std::map<std::string, std::weak_ptr<Keystore> > stores;
+}
+
+
+// number of bytes of a slot tag
+const size_t Keystore::TAG_BYTES;
+
+
+
+// -------
+// Mapping
+// -------
+/*
+ * @class Read only mapping of a keystore file, unmapped when the last
+ *        reader releases it.
+ */
+class Keystore::Mapping {
+
+    private:
+
+        // ----
+        // data
+        // ----
+        // mapped file contents
+        const uint8_t* _data;
+        // number of mapped bytes
+        size_t _size;
+        // identity of the mapped file
+        FileId _id;
+#ifdef _WIN32
+        // file mapping object
+        HANDLE _handle;
+#endif
+
+        // -----------
+        // Constructor
+        // -----------
+        /**
+         * Constructor
+         * @brief Initializes an empty mapping, set up by 'open'.
+         */
+        Mapping(): _data(nullptr), _size(0) {
+#ifdef _WIN32
+            _handle = NULL;
+#endif
+        }
+
+    public:
+
+        // ----------
+        // Destructor
+        // ----------
+        /**
+         * Destructor
+         * @brief Unmaps the file.
+         */
+        ~Mapping() {
+#ifdef _WIN32
+            if (_data != nullptr) {
+                UnmapViewOfFile(_data);
+            }
+            if (_handle != NULL) {
+                CloseHandle(_handle);
+            }
+#else
+            if (_data != nullptr) {
+                munmap(const_cast<uint8_t*>(_data), _size);
+            }
+#endif
+        }
+
+
+        // ----
+        // open
+        // ----
+        /**
+         * @brief Maps the keystore file and checks its header.
+         *
+         * @param path path of the keystore file
+         * @param status set to the error on failure
+         *
+         * @return mapping or null on failure
+         */
+        static std::shared_ptr<const Mapping> open(const std::string& path,
+            STATUS& status) {
+
+            std::shared_ptr<Mapping> mapping(new Mapping());
+            status = STATUS::IO_ERROR;
+
+#ifdef _WIN32
+            HANDLE file = openFile(path);
+            if (file == INVALID_HANDLE_VALUE) {
+                status = STATUS::NOT_FOUND;
+                return nullptr;
+            }
+
+            if (identify(file, mapping->_id) && mapping->_id.size > 0) {
+                mapping->_handle = CreateFileMappingA(file, NULL,
+                    PAGE_READONLY, 0, 0, NULL);
+            }
+            CloseHandle(file);
+
+            if (mapping->_handle == NULL) {
+                return nullptr;
+            }
+
+            mapping->_data = (const uint8_t*)MapViewOfFile(mapping->_handle,
+                FILE_MAP_READ, 0, 0, 0);
+            if (mapping->_data == nullptr) {
+                return nullptr;
+            }
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                status = STATUS::NOT_FOUND;
+                return nullptr;
+            }
+
+            struct stat fileStatus;
+            void* data = MAP_FAILED;
+            if (fstat(fd, &fileStatus) == 0 && fileStatus.st_size > 0) {
+                identify(fileStatus, mapping->_id);
+                data = mmap(nullptr, fileStatus.st_size, PROT_READ,
+                    MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+
+            if (data == MAP_FAILED) {
+                return nullptr;
+            }
+
+            mapping->_data = (const uint8_t*)data;
+#endif
+            mapping->_size = mapping->_id.size;
+
+            // Check the magic and that the slots lie within the file.
+            const uint64_t slots = mapping->slotCount();
+            if (mapping->_size < HEADER_BYTES ||
+                std::memcmp(mapping->_data, MAGIC, sizeof(MAGIC)) != 0 ||
+                slots == 0 || (slots & (slots - 1)) != 0 ||
+                slots > (mapping->_size - HEADER_BYTES) / SLOT_BYTES) {
+
+                status = STATUS::FORMAT_ERROR;
+                return nullptr;
+            }
+
+            status = STATUS::SUCCESS;
+            return mapping;
+        }
+
+
+        // --
+        // id
+        // --
+        /**
+         * @brief Identity of the mapped file.
+         *
+         * @return file identity
+         */
+        const FileId& id() const {
+            return _id;
+        }
+
+
+        // -----
+        // check
+        // -----
+        /**
+         * @brief Check value of the disk access key the file was written
+         *        with.
+         *
+         * @return check value of TAG_BYTES bytes
+         */
+        const uint8_t* check() const {
+            return _data + HEADER_CHECK;
+        }
+
+
+        // ---------
+        // slotCount
+        // ---------
+        /**
+         * @brief Number of slots of the hash table.
+         *
+         * @return number of slots
+         */
+        uint32_t slotCount() const {
+            return _size < HEADER_BYTES ? 0 :
+                static_cast<uint32_t>(loadLittle(_data + 8, 4));
+        }
+
+
+        // -----------
+        // recordCount
+        // -----------
+        /**
+         * @brief Number of records in the file.
+         *
+         * @return number of records
+         */
+        uint32_t recordCount() const {
+            return static_cast<uint32_t>(loadLittle(_data + 12, 4));
+        }
+
+
+        // ----
+        // slot
+        // ----
+        /**
+         * @brief Returns the slot with the given index.
+         *
+         * @param index slot index, less than 'slotCount()'
+         *
+         * @return slot bytes
+         */
+        const uint8_t* slot(uint32_t index) const {
+            return _data + HEADER_BYTES + size_t(index) * SLOT_BYTES;
+        }
+
+
+        // ------
+        // sealed
+        // ------
+        /**
+         * @brief Locates the sealed record referenced by the slot.
+         *
+         * @param slot slot bytes
+         * @param length set to the length of the sealed record
+         *
+         * @return sealed record or null if the slot is free or out of
+         *         bounds
+         */
+        const uint8_t* sealed(const uint8_t* slot, size_t& length) const {
+            const uint64_t offset = loadLittle(slot + SLOT_OFFSET, 8);
+            length = static_cast<size_t>(loadLittle(slot + SLOT_LENGTH, 4));
+
+            if (length < NONCE_BYTES + MAC_BYTES || offset > _size ||
+                length > _size - offset) {
+                return nullptr;
+            }
+            return _data + offset;
+        }
+
+
+        // ----
+        // find
+        // ----
+        /**
+         * @brief Probes the hash table for the slot with the given tag.
+         *
+         * @param tag tag of TAG_BYTES bytes
+         *
+         * @return slot bytes or null if not present
+         */
+        const uint8_t* find(const uint8_t* tag) const {
+            const uint32_t mask = slotCount() - 1;
+
+            uint32_t index = static_cast<uint32_t>(loadLittle(tag, 4)) & mask;
+            for (uint32_t probe = 0; probe <= mask; ++probe) {
+                const uint8_t* entry = slot(index);
+
+                if (loadLittle(entry + SLOT_LENGTH, 4) == 0) {
+                    return nullptr;
+                }
+                if (std::memcmp(entry, tag, TAG_BYTES) == 0) {
+                    return entry;
+                }
+                index = (index + 1) & mask;
+            }
+            return nullptr;
+        }
+};
+
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Derives the keys of the store. The file is not accessed until
+ *        the first lookup or update.
+ *
+ * @param path path of the keystore file
+ * @param key disk access key
+ */
+Keystore::Keystore(
+    const std::string& path,
+    const std::vector<uint8_t>& key
+): _path(path),
+_indexKey(deriveKey("seifnode keystore index", key)),
+_recordKey(deriveKey("seifnode keystore record", key)),
+_check(deriveKey("seifnode keystore check", key)) {
+
+    _check.resize(TAG_BYTES);
+}
+
+
+
+// -------
+// forFile
+// -------
+/**
+ * @brief Returns the store of the given file for the given disk access
+ *        key, creating it if no object of the process uses it any more.
+ *
+ * @param path path of the keystore file
+ * @param key disk access key
+ *
+ * @return store shared by all users of the file and key
+ */
+std::shared_ptr<Keystore> Keystore::forFile(const std::string& path,
+    const std::vector<uint8_t>& key) {
+
+    std::vector<uint8_t> check = deriveKey("seifnode keystore check", key);
+    std::string name = path;
+    name.push_back('\0');
+    name.append(check.begin(), check.begin() + TAG_BYTES);
+
+    std::lock_guard<std::mutex> lock(storesMutex);
+
+    // Forget the stores nobody uses any more.
+    for (auto it = stores.begin(); it != stores.end();) {
+        it = it->second.expired() ? stores.erase(it) : std::next(it);
+    }
+
+    std::shared_ptr<Keystore> store = stores[name].lock();
+    if (!store) {
+        store.reset(new Keystore(path, key));
+        stores[name] = store;
+    }
+    return store;
+}
+
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Wipes the derived keys.
+ */
+Keystore::~Keystore() {
+    CryptoPP::SecureWipeBuffer(_indexKey.data(), _indexKey.size());
+    CryptoPP::SecureWipeBuffer(_recordKey.data(), _recordKey.size());
+}
+
+
+
+// ---
+// tag
+// ---
+/**
+ * @brief Computes the slot tag of the given name.
+ *
+ * @param name record name
+ * @param tag container of TAG_BYTES bytes
+ *
+ * @return void
+ */
+void Keystore::tag(const std::string& name, uint8_t* tag) const {
+    Keccak sponge(SHA3_256_RATE, SHA3_SUFFIX);
+    sponge.update(_indexKey.data(), _indexKey.size());
+    sponge.update((const uint8_t*)name.data(), name.size());
+    sponge.finish(tag, TAG_BYTES);
+}
+
+
+
+// -------
+// mapping
+// -------
+/**
+ * @brief Returns the current mapping, mapping the file again if it was
+ *        replaced since it was last mapped. Checking costs one stat of
+ *        the file. Must be called with the mutex held.
+ *
+ * @param status set to the error when the file cannot be mapped
+ *
+ * @return mapping or null if the file does not exist or is invalid
+ */
+std::shared_ptr<const Keystore::Mapping> Keystore::mapping(STATUS& status) {
+    status = STATUS::SUCCESS;
+
+    FileId id;
+    if (!identify(_path, id)) {
+        _mapping.reset();
+        status = STATUS::NOT_FOUND;
+        return _mapping;
+    }
+
+    if (!_mapping || !(_mapping->id() == id)) {
+        _mapping = Mapping::open(_path, status);
+    }
+
+    return _mapping;
+}
+
+
+
+// ---
+// get
+// ---
+/**
+ * @brief Looks up and decrypts the record with the given name.
+ *
+ * @param name record name
+ * @param record set to the decrypted record
+ *
+ * @return status code indicating success or cause of error
+ */
+Keystore::STATUS Keystore::get(const std::string& name, std::string& record) {
+
+    uint8_t nameTag[TAG_BYTES];
+    tag(name, nameTag);
+
+    /* Check whether the file was replaced, e.g. by another object, before
+     * probing the table so updates are seen right away.
+     */
+    std::shared_ptr<const Mapping> current;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        STATUS status;
+        current = mapping(status);
+        if (!current) {
+            return status;
+        }
+    }
+
+    // Files written with another disk access key cannot be read.
+    if (std::memcmp(current->check(), _check.data(), TAG_BYTES) != 0) {
+        return STATUS::DECRYPTION_ERROR;
+    }
+
+    const uint8_t* slot = current->find(nameTag);
+    if (slot == nullptr) {
+        return STATUS::NOT_FOUND;
+    }
+
+    size_t length;
+    const uint8_t* sealed = current->sealed(slot, length);
+    if (sealed == nullptr) {
+        return STATUS::FORMAT_ERROR;
+    }
+
+    // The record is authenticated along with the tag of its name.
+    const size_t recordLength = length - NONCE_BYTES - MAC_BYTES;
+    std::vector<uint8_t> plain(recordLength);
+
+    try {
+        CryptoPP::GCM<CryptoPP::AES>::Decryption gcm;
+        gcm.SetKeyWithIV(_recordKey.data(), _recordKey.size(), sealed,
+            NONCE_BYTES);
+
+        if (!gcm.DecryptAndVerify(plain.data(),
+                sealed + NONCE_BYTES + recordLength, MAC_BYTES,
+                sealed, NONCE_BYTES, nameTag, TAG_BYTES,
+                sealed + NONCE_BYTES, recordLength)) {
+            CryptoPP::SecureWipeBuffer(plain.data(), plain.size());
+            return STATUS::DECRYPTION_ERROR;
+        }
+    } catch (const CryptoPP::Exception&) {
+        return STATUS::DECRYPTION_ERROR;
+    }
+
+    record.assign(plain.begin(), plain.end());
+    CryptoPP::SecureWipeBuffer(plain.data(), plain.size());
+
+    return STATUS::SUCCESS;
+}
+
+
+
+// ---
+// put
+// ---
+/**
+ * @brief Adds or replaces the record with the given name. The other
+ *        records are carried over still sealed into a new file,
+ *        which is synced to the disk before it replaces the old one.
+ *
+ * @param name record name
+ * @param record record to be sealed and stored
+ *
+ * @return status code indicating success or cause of error, the file is
+ *         left untouched if it was written with another key
+ */
+Keystore::STATUS Keystore::put(const std::string& name,
+    const std::string& record) {
+
+    if (record.size() > UINT32_MAX - NONCE_BYTES - MAC_BYTES) {
+        return STATUS::IO_ERROR;
+    }
+
+    // A sealed record along with the tag of its name.
+    struct Entry {
+        std::array<uint8_t, TAG_BYTES> tag;
+        const uint8_t* sealed;
+        size_t length;
+    };
+
+    Entry added;
+    tag(name, added.tag.data());
+
+    // Seal the new record under a fresh nonce.
+    std::vector<uint8_t> sealed(NONCE_BYTES + record.size() + MAC_BYTES);
+    ThreadRandomPool::instance().GenerateBlock(sealed.data(), NONCE_BYTES);
+
+    CryptoPP::GCM<CryptoPP::AES>::Encryption gcm;
+    gcm.SetKeyWithIV(_recordKey.data(), _recordKey.size(), sealed.data(),
+        NONCE_BYTES);
+    gcm.EncryptAndAuthenticate(sealed.data() + NONCE_BYTES,
+        sealed.data() + NONCE_BYTES + record.size(), MAC_BYTES,
+        sealed.data(), NONCE_BYTES, added.tag.data(), TAG_BYTES,
+        (const uint8_t*)record.data(), record.size());
+
+    added.sealed = sealed.data();
+    added.length = sealed.size();
+
+    /* Keep other writers, in this or another process, from replacing the
+     * file between reading the records and renaming the new file over it.
+     */
+    FileUtil::Lock fileLock(_path + ".lock");
+    if (!fileLock.held()) {
+        return STATUS::IO_ERROR;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Carry over the records of the current file, except the replaced one.
+    STATUS status;
+    std::shared_ptr<const Mapping> current = mapping(status);
+    if (!current && status != STATUS::NOT_FOUND) {
+        return status;
+    }
+
+    // Records sealed with another disk access key must not be mixed in.
+    if (current &&
+        std::memcmp(current->check(), _check.data(), TAG_BYTES) != 0) {
+        return STATUS::DECRYPTION_ERROR;
+    }
+
+    std::vector<Entry> entries;
+    if (current) {
+        /* Each record takes one slot and the slots were checked to lie
+         * within the file, so a corrupt record count cannot inflate this.
+         */
+        entries.reserve(size_t(std::min(current->recordCount(),
+            current->slotCount())) + 1);
+
+        for (uint32_t i = 0; i < current->slotCount(); ++i) {
+            const uint8_t* slot = current->slot(i);
+
+            Entry entry;
+            entry.sealed = current->sealed(slot, entry.length);
+            if (entry.sealed == nullptr ||
+                std::memcmp(slot, added.tag.data(), TAG_BYTES) == 0) {
+                continue;
+            }
+            std::copy(slot, slot + TAG_BYTES, entry.tag.begin());
+            entries.push_back(entry);
+        }
+    }
+    entries.push_back(added);
+
+    // Build the hash table, keeping it at most half full.
+    uint32_t slots = MIN_SLOTS;
+    while (slots < 2 * entries.size()) {
+        slots <<= 1;
+    }
+
+    std::vector<uint8_t> table(HEADER_BYTES + size_t(slots) * SLOT_BYTES);
+    std::copy(MAGIC, MAGIC + sizeof(MAGIC), table.begin());
+    storeLittle(&table[8], slots, 4);
+    storeLittle(&table[12], entries.size(), 4);
+    std::copy(_check.begin(), _check.end(), &table[HEADER_CHECK]);
+
+    uint64_t offset = table.size();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        uint32_t index =
+            static_cast<uint32_t>(loadLittle(entries[i].tag.data(), 4)) &
+            (slots - 1);
+
+        uint8_t* slot;
+        while (loadLittle((slot = &table[HEADER_BYTES + size_t(index) *
+                SLOT_BYTES]) + SLOT_LENGTH, 4) != 0) {
+            index = (index + 1) & (slots - 1);
+        }
+
+        std::copy(entries[i].tag.begin(), entries[i].tag.end(), slot);
+        storeLittle(slot + SLOT_OFFSET, offset, 8);
+        storeLittle(slot + SLOT_LENGTH, entries[i].length, 4);
+        offset += entries[i].length;
+    }
+
+    // Write the new file next to the old one and move it into place.
+    const std::string temporary = temporaryPath(_path);
+    {
+        std::ofstream file(temporary.c_str(),
+            std::ios::binary | std::ios::trunc);
+
+        file.write((const char*)table.data(), table.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            file.write((const char*)entries[i].sealed, entries[i].length);
+        }
+
+        file.close();
+
+        // The new file must be on the disk before it replaces the old one.
+        if (!file || !FileUtil::syncFile(temporary, false)) {
+            std::remove(temporary.c_str());
+            return STATUS::IO_ERROR;
+        }
+    }
+
+    // Release the old mapping first since it may block the replacement.
+    current.reset();
+    _mapping.reset();
+
+    if (!FileUtil::replaceFile(temporary, _path)) {
+        std::remove(temporary.c_str());
+        return STATUS::IO_ERROR;
+    }
+
+    // Make the rename itself durable.
+    if (!FileUtil::syncFolder(_path)) {
+        return STATUS::IO_ERROR;
+    }
+
+    return STATUS::SUCCESS;
+}
+
+
+
+// ----
+// size
+// ----
+/**
+ * @brief Number of records in the store.
+ *
+ * @return number of records, 0 if the file does not exist
+ */
+size_t Keystore::size() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    STATUS status;
+    std::shared_ptr<const Mapping> current = mapping(status);
+
+    return current ? current->recordCount() : 0;
+}
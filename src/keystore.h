@@ -0,0 +1,222 @@
+/** @file keystore.h
+ *  @brief Class header for the single file, memory-mapped and encrypted
+ *		   store of named key pairs used by SEIFECC
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// --------
+// Keystore
+// --------
+
+/*
+ * @class Store of named records (encoded key pairs) kept in one file. The
+ *		  file starts with an open addressing hash table of fixed size
+ *		  slots followed by the records, each sealed with AES-256-GCM under
+ *		  a key derived from the disk access key. Names are never stored,
+ *		  only a keyed SHA3-256 tag of the name which addresses the slot and
+ *		  is authenticated along with the record. The header carries a
+ *		  check value of the disk access key so a wrong key is reported
+ *		  instead of every name appearing to be missing.
+ *
+ *		  The file is memory-mapped on first use, so opening the store does
+ *		  not depend on the number of records and a lookup touches one slot
+ *		  run and one record. Updates rewrite the file next to the old one
+ *		  and rename it into place; mappings held by concurrent readers stay
+ *		  valid. Updates hold an advisory lock on a '.lock' file next to
+ *		  the store while they re-read, merge and replace it, so writers in
+ *		  other processes or objects never drop each other's records. The
+ *		  objects of a process are shared per file and disk access key.
+ */
+class Keystore {
+
+	public:
+
+		// Status enum for different types of errors
+		enum class STATUS:int {
+			SUCCESS = 0,			// Success
+			NOT_FOUND = -1,			// No record with the given name
+			DECRYPTION_ERROR = -2,	// Wrong key or record failed authentication
+			FORMAT_ERROR = -3,		// File is not a valid keystore
+			IO_ERROR = -4			// File could not be opened or written
+		};
+
+	private:
+
+		// read only mapping of the keystore file
+		class Mapping;
+
+		// ----
+		// data
+		// ----
+		// path of the keystore file
+		std::string _path;
+		// key deriving the slot tags of names
+		std::vector<uint8_t> _indexKey;
+		// key sealing the records
+		std::vector<uint8_t> _recordKey;
+		// value identifying the disk access key in the file header
+		std::vector<uint8_t> _check;
+		// current mapping of the file, null until first use
+		std::shared_ptr<const Mapping> _mapping;
+		// guards '_mapping' and serializes updates
+		std::mutex _mutex;
+
+
+		// ---
+		// tag
+		// ---
+		/**
+		 * @brief Computes the slot tag of the given name.
+		 *
+		 * @param name record name
+		 * @param tag container of TAG_BYTES bytes
+		 *
+		 * @return void
+		 */
+		void tag(const std::string& name, uint8_t* tag) const;
+
+
+		// -------
+		// mapping
+		// -------
+		/**
+		 * @brief Returns the current mapping, mapping the file again if it
+		 *		  was replaced since it was last mapped.
+		 *
+		 * @param status set to the error when the file cannot be mapped
+		 *
+		 * @return mapping or null if the file does not exist or is invalid
+		 */
+		std::shared_ptr<const Mapping> mapping(STATUS& status);
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Derives the keys of the store. The file is not accessed
+		 *		  until the first lookup or update.
+		 *
+		 * @param path path of the keystore file
+		 * @param key disk access key
+		 */
+		Keystore(const std::string& path, const std::vector<uint8_t>& key);
+
+	public:
+
+		// number of bytes of a slot tag
+		static const size_t TAG_BYTES = 16;
+
+
+		// -------
+		// forFile
+		// -------
+		/**
+		 * @brief Returns the store of the given file for the given disk
+		 *		  access key, creating it if no object of the process uses
+		 *		  it any more.
+		 *
+		 * @param path path of the keystore file
+		 * @param key disk access key
+		 *
+		 * @return store shared by all users of the file and key
+		 */
+		static std::shared_ptr<Keystore> forFile(const std::string& path,
+			const std::vector<uint8_t>& key);
+
+
+		// ----------
+		// Destructor
+		// ----------
+		/**
+		 * Destructor
+		 * @brief Wipes the derived keys.
+		 */
+		~Keystore();
+
+
+		// ---
+		// get
+		// ---
+		/**
+		 * @brief Looks up and decrypts the record with the given name.
+		 *
+		 * @param name record name
+		 * @param record set to the decrypted record
+		 *
+		 * @return status code indicating success or cause of error
+		 */
+		STATUS get(const std::string& name, std::string& record);
+
+
+		// ---
+		// put
+		// ---
+		/**
+		 * @brief Adds or replaces the record with the given name. The other
+		 *		  records are carried over still sealed into a new file,
+		 *		  which is synced to the disk before it replaces the old one.
+		 *		  The file is re-read under the lock file, so records added
+		 *		  by other writers in the meantime are kept.
+		 *
+		 * @param name record name
+		 * @param record record to be sealed and stored
+		 *
+		 * @return status code indicating success or cause of error, the
+		 *		   file is left untouched if it was written with another key
+		 */
+		STATUS put(const std::string& name, const std::string& record);
+
+
+		// ----
+		// size
+		// ----
+		/**
+		 * @brief Number of records in the store.
+		 *
+		 * @return number of records, 0 if the file does not exist
+		 */
+		size_t size();
+
+};
+
+#endif
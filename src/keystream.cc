@@ -0,0 +1,301 @@
+/** @file keystream.cc
+ *  @brief Definition of the class functions provided in keystream.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <immintrin.h>
+#define KEYSTREAM_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define KEYSTREAM_NEON 1
+#endif
+
+// ----------------
+// library includes
+// ----------------
+#include "keystream.h"
+
+
+// number of values generated per block
+const size_t Keystream::BLOCK_WORDS;
+
+
+namespace {
+
+    // signature of the XOR kernels
+    typedef void (*XorKernel)(uint8_t*, const uint8_t*, size_t);
+
+    // selected kernel along with its name
+    struct Kernel {
+        XorKernel function;
+        const char* name;
+    };
+
+
+    // ---------
+    // xorScalar
+    // ---------
+    /**
+     * @brief Portable kernel XORing 8 bytes at a time.
+     */
+    void xorScalar(uint8_t* data, const uint8_t* keystream, size_t length) {
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            uint64_t d, k;
+            std::memcpy(&d, data + i, 8);
+            std::memcpy(&k, keystream + i, 8);
+            d ^= k;
+            std::memcpy(data + i, &d, 8);
+        }
+        for (; i < length; ++i) {
+            data[i] ^= keystream[i];
+        }
+    }
+
+
+#if defined(KEYSTREAM_X86) && (defined(__SSE2__) || defined(_M_X64))
+#define KEYSTREAM_SSE2 1
+    // -------
+    // xorSSE2
+    // -------
+    /**
+     * @brief SSE2 kernel XORing 16 bytes at a time.
+     */
+    void xorSSE2(uint8_t* data, const uint8_t* keystream, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i k = _mm_loadu_si128((const __m128i*)(keystream + i));
+            _mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(d, k));
+        }
+        xorScalar(data + i, keystream + i, length - i);
+    }
+#endif
+
+
+#if defined(KEYSTREAM_X86) && defined(__GNUC__)
+#define KEYSTREAM_AVX2 1
+    // -------
+    // xorAVX2
+    // -------
+    /**
+     * @brief AVX2 kernel XORing 32 bytes at a time. Compiled for AVX2 on
+     *        its own so the rest of the module does not require it.
+     */
+    __attribute__((target("avx2")))
+    void xorAVX2(uint8_t* data, const uint8_t* keystream, size_t length) {
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i k = _mm256_loadu_si256((const __m256i*)(keystream + i));
+            _mm256_storeu_si256((__m256i*)(data + i), _mm256_xor_si256(d, k));
+        }
+        xorScalar(data + i, keystream + i, length - i);
+    }
+#endif
+
+
+#if defined(KEYSTREAM_NEON)
+    // -------
+    // xorNEON
+    // -------
+    /**
+     * @brief NEON kernel XORing 16 bytes at a time.
+     */
+    void xorNEON(uint8_t* data, const uint8_t* keystream, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            uint8x16_t d = vld1q_u8(data + i);
+            uint8x16_t k = vld1q_u8(keystream + i);
+            vst1q_u8(data + i, veorq_u8(d, k));
+        }
+        xorScalar(data + i, keystream + i, length - i);
+    }
+#endif
+
+
+    // ------------
+    // selectKernel
+    // ------------
+    /**
+     * @brief Picks the widest kernel supported by the CPU.
+     */
+    Kernel selectKernel() {
+#if defined(KEYSTREAM_AVX2)
+        if (__builtin_cpu_supports("avx2")) {
+            return Kernel{xorAVX2, "avx2"};
+        }
+#endif
+#if defined(KEYSTREAM_SSE2)
+        return Kernel{xorSSE2, "sse2"};
+#elif defined(KEYSTREAM_NEON)
+        return Kernel{xorNEON, "neon"};
+#else
+        return Kernel{xorScalar, "scalar"};
+#endif
+    }
+
+
+    // ------
+    // kernel
+    // ------
+    /**
+     * @brief Kernel selected on first use.
+     */
+    const Kernel& kernel() {
+        static const Kernel selected = selectKernel();
+        return selected;
+    }
+
+
+    // ------------
+    // littleEndian
+    // ------------
+    /**
+     * @brief Whether values can be stored with their native byte order.
+     */
+    bool littleEndian() {
+        const uint16_t probe = 1;
+        uint8_t first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+}
+
+
+// --------
+// generate
+// --------
+/**
+ * @brief Writes the given number of values from the generator into the
+ *        output in little endian byte order.
+ *
+ * @param rng xorshift random number generator
+ * @param output container of 8 * words bytes
+ * @param words number of values
+ *
+ * @return void
+ */
+void Keystream::generate(XORShift128& rng, uint8_t* output, size_t words) {
+
+    static const bool native = littleEndian();
+
+    if (native) {
+        for (size_t i = 0; i < words; ++i) {
+            const uint64_t value = rng();
+            std::memcpy(output + 8 * i, &value, 8);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < words; ++i) {
+        const uint64_t value = rng();
+        for (int j = 0; j < 8; ++j) {
+            output[8 * i + j] = static_cast<uint8_t>(value >> (8 * j));
+        }
+    }
+}
+
+
+// --------
+// xorBytes
+// --------
+/**
+ * @brief XORs the keystream bytes into the data in place using the
+ *        selected kernel.
+ *
+ * @param data bytes to be XOR'd
+ * @param keystream keystream bytes
+ * @param length number of bytes
+ *
+ * @return void
+ */
+void Keystream::xorBytes(uint8_t* data, const uint8_t* keystream,
+    size_t length) {
+
+    kernel().function(data, keystream, length);
+}
+
+
+// --------
+// xorWords
+// --------
+/**
+ * @brief XORs the data in place with the given number of whole values from
+ *        the generator, block by block.
+ *
+ * @param rng xorshift random number generator
+ * @param data container of 8 * words bytes
+ * @param words number of values
+ *
+ * @return void
+ */
+void Keystream::xorWords(XORShift128& rng, uint8_t* data, size_t words) {
+
+    // Block of keystream kept on the stack and wiped afterwards.
+    uint8_t block[BLOCK_WORDS * 8];
+
+    const XorKernel function = kernel().function;
+
+    while (words > 0) {
+        const size_t n = std::min(words, BLOCK_WORDS);
+
+        generate(rng, block, n);
+        function(data, block, n * 8);
+
+        data += n * 8;
+        words -= n;
+    }
+
+    volatile uint8_t* wipe = block;
+    for (size_t i = 0; i < sizeof(block); ++i) {
+        wipe[i] = 0;
+    }
+}
+
+
+// ----------
+// kernelName
+// ----------
+/**
+ * @brief Name of the XOR kernel selected for this CPU.
+ *
+ * @return one of "avx2", "sse2", "neon" or "scalar"
+ */
+const char* Keystream::kernelName() {
+    return kernel().name;
+}
@@ -0,0 +1,128 @@
+/** @file keystream.h
+ *  @brief Class header for the bulk XORShift128 keystream generator and
+ *		   the vectorized XOR kernels used by AESXOR256
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstddef>
+#include <cstdint>
+
+// ----------------
+// library includes
+// ----------------
+#include "xorShift128.hpp"
+
+
+// ---------
+// Keystream
+// ---------
+
+/*
+ * @class Bulk helpers for XORing data with the XORShift128 keystream. Values
+ *		  are laid out in little endian byte order, one after the other, so
+ *		  the keystream is identical to drawing one value at a time. Data is
+ *		  processed in blocks: the generator fills a block of values, which
+ *		  is then XOR'd into the data using the widest kernel the CPU
+ *		  supports (AVX2, SSE2, NEON or scalar), selected at runtime.
+ */
+class Keystream {
+
+	public:
+
+		// number of values generated per block
+		static const size_t BLOCK_WORDS = 64;
+
+
+		// --------
+		// generate
+		// --------
+		/**
+		 * @brief Writes the given number of values from the generator into
+		 *		  the output in little endian byte order.
+		 *
+		 * @param rng xorshift random number generator
+		 * @param output container of 8 * words bytes
+		 * @param words number of values
+		 *
+		 * @return void
+		 */
+		static void generate(XORShift128& rng, uint8_t* output, size_t words);
+
+
+		// --------
+		// xorBytes
+		// --------
+		/**
+		 * @brief XORs the keystream bytes into the data in place using the
+		 *		  selected kernel.
+		 *
+		 * @param data bytes to be XOR'd
+		 * @param keystream keystream bytes
+		 * @param length number of bytes
+		 *
+		 * @return void
+		 */
+		static void xorBytes(uint8_t* data, const uint8_t* keystream,
+			size_t length);
+
+
+		// --------
+		// xorWords
+		// --------
+		/**
+		 * @brief XORs the data in place with the given number of whole values
+		 *		  from the generator, block by block.
+		 *
+		 * @param rng xorshift random number generator
+		 * @param data container of 8 * words bytes
+		 * @param words number of values
+		 *
+		 * @return void
+		 */
+		static void xorWords(XORShift128& rng, uint8_t* data,
+			size_t words);
+
+
+		// ----------
+		// kernelName
+		// ----------
+		/**
+		 * @brief Name of the XOR kernel selected for this CPU.
+		 *
+		 * @return one of "avx2", "sse2", "neon" or "scalar"
+		 */
+		static const char* kernelName();
+
+};
+
+#endif
@@ -0,0 +1,218 @@
+/** @file lruCache.hpp
+ *  @brief Bounded, thread safe least recently used cache mapping string keys
+ *		   to shared objects. Used to keep parsed Crypto++ key objects alive
+ *		   between calls.
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LRUCACHE_HPP
+#define LRUCACHE_HPP
+
+// -----------------
+// standard includes
+// -----------------
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+// --------
+// LRUCache
+// --------
+
+/*
+ * @class Fixed capacity cache of shared objects. Once the capacity is reached
+ *		  the least recently used entry is evicted to make room for a new one.
+ *		  Objects handed out remain valid after eviction since they are
+ *		  reference counted. A capacity of 0 disables caching.
+ */
+template <typename T>
+class LRUCache {
+
+	private:
+
+		// list of cached entries, most recently used at the front
+		typedef std::list<std::pair<std::string, std::shared_ptr<T> > > List;
+
+		// ----
+		// data
+		// ----
+		// cached entries
+		List _entries;
+		// lookup from key to entry position in '_entries'
+		std::unordered_map<std::string, typename List::iterator> _index;
+		// maximum number of entries
+		size_t _capacity;
+		// guards all of the above
+		mutable std::mutex _mutex;
+
+	public:
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Initializes an empty cache.
+		 *
+		 * @param capacity maximum number of entries held by the cache
+		 */
+		explicit LRUCache(size_t capacity): _capacity(capacity) {
+
+		}
+
+
+		// ---
+		// get
+		// ---
+		/**
+		 * @brief Looks up the given key and marks the entry as most recently
+		 *		  used.
+		 *
+		 * @param key cache key
+		 *
+		 * @return cached object or an empty pointer if not present
+		 */
+		std::shared_ptr<T> get(const std::string& key) {
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			auto it = _index.find(key);
+			if (it == _index.end()) {
+				return std::shared_ptr<T>();
+			}
+
+			// Move the entry to the front of the list.
+			_entries.splice(_entries.begin(), _entries, it->second);
+			return it->second->second;
+		}
+
+
+		// ---
+		// put
+		// ---
+		/**
+		 * @brief Inserts or replaces the entry for the given key, evicting the
+		 *		  least recently used entry if the cache is full.
+		 *
+		 * @param key cache key
+		 * @param value object to be cached
+		 *
+		 * @return void
+		 */
+		void put(const std::string& key, std::shared_ptr<T> value) {
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if (_capacity == 0) {
+				return;
+			}
+
+			auto it = _index.find(key);
+			if (it != _index.end()) {
+				it->second->second = value;
+				_entries.splice(_entries.begin(), _entries, it->second);
+				return;
+			}
+
+			// Evict from the back until there is room for the new entry.
+			while (_entries.size() >= _capacity) {
+				_index.erase(_entries.back().first);
+				_entries.pop_back();
+			}
+
+			_entries.push_front(std::make_pair(key, value));
+			_index[key] = _entries.begin();
+		}
+
+
+		// -----
+		// clear
+		// -----
+		/**
+		 * @brief Removes all entries from the cache.
+		 *
+		 * @return void
+		 */
+		void clear() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			_index.clear();
+			_entries.clear();
+		}
+
+
+		// -------
+		// forEach
+		// -------
+		/**
+		 * @brief Invokes the given function on every cached object, from the
+		 *		  most to the least recently used, without changing the
+		 *		  usage order.
+		 *
+		 * @param f function taking a 'const std::shared_ptr<T>&'
+		 *
+		 * @return void
+		 */
+		template <typename F>
+		void forEach(F f) const {
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+				f(it->second);
+			}
+		}
+
+
+		// ----
+		// size
+		// ----
+		/**
+		 * @brief Number of entries currently held by the cache.
+		 *
+		 * @return number of entries
+		 */
+		size_t size() const {
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _entries.size();
+		}
+
+
+		// --------
+		// capacity
+		// --------
+		/**
+		 * @brief Maximum number of entries held by the cache.
+		 *
+		 * @return capacity
+		 */
+		size_t capacity() const {
+			return _capacity;
+		}
+
+};
+
+#endif
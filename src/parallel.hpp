@@ -0,0 +1,174 @@
+/** @file parallel.hpp
+ *  @brief Splits a batch into contiguous slices and runs them on a bounded
+ *		   number of threads. Used by the threaded batch operations.
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+// -----------------
+// standard includes
+// -----------------
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// --------
+// Parallel
+// --------
+
+/*
+ * @class Runs a function over the slices of a batch, one slice per thread.
+ *		  The thread count asked for by the caller is capped by the batch
+ *		  size and the number of hardware threads, and the calling thread
+ *		  works on the first slice itself. All threads started are joined
+ *		  before returning or throwing, even when starting a thread fails.
+ */
+class Parallel {
+
+	private:
+
+		// -------
+		// Joiner
+		// -------
+		/*
+		 * @class Joins the started threads when leaving the scope.
+		 */
+		class Joiner {
+
+			public:
+
+				// started threads
+				std::vector<std::thread> threads;
+
+				~Joiner() {
+					for (size_t i = 0; i < threads.size(); ++i) {
+						threads[i].join();
+					}
+				}
+		};
+
+	public:
+
+		// -----------
+		// threadCount
+		// -----------
+		/**
+		 * @brief Number of threads to use for a batch.
+		 *
+		 * @param count number of items in the batch
+		 * @param requested number of threads asked for
+		 *
+		 * @return number of threads between 1 and the smaller of the
+		 *		   batch size and the number of hardware threads
+		 */
+		static unsigned int threadCount(size_t count, unsigned int requested) {
+			static const unsigned int hardware =
+				std::max(1u, std::thread::hardware_concurrency());
+
+			return std::max(1u, static_cast<unsigned int>(
+				std::min<size_t>(std::min(requested, hardware), count)));
+		}
+
+
+		// ------------
+		// forEachSlice
+		// ------------
+		/**
+		 * @brief Splits [0, count) into contiguous slices and runs the
+		 *		  function on each, spreading the slices across threads.
+		 *
+		 * @param count number of items in the batch
+		 * @param threads number of threads asked for
+		 * @param granularity slice sizes other than the last are kept a
+		 *		  multiple of this
+		 * @param function invoked as function(begin, end)
+		 *
+		 * @throw the first exception thrown by the function, or
+		 *		  std::system_error if a thread could not be started
+		 *
+		 * @return void
+		 */
+		template <typename Function>
+		static void forEachSlice(size_t count, unsigned int threads,
+			size_t granularity, Function function) {
+
+			if (count == 0) {
+				return;
+			}
+
+			threads = threadCount(count, threads);
+
+			size_t slice = (count + threads - 1) / threads;
+			slice = (slice + granularity - 1) / granularity * granularity;
+
+			if (slice >= count) {
+				function(size_t(0), count);
+				return;
+			}
+
+			// First exception thrown by any of the slices.
+			std::exception_ptr error;
+			std::mutex errorMutex;
+
+			auto run = [&](size_t begin, size_t end) {
+				try {
+					function(begin, end);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+			};
+
+			{
+				// Declared after 'error', so the threads are joined first.
+				Joiner workers;
+				workers.threads.reserve(threads - 1);
+
+				for (size_t begin = slice; begin < count; begin += slice) {
+					const size_t end = std::min(begin + slice, count);
+					workers.threads.push_back(std::thread(run, begin, end));
+				}
+
+				run(0, slice);
+			}
+
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+};
+
+#endif
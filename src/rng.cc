@@ -37,6 +37,8 @@
 #include <vector>
 #include <exception>
 #include <mutex>
+#include <cstring>
+#include <stdexcept>
 
 // ----------------------
 // node.js addon includes
@@ -49,18 +51,94 @@
 #include <sha3.h>
 using CryptoPP::SHA3_256;
 
+#include "misc.h"
+
 // ----------------
 // library includes
 // ----------------
 #include <isaacRandomPool.h>
 
+#include "binding.h"
 #include "rng.h"
+#include "stats.h"
 #include "util.h"
 
 #define MAX_ENTROPY_GEN_MULTIPLIER 6
 
-// javascript object constructor
-Nan::Persistent<v8::Function> RNG::constructor;
+// status code reported when not enough entropy could be gathered
+const int RNG::ENTROPY_ERROR = -3;
+// status code reported when the saved state could not be synced
+const int RNG::SYNC_ERROR = -4;
+
+// size of the reservoir small requests are served from
+const size_t RNG::RESERVOIR_SIZE = 64 * 1024;
+// largest request served from the reservoir
+const size_t RNG::RESERVOIR_MAX_REQUEST = 4096;
+
+/* error thrown when the entropy sources are used during an async
+ * initialization or key generation
+ */
+const char* const RNG::BUSY_MESSAGE = "RNG initialization in progress";
+
+
+// -----------
+// unwrapState
+// -----------
+/**
+ * @brief Unwraps the key buffer and file name arguments locating the saved
+ *        RNG state. A key shorter than the AES key size is hashed to get a
+ *        key of the required size.
+ *
+ * @param info node.js arguments wrapper with the key buffer as the first
+ *        argument and the optional file name as the second
+ * @param fileId set to the file identifier of the saved state on disk
+ * @param digest set to the key used to encrypt/decrypt the saved state
+ *
+ * @return void
+ */
+static void unwrapState(
+    const Nan::FunctionCallbackInfo<v8::Value>& info,
+    std::string& fileId,
+    std::vector<uint8_t>& digest
+) {
+    /* Unwrap the first argument to get the buffer containing file
+     * encryption/decryption key.
+     */
+    v8::Local<v8::Object> bufferObj =
+        Nan::To<v8::Object>(info[0]).ToLocalChecked();
+
+    uint8_t* bufferData = Binding::data(bufferObj);
+    size_t bufferLength = Binding::length(bufferObj);
+
+    /* Unwrap the second argument to get the file identifier of the saved
+     * state on disk.
+     */
+    fileId = "./";
+    if (!info[1]->IsUndefined()) {
+
+        Nan::Utf8String str(info[1]);
+        fileId = *str;
+
+    }
+
+    /* If the size of key buffer is less than AES key size then hash the given
+     * data to get key of the required size.
+     */
+    digest.clear();
+    if (bufferLength < 32) {
+
+        digest.resize(CryptoPP::SHA3_256::DIGESTSIZE);
+        std::string bufferString(reinterpret_cast<const char*>(bufferData),
+            reinterpret_cast<const char*>(bufferData) + bufferLength);
+        hashString(digest, bufferString);
+
+    } else {
+
+        digest.reserve(CryptoPP::SHA3_256::DIGESTSIZE);
+        std::copy(bufferData, bufferData + bufferLength,
+            std::back_inserter(digest));
+    }
+}
 
 // -----------
 // Constructor
@@ -71,28 +149,45 @@ Nan::Persistent<v8::Function> RNG::constructor;
  *
  * @param initCallback callback to be invoked after async
  *        operation
- * @param prng isaac RNG object pointer
- * @param fileId file identifier of RNG state on disk
+ * @param obj wrapped object the operation was started on
+ * @param pool master pool of the RNG state on disk
  * @param digest key used to encrypt/decrypt RNG state on disk
  */
 RNG::Worker::Worker(Nan::Callback* initCallback,
-    IsaacRandomPool* prng,
-    const std::string& fileId,
+    RNG* obj,
+    const std::shared_ptr<ShardedRandomPool>& pool,
     const std::vector<uint8_t>& digest
 ): Nan::AsyncWorker(initCallback),
-_prng(prng),
-_fileId(fileId),
+_obj(obj),
+_pool(pool),
 _digest(digest),
-_isLoaded(false) {
+_isLoaded(false),
+_written(false),
+_code(0) {
 
 }
 
+/**
+ * Constructor
+ * @brief Initilizes a worker saving the RNG state.
+ *
+ * @param initCallback callback to be invoked after async
+ *        operation
+ * @param obj wrapped object the operation was started on
+ * @param pool master pool of the RNG state on disk
+ * @param options sync, atomic and force options of the save
+ */
 RNG::Worker::Worker(Nan::Callback* initCallback,
-    IsaacRandomPool* prng,
-    bool isLoaded
+    RNG* obj,
+    const std::shared_ptr<ShardedRandomPool>& pool,
+    const ShardedRandomPool::SaveOptions& options
 ): Nan::AsyncWorker(initCallback),
-_prng(prng),
-_isLoaded(isLoaded) {
+_obj(obj),
+_pool(pool),
+_isLoaded(true),
+_options(options),
+_written(false),
+_code(0) {
 
 }
 
@@ -113,13 +208,22 @@ _isLoaded(isLoaded) {
  */
 void RNG::Worker::HandleOKCallback () {
     Nan::HandleScope scope;
+
+    if (_isLoaded == false) {
+        _obj->attachPool(_pool);
+    }
     v8::Local<v8::Object> status = Nan::New<v8::Object>();
     Nan::Set(status,
         Nan::New<v8::String>("code").ToLocalChecked(),
-        Nan::New<v8::Integer>((int)_result));
+        Nan::New<v8::Integer>(_code));
     Nan::Set(status,
         Nan::New<v8::String>("message").ToLocalChecked(),
         Nan::New<v8::String>("Success").ToLocalChecked());
+    if (_isLoaded) {
+        Nan::Set(status,
+            Nan::New<v8::String>("written").ToLocalChecked(),
+            Nan::New<v8::Boolean>(_written));
+    }
 
     v8::Local<v8::Value> argv[] = {status};
     if (callback->IsEmpty() == false) {
@@ -149,7 +253,7 @@ void RNG::Worker::HandleErrorCallback () {
     v8::Local<v8::Object> error = Nan::New<v8::Object>();
     Nan::Set(error,
         Nan::New<v8::String>("code").ToLocalChecked(),
-        Nan::New<v8::Integer>((int)_result));
+        Nan::New<v8::Integer>(_code));
     Nan::Set(error,
         Nan::New<v8::String>("message").ToLocalChecked(),
         Nan::New<v8::String>(ErrorMessage()).ToLocalChecked());
@@ -177,11 +281,18 @@ void RNG::Worker::Execute() {
     // Check if the RNG has state on disk and is initialized in memory.
 
     if (_isLoaded == false) {
-        _result = _prng->IsInitialized(_fileId, _digest);
+        _result = _pool->load(_digest);
     } else {
-        _result = _prng->SaveState();
+        try {
+            _result = _pool->saveState(_options, _written);
+        } catch (const std::exception& ex) {
+            _code = RNG::SYNC_ERROR;
+            SetErrorMessage(ex.what());
+            return;
+        }
     }
 
+    _code = (int)_result;
     if (_result == IsaacRandomPool::STATUS::SUCCESS) {
         return;
     }
@@ -200,6 +311,336 @@ void RNG::Worker::Execute() {
 
 
 
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initilizes and constructs internal data.
+ *
+ * @param callback callback to be invoked after async operation
+ * @param obj wrapped object the initialization was started on
+ * @param pool master pool of the RNG state on disk
+ * @param digest key used to encrypt/decrypt RNG state on disk
+ */
+RNG::InitWorker::InitWorker(
+    Nan::Callback* callback,
+    RNG* obj,
+    const std::shared_ptr<ShardedRandomPool>& pool,
+    const std::vector<uint8_t>& digest
+): Nan::AsyncWorker(callback),
+_obj(obj),
+_pool(pool),
+_digest(digest),
+_code(0),
+_retries(0) {
+
+}
+
+
+
+// ----------------
+// HandleOKCallback
+// ----------------
+/**
+ * @brief Executed when the async work is complete without
+ *        error, invoking the given callback with the status
+ *        and the initialization details.
+ *
+ * The details are returned as the second argument to the
+ * callback {strength: [entropyStrength], retries: [retries]}
+ *
+ * @return void
+ */
+void RNG::InitWorker::HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    _obj->_busy = false;
+    _obj->attachPool(_pool);
+
+    v8::Local<v8::Object> status = Nan::New<v8::Object>();
+    Nan::Set(status,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(0));
+    Nan::Set(status,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>("Success").ToLocalChecked());
+
+    v8::Local<v8::Object> ret = Nan::New<v8::Object>();
+    Nan::Set(ret,
+        Nan::New<v8::String>("strength").ToLocalChecked(),
+        Nan::New<v8::String>(_strength).ToLocalChecked());
+    Nan::Set(ret,
+        Nan::New<v8::String>("retries").ToLocalChecked(),
+        Nan::New<v8::Uint32>(_retries));
+
+    v8::Local<v8::Value> argv[] = {status, ret};
+    callback->Call(2, argv);
+}
+
+
+
+// -------------------
+// HandleErrorCallback
+// -------------------
+/**
+ * @brief Executed when the async work is complete with
+ *        error, invoking the given callback with the
+ *        corresponding error.
+ *
+ * The error is returned as the first argument to the callback
+ * {code: [statusCode], message: [errorMessage]}
+ *
+ * @return void
+ */
+void RNG::InitWorker::HandleErrorCallback() {
+    Nan::HandleScope scope;
+
+    _obj->_busy = false;
+
+    v8::Local<v8::Object> error = Nan::New<v8::Object>();
+    Nan::Set(error,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(_code));
+    Nan::Set(error,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>(ErrorMessage()).ToLocalChecked());
+
+    v8::Local<v8::Value> argv[] = {error, Nan::Undefined()};
+    callback->Call(2, argv);
+}
+
+
+
+// -------
+// Execute
+// -------
+/**
+ * @brief Executed in a separate thread, gathering entropy and
+ *        initializing the RNG.
+ *
+ * @return void
+ */
+void RNG::InitWorker::Execute() {
+
+    std::string error;
+    if (!RNG::initializePool(*_pool, _digest, _retries, error)) {
+        _code = RNG::ENTROPY_ERROR;
+        SetErrorMessage(error.c_str());
+        return;
+    }
+
+    _strength = _pool->entropyStrength();
+}
+
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initializes an uninitialized RNG.
+ */
+RNG::RNG(): _attached(false), _busy(false), _reservoirOffset(RESERVOIR_SIZE) {
+
+}
+
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Unregisters the object from its master pool.
+ */
+RNG::~RNG() {
+    if (_attached) {
+        _pool->detach();
+    }
+}
+
+
+
+// ----------
+// selectPool
+// ----------
+/**
+ * @brief Switches the object to the master pool of the given state
+ *        file, unregistering it from the previous one.
+ *
+ * @param fileId file identifier of RNG state on disk
+ *
+ * @return void
+ */
+void RNG::selectPool(const std::string& fileId) {
+
+    resetReservoir();
+
+    if (_pool && _pool->fileId() == fileId) {
+        return;
+    }
+
+    if (_attached) {
+        _pool->detach();
+        _attached = false;
+    }
+
+    _pool = ShardedRandomPool::forFile(fileId);
+}
+
+
+
+// ----------
+// attachPool
+// ----------
+/**
+ * @brief Registers the object as a user of the seeded pool if the
+ *        pool is still the selected one.
+ *
+ * @param pool pool that was seeded
+ *
+ * @return void
+ */
+void RNG::attachPool(const std::shared_ptr<ShardedRandomPool>& pool) {
+    if (_attached || _pool != pool) {
+        return;
+    }
+
+    _pool->attach();
+    _attached = true;
+}
+
+
+
+// --------
+// generate
+// --------
+/**
+ * @brief Writes random bytes into the output. Small requests are
+ *        served from the reservoir, which is refilled in bulk when
+ *        exhausted, larger requests are generated directly.
+ *
+ * @param output container of 'length' bytes
+ * @param length number of random bytes
+ *
+ * @throw std::exception if the RNG has not been initialized
+ *
+ * @return void
+ */
+void RNG::generate(uint8_t* output, size_t length) {
+
+    Stats::Timer timer(Stats::OPERATION::RNG_GET_BYTES, length);
+
+    if (!_attached) {
+        throw std::runtime_error("RNG not initialized");
+    }
+
+    if (length > RESERVOIR_MAX_REQUEST) {
+        _pool->GenerateBlock(output, length);
+        return;
+    }
+
+    while (length > 0) {
+
+        if (_reservoirOffset == RESERVOIR_SIZE) {
+            // Allocated on first use so unused RNG objects stay small.
+            if (_reservoir.size() != RESERVOIR_SIZE) {
+                _reservoir.New(RESERVOIR_SIZE);
+            }
+            _pool->GenerateBlock(_reservoir.BytePtr(), RESERVOIR_SIZE);
+            _reservoirOffset = 0;
+        }
+
+        size_t available = RESERVOIR_SIZE - _reservoirOffset;
+        size_t n = length < available ? length : available;
+
+        // Hand the bytes out and wipe them so they are never reused.
+        uint8_t* first = _reservoir.BytePtr() + _reservoirOffset;
+        std::memcpy(output, first, n);
+        CryptoPP::SecureWipeBuffer(first, n);
+
+        _reservoirOffset += n;
+        output += n;
+        length -= n;
+    }
+}
+
+
+
+// --------------
+// resetReservoir
+// --------------
+/**
+ * @brief Wipes and discards the unused bytes of the reservoir, done
+ *        whenever the RNG is (re)seeded or destroyed.
+ *
+ * @return void
+ */
+void RNG::resetReservoir() {
+    if (_reservoir.size() != 0) {
+        CryptoPP::SecureWipeBuffer(_reservoir.BytePtr(), _reservoir.size());
+    }
+    _reservoirOffset = RESERVOIR_SIZE;
+}
+
+
+
+// --------------
+// initializePool
+// --------------
+/**
+ * @brief Initializes the isaac RNG by gathering entropy, increasing
+ *        the amount of data collected on every retry.
+ *
+ * @param pool master pool of the RNG state on disk
+ * @param digest key used to encrypt/decrypt RNG state on disk
+ * @param retries set to the number of retries
+ * @param error set to the error message on failure
+ *
+ * @return boolean indicating success/failure
+ */
+bool RNG::initializePool(
+    ShardedRandomPool& pool,
+    const std::vector<uint8_t>& digest,
+    unsigned int& retries,
+    std::string& error
+) {
+    /* Initialize the master isaac pool and check if initialization
+     * succeeded. if it fails, increase the multiplier argument which causes
+     * more data to be collected to get higher entropy.
+     */
+    int multiplier = 0;
+
+    try {
+        for (; multiplier < MAX_ENTROPY_GEN_MULTIPLIER; ++multiplier) {
+
+            if (pool.initialize(multiplier, digest)) {
+                break;
+            }
+        }
+    } catch (const std::exception& ex) {
+
+        // If there is any hardware error, report it to the caller.
+        retries = multiplier;
+        error = ex.what();
+        return false;
+    }
+
+    retries = multiplier;
+
+    // If initialization fails after max retries, report an error.
+    if (multiplier == MAX_ENTROPY_GEN_MULTIPLIER) {
+        error = "Not enough entropy!";
+        return false;
+    }
+
+    return true;
+}
+
+
+
 // ---
 // New
 // ---
@@ -235,8 +676,10 @@ NAN_METHOD(RNG::New) {
             argv.push_back(info[i]);
         }
 
-        v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
-        info.GetReturnValue().Set(cons->NewInstance(argc, argv.data()));
+        v8::Local<v8::Function> cons =
+            Binding::constructor(info.Data(), Binding::CLASS::RNG);
+        info.GetReturnValue().Set(
+            Nan::NewInstance(cons, argc, argv.data()).ToLocalChecked());
     }
 }
 
@@ -268,57 +711,35 @@ NAN_METHOD(RNG::isInitialized) {
 
     RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
     // Check arguments.
-    if (!node::Buffer::HasInstance(info[0])) {
+    if (!Binding::isBytes(info[0])) {
 
         Nan::ThrowError("Incorrect Arguments. Key buffer not "
                         "provided");
         return;
     }
 
-    /* Unwrap the first argument to get the buffer containing file
-     * encryption/decryption key.
-     */
-    v8::Local<v8::Object> bufferObj =
-        Nan::To<v8::Object>(info[0]).ToLocalChecked();
-
-    uint8_t* bufferData = (uint8_t*)node::Buffer::Data(bufferObj);
-    size_t bufferLength = node::Buffer::Length(bufferObj);
-
-    /* Unwrap the second argument to get the file identifier of the saved
-     * state on disk.
-     */
-    std::string fileId = "./";
-    if (!info[1]->IsUndefined()) {
-
-        v8::String::Utf8Value str(info[1]->ToString());
-        fileId = *str;
-
-    }
-
-    /* If the size of key buffer is less than AES key size then hash the given
-     * data to get key of the required size.
-     */
+    // Unwrap the key and file name locating the saved state.
+    std::string fileId;
     std::vector<uint8_t> digest;
-    if (bufferLength < 32) {
-
-        digest.resize(CryptoPP::SHA3_256::DIGESTSIZE);
-        std::string bufferString(reinterpret_cast<const char*>(bufferData),
-            reinterpret_cast<const char*>(bufferData) + bufferLength);
-        hashString(digest, bufferString);
-
-    } else {
-
-        digest.reserve(CryptoPP::SHA3_256::DIGESTSIZE);
-        std::copy(bufferData, bufferData + bufferLength,
-            std::back_inserter(digest));
-    }
+    unwrapState(info, fileId, digest);
 
     // Unwrap the third argument to get given callback function.
     Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
 
+    // Load the saved state into the state file's master pool.
+    obj->selectPool(fileId);
+
     // Initialize the async worker and queue it.
-    Worker* worker = new Worker(callback, &obj->prng, fileId, digest);
+    Worker* worker = new Worker(callback, obj, obj->_pool, digest);
+
+    // Keep the wrapped object alive until the worker completes.
+    worker->SaveToPersistent("rng", info.Holder());
 
     Nan::AsyncQueueWorker(worker);
 
@@ -341,11 +762,17 @@ NAN_METHOD(RNG::entropyStrength) {
     // Get a reference to the wrapped object from the argument.
     RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
-    std::string strength = obj->prng.EntropyStrength();
+    // The pool's entropy sources are being mined by the async worker.
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
+    std::string strength = obj->_pool ? obj->_pool->entropyStrength() :
+        IsaacRandomPool().EntropyStrength();
     // Return strength of underlying RNG used for key generation.
     info.GetReturnValue().Set(
-        v8::String::NewFromUtf8(Nan::GetCurrentContext()->GetIsolate(),
-        strength.c_str())
+        Nan::New<v8::String>(strength).ToLocalChecked()
     );
 }
 
@@ -368,80 +795,99 @@ NAN_METHOD(RNG::initialize) {
 
     RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
     // Check arguments
-    if (!node::Buffer::HasInstance(info[0])) {
+    if (!Binding::isBytes(info[0])) {
 
         Nan::ThrowError("Incorrect Arguments. File Identifier buffer not "
                         "provided");
         return;
     }
 
-    /* Unwrap the first argument to get the buffer containing file
-     * encryption/decryption key.
-     */
-    v8::Local<v8::Object> bufferObj =
-        Nan::To<v8::Object>(info[0]).ToLocalChecked();
+    // Unwrap the key and file name locating the saved state.
+    std::string fileId;
+    std::vector<uint8_t> digest;
+    unwrapState(info, fileId, digest);
+
+    // Gather entropy and initialize the state file's master pool.
+    obj->selectPool(fileId);
+    unsigned int retries = 0;
+    std::string error;
+    if (!initializePool(*obj->_pool, digest, retries, error)) {
+        Nan::ThrowError(error.c_str());
+        return;
+    }
+    obj->attachPool(obj->_pool);
 
-    uint8_t* bufferData = (uint8_t*)node::Buffer::Data(bufferObj);
-    size_t bufferLength = node::Buffer::Length(bufferObj);
+    info.GetReturnValue().Set(Nan::True());
 
-    /* Unwrap the second argument to get the file identifier of the saved
-     * state on disk.
-     */
-    std::string fileId = "./";
-    if (!info[1]->IsUndefined()) {
+}
 
-        v8::String::Utf8Value str(info[1]->ToString());
-        fileId = *str;
 
-    }
 
-    /* If the size of key buffer is less than AES key size then hash the given
-     * data to get key of the required size.
-     */
-    std::vector<uint8_t> digest;
-    if (bufferLength < 32) {
+// ---------------
+// initializeAsync
+// ---------------
+/**
+ * @brief Unwraps the arguments to get the key, the file name and the
+ *        callback and creates an async worker which gathers entropy
+ *        and initializes the RNG on the libuv thread pool. The RNG
+ *        must not be used until the callback is invoked.
+ *
+ * Invoked as:
+ * 'obj.initializeAsync(key, filename, function(status, result){})'
+ * 'key' is a buffer containing the disk encryption/decryption key
+ * 'filename' is the name of the RNG saved state file on disk
+ * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+ * 'result' (if available) is of the form:
+ * {strength: [entropyStrength], retries: [retries]}
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(RNG::initializeAsync) {
 
-        digest.resize(CryptoPP::SHA3_256::DIGESTSIZE);
-        std::string bufferString(reinterpret_cast<const char*>(bufferData),
-            reinterpret_cast<const char*>(bufferData) + bufferLength);
-        hashString(digest, bufferString);
+    RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
-    } else {
+    // Check arguments
+    if (!Binding::isBytes(info[0])) {
 
-        digest.reserve(CryptoPP::SHA3_256::DIGESTSIZE);
-        std::copy(bufferData, bufferData + bufferLength,
-            std::back_inserter(digest));
+        Nan::ThrowError("Incorrect Arguments. File Identifier buffer not "
+                        "provided");
+        return;
     }
 
-    /* Initialize the global Isaac rng object and check if
-     * initialization succeeded. if it fails, increase the multiplier argument
-     * which causes more data to be collected to get higher entropy.
-     */
-    int multiplier = 0;
-
-    try {
-        for (; multiplier < MAX_ENTROPY_GEN_MULTIPLIER; ++multiplier) {
-
-            if (obj->prng.Initialize(fileId, multiplier, digest)) {
-                break;
-            }
-        }
-    } catch (const std::exception& ex) {
-
-        // If there is any hardware error, catch and throw the error to node.js
-        Nan::ThrowError(ex.what());
+    if (!info[2]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
         return;
     }
 
-    // If initialization fails after max retries, throw an error to node.js.
-    if (multiplier == MAX_ENTROPY_GEN_MULTIPLIER) {
-        Nan::ThrowError("Not enough entropy!");
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
         return;
     }
 
-    info.GetReturnValue().Set(Nan::True());
+    // Unwrap the key and file name locating the saved state.
+    std::string fileId;
+    std::vector<uint8_t> digest;
+    unwrapState(info, fileId, digest);
+
+    // Unwrap the third argument to get given callback function.
+    Nan::Callback* callback = new Nan::Callback(info[2].As<v8::Function>());
+
+    obj->selectPool(fileId);
+    InitWorker* worker = new InitWorker(callback, obj, obj->_pool, digest);
 
+    // Keep the wrapped object alive until the worker completes.
+    worker->SaveToPersistent("rng", info.Holder());
+
+    obj->_busy = true;
+    Nan::AsyncQueueWorker(worker);
 }
 
 
@@ -467,19 +913,23 @@ NAN_METHOD(RNG::getBytes) {
 
     RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
     // Unwrap the first argument to get the number of required random bytes.
     uint32_t val = 0;
     if (!info[0]->IsUndefined()) {
-        val = info[0]->NumberValue();
+        val = Nan::To<uint32_t>(info[0]).FromMaybe(0);
     }
 
-    // Initialize 'output' vector containing the random bytes.
-    std::vector<uint8_t> output(val);
+    // Allocate the node.js buffer and fill it with random bytes directly.
+    v8::Local<v8::Object> buffer = Nan::NewBuffer(val).ToLocalChecked();
 
-    // Invoke 'GenerateBlock' on the isaac RNG to get the required random bytes.
     try {
 
-        obj->prng.GenerateBlock(output.data(), val);
+        obj->generate(Binding::data(buffer), val);
 
     } catch (const std::exception& ex) {
 
@@ -488,12 +938,91 @@ NAN_METHOD(RNG::getBytes) {
         return;
     }
 
-    // Copy the random bytes into node.js buffer.
-    auto slowBuffer = Nan::CopyBuffer((const char*)output.data(),
-        val).ToLocalChecked();
-
     // Set node.js buffer as return value of the function.
-    info.GetReturnValue().Set(slowBuffer);
+    info.GetReturnValue().Set(buffer);
+}
+
+
+
+// ---------
+// fillBytes
+// ---------
+/**
+ * @brief Unwraps the arguments to get a buffer, an offset and a
+ *        length and fills that part of the buffer with random bytes
+ *        without allocating.
+ *
+ * Invoked as:
+ * 'obj.fillBytes(buffer, offset, length)' where
+ * 'buffer' is the node.js buffer to be filled
+ * 'offset' (optional) is the offset of the first byte, 0 by default
+ * 'length' (optional) is the number of bytes, by default the rest of
+ * the buffer
+ * The given buffer is returned.
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(RNG::fillBytes) {
+
+    RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
+
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
+    if (!Binding::isBytes(info[0])) {
+        Nan::ThrowError("Incorrect Arguments. Buffer not provided");
+        return;
+    }
+
+    v8::Local<v8::Object> bufferObj =
+        Nan::To<v8::Object>(info[0]).ToLocalChecked();
+
+    uint8_t* bufferData = Binding::data(bufferObj);
+    size_t bufferLength = Binding::length(bufferObj);
+
+    // Unwrap the optional offset and length, checking they fit the buffer.
+    double offset = 0;
+    if (!info[1]->IsUndefined()) {
+        if (!info[1]->IsNumber()) {
+            Nan::ThrowError("Incorrect Arguments. Offset must be a number");
+            return;
+        }
+        offset = Nan::To<double>(info[1]).FromMaybe(-1);
+    }
+    if (!(offset >= 0 && offset <= bufferLength)) {
+        Nan::ThrowError("Incorrect Arguments. Offset out of range");
+        return;
+    }
+
+    double length = bufferLength - offset;
+    if (!info[2]->IsUndefined()) {
+        if (!info[2]->IsNumber()) {
+            Nan::ThrowError("Incorrect Arguments. Length must be a number");
+            return;
+        }
+        length = Nan::To<double>(info[2]).FromMaybe(-1);
+    }
+    if (!(length >= 0 && length <= bufferLength - offset)) {
+        Nan::ThrowError("Incorrect Arguments. Length out of range");
+        return;
+    }
+
+    try {
+
+        obj->generate(bufferData + (size_t)offset, (size_t)length);
+
+    } catch (const std::exception& ex) {
+
+        // Error thrown when fillBytes invoked before RNG has been initialized.
+        Nan::ThrowError(ex.what());
+        return;
+    }
+
+    info.GetReturnValue().Set(bufferObj);
 }
 
 
@@ -502,23 +1031,79 @@ NAN_METHOD(RNG::getBytes) {
 // saveState
 // ---------
 /**
- * @brief Encryptes and saves the state of the RNG to disk
+ * @brief Encryptes and saves the state of the RNG to disk unless it
+ *        has not changed since it was last saved or loaded.
  *
  * Invoked as:
- * 'obj.saveState(function (result) {})'
- * 'result' is a js object containing the code('code') and
- *  message('message')
+ * 'obj.saveState(options, function (result) {})'
+ * 'options' (optional) is of the form:
+ * {sync: ["none" (default), "data" or "full"],
+ *  atomic: [keep the previous state until the new one is written],
+ *  force: [write even if the state has not changed]}
+ * 'result' is a js object containing the code('code'),
+ *  message('message') and on success whether the state was
+ *  written('written')
  *
  * @return void
  */
 NAN_METHOD(RNG::saveState) {
     RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
-    // Unwrap the first argument to get given callback function.
-    Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
+    if (!obj->_pool) {
+        Nan::ThrowError("RNG not initialized");
+        return;
+    }
+
+    // The options are optional, so the callback is the last argument.
+    int callbackIndex = info[0]->IsObject() && !info[0]->IsFunction() ? 1 : 0;
+
+    if (!info[callbackIndex]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
+        return;
+    }
+
+    ShardedRandomPool::SaveOptions saveOptions;
+    if (callbackIndex == 1) {
+        v8::Local<v8::Object> options =
+            Nan::To<v8::Object>(info[0]).ToLocalChecked();
+
+        v8::Local<v8::Value> sync = Nan::Get(options,
+            Nan::New<v8::String>("sync").ToLocalChecked()).ToLocalChecked();
+
+        if (sync->IsString()) {
+            std::string mode(*Nan::Utf8String(sync));
+            if (mode == "data") {
+                saveOptions.sync = ShardedRandomPool::SYNC::DATA;
+            } else if (mode == "full") {
+                saveOptions.sync = ShardedRandomPool::SYNC::FULL;
+            } else if (mode != "none") {
+                Nan::ThrowError("Unsupported sync mode");
+                return;
+            }
+        }
+
+        saveOptions.atomic = Nan::To<bool>(Nan::Get(options,
+            Nan::New<v8::String>("atomic").ToLocalChecked()).ToLocalChecked()
+        ).FromJust();
+        saveOptions.force = Nan::To<bool>(Nan::Get(options,
+            Nan::New<v8::String>("force").ToLocalChecked()).ToLocalChecked()
+        ).FromJust();
+    }
+
+    // Unwrap the last argument to get given callback function.
+    Nan::Callback *callback =
+        new Nan::Callback(info[callbackIndex].As<v8::Function>());
 
     // Initialize the async worker and queue it.
-    Worker* worker = new Worker(callback, &obj->prng, true);
+    Worker* worker = new Worker(callback, obj, obj->_pool, saveOptions);
+
+    // Keep the wrapped object alive until the worker completes.
+    worker->SaveToPersistent("rng", info.Holder());
 
     Nan::AsyncQueueWorker(worker);
 }
@@ -540,7 +1125,18 @@ NAN_METHOD(RNG::saveState) {
 NAN_METHOD(RNG::destroy) {
     RNG* obj = ObjectWrap::Unwrap<RNG>(info.Holder());
 
-    obj->prng.Destroy();
+    if (obj->_busy) {
+        Nan::ThrowError(BUSY_MESSAGE);
+        return;
+    }
+
+    obj->resetReservoir();
+
+    // The state is saved and destroyed once the last user releases it.
+    if (obj->_attached) {
+        obj->_pool->release();
+        obj->_attached = false;
+    }
 }
 
 
@@ -553,28 +1149,35 @@ NAN_METHOD(RNG::destroy) {
  *        by the addon.
  *
  * @param exports node.js module exports
+ * @param data module instance data holding the class constructors
  *
  * @return void
  */
-void RNG::Init(v8::Handle<v8::Object> exports) {
+void RNG::Init(v8::Local<v8::Object> exports,
+    v8::Local<v8::Object> data) {
 
     Nan::HandleScope scope;
 
     // Prepare constructor template.
-    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+    v8::Local<v8::FunctionTemplate> tpl =
+        Nan::New<v8::FunctionTemplate>(New, data);
     tpl->SetClassName(Nan::New("RNG").ToLocalChecked());
     tpl->InstanceTemplate()->SetInternalFieldCount(6);
 
     // Prototype
-    Nan::SetPrototypeMethod(tpl, "getBytes", getBytes);
-    Nan::SetPrototypeMethod(tpl, "isInitialized", isInitialized);
-    Nan::SetPrototypeMethod(tpl, "entropyStrength", entropyStrength);
-    Nan::SetPrototypeMethod(tpl, "initialize", initialize);
-    Nan::SetPrototypeMethod(tpl, "saveState", saveState);
-    Nan::SetPrototypeMethod(tpl, "destroy", destroy);
-
-    constructor.Reset(tpl->GetFunction());
+    Nan::SetPrototypeMethod(tpl, "getBytes", getBytes, data);
+    Nan::SetPrototypeMethod(tpl, "fillBytes", fillBytes, data);
+    Nan::SetPrototypeMethod(tpl, "isInitialized", isInitialized, data);
+    Nan::SetPrototypeMethod(tpl, "entropyStrength", entropyStrength, data);
+    Nan::SetPrototypeMethod(tpl, "initialize", initialize, data);
+    Nan::SetPrototypeMethod(tpl, "initializeAsync", initializeAsync, data);
+    Nan::SetPrototypeMethod(tpl, "saveState", saveState, data);
+    Nan::SetPrototypeMethod(tpl, "destroy", destroy, data);
+
+    v8::Local<v8::Function> constructor =
+        Nan::GetFunction(tpl).ToLocalChecked();
+    Binding::setConstructor(data, Binding::CLASS::RNG, constructor);
 
     // Setting node.js module.exports.
-    exports->Set(Nan::New("RNG").ToLocalChecked(), tpl->GetFunction());
+    Nan::Set(exports, Nan::New("RNG").ToLocalChecked(), constructor);
 }
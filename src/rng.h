@@ -34,6 +34,7 @@
 #ifndef RNG_H
 #define RNG_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -44,11 +45,18 @@
 #include <node_object_wrap.h>
 #include <nan.h>
 
+// -----------------
+// cryptopp includes
+// -----------------
+#include "secblock.h"
+
 // ----------------
 // library includes
 // ----------------
 #include <isaacRandomPool.h>
 
+#include "shardedrng.h"
+
 
 // ---
 // RNG
@@ -61,18 +69,42 @@
  * 		  The functions exposed to node.js are:
  *		  function isInitialized(key, filename, callback)
  *		  function initialize(key, filename)
+ *		  function initializeAsync(key, filename, callback)
  *		  function getBytes(n) -> returns node.js buffer with 'n' random bytes
+ *		  function fillBytes(buffer, offset, length) -> fills the buffer
  *		  function destroy() -> save RNG state to disk and destroy the object
+ *
+ *		  Objects using the same state file share one master isaac pool
+ *		  per process, each thread drawing from its own shard of it.
  */
 class RNG : public Nan::ObjectWrap {
 
 	private:
 
-		// javascript object constructor
-		static Nan::Persistent<v8::Function> constructor;
+		// master pool of the selected state file
+		std::shared_ptr<ShardedRandomPool> _pool;
+		// whether this object is registered with '_pool' as a user
+		bool _attached;
+
+		// whether an async initialization is in progress
+		bool _busy;
+
+		// status code reported when not enough entropy could be gathered
+		static const int ENTROPY_ERROR;
+		// status code reported when the saved state could not be synced
+		static const int SYNC_ERROR;
 
-		// isaac RNG object
-		IsaacRandomPool prng;
+		// size of the reservoir small requests are served from
+		static const size_t RESERVOIR_SIZE;
+		// largest request served from the reservoir
+		static const size_t RESERVOIR_MAX_REQUEST;
+
+		/* random bytes generated ahead in bulk, each byte is wiped as soon as
+		 * it is handed out
+		 */
+		CryptoPP::SecByteBlock _reservoir;
+		// offset of the first unused byte in '_reservoir'
+		size_t _reservoirOffset;
 
 		// ------
 		// Worker
@@ -88,10 +120,10 @@ class RNG : public Nan::ObjectWrap {
 		    	// ----
 				// data
 				// ----
-				// pointer to isaac RNG object
-				IsaacRandomPool* _prng;
-				// file identifier of RNG state on disk
-		        std::string _fileId;
+				// wrapped object the operation was started on
+				RNG* _obj;
+				// master pool of the RNG state on disk
+				std::shared_ptr<ShardedRandomPool> _pool;
 		        // key used to encrypt/decrypt RNG state on disk
 		        std::vector<uint8_t> _digest;
 		        // status of operation of checking if RNG state is saved on disk
@@ -100,6 +132,12 @@ class RNG : public Nan::ObjectWrap {
 		         * load the RNG state
 		         */
 		        bool _isLoaded;
+		        // options of saving the RNG state
+		        ShardedRandomPool::SaveOptions _options;
+		        // whether the RNG state was written by the save
+		        bool _written;
+		        // status code reported to the callback
+		        int _code;
 
 		    public:
 		    	// -----------
@@ -111,19 +149,30 @@ class RNG : public Nan::ObjectWrap {
 				 *
 				 * @param initCallback callback to be invoked after async
 				 *		  operation
-				 * @param prng isaac RNG object pointer
-				 * @param fileId file identifier of RNG state on disk
+				 * @param obj wrapped object the operation was started on
+				 * @param pool master pool of the RNG state on disk
 				 * @param digest key used to encrypt/decrypt RNG state on disk
 				 */
 		        Worker(Nan::Callback* initCallback,
-		        	IsaacRandomPool* prng,
-		        	const std::string& fileId,
+		        	RNG* obj,
+		        	const std::shared_ptr<ShardedRandomPool>& pool,
             		const std::vector<uint8_t>& digest
             	);
 
+				/**
+				 * Constructor
+				 * @brief Initilizes a worker saving the RNG state.
+				 *
+				 * @param initCallback callback to be invoked after async
+				 *		  operation
+				 * @param obj wrapped object the operation was started on
+				 * @param pool master pool of the RNG state on disk
+				 * @param options sync, atomic and force options of the save
+				 */
             	Worker(Nan::Callback* initCallback,
-				    IsaacRandomPool* prng,
-				    bool isLoaded
+				    RNG* obj,
+				    const std::shared_ptr<ShardedRandomPool>& pool,
+				    const ShardedRandomPool::SaveOptions& options
 				);
 
 
@@ -176,6 +225,202 @@ class RNG : public Nan::ObjectWrap {
 		};
 
 
+		// ----------
+		// InitWorker
+		// ----------
+		/*
+		 * @class This class represents the node.js async worker responsible for
+		 *		  gathering entropy and initializing the RNG on the libuv
+		 *		  thread pool and invoking the given callback function with
+		 *		  the status of the operation, the entropy strength and the
+		 *		  number of retries.
+		 */
+		class InitWorker: public Nan::AsyncWorker {
+
+			private:
+				// ----
+				// data
+				// ----
+
+				// wrapped object the initialization was started on
+				RNG* _obj;
+				// master pool of the RNG state on disk
+				std::shared_ptr<ShardedRandomPool> _pool;
+				// key used to encrypt/decrypt RNG state on disk
+				std::vector<uint8_t> _digest;
+				// status code of the initialization
+				int _code;
+				// number of retries with a higher entropy multiplier
+				unsigned int _retries;
+				// entropy strength of the RNG
+				std::string _strength;
+
+			public:
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Initilizes and constructs internal data.
+				 *
+				 * @param callback callback to be invoked after async operation
+				 * @param obj wrapped object the initialization was started on
+				 * @param pool master pool of the RNG state on disk
+				 * @param digest key used to encrypt/decrypt RNG state on disk
+				 */
+				InitWorker(
+					Nan::Callback* callback,
+					RNG* obj,
+					const std::shared_ptr<ShardedRandomPool>& pool,
+					const std::vector<uint8_t>& digest
+				);
+
+
+				// ----------------
+				// HandleOKCallback
+				// ----------------
+				/**
+				 * @brief Executed when the async work is complete without
+				 *		  error, invoking the given callback with the status
+				 *		  and the initialization details.
+				 *
+				 * The details are returned as the second argument to the
+				 * callback {strength: [entropyStrength], retries: [retries]}
+				 *
+				 * @return void
+				 */
+				void HandleOKCallback();
+
+
+				// -------------------
+				// HandleErrorCallback
+				// -------------------
+				/**
+				 * @brief Executed when the async work is complete with
+				 *		  error, invoking the given callback with the
+				 *		  corresponding error.
+				 *
+				 * The error is returned as the first argument to the callback
+				 * {code: [statusCode], message: [errorMessage]}
+				 *
+				 * @return void
+				 */
+				void HandleErrorCallback();
+
+
+				// -------
+				// Execute
+				// -------
+				/**
+				 * @brief Executed in a separate thread, gathering entropy and
+				 *		  initializing the RNG.
+				 *
+				 * @return void
+				 */
+				void Execute();
+		};
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Initializes an uninitialized RNG.
+		 */
+		RNG();
+
+
+		// ----------
+		// Destructor
+		// ----------
+		/**
+		 * Destructor
+		 * @brief Unregisters the object from its master pool.
+		 */
+		~RNG();
+
+
+		// ----------
+		// selectPool
+		// ----------
+		/**
+		 * @brief Switches the object to the master pool of the given state
+		 *		  file, unregistering it from the previous one.
+		 *
+		 * @param fileId file identifier of RNG state on disk
+		 *
+		 * @return void
+		 */
+		void selectPool(const std::string& fileId);
+
+
+		// ----------
+		// attachPool
+		// ----------
+		/**
+		 * @brief Registers the object as a user of the seeded pool if the
+		 *		  pool is still the selected one.
+		 *
+		 * @param pool pool that was seeded
+		 *
+		 * @return void
+		 */
+		void attachPool(const std::shared_ptr<ShardedRandomPool>& pool);
+
+
+		// --------
+		// generate
+		// --------
+		/**
+		 * @brief Writes random bytes into the output. Small requests are
+		 *		  served from the reservoir, which is refilled in bulk when
+		 *		  exhausted, larger requests are generated directly.
+		 *
+		 * @param output container of 'length' bytes
+		 * @param length number of random bytes
+		 *
+		 * @throw std::exception if the RNG has not been initialized
+		 *
+		 * @return void
+		 */
+		void generate(uint8_t* output, size_t length);
+
+
+		// --------------
+		// resetReservoir
+		// --------------
+		/**
+		 * @brief Wipes and discards the unused bytes of the reservoir, done
+		 *		  whenever the RNG is (re)seeded or destroyed.
+		 *
+		 * @return void
+		 */
+		void resetReservoir();
+
+
+		// --------------
+		// initializePool
+		// --------------
+		/**
+		 * @brief Initializes the isaac RNG by gathering entropy, increasing
+		 *		  the amount of data collected on every retry.
+		 *
+		 * @param pool master pool of the RNG state on disk
+		 * @param digest key used to encrypt/decrypt RNG state on disk
+		 * @param retries set to the number of retries
+		 * @param error set to the error message on failure
+		 *
+		 * @return boolean indicating success/failure
+		 */
+		static bool initializePool(
+			ShardedRandomPool& pool,
+			const std::vector<uint8_t>& digest,
+			unsigned int& retries,
+			std::string& error
+		);
+
+
 		// ---
 		// New
 		// ---
@@ -227,7 +472,8 @@ class RNG : public Nan::ObjectWrap {
 		 *		   source of entropy is the OS this makes the module's strength
 		 *		   WEAK w.r.t entropy, access to either the microphone or camera
 		 *		   results in Medium strength and finally access to the OS, camera,
-		 *		   microphone and more enables STRONG strength.
+		 *		   microphone and more enables STRONG strength. Throws while an
+		 *		   initializeAsync call on the object is gathering entropy.
 		 */
 		static NAN_METHOD(entropyStrength);
 
@@ -249,6 +495,30 @@ class RNG : public Nan::ObjectWrap {
 		static NAN_METHOD(initialize);
 
 
+		// ---------------
+		// initializeAsync
+		// ---------------
+		/**
+		 * @brief Unwraps the arguments to get the key, the file name and the
+		 *		  callback and creates an async worker which gathers entropy
+		 *		  and initializes the RNG on the libuv thread pool. The RNG
+		 *		  must not be used until the callback is invoked.
+		 *
+		 * Invoked as:
+		 * 'obj.initializeAsync(key, filename, function(status, result){})'
+		 * 'key' is a buffer containing the disk encryption/decryption key
+		 * 'filename' is the name of the RNG saved state file on disk
+		 * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+		 * 'result' (if available) is of the form:
+		 * {strength: [entropyStrength], retries: [retries]}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(initializeAsync);
+
+
 		// --------
 		// getBytes
 		// --------
@@ -269,16 +539,45 @@ class RNG : public Nan::ObjectWrap {
 		static NAN_METHOD(getBytes);
 
 
+		// ---------
+		// fillBytes
+		// ---------
+		/**
+		 * @brief Unwraps the arguments to get a buffer, an offset and a
+		 *		  length and fills that part of the buffer with random bytes
+		 *		  without allocating.
+		 *
+		 * Invoked as:
+		 * 'obj.fillBytes(buffer, offset, length)' where
+		 * 'buffer' is the node.js buffer to be filled
+		 * 'offset' (optional) is the offset of the first byte, 0 by default
+		 * 'length' (optional) is the number of bytes, by default the rest of
+		 * the buffer
+		 * The given buffer is returned.
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(fillBytes);
+
+
 		// ---------
 		// saveState
 		// ---------
 		/**
-		 * @brief Encryptes and saves the state of the RNG to disk
+		 * @brief Encryptes and saves the state of the RNG to disk unless it
+		 *		  has not changed since it was last saved or loaded.
 		 *
 		 * Invoked as:
-		 * 'obj.saveState(function (result) {})'
-		 * 'result' is a js object containing the code('code') and
-		 * 	message('message')
+		 * 'obj.saveState(options, function (result) {})'
+		 * 'options' (optional) is of the form:
+		 * {sync: ["none" (default), "data" or "full"],
+		 *  atomic: [keep the previous state until the new one is written],
+		 *  force: [write even if the state has not changed]}
+		 * 'result' is a js object containing the code('code'),
+		 * 	message('message') and on success whether the state was
+		 *	written('written')
 		 *
 		 * @return void
 		 */
@@ -301,6 +600,11 @@ class RNG : public Nan::ObjectWrap {
 
 	public:
 
+		/* error thrown when the entropy sources are used during an async
+		 * initialization or key generation
+		 */
+		static const char* const BUSY_MESSAGE;
+
 		// ----
 		// Init
 		// ----
@@ -309,10 +613,12 @@ class RNG : public Nan::ObjectWrap {
 		 * 		  by the addon.
 		 *
 		 * @param exports node.js module exports
+		 * @param data module instance data holding the class constructors
 		 *
 		 * @return void
 		 */
-    	static void Init(v8::Handle<v8::Object> exports);
+    	static void Init(v8::Local<v8::Object> exports,
+			v8::Local<v8::Object> data);
 
 };
 
@@ -0,0 +1,420 @@
+/** @file securearena.cc
+ *  @brief Definition of the class functions provided in securearena.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "misc.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "securearena.h"
+
+
+namespace {
+    // Process wide usage counters.
+    std::atomic<size_t> mappedRegions(0);
+    std::atomic<size_t> mappedBytes(0);
+    std::atomic<size_t> lockedBytes(0);
+    std::atomic<size_t> heapBytes(0);
+    std::atomic<size_t> liveBlocks(0);
+
+    // Index of the smallest size class holding 'size' bytes.
+    size_t sizeClassOf(size_t size) {
+        size_t sizeClass = 0;
+        size_t blockSize = SecureArena::MIN_BLOCK_BYTES;
+        while (blockSize < size) {
+            blockSize <<= 1;
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+}
+
+
+// -----------------
+// SecureArenaHolder
+// -----------------
+/*
+ * @brief Thread local owner of the arena of a thread, retiring it when the
+ *        thread exits.
+ */
+struct SecureArenaHolder {
+    SecureArena* arena;
+
+    SecureArenaHolder(): arena(new SecureArena()) {
+
+    }
+
+    ~SecureArenaHolder() {
+        arena->retire();
+    }
+};
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initializes an arena without any region.
+ */
+SecureArena::SecureArena(): _regions(nullptr), _cursor(nullptr),
+_remaining(0), _live(0), _retired(false) {
+
+    for (size_t i = 0; i < CLASSES; ++i) {
+        _free[i] = nullptr;
+    }
+}
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Unmaps the regions of the arena.
+ */
+SecureArena::~SecureArena() {
+
+    while (_regions != nullptr) {
+        Region region = *_regions;
+        unmap(region.data, REGION_BYTES, region.locked);
+        mappedRegions--;
+        _regions = region.next;
+    }
+}
+
+
+// --------
+// allocate
+// --------
+/**
+ * @brief Returns a buffer of at least the given length from the arena
+ *        of the calling thread, zeroed unless it is larger than
+ *        MAX_BLOCK_BYTES and taken from the heap.
+ *
+ * @param length number of bytes
+ *
+ * @throw std::bad_alloc if no memory is available
+ *
+ * @return buffer aligned to 16 bytes
+ */
+void* SecureArena::allocate(size_t length) {
+
+    if (length > static_cast<size_t>(-1) - sizeof(Header) - REGION_BYTES) {
+        throw std::bad_alloc();
+    }
+
+    const size_t size = length + sizeof(Header);
+    Header* header;
+
+    if (size > MAX_BLOCK_BYTES) {
+        /* Large blocks hold bulk ciphers and messages, mapping and locking
+         * each of them would cost several system calls per message.
+         */
+        header = static_cast<Header*>(::operator new(size));
+        header->owner = nullptr;
+        header->size = size;
+        heapBytes += size;
+    } else {
+        header = local().take(sizeClassOf(size));
+    }
+
+    liveBlocks++;
+    return header + 1;
+}
+
+
+// ----------
+// deallocate
+// ----------
+/**
+ * @brief Wipes the buffer and returns it to the arena it came from.
+ *
+ * @param data buffer returned by 'allocate', or nullptr
+ *
+ * @return void
+ */
+void SecureArena::deallocate(void* data) {
+
+    if (data == nullptr) {
+        return;
+    }
+
+    Header* header = static_cast<Header*>(data) - 1;
+    liveBlocks--;
+
+    if (header->owner == nullptr) {
+        CryptoPP::SecureWipeBuffer(static_cast<uint8_t*>(data),
+            header->size - sizeof(Header));
+        heapBytes -= header->size;
+        ::operator delete(header);
+        return;
+    }
+
+    CryptoPP::SecureWipeBuffer(static_cast<uint8_t*>(data),
+        header->size - sizeof(Header));
+    header->owner->give(header);
+}
+
+
+// -----
+// usage
+// -----
+/**
+ * @brief Returns the process wide usage of the arenas.
+ *
+ * @return usage counters
+ */
+SecureArena::Usage SecureArena::usage() {
+
+    Usage usage;
+    usage.regions = mappedRegions;
+    usage.mappedBytes = mappedBytes;
+    usage.lockedBytes = lockedBytes;
+    usage.heapBytes = heapBytes;
+    usage.liveBlocks = liveBlocks;
+    return usage;
+}
+
+
+// ----
+// take
+// ----
+/**
+ * @brief Returns a block of the given size class, reusing a freed block
+ *        or carving a new one.
+ *
+ * @param sizeClass index of the size class
+ *
+ * @return block header
+ */
+SecureArena::Header* SecureArena::take(size_t sizeClass) {
+
+    const size_t size = MIN_BLOCK_BYTES << sizeClass;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_live;
+
+    // Reuse a freed block, clearing the free list link it holds.
+    if (_free[sizeClass] != nullptr) {
+        Header* header = static_cast<Header*>(_free[sizeClass]);
+        void** link = reinterpret_cast<void**>(header + 1);
+        _free[sizeClass] = *link;
+        *link = nullptr;
+        return header;
+    }
+
+    if (_remaining < size) {
+        // The tail of the current region is left unused.
+        bool locked;
+        Region* region = static_cast<Region*>(map(REGION_BYTES, locked));
+        region->data = region;
+        region->locked = locked;
+        region->next = _regions;
+        _regions = region;
+        mappedRegions++;
+
+        // Blocks start after the region bookkeeping, 16 byte aligned.
+        const size_t reserved = (sizeof(Region) + 15) / 16 * 16;
+        _cursor = reinterpret_cast<uint8_t*>(region) + reserved;
+        _remaining = REGION_BYTES - reserved;
+    }
+
+    Header* header = reinterpret_cast<Header*>(_cursor);
+    _cursor += size;
+    _remaining -= size;
+
+    header->owner = this;
+    header->size = size;
+    return header;
+}
+
+
+// ----
+// give
+// ----
+/**
+ * @brief Puts a wiped block back on its free list, freeing the arena if it
+ *        was the last block of a retired arena.
+ *
+ * @param header block header
+ *
+ * @return void
+ */
+void SecureArena::give(Header* header) {
+
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        const size_t sizeClass = sizeClassOf(header->size);
+        *reinterpret_cast<void**>(header + 1) = _free[sizeClass];
+        _free[sizeClass] = header;
+
+        last = --_live == 0 && _retired;
+    }
+
+    if (last) {
+        delete this;
+    }
+}
+
+
+// ------
+// retire
+// ------
+/**
+ * @brief Called when the owning thread exits, freeing the arena unless
+ *        blocks are still handed out.
+ *
+ * @return void
+ */
+void SecureArena::retire() {
+
+    bool unused;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _retired = true;
+        unused = _live == 0;
+    }
+
+    if (unused) {
+        delete this;
+    }
+}
+
+
+// -----
+// local
+// -----
+/**
+ * @brief Returns the arena of the calling thread, creating it on first
+ *        use.
+ *
+ * @return arena of the calling thread
+ */
+SecureArena& SecureArena::local() {
+    static thread_local SecureArenaHolder holder;
+    return *holder.arena;
+}
+
+
+// ---
+// map
+// ---
+/**
+ * @brief Maps zeroed memory and tries to lock it into RAM.
+ *
+ * @param length number of bytes, a multiple of the page size
+ * @param locked set to whether the memory could be locked
+ *
+ * @throw std::bad_alloc if the memory cannot be mapped
+ *
+ * @return mapped memory
+ */
+void* SecureArena::map(size_t length, bool& locked) {
+
+#ifdef _WIN32
+    void* data = VirtualAlloc(nullptr, length, MEM_COMMIT | MEM_RESERVE,
+        PAGE_READWRITE);
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    locked = VirtualLock(data, length) != 0;
+#else
+    void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (data == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+
+    // Locking fails beyond RLIMIT_MEMLOCK, the memory is then still wiped.
+    locked = mlock(data, length) == 0;
+
+#ifdef MADV_DONTDUMP
+    madvise(data, length, MADV_DONTDUMP);
+#endif
+#endif
+
+    mappedBytes += length;
+    if (locked) {
+        lockedBytes += length;
+    }
+    return data;
+}
+
+
+// -----
+// unmap
+// -----
+/**
+ * @brief Unlocks and unmaps memory returned by 'map'.
+ *
+ * @param data mapped memory
+ * @param length number of bytes
+ * @param locked whether the memory was locked
+ *
+ * @return void
+ */
+void SecureArena::unmap(void* data, size_t length, bool locked) {
+
+    mappedBytes -= length;
+    if (locked) {
+        lockedBytes -= length;
+    }
+
+#ifdef _WIN32
+    if (locked) {
+        VirtualUnlock(data, length);
+    }
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    if (locked) {
+        munlock(data, length);
+    }
+    munmap(data, length);
+#endif
+}
@@ -0,0 +1,394 @@
+/** @file securearena.h
+ *  @brief Class header for the per-thread, locked memory arena holding key
+ *		   material and transient crypto buffers, wiped when released
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SECUREARENA_H
+#define SECUREARENA_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+
+
+// -----------
+// SecureArena
+// -----------
+
+/*
+ * @class Memory arena with one instance per thread serving small scratch
+ *		  buffers from power of two size classes carved out of regions
+ *		  which are locked into RAM (mlock/VirtualLock) when the process
+ *		  limits allow it and excluded from core dumps where supported.
+ *		  Released blocks are wiped and kept on a free list of the arena
+ *		  they came from, so the hot paths reuse warm memory instead of
+ *		  going through malloc and never leave secrets in freed heap
+ *		  memory. Blocks may be released on any thread. Requests above
+ *		  MAX_BLOCK_BYTES are bulk data rather than key material: they
+ *		  come from the ordinary heap, so they cost no system calls and
+ *		  are not pinned, and are only wiped when released. The arena of
+ *		  a thread is freed once the thread has exited and all of its
+ *		  blocks have been released.
+ */
+class SecureArena {
+
+	public:
+
+		// smallest block handed out, including the block header
+		static const size_t MIN_BLOCK_BYTES = 64;
+		// largest block served from the size classes
+		static const size_t MAX_BLOCK_BYTES = 16 * 1024;
+		// size of the regions blocks are carved out of
+		static const size_t REGION_BYTES = 64 * 1024;
+
+		// Process wide usage of the arenas
+		struct Usage {
+			// regions mapped by the arenas of all threads
+			size_t regions;
+			// bytes mapped for regions
+			size_t mappedBytes;
+			// bytes of the above locked into RAM
+			size_t lockedBytes;
+			// bytes of the large blocks taken from the heap
+			size_t heapBytes;
+			// blocks handed out and not yet released
+			size_t liveBlocks;
+		};
+
+
+		// --------
+		// allocate
+		// --------
+		/**
+		 * @brief Returns a buffer of at least the given length from the
+		 *		  arena of the calling thread, zeroed unless it is larger
+		 *		  than MAX_BLOCK_BYTES and taken from the heap.
+		 *
+		 * @param length number of bytes
+		 *
+		 * @throw std::bad_alloc if no memory is available
+		 *
+		 * @return buffer aligned to 16 bytes
+		 */
+		static void* allocate(size_t length);
+
+
+		// ----------
+		// deallocate
+		// ----------
+		/**
+		 * @brief Wipes the buffer and returns it to the arena it came from.
+		 *
+		 * @param data buffer returned by 'allocate', or nullptr
+		 *
+		 * @return void
+		 */
+		static void deallocate(void* data);
+
+
+		// -----
+		// usage
+		// -----
+		/**
+		 * @brief Returns the process wide usage of the arenas.
+		 *
+		 * @return usage counters
+		 */
+		static Usage usage();
+
+	private:
+
+		// number of size classes, MIN_BLOCK_BYTES to MAX_BLOCK_BYTES
+		static const size_t CLASSES = 9;
+
+		// Header preceding every block
+		struct Header {
+			// arena owning the block, nullptr for a block from the heap
+			SecureArena* owner;
+			// size of the block including the header
+			size_t size;
+		};
+
+		// Region mapped by the arena
+		struct Region {
+			void* data;
+			bool locked;
+			Region* next;
+		};
+
+
+		// ----
+		// data
+		// ----
+		// guards the data below, blocks may be released by other threads
+		std::mutex _mutex;
+		// wiped blocks ready for reuse, one list per size class
+		void* _free[CLASSES];
+		// regions mapped by the arena
+		Region* _regions;
+		// unused part of the newest region
+		uint8_t* _cursor;
+		size_t _remaining;
+		// number of blocks handed out and not yet released
+		size_t _live;
+		// whether the owning thread has exited
+		bool _retired;
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Initializes an arena without any region.
+		 */
+		SecureArena();
+
+
+		// ----------
+		// Destructor
+		// ----------
+		/**
+		 * Destructor
+		 * @brief Unmaps the regions of the arena.
+		 */
+		~SecureArena();
+
+
+		// ----
+		// take
+		// ----
+		/**
+		 * @brief Returns a block of the given size class, reusing a freed
+		 *		  block or carving a new one.
+		 *
+		 * @param sizeClass index of the size class
+		 *
+		 * @return block header
+		 */
+		Header* take(size_t sizeClass);
+
+
+		// ----
+		// give
+		// ----
+		/**
+		 * @brief Puts a wiped block back on its free list, freeing the arena
+		 *		  if it was the last block of a retired arena.
+		 *
+		 * @param header block header
+		 *
+		 * @return void
+		 */
+		void give(Header* header);
+
+
+		// ------
+		// retire
+		// ------
+		/**
+		 * @brief Called when the owning thread exits, freeing the arena
+		 *		  unless blocks are still handed out.
+		 *
+		 * @return void
+		 */
+		void retire();
+
+
+		// -----
+		// local
+		// -----
+		/**
+		 * @brief Returns the arena of the calling thread, creating it on
+		 *		  first use.
+		 *
+		 * @return arena of the calling thread
+		 */
+		static SecureArena& local();
+
+
+		// ---
+		// map
+		// ---
+		/**
+		 * @brief Maps zeroed memory and tries to lock it into RAM.
+		 *
+		 * @param length number of bytes, a multiple of the page size
+		 * @param locked set to whether the memory could be locked
+		 *
+		 * @throw std::bad_alloc if the memory cannot be mapped
+		 *
+		 * @return mapped memory
+		 */
+		static void* map(size_t length, bool& locked);
+
+
+		// -----
+		// unmap
+		// -----
+		/**
+		 * @brief Unlocks and unmaps memory returned by 'map'.
+		 *
+		 * @param data mapped memory
+		 * @param length number of bytes
+		 * @param locked whether the memory was locked
+		 *
+		 * @return void
+		 */
+		static void unmap(void* data, size_t length, bool locked);
+
+		friend struct SecureArenaHolder;
+
+};
+
+
+// ---------------
+// SecureAllocator
+// ---------------
+
+/*
+ * @class Standard allocator drawing from the secure arena, for containers
+ *		  holding key material or plaintext.
+ */
+template <typename T>
+class SecureAllocator {
+
+	public:
+
+		typedef T value_type;
+		typedef T* pointer;
+		typedef const T* const_pointer;
+		typedef T& reference;
+		typedef const T& const_reference;
+		typedef size_t size_type;
+		typedef ptrdiff_t difference_type;
+
+		template <typename U>
+		struct rebind {
+			typedef SecureAllocator<U> other;
+		};
+
+		SecureAllocator() {}
+
+		template <typename U>
+		SecureAllocator(const SecureAllocator<U>&) {}
+
+		T* allocate(size_t count) {
+			if (count > static_cast<size_t>(-1) / sizeof(T)) {
+				throw std::bad_alloc();
+			}
+			return static_cast<T*>(SecureArena::allocate(count * sizeof(T)));
+		}
+
+		void deallocate(T* data, size_t) {
+			SecureArena::deallocate(data);
+		}
+
+		size_t max_size() const {
+			return static_cast<size_t>(-1) / sizeof(T);
+		}
+
+		template <typename U, typename... Args>
+		void construct(U* p, Args&&... args) {
+			::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+		}
+
+		template <typename U>
+		void destroy(U* p) {
+			p->~U();
+		}
+
+		template <typename U>
+		bool operator==(const SecureAllocator<U>&) const {
+			return true;
+		}
+
+		template <typename U>
+		bool operator!=(const SecureAllocator<U>&) const {
+			return false;
+		}
+};
+
+// string whose characters live in the secure arena
+typedef std::basic_string<char, std::char_traits<char>,
+	SecureAllocator<char> > SecureString;
+
+
+// ------------
+// SecureBuffer
+// ------------
+
+/*
+ * @class Fixed size scratch buffer from the secure arena, wiped and
+ *		  returned when it goes out of scope.
+ */
+class SecureBuffer {
+
+	private:
+
+		// ----
+		// data
+		// ----
+		uint8_t* _data;
+		size_t _size;
+
+		SecureBuffer(const SecureBuffer&);
+		SecureBuffer& operator=(const SecureBuffer&);
+
+	public:
+
+		explicit SecureBuffer(size_t size):
+		_data(static_cast<uint8_t*>(SecureArena::allocate(size))),
+		_size(size) {
+
+		}
+
+		~SecureBuffer() {
+			SecureArena::deallocate(_data);
+		}
+
+		uint8_t* data() {
+			return _data;
+		}
+
+		const uint8_t* data() const {
+			return _data;
+		}
+
+		size_t size() const {
+			return _size;
+		}
+};
+
+#endif
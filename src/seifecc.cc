@@ -33,8 +33,15 @@
 // -----------------
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <mutex>
+#include <stdexcept>
+#include <thread>
 
 // ----------------------
 // node.js addon includes
@@ -51,7 +58,6 @@ using CryptoPP::StringSink;
 using CryptoPP::StringSource;
 using CryptoPP::ArraySink;
 using CryptoPP::ArraySource;
-using CryptoPP::PK_EncryptorFilter;
 using CryptoPP::PK_DecryptorFilter;
 
 #include "eccrypto.h"
@@ -70,18 +76,23 @@ using CryptoPP::DL_PublicKey_EC;
 namespace ASN1 = CryptoPP::ASN1;
 
 #include "cryptlib.h"
+#include "misc.h"
 
 #include "sha3.h"
 using CryptoPP::SHA3_256;
 
-#include "osrng.h"
-using CryptoPP::AutoSeededRandomPool;
-
 
 // ----------------
 // library includes
 // ----------------
+#include "binding.h"
+#include "keccak.h"
+#include "parallel.hpp"
+#include "rng.h"
+#include "securearena.h"
 #include "seifecc.h"
+#include "stats.h"
+#include "threadrng.h"
 #include "util.h"
 
 namespace {
@@ -92,10 +103,333 @@ namespace {
     const std::string PRIV_KEY_FILE_NAME = "ecies.private.key";
     // public key file name
     const std::string PUB_KEY_FILE_NAME = "ecies.public.key";
+    // keystore file name
+    const std::string KEYSTORE_FILE_NAME = "ecies.keystore";
+
+    // Curve used for new keys when none is specified.
+    const std::string DEFAULT_CURVE = "secp521r1";
+    // Maximum entropy multiplier tried while initializing the RNG.
+    const int MAX_ENTROPY_GEN_MULTIPLIER = 6;
+    // Domain separation of the session key derivation.
+    const char SESSION_DOMAIN[] = "seifnode ECDH session v2";
+    /* Serializes key generation since it rewrites the rng state and key
+     * files, possibly from several libuv threads at once.
+     */
+    std::mutex keyGenerationMutex;
+}
+
+
+// -------------
+// curveFromName
+// -------------
+/**
+ * @brief Looks up the object identifier of the named curve.
+ *
+ * @param name curve name, one of secp256r1, secp384r1 or secp521r1
+ * @param oid resulting curve object identifier
+ *
+ * @return boolean indicating whether the curve is supported
+ */
+static bool curveFromName(const std::string& name, CryptoPP::OID& oid) {
+    if (name == "secp256r1") {
+        oid = ASN1::secp256r1();
+    } else if (name == "secp384r1") {
+        oid = ASN1::secp384r1();
+    } else if (name == "secp521r1") {
+        oid = ASN1::secp521r1();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+// -----------
+// curveToName
+// -----------
+/**
+ * @brief Returns the name of the curve with the given object identifier.
+ *
+ * @param oid curve object identifier
+ *
+ * @return curve name or an empty string if the curve is not supported
+ */
+static std::string curveToName(const CryptoPP::OID& oid) {
+    if (oid == ASN1::secp256r1()) {
+        return "secp256r1";
+    } else if (oid == ASN1::secp384r1()) {
+        return "secp384r1";
+    } else if (oid == ASN1::secp521r1()) {
+        return "secp521r1";
+    }
+    return "";
+}
+
+// --------------
+// countFromValue
+// --------------
+/**
+ * @brief Reads a numeric constructor option that must be a non-negative
+ *        integer fitting in 32 bits, so negative or fractional values are
+ *        rejected instead of wrapping around.
+ *
+ * @param value option value, undefined to keep the default
+ * @param count resulting count, left unchanged when the value is undefined
+ *
+ * @return boolean indicating whether the value is undefined or a valid count
+ */
+static bool countFromValue(const v8::Local<v8::Value>& value, uint32_t& count) {
+    if (value->IsUndefined()) {
+        return true;
+    }
+    if (!value->IsNumber()) {
+        return false;
+    }
+
+    double number = Nan::To<double>(value).FromJust();
+    if (!(number >= 0) || number > UINT32_MAX ||
+        std::floor(number) != number) {
+        return false;
+    }
+
+    count = static_cast<uint32_t>(number);
+    return true;
+}
+
+// -----------
+// keyCacheKey
+// -----------
+/**
+ * @brief Returns the key cache lookup key of the encoded key: its
+ *        SHA3-256 digest preceded by the encoding, so a hex string and a
+ *        buffer never share an entry.
+ *
+ * @param encodedKey hex encoded or BER encoded key
+ * @param binary whether the key is BER encoded
+ *
+ * @return cache lookup key
+ */
+static std::string keyCacheKey(const std::string& encodedKey, bool binary) {
+    std::vector<uint8_t> digest(CryptoPP::SHA3_256::DIGESTSIZE);
+    hashString(digest, encodedKey);
+
+    std::string cacheKey(1, binary ? 'b' : 'h');
+    cacheKey.append(digest.begin(), digest.end());
+    return cacheKey;
+}
+
+// -------------------
+// elapsedMilliseconds
+// -------------------
+/**
+ * @brief Returns the time passed since the given point in milliseconds.
+ *
+ * @param start point in time
+ *
+ * @return elapsed time in milliseconds
+ */
+static double elapsedMilliseconds(
+    const std::chrono::steady_clock::time_point& start
+) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// -----------
+// encryptWith
+// -----------
+/**
+ * @brief Encrypts the message using the given encryption object, writing
+ *        the cipher directly into the output string.
+ *
+ * @param encryptor encryption object holding the public key
+ * @param prng random number generator for the ephemeral key
+ * @param message message to be encrypted
+ * @param length length of the message
+ * @param cipher resulting cipher
+ *
+ * @throw CryptoPP::Exception in case of encryption errors
+ *
+ * @return void
+ */
+template <typename String>
+static void encryptWith(
+    const CryptoPP::PK_Encryptor& encryptor,
+    CryptoPP::RandomNumberGenerator& prng,
+    const uint8_t* message,
+    size_t length,
+    String& cipher
+)
+{
+    Stats::Timer timer(Stats::OPERATION::ECC_ENCRYPT, length);
+
+    cipher.resize(encryptor.CiphertextLength(length));
+    encryptor.Encrypt(prng, message, length,
+        reinterpret_cast<uint8_t*>(&cipher[0]));
+}
+
+
+// -------
+// loadKey
+// -------
+/**
+ * @brief Parses the BER encoded public key into the encryption object and
+ *        builds fixed-base precomputation tables for the base point and
+ *        public element when enabled.
+ *
+ * @param encryptor resulting encryption object
+ * @param encoded BER encoded public key
+ * @param precomputeStorage number of precomputed points, 0 to disable
+ *        precomputation
+ *
+ * @throw CryptoPP::Exception if the key cannot be decoded
+ *
+ * @return approximate size of the precomputation tables in bytes
+ */
+static size_t loadKey(
+    ECIES<ECP>::Encryptor& encryptor,
+    const SecureString& encoded,
+    unsigned int precomputeStorage
+)
+{
+    ArraySource ss(reinterpret_cast<const uint8_t*>(encoded.data()),
+        encoded.size(), true);
+    encryptor.AccessPublicKey().Load(ss);
+
+    if (precomputeStorage == 0) {
+        return 0;
+    }
+
+    /* Precompute tables for both the base point (ephemeral k*G) and the
+     * recipient's public element (shared secret k*Q).
+     */
+    encryptor.AccessKey().Precompute(precomputeStorage);
+
+    // Each table holds 'precomputeStorage' points of two coordinates.
+    const size_t pointBytes = encryptor.GetKey()
+        .GetAbstractGroupParameters().GetEncodedElementSize(false) - 1;
+    return 2 * precomputeStorage * pointBytes;
+}
+
+/**
+ * @brief Parses the BER encoded private key into the decryption object.
+ *
+ * @param decryptor resulting decryption object
+ * @param encoded BER encoded private key
+ *
+ * @throw CryptoPP::Exception if the key cannot be decoded
+ *
+ * @return 0, private keys are not precomputed
+ */
+static size_t loadKey(
+    ECIES<ECP>::Decryptor& decryptor,
+    const SecureString& encoded,
+    unsigned int
+)
+{
+    ArraySource ss(reinterpret_cast<const uint8_t*>(encoded.data()),
+        encoded.size(), true);
+    decryptor.AccessPrivateKey().Load(ss);
+    return 0;
+}
+
+
+// ---------
+// CachedKey
+// ---------
+/**
+ * Constructor
+ * @brief Parses the first object of the key.
+ *
+ * @param encoded BER encoded key
+ * @param precomputeStorage number of precomputed points of each parsed
+ *        object, 0 to disable precomputation
+ *
+ * @throw CryptoPP::Exception if the key cannot be decoded
+ */
+template <typename T>
+SEIFECC::CachedKey<T>::CachedKey(
+    const SecureString& encoded,
+    unsigned int precomputeStorage
+): _encoded(encoded), _precomputeStorage(precomputeStorage), _objects(1) {
+
+    std::unique_ptr<T> object(new T());
+    _objectBytes = loadKey(*object, _encoded, _precomputeStorage);
+    _idle.push_back(std::move(object));
+}
+
+/**
+ * @brief Leases an idle object, parsing a new one when all of them are in
+ *        use.
+ *
+ * @throw CryptoPP::Exception if the key cannot be decoded
+ *
+ * @return object leased to the calling thread
+ */
+template <typename T>
+typename SEIFECC::CachedKey<T>::Lease SEIFECC::CachedKey<T>::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!_idle.empty()) {
+            std::unique_ptr<T> object = std::move(_idle.back());
+            _idle.pop_back();
+            return Lease(*this, std::move(object));
+        }
+        ++_objects;
+    }
+
+    // Parse outside the lock so other threads keep leasing idle objects.
+    std::unique_ptr<T> object(new T());
+    try {
+        loadKey(*object, _encoded, _precomputeStorage);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_objects;
+        throw;
+    }
+    return Lease(*this, std::move(object));
+}
+
+/**
+ * @brief Keeps the object for the next lease, up to one per hardware
+ *        thread.
+ *
+ * @param object object handed back by a lease
+ *
+ * @return void
+ */
+template <typename T>
+void SEIFECC::CachedKey<T>::release(std::unique_ptr<T> object) {
+    static const size_t maxIdle =
+        std::max(1u, std::thread::hardware_concurrency());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_idle.size() < maxIdle) {
+        _idle.push_back(std::move(object));
+    } else {
+        --_objects;
+    }
+}
+
+/**
+ * @brief Returns the approximate size of the precomputation tables of all
+ *        parsed objects of the key.
+ *
+ * @return size in bytes
+ */
+template <typename T>
+size_t SEIFECC::CachedKey<T>::precomputedBytes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _objects * _objectBytes;
 }
 
-// javascript object constructor
-Nan::Persistent<v8::Function> SEIFECC::constructor;
+
+// default number of parsed keys of each kind kept in the cache
+const size_t SEIFECC::DEFAULT_KEY_CACHE_SIZE = 256;
+const size_t SEIFECC::DEFAULT_SESSION_CACHE_SIZE = 64;
+const unsigned int SEIFECC::DEFAULT_SESSION_LIFETIME = 10 * 60 * 1000;
+const size_t SEIFECC::SESSION_KEY_BYTES = 48;
 
 // Helper functions for printing the public and private keys.
 void PrintPrivateKey(const DL_PrivateKey_EC<ECP>& key,
@@ -208,14 +542,17 @@ void PrintPublicKey(const DL_PublicKey_EC<ECP>& key, std::ostream& out)
  * @param key disk access key for public/private keys and
  *        rng state
  * @param folderPath folder containing keys and rng state files
+ * @param encoding encoding of the returned keys
  */
 SEIFECC::Worker::Worker(
     Nan::Callback* initCallback,
     const std::vector<uint8_t>& key,
-    const std::string& folderPath
+    const std::string& folderPath,
+    KEY_ENCODING encoding
 ): Nan::AsyncWorker(initCallback),
 _wfolderPath(folderPath),
-_wkey(key) {
+_wkey(key),
+_encoding(encoding) {
 
 }
 
@@ -231,7 +568,7 @@ _wkey(key) {
  *        keys as an argument.
  *
  * The keys are returned as the second argument to the callback
- * {enc: [publicKey], dec: [privateKey]}
+ * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
  *
  * @return void
  */
@@ -254,15 +591,24 @@ void SEIFECC::Worker::HandleOKCallback () {
     /* Creating js object with 'enc' set as the public key and
      * 'dec' as the private key.
      */
-    v8::Local<v8::Object> ret = Nan::New<v8::Object>();
-    Nan::Set(ret,
-        Nan::New<v8::String>("enc").ToLocalChecked(),
-        Nan::New<v8::String>(_encodedPub).ToLocalChecked()
-    );
-    Nan::Set(ret,
-        Nan::New<v8::String>("dec").ToLocalChecked(),
-        Nan::New<v8::String>(_encodedPriv).ToLocalChecked()
-    );
+    v8::Local<v8::Object> ret =
+        keysObject(_encodedPub, _encodedPriv, _curve, _encoding);
+
+    // Report where the time loading the keys went.
+    v8::Local<v8::Object> timings = Nan::New<v8::Object>();
+    Nan::Set(timings,
+        Nan::New<v8::String>("privateKey").ToLocalChecked(),
+        Nan::New<v8::Number>(_timings.privateKey));
+    Nan::Set(timings,
+        Nan::New<v8::String>("publicKey").ToLocalChecked(),
+        Nan::New<v8::Number>(_timings.publicKey));
+    Nan::Set(timings,
+        Nan::New<v8::String>("encode").ToLocalChecked(),
+        Nan::New<v8::Number>(_timings.encode));
+    Nan::Set(timings,
+        Nan::New<v8::String>("total").ToLocalChecked(),
+        Nan::New<v8::Number>(_timings.total));
+    Nan::Set(ret, Nan::New<v8::String>("timings").ToLocalChecked(), timings);
 
     // Invoking given callback with an undefined error and keys object.
     v8::Local<v8::Value> argv[] = {status, ret};
@@ -328,8 +674,11 @@ void SEIFECC::Worker::Execute() {
         _status = SEIFECC::loadKeys(
             _encodedPub,
             _encodedPriv,
+            _curve,
             _wkey,
-            _wfolderPath
+            _wfolderPath,
+            _encoding,
+            _timings
         );
 
         if (_status == STATUS::SUCCESS) {
@@ -355,6 +704,7 @@ void SEIFECC::Worker::Execute() {
 }
 
 
+
 // -----------
 // Constructor
 // -----------
@@ -362,774 +712,2843 @@ void SEIFECC::Worker::Execute() {
  * Constructor
  * @brief Initilizes and constructs internal data.
  *
- * @param keyData byte vector corresponding to disk access key
- * @param folderPath folder containing the encrypted keys
+ * @param callback callback to be invoked after async operation
+ * @param obj object whose busy count the worker holds
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ * @param curve name of the curve to generate the keys on
+ * @param encoding encoding of the returned keys
+ * @param keyPool pool of pregenerated key pairs, or null
  */
-SEIFECC::SEIFECC(
-    const std::vector<uint8_t>& keyData,
-    const std::string& folderPath
-): _key(keyData), _folderPath(folderPath) {
+SEIFECC::KeyGenWorker::KeyGenWorker(
+    Nan::Callback* callback,
+    SEIFECC* obj,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath,
+    const std::string& curve,
+    KEY_ENCODING encoding,
+    const std::shared_ptr<KeyPool>& keyPool
+): Nan::AsyncWorker(callback),
+_obj(obj),
+_wkey(key),
+_wfolderPath(folderPath),
+_curve(curve),
+_keyPool(keyPool),
+_status(STATUS::SUCCESS),
+_retries(0),
+_encoding(encoding) {
 
 }
 
 
 
-// --------------
-// SavePrivateKey
-// --------------
+// ----------------
+// HandleOKCallback
+// ----------------
 /**
- * @brief Encrypt and save the private key to the disk with the given
- *        file name.
+ * @brief Executed when the async work is complete without
+ *        error, invoking the given callback with the
+ *        generated keys as an argument.
  *
- * @param privateKey private key object
- * @param file file name of encrypted private key
- * @param key disk access key for public/private keys and
- *        rng state
- * @param folderPath folder containing keys and rng state files
+ * The keys are returned as the second argument to the callback
+ * {enc: [publicKey], dec: [privateKey], curve: [curveName],
+ *  strength: [entropyStrength], retries: [retries]}
  *
  * @return void
  */
-void SEIFECC::SavePrivateKey(
-    const PrivateKey& privateKey,
-    const std::string& file,
-    const std::vector<uint8_t>& key,
-    const std::string& folderPath
-)
-{
-    // Create file encryptor object.
-    FileCryptopp fileEncryptor(folderPath + file);
+void SEIFECC::KeyGenWorker::HandleOKCallback() {
+    Nan::HandleScope scope;
 
-    // Save the private key into a string using CryptoPP StringSink.
-    std::string keyStr;
-    StringSink keySink(keyStr);
+    --_obj->_busy;
 
-    privateKey.Save(keySink);
+    v8::Local<v8::Object> status = Nan::New<v8::Object>();
+    Nan::Set(status,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(0)
+    );
+    Nan::Set(status,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>("Success").ToLocalChecked()
+    );
 
-    // Write the string form of the private key to the file.
-    std::stringstream fss(keyStr);
-    fileEncryptor.writeFile(fss, key);
+    v8::Local<v8::Object> ret =
+        keysObject(_encodedPub, _encodedPriv, _curve, _encoding);
+    Nan::Set(ret,
+        Nan::New<v8::String>("strength").ToLocalChecked(),
+        Nan::New<v8::String>(_strength).ToLocalChecked()
+    );
+    Nan::Set(ret,
+        Nan::New<v8::String>("retries").ToLocalChecked(),
+        Nan::New<v8::Uint32>(_retries)
+    );
+
+    v8::Local<v8::Value> argv[] = {status, ret};
+
+    callback->Call(2, argv);
 }
 
 
-// -------------
-// SavePublicKey
-// -------------
+
+// -------------------
+// HandleErrorCallback
+// -------------------
 /**
- * @brief Encrypt and save the public key to the disk with the given
- *        file name.
+ * @brief Executed when the async work is complete with
+ *        error, invoking the given callback with the
+ *        corresponding error.
  *
- * @param publicKey public key object
- * @param file file name of encrypted public key
- * @param key disk access key for public/private keys and
- *        rng state
- * @param folderPath folder containing keys and rng state files
+ * The error is returned as the first argument to the callback
+ * {code: [statusCode], message: [errorMessage], retries: [retries]}
  *
  * @return void
  */
-void SEIFECC::SavePublicKey(
-    const PublicKey& publicKey,
-    const std::string& file,
-    const std::vector<uint8_t>& key,
-    const std::string& folderPath
-)
-{
-    // Create file encryptor object.
-    FileCryptopp fileEncryptor(folderPath + file);
+void SEIFECC::KeyGenWorker::HandleErrorCallback() {
+    Nan::HandleScope scope;
 
-    // Save the public key into a string using CryptoPP StringSink.
-    std::string keyStr;
-    StringSink keySink(keyStr);
+    --_obj->_busy;
 
-    publicKey.Save(keySink);
+    v8::Local<v8::Object> error = Nan::New<v8::Object>();
+    Nan::Set(error,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>((int)_status)
+    );
+    Nan::Set(error,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>(ErrorMessage()).ToLocalChecked()
+    );
+    Nan::Set(error,
+        Nan::New<v8::String>("retries").ToLocalChecked(),
+        Nan::New<v8::Uint32>(_retries)
+    );
 
-    // Write the string form of the public key to the file.
-    std::stringstream fss(keyStr);
-    fileEncryptor.writeFile(fss, key);
+    v8::Local<v8::Value> argv[] = {error, Nan::Undefined()};
+
+    callback->Call(2, argv);
 }
 
 
 
-// --------------
-// LoadPrivateKey
-// --------------
+// -------
+// Execute
+// -------
 /**
- * @brief Decrypt the file with the given name and load it as the
- *        private key.
+ * @brief Executed in a separate thread, generating the keys.
  *
- * @param privateKey private key object
- * @param file file name of encrypted private key
- * @param key disk access key for public/private keys and
- *        rng state
- * @param folderPath folder containing keys and rng state files
+ * @return void
+ */
+void SEIFECC::KeyGenWorker::Execute() {
+
+    std::string error;
+
+    try {
+        _status = SEIFECC::generateKeys(
+            _encodedPub,
+            _encodedPriv,
+            _curve,
+            _wkey,
+            _wfolderPath,
+            nullptr,
+            "",
+            _keyPool.get(),
+            _encoding,
+            _retries,
+            _strength,
+            error
+        );
+    } catch (const std::exception& ex) {
+        _status = STATUS::KEY_GENERATION_ERROR;
+        error = ex.what();
+    }
+
+    if (_status != STATUS::SUCCESS) {
+        SetErrorMessage(error.c_str());
+    }
+}
+
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initilizes and constructs internal data.
  *
- * @return status code indicating success or cause of error
+ * @param callback callback to be invoked after async operation
+ * @param obj wrapped object owning the key caches
+ * @param mode operation to be performed
+ * @param encodedKey encoded public or private key
+ * @param encoding encoding of the key
+ * @param data input data, which must stay alive and unmodified
+ *        until the callback is invoked
+ * @param length length of input data
  */
-SEIFECC::STATUS SEIFECC::LoadPrivateKey(
-    PrivateKey& privateKey,
-    const std::string& file,
-    const std::vector<uint8_t>& key,
-    const std::string& folderPath
-)
-{
-    // Create file decryptor object.
-    FileCryptopp fileDecryptor(folderPath + file);
+SEIFECC::CryptoWorker::CryptoWorker(
+    Nan::Callback* callback,
+    SEIFECC* obj,
+    MODE mode,
+    const std::string& encodedKey,
+    KEY_ENCODING encoding,
+    const uint8_t* data,
+    size_t length
+): Nan::AsyncWorker(callback),
+_obj(obj),
+_mode(mode),
+_encodedKey(encodedKey),
+_encoding(encoding),
+_data(data),
+_length(length) {
 
-    // If private key file does not exist then return appropriate error.
-    if (!fileDecryptor.fileExists()) {
-        return SEIFECC::STATUS::FILE_NOT_FOUND;
+}
+
+
+
+// ----------------
+// HandleOKCallback
+// ----------------
+/**
+ * @brief Executed when the async work is complete without
+ *        error, invoking the given callback with the status
+ *        and resulting buffer as arguments.
+ *
+ * @return void
+ */
+void SEIFECC::CryptoWorker::HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    /* Creating js status object with 'code' set as the status code(0) and
+     * 'message' as "Success".
+     */
+    v8::Local<v8::Object> status = Nan::New<v8::Object>();
+    Nan::Set(status,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(0)
+    );
+    Nan::Set(status,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>("Success").ToLocalChecked()
+    );
+
+    // Hand the output over to a node.js buffer without copying it.
+    v8::Local<v8::Object> output = Binding::externalBuffer(std::move(_output));
+
+    v8::Local<v8::Value> argv[] = {status, output};
+
+    callback->Call(2, argv);
+}
+
+
+
+// -------------------
+// HandleErrorCallback
+// -------------------
+/**
+ * @brief Executed when the async work is complete with
+ *        error, invoking the given callback with the
+ *        corresponding error.
+ *
+ * The error is returned as the first argument to the callback
+ * {code: [statusCode], message: [errorMessage]}
+ *
+ * @return void
+ */
+void SEIFECC::CryptoWorker::HandleErrorCallback() {
+    Nan::HandleScope scope;
+
+    v8::Local<v8::Object> error = Nan::New<v8::Object>();
+    Nan::Set(error,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>((int)SEIFECC::STATUS::CIPHER_ERROR)
+    );
+    Nan::Set(error,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>(ErrorMessage()).ToLocalChecked()
+    );
+
+    // Invoke callback with the above error object and undefined output.
+    v8::Local<v8::Value> argv[] = {error, Nan::Undefined()};
+
+    callback->Call(2, argv);
+}
+
+
+
+// -------
+// Execute
+// -------
+/**
+ * @brief Executed in a separate thread, encrypting or
+ *        decrypting the input data.
+ *
+ * @return void
+ */
+void SEIFECC::CryptoWorker::Execute() {
+
+    try {
+
+        if (_mode == MODE::ENCRYPT) {
+            _obj->encryptMessage(_output, _encodedKey, _encoding, _data,
+                _length);
+        } else {
+            _obj->decryptMessage(_output, _encodedKey, _encoding, _data,
+                _length);
+        }
+
+    } catch (const std::exception& ex) {
+        SetErrorMessage(ex.what());
+    } catch (...) {
+        SetErrorMessage("Unknown Error");
     }
+}
 
-    // Read the encrypted file to get the private key string.
-    std::stringstream fss;
-    if (!fileDecryptor.readFile(fss, key)) {
-        // If decryption fails return an error.
-        return SEIFECC::STATUS::DECRYPTION_ERROR;
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initilizes and constructs internal data.
+ *
+ * @param callback callback to be invoked after async operation
+ * @param obj wrapped object owning the key caches
+ * @param encodedKey encoded public key
+ * @param encoding encoding of the key
+ * @param messages pointer/length pairs of the messages, which must
+ *        stay alive and unmodified until the callback is invoked
+ * @param threads maximum number of threads to use
+ */
+SEIFECC::BatchWorker::BatchWorker(
+    Nan::Callback* callback,
+    SEIFECC* obj,
+    const std::string& encodedKey,
+    KEY_ENCODING encoding,
+    std::vector<std::pair<const uint8_t*, size_t> >&& messages,
+    unsigned int threads
+): Nan::AsyncWorker(callback),
+_obj(obj),
+_encodedKey(encodedKey),
+_encoding(encoding),
+_messages(std::move(messages)),
+_threads(threads) {
+
+}
+
+
+
+// ----------------
+// HandleOKCallback
+// ----------------
+/**
+ * @brief Executed when the async work is complete without
+ *        error, invoking the given callback with the status
+ *        and an array of the resulting buffers as arguments.
+ *
+ * @return void
+ */
+void SEIFECC::BatchWorker::HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    /* Creating js status object with 'code' set as the status code(0) and
+     * 'message' as "Success".
+     */
+    v8::Local<v8::Object> status = Nan::New<v8::Object>();
+    Nan::Set(status,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(0)
+    );
+    Nan::Set(status,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>("Success").ToLocalChecked()
+    );
+
+    // Hand the ciphers over to an array of node.js buffers.
+    const uint32_t count = static_cast<uint32_t>(_ciphers.size());
+    v8::Local<v8::Array> ciphers = Nan::New<v8::Array>(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        Nan::Set(ciphers, i, Binding::externalBuffer(std::move(_ciphers[i])));
     }
 
-    std::string keyStr = fss.str();
+    v8::Local<v8::Value> argv[] = {status, ciphers};
 
-    // Use CryptoPP StringSource to get the private key object from the string.
-    StringSource keySource(keyStr, true);
+    callback->Call(2, argv);
+}
 
-    privateKey.Load(keySource);
 
-    return SEIFECC::STATUS::SUCCESS;
+
+// -------------------
+// HandleErrorCallback
+// -------------------
+/**
+ * @brief Executed when the async work is complete with
+ *        error, invoking the given callback with the
+ *        corresponding error.
+ *
+ * The error is returned as the first argument to the callback
+ * {code: [statusCode], message: [errorMessage]}
+ *
+ * @return void
+ */
+void SEIFECC::BatchWorker::HandleErrorCallback() {
+    Nan::HandleScope scope;
+
+    v8::Local<v8::Object> error = Nan::New<v8::Object>();
+    Nan::Set(error,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>((int)SEIFECC::STATUS::CIPHER_ERROR)
+    );
+    Nan::Set(error,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>(ErrorMessage()).ToLocalChecked()
+    );
+
+    // Invoke callback with the above error object and undefined output.
+    v8::Local<v8::Value> argv[] = {error, Nan::Undefined()};
+
+    callback->Call(2, argv);
 }
 
 
-// -------------
-// LoadPublicKey
-// -------------
+
+// -------
+// Execute
+// -------
 /**
- * @brief Decrypt the file with the given name and load it as the
- *        public key.
+ * @brief Executed in a separate thread, encrypting the
+ *        messages.
  *
- * @param publicKey public key object
- * @param file file name of encrypted public key
- * @param key disk access key for public/private keys and
- *        rng state
- * @param folderPath folder containing keys and rng state files
+ * @return void
+ */
+void SEIFECC::BatchWorker::Execute() {
+
+    try {
+
+        _obj->encryptMessages(_ciphers, _encodedKey, _encoding, _messages,
+            _threads);
+
+    } catch (const std::exception& ex) {
+        SetErrorMessage(ex.what());
+    } catch (...) {
+        SetErrorMessage("Unknown Error");
+    }
+}
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initilizes and constructs internal data.
  *
- * @return status code indicating success or cause of error
+ * @param keyData byte vector corresponding to disk access key
+ * @param folderPath folder containing the encrypted keys
+ * @param keyCacheSize number of parsed keys of each kind to cache
+ * @param precomputeStorage number of precomputed points for cached
+ *        public keys, 0 to disable precomputation
+ * @param curve name of the curve used when generating keys
+ * @param keyEncoding encoding of the keys returned to javascript
+ * @param sessionCacheSize number of session keys to cache
+ * @param sessionLifetime lifetime of a session key in milliseconds
+ * @param keyPoolSize number of key pairs on 'curve' to pregenerate, 0 to
+ *        disable the pool
+ * @param keyPoolRate maximum number of pairs pregenerated per second, 0
+ *        for no limit
  */
-SEIFECC::STATUS SEIFECC::LoadPublicKey(
-    PublicKey& publicKey,
-    const std::string& file,
-    const std::vector<uint8_t>& key,
-    const std::string& folderPath
+SEIFECC::SEIFECC(
+    const std::vector<uint8_t>& keyData,
+    const std::string& folderPath,
+    size_t keyCacheSize,
+    unsigned int precomputeStorage,
+    const std::string& curve,
+    KEY_ENCODING keyEncoding,
+    size_t sessionCacheSize,
+    unsigned int sessionLifetime,
+    size_t keyPoolSize,
+    unsigned int keyPoolRate
+): _key(keyData), _folderPath(folderPath),
+_encryptors(keyCacheSize),
+_decryptors(keyCacheSize),
+_sessions(sessionCacheSize),
+_sessionLifetime(sessionLifetime),
+_precomputeStorage(precomputeStorage),
+_curve(curve),
+_keyEncoding(keyEncoding),
+_keystore(Keystore::forFile(folderPath + KEYSTORE_FILE_NAME, keyData)),
+_busy(0) {
+
+    // Start pregenerating key pairs on the default curve when enabled.
+    CryptoPP::OID oid;
+    if (keyPoolSize > 0 && curveFromName(curve, oid)) {
+        _keyPool = std::make_shared<KeyPool>(oid,
+            folderPath + RNG_STATE_FILE_NAME, keyPoolSize, keyPoolRate,
+            keyGenerationMutex);
+    }
+}
+
+
+
+// ------------
+// getEncryptor
+// ------------
+/**
+ * @brief Returns the encryption object for the given encoded public
+ *        key, parsing it only if it is not already cached. Newly parsed
+ *        keys get fixed-base precomputation tables for the base point
+ *        and public element when enabled.
+ *
+ * @param encodedKey encoded public key
+ * @param encoding encoding of the key
+ *
+ * @throw CryptoPP::Exception if the key cannot be decoded
+ *
+ * @return shared encryption object holding the loaded key
+ */
+std::shared_ptr<SEIFECC::CachedKey<SEIFECC::Encryptor> >
+SEIFECC::getEncryptor(
+    const std::string& encodedKey,
+    KEY_ENCODING encoding
 )
 {
-    // Create file decryptor object.
-    FileCryptopp fileDecryptor(folderPath + file);
+    // Key the cache on the SHA3-256 digest of the encoded key.
+    std::string cacheKey = keyCacheKey(encodedKey,
+        encoding == KEY_ENCODING::BINARY);
+
+    std::shared_ptr<CachedKey<Encryptor> > cached = _encryptors.get(cacheKey);
+    if (cached) {
+        return cached;
+    }
+
+    /* Hex decode the string to get the public key string using
+     * CryptoPP StringSource and HexDecoder and store in 'em'. Binary keys
+     * are BER encoded already.
+     */
+    SecureString em;
+    if (encoding == KEY_ENCODING::HEX) {
+        StringSource ss0(encodedKey, true, new CryptoPP::HexDecoder(
+            new CryptoPP::StringSinkTemplate<SecureString>(em)));
+    } else {
+        em.assign(encodedKey.data(), encodedKey.size());
+    }
+
+    /* The decoded key is kept to parse an encryption object for each
+     * thread using the key at the same time.
+     */
+    std::shared_ptr<CachedKey<Encryptor> > e1 =
+        std::make_shared<CachedKey<Encryptor> >(em, _precomputeStorage);
+
+    _encryptors.put(cacheKey, e1);
+    return e1;
+}
+
+
+
+// ------------
+// getDecryptor
+// ------------
+/**
+ * @brief Returns the decryption object for the given encoded private
+ *        key, parsing it only if it is not already cached.
+ *
+ * @param encodedKey encoded private key
+ * @param encoding encoding of the key
+ *
+ * @throw CryptoPP::Exception if the key cannot be decoded
+ *
+ * @return shared decryption object holding the loaded key
+ */
+std::shared_ptr<SEIFECC::CachedKey<SEIFECC::Decryptor> >
+SEIFECC::getDecryptor(
+    const std::string& encodedKey,
+    KEY_ENCODING encoding
+)
+{
+    /* Key the cache on the SHA3-256 digest of the encoded key so that the
+     * private key itself is not kept around as a lookup key.
+     */
+    std::string cacheKey = keyCacheKey(encodedKey,
+        encoding == KEY_ENCODING::BINARY);
+
+    std::shared_ptr<CachedKey<Decryptor> > cached = _decryptors.get(cacheKey);
+    if (cached) {
+        return cached;
+    }
+
+    /* Hex decode the string to get the private key string using
+     * CryptoPP StringSource and HexDecoder and store it in string 'em',
+     * which lives in the secure arena and is wiped on release. Binary
+     * keys are BER encoded already.
+     */
+    SecureString em;
+    if (encoding == KEY_ENCODING::HEX) {
+        StringSource ss0(encodedKey, true, new CryptoPP::HexDecoder(
+            new CryptoPP::StringSinkTemplate<SecureString>(em)));
+    } else {
+        em.assign(encodedKey.data(), encodedKey.size());
+    }
+
+    /* The decoded key is kept in the secure arena to parse a decryption
+     * object for each thread using the key at the same time.
+     */
+    std::shared_ptr<CachedKey<Decryptor> > d1 =
+        std::make_shared<CachedKey<Decryptor> >(em, 0);
+
+    _decryptors.put(cacheKey, d1);
+    return d1;
+}
+
+
+
+// ----------
+// getSession
+// ----------
+/**
+ * @brief Returns the session key material shared by the private key and
+ *        the peer public key, running ECDH and the SHAKE256 KDF only if no
+ *        unexpired session key is cached. The KDF binds both public keys
+ *        and derives one key per direction: the material for sending from
+ *        this side comes first, the material for receiving from the peer
+ *        second, so the peer derives the same two halves swapped.
+ *
+ * @param privateKey encoded private key
+ * @param privateEncoding encoding of the private key
+ * @param publicKey encoded peer public key
+ * @param publicEncoding encoding of the public key
+ *
+ * @throw CryptoPP::Exception if a key cannot be decoded, the keys are on
+ *        different curves or the peer key is invalid
+ *
+ * @return shared session key
+ */
+std::shared_ptr<SEIFECC::SessionKey> SEIFECC::getSession(
+    const std::string& privateKey,
+    KEY_ENCODING privateEncoding,
+    const std::string& publicKey,
+    KEY_ENCODING publicEncoding
+)
+{
+    // Key the cache on the digests of both keys, as the key caches do.
+    const std::string cacheKey =
+        keyCacheKey(privateKey, privateEncoding == KEY_ENCODING::BINARY) +
+        keyCacheKey(publicKey, publicEncoding == KEY_ENCODING::BINARY);
+
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+
+    std::shared_ptr<SessionKey> cached = _sessions.get(cacheKey);
+    if (cached && now < cached->expires) {
+        return cached;
+    }
+
+    std::shared_ptr<CachedKey<Decryptor> > d1 =
+        getDecryptor(privateKey, privateEncoding);
+    std::shared_ptr<CachedKey<Encryptor> > e1 =
+        getEncryptor(publicKey, publicEncoding);
+
+    /* Shared point: the private exponent times the peer's public element,
+     * along with the compressed encodings of both public elements.
+     */
+    CryptoPP::SecByteBlock z;
+    CryptoPP::SecByteBlock own;
+    CryptoPP::SecByteBlock peer;
+    {
+        CachedKey<Decryptor>::Lease decryptor = d1->acquire();
+        CachedKey<Encryptor>::Lease encryptor = e1->acquire();
+
+        const DL_GroupParameters_EC<ECP>& params =
+            decryptor->GetKey().GetGroupParameters();
+        const ECPPoint& q = encryptor->GetKey().GetPublicElement();
+
+        if (!(params == encryptor->GetKey().GetGroupParameters())) {
+            throw CryptoPP::Exception(CryptoPP::Exception::INVALID_ARGUMENT,
+                "Session keys must be on the same curve");
+        }
+
+        // Reject points off the curve before multiplying by the secret.
+        if (!params.ValidateElement(1, q, nullptr)) {
+            throw CryptoPP::Exception(CryptoPP::Exception::INVALID_ARGUMENT,
+                "Invalid peer public key");
+        }
+
+        const ECPPoint shared = params.ExponentiateElement(q,
+            decryptor->GetKey().GetPrivateExponent());
+        if (params.IsIdentity(shared)) {
+            throw CryptoPP::Exception(CryptoPP::Exception::INVALID_ARGUMENT,
+                "Invalid peer public key");
+        }
+
+        z.New(params.GetCurve().GetField().MaxElementByteLength());
+        shared.x.Encode(z.data(), z.size());
+
+        own.New(params.GetEncodedElementSize(true));
+        params.EncodeElement(true, params.ExponentiateBase(
+            decryptor->GetKey().GetPrivateExponent()), own.data());
+        peer.New(own.size());
+        params.EncodeElement(true, q, peer.data());
+    }
+
+    /* Both sides hash the public keys in the same, sorted, order. The
+     * first half of the output keys the direction from the lower key to
+     * the higher one, the second half the other direction.
+     */
+    const bool ownFirst = std::lexicographical_compare(own.begin(), own.end(),
+        peer.begin(), peer.end());
+    const CryptoPP::SecByteBlock& low = ownFirst ? own : peer;
+    const CryptoPP::SecByteBlock& high = ownFirst ? peer : own;
+
+    CryptoPP::SecByteBlock material(2 * SESSION_KEY_BYTES);
+
+    Keccak shake(136, 0x1F);
+    shake.update(reinterpret_cast<const uint8_t*>(SESSION_DOMAIN),
+        sizeof(SESSION_DOMAIN) - 1);
+    shake.update(z.data(), z.size());
+    shake.update(low.data(), low.size());
+    shake.update(high.data(), high.size());
+    shake.finish(material.data(), material.size());
+
+    // Sending material first: the lower key sends with the first half.
+    std::shared_ptr<SessionKey> session = std::make_shared<SessionKey>();
+    session->secret.New(material.size());
+    const uint8_t* lowToHigh = material.data();
+    const uint8_t* highToLow = material.data() + SESSION_KEY_BYTES;
+    std::memcpy(session->secret.data(), ownFirst ? lowToHigh : highToLow,
+        SESSION_KEY_BYTES);
+    std::memcpy(session->secret.data() + SESSION_KEY_BYTES,
+        ownFirst ? highToLow : lowToHigh, SESSION_KEY_BYTES);
+
+    session->expires = now + _sessionLifetime;
+
+    _sessions.put(cacheKey, session);
+    return session;
+}
+
+
+
+// --------------
+// encryptMessage
+// --------------
+/**
+ * @brief Encrypts the message with the given public key.
+ *
+ * @param cipher resulting cipher
+ * @param encodedKey encoded public key
+ * @param encoding encoding of the key
+ * @param message message to be encrypted
+ * @param length length of the message
+ *
+ * @throw CryptoPP::Exception in case of encryption errors
+ *
+ * @return void
+ */
+void SEIFECC::encryptMessage(
+    SecureString& cipher,
+    const std::string& encodedKey,
+    KEY_ENCODING encoding,
+    const uint8_t* message,
+    size_t length
+)
+{
+    // Get the encryption object holding the parsed public key.
+    std::shared_ptr<CachedKey<Encryptor> > e1 =
+        getEncryptor(encodedKey, encoding);
+
+    // Generator of the calling thread, safe on the main thread and workers.
+    CryptoPP::RandomNumberGenerator& prng = ThreadRandomPool::instance();
+
+    // Lease an object of the key no other thread is using.
+    CachedKey<Encryptor>::Lease encryptor = e1->acquire();
+
+    encryptWith(*encryptor, prng, message, length, cipher);
+}
+
+
+
+// ---------------
+// encryptMessages
+// ---------------
+/**
+ * @brief Encrypts a batch of messages with the same public key. The
+ *        key is looked up once; when more than one thread is
+ *        requested the batch is split into contiguous slices, each
+ *        encrypted on its own thread with its own object of the key.
+ *        The threads are capped by the number of hardware threads.
+ *
+ * @param ciphers resulting ciphers, in the order of the messages
+ * @param encodedKey encoded public key
+ * @param encoding encoding of the key
+ * @param messages pointer/length pairs of the messages
+ * @param threads maximum number of threads to use
+ *
+ * @throw CryptoPP::Exception in case of encryption errors, or
+ *        std::system_error if a thread could not be started
+ *
+ * @return void
+ */
+void SEIFECC::encryptMessages(
+    std::vector<std::string>& ciphers,
+    const std::string& encodedKey,
+    KEY_ENCODING encoding,
+    const std::vector<std::pair<const uint8_t*, size_t> >& messages,
+    unsigned int threads
+)
+{
+    // Get the encryption object holding the parsed public key.
+    std::shared_ptr<CachedKey<Encryptor> > e1 =
+        getEncryptor(encodedKey, encoding);
+
+    const size_t count = messages.size();
+    ciphers.resize(count);
+
+    Parallel::forEachSlice(count, threads, 1, [&](size_t begin, size_t end) {
+        /* Curve objects are not safe to share between threads, so each
+         * thread leases its own object of the key.
+         */
+        CachedKey<Encryptor>::Lease encryptor = e1->acquire();
+
+        CryptoPP::RandomNumberGenerator& prng = ThreadRandomPool::instance();
+
+        for (size_t i = begin; i < end; ++i) {
+            encryptWith(*encryptor, prng,
+                messages[i].first, messages[i].second, ciphers[i]);
+        }
+    });
+}
+
+
+
+// --------------
+// decryptMessage
+// --------------
+/**
+ * @brief Decrypts the cipher with the given private key.
+ *
+ * @param message resulting decrypted message
+ * @param encodedKey encoded private key
+ * @param encoding encoding of the key
+ * @param cipher cipher to be decrypted
+ * @param length length of the cipher
+ *
+ * @throw CryptoPP::Exception in case of decryption errors
+ *
+ * @return void
+ */
+void SEIFECC::decryptMessage(
+    SecureString& message,
+    const std::string& encodedKey,
+    KEY_ENCODING encoding,
+    const uint8_t* cipher,
+    size_t length
+)
+{
+    Stats::Timer timer(Stats::OPERATION::ECC_DECRYPT, length);
+
+    // Get the decryption object holding the parsed private key.
+    std::shared_ptr<CachedKey<Decryptor> > d1 =
+        getDecryptor(encodedKey, encoding);
+
+    // Generator of the calling thread, safe on the main thread and workers.
+    CryptoPP::RandomNumberGenerator& prng = ThreadRandomPool::instance();
+
+    /* The message is shorter than the cipher, so reserving that much up
+     * front keeps the sink from growing and its bytes out of the inline
+     * buffer of the string object.
+     */
+    message.reserve(length);
+
+    // Lease an object of the key no other thread is using.
+    CachedKey<Decryptor>::Lease decryptor = d1->acquire();
+
+    /* Apply the CryptoPP PK_DecryptorFilter transformer to decrypt the
+     * cipher buffer and store the result in a string using StringSink.
+     */
+    ArraySource ss6(
+        cipher,
+        length,
+        true,
+        new PK_DecryptorFilter(prng, *decryptor,
+            new CryptoPP::StringSinkTemplate<SecureString>(message))
+    );
+}
+
+
+
+// --------------
+// SavePrivateKey
+// --------------
+/**
+ * @brief Encrypt and save the private key to the disk with the given
+ *        file name.
+ *
+ * @param privateKey private key object
+ * @param file file name of encrypted private key
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ *
+ * @return void
+ */
+void SEIFECC::SavePrivateKey(
+    const PrivateKey& privateKey,
+    const std::string& file,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath
+)
+{
+    // Create file encryptor object.
+    FileCryptopp fileEncryptor(folderPath + file);
+
+    // Save the private key into a string using CryptoPP StringSink.
+    std::string keyStr;
+    StringSink keySink(keyStr);
+
+    privateKey.Save(keySink);
+
+    // Write the string form of the private key to the file.
+    std::stringstream fss(keyStr);
+    Stats::Timer timer(Stats::OPERATION::DISK_WRITE, keyStr.size());
+    fileEncryptor.writeFile(fss, key);
+}
+
+
+// -------------
+// SavePublicKey
+// -------------
+/**
+ * @brief Encrypt and save the public key to the disk with the given
+ *        file name.
+ *
+ * @param publicKey public key object
+ * @param file file name of encrypted public key
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ *
+ * @return void
+ */
+void SEIFECC::SavePublicKey(
+    const PublicKey& publicKey,
+    const std::string& file,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath
+)
+{
+    // Create file encryptor object.
+    FileCryptopp fileEncryptor(folderPath + file);
+
+    // Save the public key into a string using CryptoPP StringSink.
+    std::string keyStr;
+    StringSink keySink(keyStr);
+
+    publicKey.Save(keySink);
+
+    // Write the string form of the public key to the file.
+    std::stringstream fss(keyStr);
+    Stats::Timer timer(Stats::OPERATION::DISK_WRITE, keyStr.size());
+    fileEncryptor.writeFile(fss, key);
+}
+
+
+
+// --------------
+// LoadPrivateKey
+// --------------
+/**
+ * @brief Decrypt the file with the given name and load it as the
+ *        private key.
+ *
+ * @param privateKey private key object
+ * @param file file name of encrypted private key
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ * @param ber set to the decrypted BER encoding of the key when not
+ *        null
+ *
+ * @return status code indicating success or cause of error
+ */
+SEIFECC::STATUS SEIFECC::LoadPrivateKey(
+    PrivateKey& privateKey,
+    const std::string& file,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath,
+    std::string* ber
+)
+{
+    // Create file decryptor object.
+    FileCryptopp fileDecryptor(folderPath + file);
+
+    // If private key file does not exist then return appropriate error.
+    if (!fileDecryptor.fileExists()) {
+        return SEIFECC::STATUS::FILE_NOT_FOUND;
+    }
+
+    // Read the encrypted file to get the private key string.
+    std::stringstream fss;
+    bool decrypted;
+    {
+        Stats::Timer timer(Stats::OPERATION::DISK_READ, 0);
+        decrypted = fileDecryptor.readFile(fss, key);
+        timer.setBytes(static_cast<size_t>(fss.tellp()));
+    }
+    if (!decrypted) {
+        // If decryption fails return an error.
+        return SEIFECC::STATUS::DECRYPTION_ERROR;
+    }
+
+    std::string keyStr = fss.str();
+
+    // Use CryptoPP StringSource to get the private key object from the string.
+    StringSource keySource(keyStr, true);
+
+    privateKey.Load(keySource);
+
+    if (ber != nullptr) {
+        ber->swap(keyStr);
+    }
+
+    return SEIFECC::STATUS::SUCCESS;
+}
+
+
+// -------------
+// LoadPublicKey
+// -------------
+/**
+ * @brief Decrypt the file with the given name and load it as the
+ *        public key.
+ *
+ * @param publicKey public key object
+ * @param file file name of encrypted public key
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ * @param ber set to the decrypted BER encoding of the key when not
+ *        null
+ *
+ * @return status code indicating success or cause of error
+ */
+SEIFECC::STATUS SEIFECC::LoadPublicKey(
+    PublicKey& publicKey,
+    const std::string& file,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath,
+    std::string* ber
+)
+{
+    // Create file decryptor object.
+    FileCryptopp fileDecryptor(folderPath + file);
+
+    // If public key file does not exist then return appropriate error.
+    if (!fileDecryptor.fileExists()) {
+        return SEIFECC::STATUS::FILE_NOT_FOUND;
+    }
+
+    // Read the encrypted file to get the public key string.
+    std::stringstream fss;
+    bool decrypted;
+    {
+        Stats::Timer timer(Stats::OPERATION::DISK_READ, 0);
+        decrypted = fileDecryptor.readFile(fss, key);
+        timer.setBytes(static_cast<size_t>(fss.tellp()));
+    }
+    if (!decrypted) {
+        // If decryption fails return an error.
+        return SEIFECC::STATUS::DECRYPTION_ERROR;
+    }
+
+    std::string keyStr = fss.str();
+
+    // Use CryptoPP StringSource to get the public key object from the string.
+    StringSource keySource(keyStr, true);
+
+    publicKey.Load(keySource);
+
+    if (ber != nullptr) {
+        ber->swap(keyStr);
+    }
+
+    return SEIFECC::STATUS::SUCCESS;
+}
+
+
+
+// ----------
+// encodeKeys
+// ----------
+/**
+ * @brief Encodes the keys of the given decryption object and the
+ *        corresponding encryption object.
+ *
+ * @param d0 decryption object holding the private key
+ * @param e0 encryption object holding the public key
+ * @param encoding encoding of the keys
+ * @param encodedPub set to the encoded public key
+ * @param encodedPriv set to the encoded private key
+ *
+ * @return void
+ */
+void SEIFECC::encodeKeys(
+    const Decryptor& d0,
+    const Encryptor& e0,
+    KEY_ENCODING encoding,
+    std::string& encodedPub,
+    std::string& encodedPriv
+)
+{
+    if (encoding == KEY_ENCODING::BINARY) {
+        // Save the public point compressed, roughly halving its size.
+        Encryptor compressed;
+        compressed.AccessPublicKey().AssignFrom(e0.GetPublicKey());
+        compressed.AccessKey().AccessGroupParameters()
+            .SetPointCompression(true);
+
+        StringSink pubSs(encodedPub), privSs(encodedPriv);
+        compressed.GetPublicKey().Save(pubSs);
+        d0.GetPrivateKey().Save(privSs);
+        return;
+    }
+
+    /* Get the string versions of the keys from the encryption and decryption
+     * objects using CryptoPP StringSink.
+     */
+    std::string pubStr, privStr;
+    StringSink pubSs(pubStr), privSs(privStr);
+    e0.GetPublicKey().Save(pubSs);
+    d0.GetPrivateKey().Save(privSs);
+
+    // Hex encode the string keys using CryptoPP StringSource and HexEncoder.
+    StringSource ss1(pubStr, true,
+        new CryptoPP::HexEncoder(new StringSink(encodedPub)));
+
+    StringSource ss2(privStr, true,
+        new CryptoPP::HexEncoder(new StringSink(encodedPriv)));
+
+    CryptoPP::SecureWipeBuffer(&privStr[0], privStr.size());
+}
+
+
+
+// ---------
+// unwrapKey
+// ---------
+/**
+ * @brief Gets the key from a javascript value, a hex encoded string or a
+ *        buffer holding the BER encoded key.
+ *
+ * @param value javascript string or buffer
+ * @param encodedKey set to the encoded key
+ *
+ * @return encoding of the key
+ */
+SEIFECC::KEY_ENCODING SEIFECC::unwrapKey(
+    v8::Local<v8::Value> value,
+    std::string& encodedKey
+)
+{
+    if (Binding::isBytes(value)) {
+        v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(value).ToLocalChecked();
+
+        encodedKey.assign(Binding::data(bufferObj),
+            Binding::length(bufferObj));
+        return KEY_ENCODING::BINARY;
+    }
+
+    Nan::Utf8String str(value);
+    encodedKey.assign(*str, str.length());
+    return KEY_ENCODING::HEX;
+}
+
+
+
+// --------------
+// unwrapMessages
+// --------------
+/**
+ * @brief Gets the data of each buffer in a javascript array, throwing
+ *        a javascript error if an element is not a buffer.
+ *
+ * @param value javascript array of buffers
+ * @param messages set to the pointer/length pairs of the buffers
+ * @param buffers (optional) array set to the unwrapped buffer objects, for
+ *        async callers to pin while the pointers are in use
+ *
+ * @return boolean indicating whether all elements were buffers
+ */
+bool SEIFECC::unwrapMessages(
+    v8::Local<v8::Value> value,
+    std::vector<std::pair<const uint8_t*, size_t> >& messages,
+    v8::Local<v8::Array>* buffers
+)
+{
+    v8::Local<v8::Array> array = value.As<v8::Array>();
+    const uint32_t count = array->Length();
+
+    messages.clear();
+    messages.reserve(count);
+
+    if (buffers) {
+        *buffers = Nan::New<v8::Array>(count);
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        v8::Local<v8::Value> element = Nan::Get(array, i).ToLocalChecked();
+
+        if (!Binding::isBytes(element)) {
+            Nan::ThrowError("Incorrect Arguments. Messages must be buffers");
+            return false;
+        }
+
+        v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(element).ToLocalChecked();
+        messages.push_back(std::make_pair(
+            Binding::data(bufferObj),
+            Binding::length(bufferObj)
+        ));
+
+        if (buffers) {
+            Nan::Set(*buffers, i, bufferObj);
+        }
+    }
+    return true;
+}
+
+
+
+// ----------
+// keysObject
+// ----------
+/**
+ * @brief Creates the javascript object holding the keys, as strings or
+ *        buffers depending on the encoding.
+ *
+ * @param encodedPub encoded public key
+ * @param encodedPriv encoded private key
+ * @param curve name of the curve of the keys
+ * @param encoding encoding of the keys
+ *
+ * @return object of the form:
+ *         {enc: [publicKey], dec: [privateKey], curve: [curveName]}
+ */
+v8::Local<v8::Object> SEIFECC::keysObject(
+    const std::string& encodedPub,
+    const std::string& encodedPriv,
+    const std::string& curve,
+    KEY_ENCODING encoding
+)
+{
+    v8::Local<v8::Value> pub, priv;
+    if (encoding == KEY_ENCODING::BINARY) {
+        pub = Nan::CopyBuffer(encodedPub.data(), encodedPub.size())
+            .ToLocalChecked();
+        priv = Nan::CopyBuffer(encodedPriv.data(), encodedPriv.size())
+            .ToLocalChecked();
+    } else {
+        pub = Nan::New<v8::String>(encodedPub).ToLocalChecked();
+        priv = Nan::New<v8::String>(encodedPriv).ToLocalChecked();
+    }
+
+    v8::Local<v8::Object> ret = Nan::New<v8::Object>();
+    Nan::Set(ret, Nan::New<v8::String>("enc").ToLocalChecked(), pub);
+    Nan::Set(ret, Nan::New<v8::String>("dec").ToLocalChecked(), priv);
+    Nan::Set(ret,
+        Nan::New<v8::String>("curve").ToLocalChecked(),
+        Nan::New<v8::String>(curve).ToLocalChecked());
+
+    return ret;
+}
+
+
+
+// ---------
+// keyRecord
+// ---------
+/**
+ * @brief Serializes the key pair into a keystore record: the length of
+ *        the encoded private key as 4 little endian bytes followed by
+ *        the encoded private and public keys.
+ *
+ * @param d0 decryption object holding the private key
+ * @param e0 encryption object holding the public key
+ *
+ * @return keystore record
+ */
+std::string SEIFECC::keyRecord(const Decryptor& d0, const Encryptor& e0) {
+    std::string privStr, pubStr;
+    StringSink privSs(privStr), pubSs(pubStr);
+    d0.GetPrivateKey().Save(privSs);
+    e0.GetPublicKey().Save(pubSs);
+
+    std::string record(4, '\0');
+    for (size_t i = 0; i < 4; ++i) {
+        record[i] = static_cast<char>(privStr.size() >> (8 * i));
+    }
+    record += privStr;
+    record += pubStr;
+
+    CryptoPP::SecureWipeBuffer(&privStr[0], privStr.size());
+
+    return record;
+}
+
+
+
+// --------------
+// loadStoredKeys
+// --------------
+/**
+ * @brief Looks up the named key pair in the keystore.
+ *
+ * @param keystore keystore holding the key pair
+ * @param name name of the key pair
+ * @param encoding encoding of the returned keys
+ * @param encodedPub set to the encoded public key
+ * @param encodedPriv set to the encoded private key
+ * @param curve set to the name of the curve of the keys
+ *
+ * @return status code of the keystore lookup, FORMAT_ERROR if the record
+ *         does not hold a key pair
+ */
+Keystore::STATUS SEIFECC::loadStoredKeys(
+    Keystore& keystore,
+    const std::string& name,
+    KEY_ENCODING encoding,
+    std::string& encodedPub,
+    std::string& encodedPriv,
+    std::string& curve
+)
+{
+    std::string record;
+    Keystore::STATUS status = keystore.get(name, record);
+    if (status != Keystore::STATUS::SUCCESS) {
+        return status;
+    }
+
+    size_t privLength = 0;
+    for (size_t i = 0; i < 4 && i < record.size(); ++i) {
+        privLength |= size_t(uint8_t(record[i])) << (8 * i);
+    }
+
+    try {
+        if (record.size() < 4 || privLength > record.size() - 4) {
+            throw std::length_error("Truncated key record");
+        }
+
+        // Load the keys from the BER encoded strings of the record.
+        Decryptor d0;
+        StringSource privSource((const uint8_t*)record.data() + 4, privLength,
+            true);
+        d0.AccessPrivateKey().Load(privSource);
+
+        Encryptor e0;
+        StringSource pubSource((const uint8_t*)record.data() + 4 + privLength,
+            record.size() - 4 - privLength, true);
+        e0.AccessPublicKey().Load(pubSource);
+
+        encodeKeys(d0, e0, encoding, encodedPub, encodedPriv);
+
+        curve = curveToName(d0.GetKey().GetGroupParameters().GetCurveOID());
+    } catch (const std::exception&) {
+        status = Keystore::STATUS::FORMAT_ERROR;
+    }
+
+    CryptoPP::SecureWipeBuffer(&record[0], record.size());
+
+    return status;
+}
+
+
+
+// --------
+// loadKeys
+// --------
+/**
+ * @brief Loads the keys by decrypting the existing files, the
+ *        public key file on a second thread while the private key
+ *        file is read on the calling one.
+ *
+ * @param encodedPub public key to be loaded from encrypted file
+ * @param encodedPriv private key to be loaded from encrypted file
+ * @param curve name of the curve recorded in the key files
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ * @param encoding encoding of the returned keys
+ * @param timings set to the durations of the phases of loading
+ *
+ * @return status code indicating success or cause of error
+ */
+SEIFECC::STATUS SEIFECC::loadKeys(
+    std::string& encodedPub,
+    std::string& encodedPriv,
+    std::string& curve,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath,
+    KEY_ENCODING encoding,
+    LoadTimings& timings
+)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
+    /* Decrypt and parse the public key file on a second thread while the
+     * private key file is handled on this one.
+     */
+    ECIES<ECP>::Encryptor e0;
+    std::string pubBer;
+    SEIFECC::STATUS pubRc = SEIFECC::STATUS::SUCCESS;
+    std::exception_ptr pubError;
+
+    std::thread pubLoader([&]() {
+        try {
+            pubRc = LoadPublicKey(e0.AccessPublicKey(), PUB_KEY_FILE_NAME,
+                key, folderPath, &pubBer);
+        } catch (...) {
+            pubError = std::current_exception();
+        }
+        timings.publicKey = elapsedMilliseconds(start);
+    });
+
+    // ECC Decryption object containing the private key.
+    ECIES<ECP>::Decryptor d0;
+    std::string privBer;
+    SEIFECC::STATUS rc;
+    try {
+        rc = LoadPrivateKey(d0.AccessPrivateKey(), PRIV_KEY_FILE_NAME, key,
+            folderPath, &privBer);
+    } catch (...) {
+        pubLoader.join();
+        throw;
+    }
+    timings.privateKey = elapsedMilliseconds(start);
+
+    pubLoader.join();
+
+    /* If loading a key fails return the error, which could be due to the
+     * file not being present on the disk or due to a decryption error. The
+     * private key is reported first.
+     */
+    if (rc == SEIFECC::STATUS::SUCCESS) {
+        if (pubError) {
+            std::rethrow_exception(pubError);
+        }
+        rc = pubRc;
+    }
+
+    if (rc != SEIFECC::STATUS::SUCCESS) {
+        CryptoPP::SecureWipeBuffer(&privBer[0], privBer.size());
+        return rc;
+    }
+
+    const Clock::time_point encodeStart = Clock::now();
+
+    /* The decrypted files already hold the BER encoding of the keys, so
+     * hex keys are encoded from them without serializing the key objects
+     * again. Binary public keys are serialized again with the point
+     * compressed.
+     */
+    if (encoding == KEY_ENCODING::HEX) {
+        StringSource ss1(pubBer, true,
+            new CryptoPP::HexEncoder(new StringSink(encodedPub)));
+
+        StringSource ss2(privBer, true,
+            new CryptoPP::HexEncoder(new StringSink(encodedPriv)));
+    } else {
+        Encryptor compressed;
+        compressed.AccessPublicKey().AssignFrom(e0.GetPublicKey());
+        compressed.AccessKey().AccessGroupParameters()
+            .SetPointCompression(true);
+
+        StringSink pubSs(encodedPub);
+        compressed.GetPublicKey().Save(pubSs);
+        encodedPriv = privBer;
+    }
+    CryptoPP::SecureWipeBuffer(&privBer[0], privBer.size());
+
+    // The curve is part of the encoded key parameters.
+    curve = curveToName(d0.GetKey().GetGroupParameters().GetCurveOID());
+
+    timings.encode = elapsedMilliseconds(encodeStart);
+    timings.total = elapsedMilliseconds(start);
+
+    return SEIFECC::STATUS::SUCCESS;
+}
+
+
+// ------------
+// generateKeys
+// ------------
+/**
+ * @brief Takes a pregenerated key pair from the pool, or initializes the
+ *        RNG and uses it to generate the public and private keys, then
+ *        encrypts them and saves them to disk.
+ *
+ * @param encodedPub public key to be generated
+ * @param encodedPriv private key to be generated
+ * @param curve name of the curve to generate the keys on
+ * @param key disk access key for public/private keys and
+ *        rng state
+ * @param folderPath folder containing keys and rng state files
+ * @param keystore keystore to save the keys in under 'name', or null to
+ *        save them to the key files of the folder
+ * @param name name of the keys in the keystore
+ * @param pool pool of pregenerated key pairs, or null to generate them
+ * @param encoding encoding of the returned keys
+ * @param retries set to the number of entropy gathering retries
+ * @param strength set to the entropy strength of the RNG
+ * @param error set to the error message on failure
+ *
+ * @return status code indicating success or cause of error
+ */
+SEIFECC::STATUS SEIFECC::generateKeys(
+    std::string& encodedPub,
+    std::string& encodedPriv,
+    const std::string& curve,
+    const std::vector<uint8_t>& key,
+    const std::string& folderPath,
+    Keystore* keystore,
+    const std::string& name,
+    KeyPool* pool,
+    KEY_ENCODING encoding,
+    unsigned int& retries,
+    std::string& strength,
+    std::string& error
+)
+{
+    CryptoPP::OID oid;
+    if (!curveFromName(curve, oid)) {
+        error = "Unsupported curve";
+        return STATUS::CURVE_ERROR;
+    }
+
+    // Take a pregenerated pair when the pool holds keys on this curve.
+    std::unique_ptr<KeyPool::KeyPair> pair;
+    if (pool != nullptr && pool->curve() == oid) {
+        pair = pool->take(retries, strength);
+    }
+
+    std::lock_guard<std::mutex> lock(keyGenerationMutex);
+
+    if (!pair) {
+        STATUS status = createKeyPair(pair, oid, folderPath, retries,
+            strength, error);
+        if (status != STATUS::SUCCESS) {
+            return status;
+        }
+    }
+
+    const Decryptor& d0 = pair->decryptor;
+    const Encryptor& e0 = pair->encryptor;
+
+    // Save the validated keys to encrypted files or the keystore.
+    try {
+        if (keystore == nullptr) {
+            SavePrivateKey(d0.GetPrivateKey(), PRIV_KEY_FILE_NAME, key,
+                folderPath);
+            SavePublicKey(e0.GetPublicKey(), PUB_KEY_FILE_NAME, key,
+                folderPath);
+        } else if (keystore->put(name, keyRecord(d0, e0)) !=
+                   Keystore::STATUS::SUCCESS) {
+            error = "Keys could not be saved in the keystore";
+            return STATUS::KEY_GENERATION_ERROR;
+        }
+    } catch (...) {
+        error = "Key generation failed";
+        return STATUS::KEY_GENERATION_ERROR;
+    }
+
+    // Encode the keys as requested.
+    encodeKeys(d0, e0, encoding, encodedPub, encodedPriv);
+
+    return STATUS::SUCCESS;
+}
+
+
+
+// -------------
+// createKeyPair
+// -------------
+/**
+ * @brief Initializes a new isaac RNG from the folder's state file and uses
+ *        it to generate and validate a key pair. Must be called with
+ *        'keyGenerationMutex' held.
+ *
+ * @param pair set to the validated key pair
+ * @param oid curve to generate the keys on
+ * @param folderPath folder containing the rng state file
+ * @param retries set to the number of entropy gathering retries
+ * @param strength set to the entropy strength of the RNG
+ * @param error set to the error message on failure
+ *
+ * @return status code indicating success or cause of error
+ */
+SEIFECC::STATUS SEIFECC::createKeyPair(
+    std::unique_ptr<KeyPool::KeyPair>& pair,
+    const CryptoPP::OID& oid,
+    const std::string& folderPath,
+    unsigned int& retries,
+    std::string& strength,
+    std::string& error
+)
+{
+    // Using the default file name for the RNG saved state.
+    std::string fileName = RNG_STATE_FILE_NAME;
+
+    std::string fileId = folderPath + fileName;
+
+    IsaacRandomPool prng;
+
+    /* Initialize the global Isaac rng object and check if
+     * initialization succeeded. if it fails, increase the multiplier argument
+     * which causes more data to be collected to get higher entropy.
+     */
+    int multiplier = 0;
+
+    try {
+        for (; multiplier < MAX_ENTROPY_GEN_MULTIPLIER; ++multiplier) {
+            if (prng.Initialize(fileId, multiplier)) {
+                break;
+            }
+        }
+    } catch (const std::exception& ex) {
+
+        // If there is any hardware error, report it to the caller.
+        retries = multiplier;
+        error = ex.what();
+        return STATUS::ENTROPY_ERROR;
+    }
+
+    retries = multiplier;
+
+    // If initialization fails after max retries, report an error.
+    if (multiplier == MAX_ENTROPY_GEN_MULTIPLIER) {
+        error = "Not enough entropy!";
+        return STATUS::ENTROPY_ERROR;
+    }
+
+    strength = prng.EntropyStrength();
+
+    /* ECC Decryption object created using our Isaac RNG and the selected
+     * curve, along with the corresponding encryption object. The curve OID
+     * is saved along with the keys.
+     */
+    pair.reset(new KeyPool::KeyPair(prng, oid));
+
+    // Validate the private and public keys using our Isaac RNG.
+    try {
+        pair->decryptor.GetPrivateKey().ThrowIfInvalid(prng, 3);
+        pair->encryptor.GetPublicKey().ThrowIfInvalid(prng, 3);
+    } catch (...) {
+        pair.reset();
+        error = "Key generation failed";
+        return STATUS::KEY_GENERATION_ERROR;
+    }
+
+    return STATUS::SUCCESS;
+}
+
+
+
+
+
+// ---
+// New
+// ---
+/**
+ * @brief Creates the node object and corresponding underlying object
+ *        with provided arguments - disk access key and folder
+ *        containing the encrypted keys.
+ *
+ * Invoked as:
+ * 'let obj = new SEIFECC(diskKey, folder, options)' or
+ * 'let obj = SEIFECC(diskKey, folder, options)' where
+ * 'diskKey' is the key used to encrypt the keys and rng state
+ * 'folder' is the folder where the keys and rng state are saved on disk
+ * 'options' (optional) is of the form:
+ * {keyCacheSize: [number of parsed keys of each kind to cache],
+ *  precomputeStorage: [number of precomputed points per public key],
+ *  curve: [secp256r1, secp384r1 or secp521r1 (default)],
+ *  keyEncoding: [hex (default) or binary],
+ *  sessionCacheSize: [number of session keys to cache],
+ *  sessionLifetime: [milliseconds a session key is reused],
+ *  keyPoolSize: [number of key pairs on 'curve' to pregenerate, 0 (default)
+ *  disables the pool],
+ *  keyPoolRate: [maximum pairs pregenerated per second, 0 (default) for no
+ *  limit]}
+ * The numeric options must be non-negative 32-bit integers, other values
+ * throw an error.
+ *
+ * @param info node.js arguments wrapper containing the disk access key
+ *        and folder path
+ *
+ * @return
+ */
+NAN_METHOD(SEIFECC::New) {
+
+    if (info.IsConstructCall()) {
+
+        // Invoked as constructor: 'let obj = new SEIFECC()'.
+
+        // Check arguments.
+        if (!Binding::isBytes(info[0])) {
+
+            Nan::ThrowError("Incorrect Arguments. Disk access key buffer "
+                            "not provided");
+            return;
+        }
+
+        /* Unwrap the first argument to get the key buffer used to store
+         * RNG state to the disk.
+         */
+        v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(info[0]).ToLocalChecked();
+
+        uint8_t* bufferData = Binding::data(bufferObj);
+        size_t bufferLength = Binding::length(bufferObj);
+
+        /* If the size of key buffer is less than AES key size then hash the
+         * given data to get key of the required size.
+         */
+        std::vector<uint8_t> digest;
+        if (bufferLength < 32) {
+            digest.resize(CryptoPP::SHA3_256::DIGESTSIZE);
+            std::string bufferString(reinterpret_cast<const char*>(bufferData),
+                reinterpret_cast<const char*>(bufferData) + bufferLength);
+            hashString(digest, bufferString);
+
+        } else {
+            digest.reserve(CryptoPP::SHA3_256::DIGESTSIZE);
+            std::copy(bufferData, bufferData + bufferLength,
+                std::back_inserter(digest));
+        }
+
+        /* Unwrap the second argument to get the folder on disk where the RNG
+         * state and keys will be encrypted and stored.
+         */
+        std::string folder = "./";
+        if (!info[1]->IsUndefined()) {
+            Nan::Utf8String str(info[1]);
+            folder = *str;
+            if (folder.back() != '/') {
+                folder = folder + "/";
+            }
+        }
+
+        // Unwrap the optional third argument to get the options object.
+        uint32_t keyCacheSize = DEFAULT_KEY_CACHE_SIZE;
+        uint32_t precomputeStorage = 0;
+        std::string curve = DEFAULT_CURVE;
+        KEY_ENCODING keyEncoding = KEY_ENCODING::HEX;
+        uint32_t sessionCacheSize = DEFAULT_SESSION_CACHE_SIZE;
+        uint32_t sessionLifetime = DEFAULT_SESSION_LIFETIME;
+        uint32_t keyPoolSize = 0;
+        uint32_t keyPoolRate = 0;
+        if (info[2]->IsObject()) {
+            v8::Local<v8::Object> options =
+                Nan::To<v8::Object>(info[2]).ToLocalChecked();
+
+            v8::Local<v8::Value> cacheSize = Nan::Get(options,
+                Nan::New<v8::String>("keyCacheSize").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (!countFromValue(cacheSize, keyCacheSize)) {
+                Nan::ThrowError("Invalid keyCacheSize");
+                return;
+            }
+
+            v8::Local<v8::Value> storage = Nan::Get(options,
+                Nan::New<v8::String>("precomputeStorage").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (!countFromValue(storage, precomputeStorage)) {
+                Nan::ThrowError("Invalid precomputeStorage");
+                return;
+            }
+
+            v8::Local<v8::Value> curveName = Nan::Get(options,
+                Nan::New<v8::String>("curve").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (curveName->IsString()) {
+                curve = std::string(*Nan::Utf8String(curveName));
+
+                CryptoPP::OID oid;
+                if (!curveFromName(curve, oid)) {
+                    Nan::ThrowError("Unsupported curve");
+                    return;
+                }
+            }
+
+            v8::Local<v8::Value> encodingName = Nan::Get(options,
+                Nan::New<v8::String>("keyEncoding").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (encodingName->IsString()) {
+                std::string encoding(*Nan::Utf8String(encodingName));
+
+                if (encoding == "binary") {
+                    keyEncoding = KEY_ENCODING::BINARY;
+                } else if (encoding != "hex") {
+                    Nan::ThrowError("Unsupported key encoding");
+                    return;
+                }
+            }
+
+            v8::Local<v8::Value> sessionSize = Nan::Get(options,
+                Nan::New<v8::String>("sessionCacheSize").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (!countFromValue(sessionSize, sessionCacheSize)) {
+                Nan::ThrowError("Invalid sessionCacheSize");
+                return;
+            }
+
+            v8::Local<v8::Value> lifetime = Nan::Get(options,
+                Nan::New<v8::String>("sessionLifetime").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (!countFromValue(lifetime, sessionLifetime)) {
+                Nan::ThrowError("Invalid sessionLifetime");
+                return;
+            }
+
+            v8::Local<v8::Value> poolSize = Nan::Get(options,
+                Nan::New<v8::String>("keyPoolSize").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (!countFromValue(poolSize, keyPoolSize)) {
+                Nan::ThrowError("Invalid keyPoolSize");
+                return;
+            }
+
+            v8::Local<v8::Value> poolRate = Nan::Get(options,
+                Nan::New<v8::String>("keyPoolRate").ToLocalChecked()
+            ).ToLocalChecked();
+
+            if (!countFromValue(poolRate, keyPoolRate)) {
+                Nan::ThrowError("Invalid keyPoolRate");
+                return;
+            }
+        }
+
+        // Create the wrapped object using the disk access key and given folder.
+        SEIFECC* obj = new SEIFECC(digest, folder, keyCacheSize,
+            precomputeStorage, curve, keyEncoding, sessionCacheSize,
+            sessionLifetime, keyPoolSize, keyPoolRate);
+
+        obj->Wrap(info.This());
+        info.GetReturnValue().Set(info.This());
+
+    } else {
+
+        // Invoked as plain function `SEIFECC(...)`, turn into construct call.
+        const int argc = info.Length();
+
+        // Creating argument array for construct call.
+        std::vector<v8::Local<v8::Value> > argv;
+        argv.reserve(argc);
+        for (int i = 0; i < argc; ++i) {
+            argv.push_back(info[i]);
+        }
+
+        v8::Local<v8::Function> cons =
+            Binding::constructor(info.Data(), Binding::CLASS::SEIFECC);
+        info.GetReturnValue().Set(
+            Nan::NewInstance(cons, argc, argv.data()).ToLocalChecked());
+
+    }
+}
+
+
+
+
+// --------
+// loadKeys
+// --------
+/**
+ * @brief Creates an async worker to load keys from the disk and
+ *        invokes the callback function with the error object (if
+ *        applicable) and/or the object containing the keys.
+ *
+ * Invoked as:
+ * 'obj.loadKeys(function(status, keys){})' where
+ * 'status' (if applicable) is of the form:
+ * {code: [statusCode], message: [statusMessage]}
+ * 'keys' (if available) is of the form:
+ * {enc: [publicKey], dec: [privateKey]}, the keys being hex encoded
+ * strings or BER buffers depending on the 'keyEncoding' option
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFECC::loadKeys) {
+
+    // Get a reference to the wrapped object from the argument.
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
+
+    // Unwrap the first argument to get given callback function.
+    Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
+
+    // Initialize the async worker and queue it.
+    Worker* worker = new Worker(
+        callback,
+        obj->_key,
+        obj->_folderPath,
+        obj->_keyEncoding
+    );
+
+    Nan::AsyncQueueWorker(worker);
+}
+
+
+// ---------------
+// entropyStrength
+// ---------------
+
+/**
+ * @brief Returns the possible strength of entropy avaible for mining.
+ *
+ * @return A string with values "WEAK", "MEDIUM" or "STRONG". If the only
+ *		   source of entropy is the OS this makes the module's strength
+ *		   WEAK w.r.t entropy, access to either the microphone or camera
+ *		   results in Medium strength and finally access to the OS, camera,
+ *		   microphone and more enables STRONG strength.
+ */
+NAN_METHOD(SEIFECC::entropyStrength) {
+    // Get a reference to the wrapped object from the argument.
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
+
+    // The entropy sources are being mined by an async key generation.
+    if (obj->_busy > 0) {
+        Nan::ThrowError(RNG::BUSY_MESSAGE);
+        return;
+    }
+
+    std::string strength = obj->prng.EntropyStrength();
+    // Return strength of underlying RNG used for key generation.
+    info.GetReturnValue().Set(
+        Nan::New<v8::String>(strength).ToLocalChecked()
+    );
+}
+
+
+// ------------
+// generateKeys
+// ------------
+/**
+ * @brief Initializes the isaac RNG and uses it to generate the
+ *        public/private keys, or takes a pair from the key pool, and
+ *        returns them to the caller.
+ *
+ * Invoked as:
+ * 'let keys = obj.generateKeys(curve)' where
+ * 'curve' (optional) overrides the curve given at construction
+ * 'keys' (if available) is of the form:
+ * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFECC::generateKeys) {
+
+    // Get a reference to the wrapped object from the argument.
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
+
+    std::string curve = obj->_curve;
+    if (info[0]->IsString()) {
+        curve = std::string(*Nan::Utf8String(info[0]));
+    }
+
+    // Generate the public and private keys as strings and save them to disk.
+    std::string encodedPub, encodedPriv, strength, error;
+    unsigned int retries = 0;
+    STATUS status = generateKeys(
+        encodedPub,
+        encodedPriv,
+        curve,
+        obj->_key,
+        obj->_folderPath,
+        nullptr,
+        "",
+        obj->_keyPool.get(),
+        obj->_keyEncoding,
+        retries,
+        strength,
+        error
+    );
+
+    // Keys that fail validation or cannot be saved are not returned.
+    if (status == STATUS::KEY_GENERATION_ERROR) {
+        return;
+    }
+
+    if (status != STATUS::SUCCESS) {
+        Nan::ThrowError(error.c_str());
+        return;
+    }
+
+    /* Creating js object with 'enc' set as the public key and
+     * 'dec' as the private key.
+     */
+    v8::Local<v8::Object> ret = keysObject(encodedPub, encodedPriv, curve,
+        obj->_keyEncoding);
+
+    // Set the above object as the value to be returned to node.js.
+    info.GetReturnValue().Set(ret);
+}
+
+
+
+// -----------------
+// generateKeysAsync
+// -----------------
+/**
+ * @brief Creates an async worker which initializes the isaac RNG and
+ *        uses it to generate the public/private keys on the libuv
+ *        thread pool, invoking the callback function with the status
+ *        and the keys.
+ *
+ * Invoked as:
+ * 'obj.generateKeysAsync(curve, function(status, keys){})' where
+ * 'curve' (optional) overrides the curve given at construction
+ * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+ * 'keys' (if available) is of the form:
+ * {enc: [publicKey], dec: [privateKey], curve: [curveName],
+ *  strength: [entropyStrength], retries: [retries]}
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFECC::generateKeysAsync) {
+
+    // Get a reference to the wrapped object from the argument.
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
+
+    // The curve is optional, so the callback is the last argument.
+    int callbackIndex = info.Length() > 1 ? 1 : 0;
+    if (!info[callbackIndex]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
+        return;
+    }
+
+    std::string curve = obj->_curve;
+    if (callbackIndex == 1 && info[0]->IsString()) {
+        curve = std::string(*Nan::Utf8String(info[0]));
+    }
+
+    Nan::Callback* callback =
+        new Nan::Callback(info[callbackIndex].As<v8::Function>());
+
+    KeyGenWorker* worker = new KeyGenWorker(callback, obj, obj->_key,
+        obj->_folderPath, curve, obj->_keyEncoding, obj->_keyPool);
+
+    // Keep the wrapped object alive until the worker completes.
+    worker->SaveToPersistent("ecc", info.Holder());
+
+    ++obj->_busy;
+    Nan::AsyncQueueWorker(worker);
+}
+
+
+
+// -------
+// encrypt
+// -------
+/**
+ * @brief Unwraps the arguments to get the public key and message and
+ *        encrypt the message using the public key to return the cipher.
+ *
+ * Invoked as:
+ * 'let cipher = obj.encrypt(key, message)'
+ * 'key' is the hex encoded string or BER buffer of the ECC public key
+ * 'message' is the buffer containing the message to be encrypted
+ * 'cipher' is the string containing the encrypted cipher
+ *
+ * @param info node.js arguments wrapper containing public key string
+ *        and message
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFECC::encrypt) {
 
-    // If public key file does not exist then return appropriate error.
-    if (!fileDecryptor.fileExists()) {
-        return SEIFECC::STATUS::FILE_NOT_FOUND;
+    // Check arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
+        return;
     }
 
-    // Read the encrypted file to get the public key string.
-    std::stringstream fss;
-    if (!fileDecryptor.readFile(fss, key)) {
-        // If decryption fails return an error.
-        return SEIFECC::STATUS::DECRYPTION_ERROR;
+    if (!Binding::isBytes(info[1])) {
+
+        Nan::ThrowError("Incorrect Arguments. Message buffer not provided");
+        return;
     }
 
-    std::string keyStr = fss.str();
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    // Use CryptoPP StringSource to get the public key object from the string.
-    StringSource keySource(keyStr, true);
+    // Unwrap the first argument to get the hex encoded or binary public key.
+    std::string pubStr;
+    KEY_ENCODING encoding = unwrapKey(info[0], pubStr);
 
-    publicKey.Load(keySource);
+    // Unwrap the second argument to get the message buffer to be encrypted.
+    v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(info[1]).ToLocalChecked();
 
-    return SEIFECC::STATUS::SUCCESS;
-}
+    uint8_t* messageData = Binding::data(bufferObj);
+    size_t messageLength = Binding::length(bufferObj);
 
+    // String containing the encrypted cipher.
+    SecureString enc;
+    try {
 
+        obj->encryptMessage(enc, pubStr, encoding, messageData,
+            messageLength);
 
-// --------
-// loadKeys
-// --------
+    } catch (const std::exception& ex) {
+        Nan::ThrowError(ex.what());
+        return;
+    } catch (...) {
+        Nan::ThrowError("Unknown error while encrypting message");
+        return;
+    }
+
+    // Hand the cipher over to a node.js buffer without copying it.
+    info.GetReturnValue().Set(Binding::externalBuffer(std::move(enc)));
+}
+
+
+// -------
+// decrypt
+// -------
 /**
- * @brief Loads the keys by decrypting existing files and initializes
- *        the random number generator.
+ * @brief Unwraps the arguments to get private key and cipher and
+ *        decrypt the cipher using the private key to return the
+ *        original message.
  *
- * @param encodedPub public key to be loaded from encrypted file
- * @param encodedPriv private key to be loaded from encrypted file
- * @param key disk access key for public/private keys and
- *        rng state
- * @param folderPath folder containing keys and rng state files
+ * Invoked as:
+ * 'let message = obj.decrypt(key, cipher)'
+ * 'key' is the hex encoded string or BER buffer of the ECC private key
+ * 'cipher' is the string containing the cipher to be decrypted
+ * 'message' is the buffer containing the decrypted message
  *
- * @return status code indicating success or cause of error
+ * @param info node.js arguments wrapper containing private key string
+ *        and cipher.
+ *
+ * @return void
  */
-SEIFECC::STATUS SEIFECC::loadKeys(
-    std::string& encodedPub,
-    std::string& encodedPriv,
-    const std::vector<uint8_t>& key,
-    const std::string& folderPath
-)
-{
-    // ECC Decryption object containing the private key.
-    ECIES<ECP>::Decryptor d0;
+NAN_METHOD(SEIFECC::decrypt) {
 
-    // Load the private key from encrypted file on disk.
-    SEIFECC::STATUS rc;
-    if ((rc = LoadPrivateKey(d0.AccessPrivateKey(), PRIV_KEY_FILE_NAME,
-                             key, folderPath))
-        != SEIFECC::STATUS::SUCCESS) {
-        /* If loading the key fails return the error which could be due to
-         * the file not being present on the disk or due to a decryption error.
-         */
-        return rc;
+    // Check arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
+        return;
     }
 
-    // ECC Decryption object containing the public key
-    ECIES<ECP>::Encryptor e0;
-
-    // Load the public key from encrypted file on disk.
-    if ((rc = LoadPublicKey(e0.AccessPublicKey(), PUB_KEY_FILE_NAME,
-                            key, folderPath))
-        != SEIFECC::STATUS::SUCCESS) {
-        /* If loading the key fails return the error which could be due to
-         * the file not being present on the disk or due to a decryption error.
-         */
-        return rc;
+    if (info[1]->IsUndefined() || !Binding::isBytes(info[1])) {
+        Nan::ThrowError("Incorrect Arguments. Missing encrypted cipher buffer");
+        return;
     }
 
-    /* Get the string versions of the keys from the encryption and decryption
-     * objects using CryptoPP StringSink.
-     */
-    std::string pubStr, privStr;
-    StringSink pubSs(pubStr), privSs(privStr);
-    e0.GetPublicKey().Save(pubSs);
-    d0.GetPrivateKey().Save(privSs);
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    // Hex encode the string keys using CryptoPP StringSource and HexEncoder.
-    StringSource ss1(pubStr, true,
-        new CryptoPP::HexEncoder(new StringSink(encodedPub)));
+    // Unwrap the first argument to get the hex encoded or binary private key.
+    std::string privStr;
+    KEY_ENCODING encoding = unwrapKey(info[0], privStr);
 
-    StringSource ss2(privStr, true,
-        new CryptoPP::HexEncoder(new StringSink(encodedPriv)));
+    // Unwrap the second argument to get the cipher buffer.
+    v8::Local<v8::Object> bufferObj1 =
+                Nan::To<v8::Object>(info[1]).ToLocalChecked();
+    uint8_t* cipherData = Binding::data(bufferObj1);
+    size_t cipherLength = Binding::length(bufferObj1);
 
-    // Hash the hex encoded private key string using CryptoPP SHA3_256.
-    std::vector<uint8_t> digest(CryptoPP::SHA3_256::DIGESTSIZE);
-    hashString(digest, encodedPriv);
+    // string containing decrypted string message, wiped on release
+    SecureString dm0;
 
-    // Using the default file name for the RNG saved state.
-    std::string fileName = RNG_STATE_FILE_NAME;
+    try {
 
-    std::string fileId = folderPath + fileName;
+        obj->decryptMessage(dm0, privStr, encoding, cipherData,
+            cipherLength);
 
-    return SEIFECC::STATUS::SUCCESS;
+    } catch (const std::exception& ex) {
+
+        Nan::ThrowError(ex.what());
+        return;
+
+    } catch (...) {
+
+        Nan::ThrowError("Unknown error while decrypting message");
+        return;
+    }
+
+    /* Hand the decrypted message over to a node.js buffer without copying
+     * it, so it stays in the secure arena until the buffer is collected.
+     */
+    info.GetReturnValue().Set(Binding::externalBuffer(std::move(dm0)));
 }
 
 
-// ------------
-// generateKeys
-// ------------
+
+// -----------
+// encryptMany
+// -----------
 /**
- * @brief Initialize the RNG and use it to generate the public and
- *        private keys, encrypt them and save to disk.
+ * @brief Unwraps the arguments to get the public key and an array of
+ *        messages and encrypts all of them with the same key in a
+ *        single call.
  *
- * @param encodedPub public key to be generated
- * @param encodedPriv private key to be generated
- * @param key disk access key for public/private keys and
- *        rng state
- * @param folderPath folder containing keys and rng state files
+ * Invoked as:
+ * 'let ciphers = obj.encryptMany(key, messages, threads)'
+ * 'key' is the hex encoded string or BER buffer of the ECC public key
+ * 'messages' is an array of buffers to be encrypted
+ * 'threads' (optional) is the maximum number of threads to spread the
+ * batch across (default 1, capped by the number of hardware threads)
+ * 'ciphers' is an array of cipher buffers in the order of 'messages'
+ *
+ * @param info node.js arguments wrapper
  *
- * @return boolean indicating success/failure
+ * @return void
  */
-bool SEIFECC::generateKeys(
-    std::string& encodedPub,
-    std::string& encodedPriv,
-    const std::vector<uint8_t>& key,
-    const std::string& folderPath
-)
-{
-    // Using the default file name for the RNG saved state.
-    std::string fileName = RNG_STATE_FILE_NAME;
+NAN_METHOD(SEIFECC::encryptMany) {
 
-    std::string fileId = folderPath + fileName;
+    // Check arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
+        return;
+    }
 
-    IsaacRandomPool prng;
+    if (!info[1]->IsArray()) {
+        Nan::ThrowError("Incorrect Arguments. Array of message buffers not "
+                        "provided");
+        return;
+    }
 
-    /* Initialize the global Isaac rng object and check if
-     * initialization succeeded. if it fails, increase the multiplier argument
-     * which causes more data to be collected to get higher entropy.
-     */
-    int multiplier = 0;
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    try {
-        for (; multiplier < 6; ++multiplier) {
-            if (prng.Initialize(fileId, multiplier)) {
-                break;
-            }
-        }
-    } catch (const std::exception& ex) {
+    // Unwrap the first argument to get the hex encoded or binary public key.
+    std::string pubStr;
+    KEY_ENCODING encoding = unwrapKey(info[0], pubStr);
 
-        // If there is any hardware error, catch and throw the error to node.js
-        Nan::ThrowError(ex.what());
-        return false;
+    // Unwrap the second argument to get the message buffers.
+    std::vector<std::pair<const uint8_t*, size_t> > messages;
+    if (!unwrapMessages(info[1], messages)) {
+        return;
     }
+    const uint32_t count = static_cast<uint32_t>(messages.size());
 
-    // If initialization fails after max retries, throw an error to node.js.
-    if (multiplier == 6) {
-        Nan::ThrowError("Not enough entropy!");
-        return false;
+    // Unwrap the optional third argument to get the number of threads.
+    unsigned int threads = 1;
+    if (info[2]->IsNumber()) {
+        threads = Nan::To<uint32_t>(info[2]).FromJust();
     }
 
-    // ECC Decryption object created using our Isaac RNG and secp521r1 curve.
-    ECIES<ECP>::Decryptor d0(prng, CryptoPP::ASN1::secp521r1());
+    // Strings containing the encrypted ciphers.
+    std::vector<std::string> ciphers;
+    try {
 
-    // ECC Encryption object corresponding to the above decryptor object.
-    ECIES<ECP>::Encryptor e0(d0);
+        obj->encryptMessages(ciphers, pubStr, encoding, messages, threads);
 
-    /* Generate the private and public keys using our Isaac RNG and
-     * save them to encrypted files on the disk in the given folder.
-     */
-    try {
-        d0.GetPrivateKey().ThrowIfInvalid(prng, 3);
-        e0.GetPublicKey().ThrowIfInvalid(prng, 3);
-        SavePrivateKey(d0.GetPrivateKey(), PRIV_KEY_FILE_NAME, key, folderPath);
-        SavePublicKey(e0.GetPublicKey(), PUB_KEY_FILE_NAME, key, folderPath);
+    } catch (const std::exception& ex) {
+        Nan::ThrowError(ex.what());
+        return;
     } catch (...) {
-        return false;
+        Nan::ThrowError("Unknown error while encrypting messages");
+        return;
     }
 
-    // Get the string versions of the public and private keys using StringSink.
-    std::string pubStr, privStr;
-    StringSink pubSs(pubStr), privSs(privStr);
-    e0.GetPublicKey().Save(pubSs);
-    d0.GetPrivateKey().Save(privSs);
-
-    // Hex encode the string keys using CryptoPP StringSource and HexEncoder.
-    StringSource ss1(pubStr, true,
-        new CryptoPP::HexEncoder(new StringSink(encodedPub)));
-
-    StringSource ss2(privStr, true,
-        new CryptoPP::HexEncoder(new StringSink(encodedPriv)));
+    // Hand the ciphers over to an array of node.js buffers.
+    v8::Local<v8::Array> ret = Nan::New<v8::Array>(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        Nan::Set(ret, i, Binding::externalBuffer(std::move(ciphers[i])));
+    }
 
-    return true;
+    info.GetReturnValue().Set(ret);
 }
 
 
 
-
-
-// ---
-// New
-// ---
+// ----------------
+// encryptManyAsync
+// ----------------
 /**
- * @brief Creates the node object and corresponding underlying object
- *        with provided arguments - disk access key and folder
- *        containing the encrypted keys.
+ * @brief Unwraps the arguments to get the public key, an array of
+ *        messages and callback and creates an async worker which
+ *        encrypts all of them on the libuv thread pool.
  *
  * Invoked as:
- * 'let obj = new SEIFECC(diskKey, folder)' or
- * 'let obj = SEIFECC(diskKey, folder)' where
- * 'diskKey' is the key used to encrypt the keys and rng state
- * 'folder' is the folder where the keys and rng state are saved on disk
+ * 'obj.encryptManyAsync(key, messages, threads, function(status, ciphers){})'
+ * 'key' is the hex encoded string or BER buffer of the ECC public key
+ * 'messages' is an array of buffers to be encrypted; the buffers are kept
+ * alive until the callback is invoked and their contents must not be
+ * modified before then
+ * 'threads' (optional) is the maximum number of threads to spread the
+ * batch across (default 1, capped by the number of hardware threads)
+ * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+ * 'ciphers' (if available) is an array of cipher buffers in the order of
+ * 'messages'
  *
- * @param info node.js arguments wrapper containing the disk access key
- *        and folder path
+ * @param info node.js arguments wrapper
  *
- * @return
+ * @return void
  */
-NAN_METHOD(SEIFECC::New) {
+NAN_METHOD(SEIFECC::encryptManyAsync) {
 
-    if (info.IsConstructCall()) {
+    // Check arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
+        return;
+    }
 
-        // Invoked as constructor: 'let obj = new SEIFECC()'.
+    if (!info[1]->IsArray()) {
+        Nan::ThrowError("Incorrect Arguments. Array of message buffers not "
+                        "provided");
+        return;
+    }
 
-        // Check arguments.
-        if (!node::Buffer::HasInstance(info[0])) {
+    // The number of threads is optional, so the callback is the last argument.
+    const int callbackIndex = info[2]->IsFunction() ? 2 : 3;
+    if (!info[callbackIndex]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
+        return;
+    }
 
-            Nan::ThrowError("Incorrect Arguments. Disk access key buffer "
-                            "not provided");
-            return;
-        }
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-        /* Unwrap the first argument to get the key buffer used to store
-         * RNG state to the disk.
-         */
-        v8::Local<v8::Object> bufferObj =
-            Nan::To<v8::Object>(info[0]).ToLocalChecked();
+    // Unwrap the first argument to get the hex encoded or binary public key.
+    std::string pubStr;
+    KEY_ENCODING encoding = unwrapKey(info[0], pubStr);
 
-        uint8_t* bufferData = (uint8_t*)node::Buffer::Data(bufferObj);
-        size_t bufferLength = node::Buffer::Length(bufferObj);
+    /* Unwrap the second argument to get the message buffers, keeping the
+     * buffer objects themselves since the caller may replace the array
+     * elements while the work is running.
+     */
+    std::vector<std::pair<const uint8_t*, size_t> > messages;
+    v8::Local<v8::Array> buffers;
+    if (!unwrapMessages(info[1], messages, &buffers)) {
+        return;
+    }
 
-        /* If the size of key buffer is less than AES key size then hash the
-         * given data to get key of the required size.
-         */
-        std::vector<uint8_t> digest;
-        if (bufferLength < 32) {
-            digest.resize(CryptoPP::SHA3_256::DIGESTSIZE);
-            std::string bufferString(reinterpret_cast<const char*>(bufferData),
-                reinterpret_cast<const char*>(bufferData) + bufferLength);
-            hashString(digest, bufferString);
+    // Unwrap the optional third argument to get the number of threads.
+    unsigned int threads = 1;
+    if (callbackIndex == 3 && info[2]->IsNumber()) {
+        threads = Nan::To<uint32_t>(info[2]).FromJust();
+    }
 
-        } else {
-            digest.reserve(CryptoPP::SHA3_256::DIGESTSIZE);
-            std::copy(bufferData, bufferData + bufferLength,
-                std::back_inserter(digest));
-        }
+    Nan::Callback* callback =
+        new Nan::Callback(info[callbackIndex].As<v8::Function>());
 
-        /* Unwrap the second argument to get the folder on disk where the RNG
-         * state and keys will be encrypted and stored.
-         */
-        std::string folder = "./";
-        if (!info[1]->IsUndefined()) {
-            v8::String::Utf8Value str(info[1]->ToString());
-            folder = *str;
-            if (folder.back() != '/') {
-                folder = folder + "/";
-            }
-        }
+    BatchWorker* worker = new BatchWorker(
+        callback,
+        obj,
+        pubStr,
+        encoding,
+        std::move(messages),
+        threads
+    );
+
+    // Pin the wrapped object and message buffers until the work is complete.
+    worker->SaveToPersistent("obj", info.Holder());
+    worker->SaveToPersistent("messages", buffers);
 
-        // Create the wrapped object using the disk access key and given folder.
-        SEIFECC* obj = new SEIFECC(digest, folder);
+    Nan::AsyncQueueWorker(worker);
+}
 
-        obj->Wrap(info.This());
-        info.GetReturnValue().Set(info.This());
 
-    } else {
+// -------------
+// keyCacheStats
+// -------------
+/**
+ * @brief Returns the state of the parsed key cache.
+ *
+ * Invoked as:
+ * 'let stats = obj.keyCacheStats()' where 'stats' is of the form:
+ * {publicKeys: [cached public keys], privateKeys: [cached private
+ *  keys], capacity: [capacity per kind], precomputeStorage:
+ *  [precomputed points per key], precomputedBytes: [approximate
+ *  memory used by precomputation tables], sessions: [cached session
+ *  keys], keyPool: {size, available, generated, taken, misses,
+ *  state}} with 'state' one of "disabled", "seeding", "ready" or
+ *  "failed"
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFECC::keyCacheStats) {
 
-        // Invoked as plain function `SEIFECC(...)`, turn into construct call.
-        const int argc = info.Length();
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-        // Creating argument array for construct call.
-        std::vector<v8::Local<v8::Value> > argv;
-        argv.reserve(argc);
-        for (int i = 0; i < argc; ++i) {
-            argv.push_back(info[i]);
+    // Sum up the precomputation tables held by the cached public keys.
+    size_t precomputedBytes = 0;
+    obj->_encryptors.forEach(
+        [&precomputedBytes](const std::shared_ptr<CachedKey<Encryptor> >& e) {
+            precomputedBytes += e->precomputedBytes();
         }
+    );
 
-        v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
-        info.GetReturnValue().Set(cons->NewInstance(argc, argv.data()));
-
+    v8::Local<v8::Object> ret = Nan::New<v8::Object>();
+    Nan::Set(ret,
+        Nan::New<v8::String>("publicKeys").ToLocalChecked(),
+        Nan::New<v8::Number>(obj->_encryptors.size()));
+    Nan::Set(ret,
+        Nan::New<v8::String>("privateKeys").ToLocalChecked(),
+        Nan::New<v8::Number>(obj->_decryptors.size()));
+    Nan::Set(ret,
+        Nan::New<v8::String>("capacity").ToLocalChecked(),
+        Nan::New<v8::Number>(obj->_encryptors.capacity()));
+    Nan::Set(ret,
+        Nan::New<v8::String>("precomputeStorage").ToLocalChecked(),
+        Nan::New<v8::Number>(obj->_precomputeStorage));
+    Nan::Set(ret,
+        Nan::New<v8::String>("precomputedBytes").ToLocalChecked(),
+        Nan::New<v8::Number>(precomputedBytes));
+    Nan::Set(ret,
+        Nan::New<v8::String>("sessions").ToLocalChecked(),
+        Nan::New<v8::Number>(obj->_sessions.size()));
+
+    // Counters of the pool of pregenerated key pairs, zero when disabled.
+    KeyPool::Stats poolStats = {0, 0, 0, 0, 0, KeyPool::FAILED};
+    std::string poolState = "disabled";
+    if (obj->_keyPool) {
+        poolStats = obj->_keyPool->stats();
+        poolState = poolStats.state == KeyPool::SEEDING ? "seeding" :
+            poolStats.state == KeyPool::READY ? "ready" : "failed";
     }
-}
+    v8::Local<v8::Object> keyPool = Nan::New<v8::Object>();
+    Nan::Set(keyPool, Nan::New<v8::String>("size").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(poolStats.depth)));
+    Nan::Set(keyPool, Nan::New<v8::String>("available").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(poolStats.available)));
+    Nan::Set(keyPool, Nan::New<v8::String>("generated").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(poolStats.generated)));
+    Nan::Set(keyPool, Nan::New<v8::String>("taken").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(poolStats.taken)));
+    Nan::Set(keyPool, Nan::New<v8::String>("misses").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(poolStats.misses)));
+    Nan::Set(keyPool, Nan::New<v8::String>("state").ToLocalChecked(),
+        Nan::New<v8::String>(poolState).ToLocalChecked());
+    Nan::Set(ret, Nan::New<v8::String>("keyPool").ToLocalChecked(), keyPool);
 
+    info.GetReturnValue().Set(ret);
+}
 
 
 
-// --------
-// loadKeys
-// --------
+// ------------
+// encryptAsync
+// ------------
 /**
- * @brief Creates an async worker to load keys from the disk and
- *        invokes the callback function with the error object (if
- *        applicable) and/or the object containing the keys.
+ * @brief Unwraps the arguments to get the public key, message and
+ *        callback and creates an async worker which encrypts the
+ *        message on the libuv thread pool.
  *
  * Invoked as:
- * 'obj.loadKeys(function(status, keys){})' where
- * 'status' (if applicable) is of the form:
- * {code: [statusCode], message: [statusMessage]}
- * 'keys' (if available) is of the form:
- * {enc: [publicKey], dec: [privateKey]}
+ * 'obj.encryptAsync(key, message, function(status, cipher){})'
+ * 'key' is the hex encoded string or BER buffer of the ECC public key
+ * 'message' is the buffer containing the message to be encrypted; it
+ * must not be modified until the callback is invoked
+ * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+ * 'cipher' (if available) is the buffer containing the cipher
  *
  * @param info node.js arguments wrapper
  *
  * @return void
  */
-NAN_METHOD(SEIFECC::loadKeys) {
+NAN_METHOD(SEIFECC::encryptAsync) {
+
+    // Check arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
+        return;
+    }
+
+    if (!Binding::isBytes(info[1])) {
+        Nan::ThrowError("Incorrect Arguments. Message buffer not provided");
+        return;
+    }
+
+    if (!info[2]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
+        return;
+    }
 
-    // Get a reference to the wrapped object from the argument.
     SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    // Unwrap the first argument to get given callback function.
-    Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
+    // Unwrap the first argument to get the hex encoded or binary public key.
+    std::string pubStr;
+    KEY_ENCODING encoding = unwrapKey(info[0], pubStr);
 
-    // Initialize the async worker and queue it.
-    Worker* worker = new Worker(
+    // Unwrap the second argument to get the message buffer to be encrypted.
+    v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(info[1]).ToLocalChecked();
+
+    const uint8_t* messageData = Binding::data(bufferObj);
+    size_t messageLength = Binding::length(bufferObj);
+
+    // Unwrap the third argument to get given callback function.
+    Nan::Callback* callback = new Nan::Callback(info[2].As<v8::Function>());
+
+    CryptoWorker* worker = new CryptoWorker(
         callback,
-        obj->_key,
-        obj->_folderPath
+        obj,
+        CryptoWorker::MODE::ENCRYPT,
+        pubStr,
+        encoding,
+        messageData,
+        messageLength
     );
 
+    // Pin the wrapped object and message buffer until the work is complete.
+    worker->SaveToPersistent("obj", info.Holder());
+    worker->SaveToPersistent("data", bufferObj);
+
     Nan::AsyncQueueWorker(worker);
 }
 
 
-// ---------------
-// entropyStrength
-// ---------------
 
+// ------------
+// decryptAsync
+// ------------
 /**
- * @brief Returns the possible strength of entropy avaible for mining.
+ * @brief Unwraps the arguments to get the private key, cipher and
+ *        callback and creates an async worker which decrypts the
+ *        cipher on the libuv thread pool.
  *
- * @return A string with values "WEAK", "MEDIUM" or "STRONG". If the only
- *		   source of entropy is the OS this makes the module's strength
- *		   WEAK w.r.t entropy, access to either the microphone or camera
- *		   results in Medium strength and finally access to the OS, camera,
- *		   microphone and more enables STRONG strength.
+ * Invoked as:
+ * 'obj.decryptAsync(key, cipher, function(status, message){})'
+ * 'key' is the hex encoded string or BER buffer of the ECC private key
+ * 'cipher' is the buffer containing the cipher to be decrypted; it
+ * must not be modified until the callback is invoked
+ * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+ * 'message' (if available) is the buffer containing the message
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
  */
-NAN_METHOD(SEIFECC::entropyStrength) {
-    // Get a reference to the wrapped object from the argument.
+NAN_METHOD(SEIFECC::decryptAsync) {
+
+    // Check arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Missing Private key string");
+        return;
+    }
+
+    if (!Binding::isBytes(info[1])) {
+        Nan::ThrowError("Incorrect Arguments. Missing encrypted cipher buffer");
+        return;
+    }
+
+    if (!info[2]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
+        return;
+    }
+
     SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    std::string strength = obj->prng.EntropyStrength();
-    // Return strength of underlying RNG used for key generation.
-    info.GetReturnValue().Set(
-        v8::String::NewFromUtf8(Nan::GetCurrentContext()->GetIsolate(),
-        strength.c_str())
+    // Unwrap the first argument to get the hex encoded or binary private key.
+    std::string privStr;
+    KEY_ENCODING encoding = unwrapKey(info[0], privStr);
+
+    // Unwrap the second argument to get the cipher buffer.
+    v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(info[1]).ToLocalChecked();
+
+    const uint8_t* cipherData = Binding::data(bufferObj);
+    size_t cipherLength = Binding::length(bufferObj);
+
+    // Unwrap the third argument to get given callback function.
+    Nan::Callback* callback = new Nan::Callback(info[2].As<v8::Function>());
+
+    CryptoWorker* worker = new CryptoWorker(
+        callback,
+        obj,
+        CryptoWorker::MODE::DECRYPT,
+        privStr,
+        encoding,
+        cipherData,
+        cipherLength
     );
+
+    // Pin the wrapped object and cipher buffer until the work is complete.
+    worker->SaveToPersistent("obj", info.Holder());
+    worker->SaveToPersistent("data", bufferObj);
+
+    Nan::AsyncQueueWorker(worker);
 }
 
 
-// ------------
-// generateKeys
-// ------------
+// ---------
+// storeKeys
+// ---------
 /**
- * @brief Initializes the isaac RNG and uses it to generate the
- *        public/private keys and return them to the caller.
+ * @brief Unwraps the arguments to get the name and the keys and saves
+ *        the keys in the keystore file of the folder under the given
+ *        name, replacing any keys of the same name.
  *
  * Invoked as:
- * 'let keys = obj.generateKeys()' where
- * 'keys' (if available) is of the form:
- * {enc: [publicKey], dec: [privateKey]}
+ * 'obj.storeKeys(name, keys)' where
+ * 'name' is the string naming the key pair
+ * 'keys' is of the form: {enc: [publicKey], dec: [privateKey]}, each key
+ * being a hex encoded string or BER buffer
  *
  * @param info node.js arguments wrapper
  *
  * @return void
  */
-NAN_METHOD(SEIFECC::generateKeys) {
+NAN_METHOD(SEIFECC::storeKeys) {
 
     // Get a reference to the wrapped object from the argument.
     SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    // Generate the public and private keys as strings and save them to disk.
+    // Check arguments.
+    if (!info[0]->IsString() || !info[1]->IsObject()) {
+        Nan::ThrowError("Incorrect Arguments. Name and keys not provided");
+        return;
+    }
+
+    std::string name(*Nan::Utf8String(info[0]));
+
+    v8::Local<v8::Object> keys = Nan::To<v8::Object>(info[1]).ToLocalChecked();
     std::string encodedPub, encodedPriv;
-    if (!obj->generateKeys(
-            encodedPub,
-            encodedPriv,
-            obj->_key,
-            obj->_folderPath
-        )
-    ) {
+    KEY_ENCODING pubEncoding = unwrapKey(Nan::Get(keys,
+        Nan::New<v8::String>("enc").ToLocalChecked()).ToLocalChecked(),
+        encodedPub);
+    KEY_ENCODING privEncoding = unwrapKey(Nan::Get(keys,
+        Nan::New<v8::String>("dec").ToLocalChecked()).ToLocalChecked(),
+        encodedPriv);
+
+    // Decode the keys, which also checks that they are well formed.
+    std::string record;
+    try {
+        Decryptor d0;
+        if (privEncoding == KEY_ENCODING::BINARY) {
+            StringSource privSource(encodedPriv, true);
+            d0.AccessPrivateKey().Load(privSource);
+        } else {
+            StringSource privSource(encodedPriv, true,
+                new CryptoPP::HexDecoder);
+            d0.AccessPrivateKey().Load(privSource);
+        }
+
+        Encryptor e0;
+        if (pubEncoding == KEY_ENCODING::BINARY) {
+            StringSource pubSource(encodedPub, true);
+            e0.AccessPublicKey().Load(pubSource);
+        } else {
+            StringSource pubSource(encodedPub, true,
+                new CryptoPP::HexDecoder);
+            e0.AccessPublicKey().Load(pubSource);
+        }
 
+        record = keyRecord(d0, e0);
+    } catch (const std::exception&) {
+        CryptoPP::SecureWipeBuffer(&encodedPriv[0], encodedPriv.size());
+        Nan::ThrowError("Incorrect Arguments. Invalid keys");
         return;
     }
+    CryptoPP::SecureWipeBuffer(&encodedPriv[0], encodedPriv.size());
 
-    /* Creating js object with 'enc' set as the public key and
-     * 'dec' as the private key.
-     */
-    v8::Local<v8::Object> ret = Nan::New<v8::Object>();
-    Nan::Set(ret,
-        Nan::New<v8::String>("enc").ToLocalChecked(),
-        Nan::New<v8::String>(encodedPub).ToLocalChecked());
-    Nan::Set(ret,
-        Nan::New<v8::String>("dec").ToLocalChecked(),
-        Nan::New<v8::String>(encodedPriv).ToLocalChecked());
+    Keystore::STATUS status = obj->_keystore->put(name, record);
+    CryptoPP::SecureWipeBuffer(&record[0], record.size());
 
-    // Set the above object as the value to be returned to node.js.
-    info.GetReturnValue().Set(ret);
+    if (status != Keystore::STATUS::SUCCESS) {
+        Nan::ThrowError("Keys could not be saved in the keystore");
+        return;
+    }
 }
 
 
 
-// -------
-// encrypt
-// -------
+// --------------
+// loadStoredKeys
+// --------------
 /**
- * @brief Unwraps the arguments to get the public key and message and
- *        encrypt the message using the public key to return the cipher.
+ * @brief Returns the named keys from the keystore file of the folder.
  *
  * Invoked as:
- * 'let cipher = obj.encrypt(key, message)'
- * 'key' is the string containing the hex encoded ECC public key
- * 'message' is the buffer containing the message to be encrypted
- * 'cipher' is the string containing the encrypted cipher
+ * 'let keys = obj.loadStoredKeys(name)' where
+ * 'name' is the string naming the key pair
+ * 'keys' is undefined if there are no keys with the given name, or of
+ * the form: {enc: [publicKey], dec: [privateKey], curve: [curveName]}
  *
- * @param info node.js arguments wrapper containing public key string
- *        and message
+ * @param info node.js arguments wrapper
  *
  * @return void
  */
-NAN_METHOD(SEIFECC::encrypt) {
+NAN_METHOD(SEIFECC::loadStoredKeys) {
+
+    // Get a reference to the wrapped object from the argument.
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
     // Check arguments.
-    if (info[0]->IsUndefined()) {
-        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
+    if (!info[0]->IsString()) {
+        Nan::ThrowError("Incorrect Arguments. Name not provided");
         return;
     }
 
-    if (!node::Buffer::HasInstance(info[1])) {
+    std::string encodedPub, encodedPriv, curve;
+    Keystore::STATUS status = loadStoredKeys(*obj->_keystore,
+        std::string(*Nan::Utf8String(info[0])), obj->_keyEncoding,
+        encodedPub, encodedPriv, curve);
 
-        Nan::ThrowError("Incorrect Arguments. Message buffer not provided");
-        return;
+    switch (status) {
+        case Keystore::STATUS::SUCCESS:
+            break;
+        case Keystore::STATUS::NOT_FOUND:
+            return;
+        case Keystore::STATUS::DECRYPTION_ERROR:
+            Nan::ThrowError("Keystore decryption failed");
+            return;
+        default:
+            Nan::ThrowError("Keystore could not be read");
+            return;
     }
 
-    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
+    /* Creating js object with 'enc' set as the public key and
+     * 'dec' as the private key.
+     */
+    v8::Local<v8::Object> ret = keysObject(encodedPub, encodedPriv, curve,
+        obj->_keyEncoding);
 
-    // Unwrap the first argument to get the hex encoded public key string.
-    v8::String::Utf8Value str(info[0]->ToString());
-    std::string pubStr(*str);
+    info.GetReturnValue().Set(ret);
+}
 
-    // Unwrap the second argument to get the message buffer to be encrypted.
-    v8::Local<v8::Object> bufferObj =
-            Nan::To<v8::Object>(info[1]).ToLocalChecked();
 
-    uint8_t* messageData = (uint8_t*)node::Buffer::Data(bufferObj);
-    size_t messageLength = node::Buffer::Length(bufferObj);
 
-    // Vector containing hex encoded encrypted cipher.
-    std::vector<uint8_t> enc;
-    try {
-        /* Hex decode the string to get the public key string using
-         * CryptoPP StringSource and HexDecoder and store in 'em'.
-         */
-        std::string em;
-        StringSource ss0(pubStr, true,
-            new CryptoPP::HexDecoder(new StringSink(em)));
+// ------------------
+// generateStoredKeys
+// ------------------
+/**
+ * @brief Initializes the isaac RNG and uses it to generate the
+ *        public/private keys, saving them in the keystore file of the
+ *        folder under the given name instead of the key files.
+ *
+ * Invoked as:
+ * 'let keys = obj.generateStoredKeys(name, curve)' where
+ * 'name' is the string naming the key pair
+ * 'curve' (optional) overrides the curve given at construction
+ * 'keys' (if available) is of the form:
+ * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFECC::generateStoredKeys) {
 
-        /* This decoded string can now be converted to public key object wrapped
-         * in the ECC encryption object using StringSource.
-         */
-        ECIES<ECP>::Encryptor e1;
-        StringSource ss(em, true);
-        e1.AccessPublicKey().Load(ss);
+    // Get a reference to the wrapped object from the argument.
+    SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-        AutoSeededRandomPool prng;
+    // Check arguments.
+    if (!info[0]->IsString()) {
+        Nan::ThrowError("Incorrect Arguments. Name not provided");
+        return;
+    }
 
-        /* Apply the CryptoPP PK_EncryptorFilter transformer to encrypt the
-         * message buffer; store the result in a vector 'em0' using ArraySource.
-         */
-        std::string em0;
-        ArraySource ss1 (
-            messageData,
-            messageLength,
-            true,
-            new PK_EncryptorFilter(
-                prng,
-                e1,
-                new StringSink(em0)
-            )
-        );
+    std::string name(*Nan::Utf8String(info[0]));
 
-        enc.resize(em0.size());
-        // Hex encode the string cipher using CryptoPP StringSource & HexEncoder
-        StringSource ss6(
-            em0,
-            true,
-            new ArraySink(enc.data(), enc.size())
-        );
+    std::string curve = obj->_curve;
+    if (info[1]->IsString()) {
+        curve = std::string(*Nan::Utf8String(info[1]));
+    }
 
-    } catch (const std::exception& ex) {
-        Nan::ThrowError(ex.what());
-        return;
-    } catch (...) {
-        Nan::ThrowError("Unknown error while encrypting message");
+    // Generate the public and private keys and save them in the keystore.
+    std::string encodedPub, encodedPriv, strength, error;
+    unsigned int retries = 0;
+    STATUS status = generateKeys(
+        encodedPub,
+        encodedPriv,
+        curve,
+        obj->_key,
+        obj->_folderPath,
+        obj->_keystore.get(),
+        name,
+        obj->_keyPool.get(),
+        obj->_keyEncoding,
+        retries,
+        strength,
+        error
+    );
+
+    if (status != STATUS::SUCCESS) {
+        Nan::ThrowError(error.c_str());
         return;
     }
 
-    // Set the encoded cipher output as the value to be returned to node.js.
-    // info.GetReturnValue().Set(
-    //     Nan::New<v8::String>(encoded.c_str()).ToLocalChecked());
-
-    // Copy cipherData vector into a node.js buffer.
-    auto slowBuffer = Nan::CopyBuffer((const char*)enc.data(),
-        enc.size()).ToLocalChecked();
+    /* Creating js object with 'enc' set as the public key and
+     * 'dec' as the private key.
+     */
+    v8::Local<v8::Object> ret = keysObject(encodedPub, encodedPriv, curve,
+        obj->_keyEncoding);
 
-    // Set node.js buffer as return value of the function
-    info.GetReturnValue().Set(slowBuffer);
+    info.GetReturnValue().Set(ret);
 }
 
 
-// -------
-// decrypt
-// -------
+
+// ----------
+// sessionKey
+// ----------
 /**
- * @brief Unwraps the arguments to get private key and cipher and
- *        decrypt the cipher using the private key to return the
- *        original message.
+ * @brief Unwraps the arguments to get the private key and the peer public
+ *        key and returns the session key material they share, from the
+ *        session cache when possible.
  *
  * Invoked as:
- * 'let message = obj.decrypt(key, cipher)'
- * 'key' is the string containing the hex encoded ECC private key
- * 'cipher' is the string containing the cipher to be decrypted
- * 'message' is the buffer containing the decrypted message
+ * 'let secret = obj.sessionKey(privateKey, peerPublicKey)' where
+ * 'privateKey' is the hex encoded string or BER buffer of the ECC private
+ * key
+ * 'peerPublicKey' is the hex encoded string or BER buffer of the peer's ECC
+ * public key, on the same curve
+ * 'secret' is a buffer of 96 bytes: the 48 bytes keying messages sent to
+ * the peer followed by the 48 bytes keying messages received from it,
+ * each an AES-256 key followed by an AESXOR256 seed; the peer gets the
+ * two halves swapped
  *
- * @param info node.js arguments wrapper containing private key string
- *        and cipher.
+ * @param info node.js arguments wrapper
  *
  * @return void
  */
-NAN_METHOD(SEIFECC::decrypt) {
+NAN_METHOD(SEIFECC::sessionKey) {
 
     // Check arguments.
-    if (info[0]->IsUndefined()) {
-        Nan::ThrowError("Incorrect Arguments. Missing Public key string");
-        return;
-    }
-
-    if (info[1]->IsUndefined() || !node::Buffer::HasInstance(info[1])) {
-        Nan::ThrowError("Incorrect Arguments. Missing encrypted cipher buffer");
+    if (info[0]->IsUndefined() || info[1]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Please provide the private key "
+                        "and the peer public key -> 'function sessionKey("
+                        "privateKey, peerPublicKey)'");
         return;
     }
 
     SEIFECC* obj = ObjectWrap::Unwrap<SEIFECC>(info.Holder());
 
-    // Unwrap the first argument to get the hex encoded private key string.
-    v8::String::Utf8Value str(info[0]->ToString());
-    std::string privStr(*str);
-
-    // Unwrap the second argument to get the cipher buffer.
-    v8::Local<v8::Object> bufferObj1 =
-                Nan::To<v8::Object>(info[1]).ToLocalChecked();
-    uint8_t* cipherData = (uint8_t *)node::Buffer::Data(bufferObj1);
-    size_t cipherLength = node::Buffer::Length(bufferObj1);
-
-    // string containing decrypted string message
-    std::string dm0;
+    std::string privStr, pubStr;
+    KEY_ENCODING privEncoding = unwrapKey(info[0], privStr);
+    KEY_ENCODING pubEncoding = unwrapKey(info[1], pubStr);
 
+    std::shared_ptr<SessionKey> session;
     try {
 
-        /* Hex decode the string to get the private key string using
-         * CryptoPP StringSource and HexDecoder and store it in string 'em'.
-         */
-        std::string em;
-        StringSource ss0(privStr, true,
-            new CryptoPP::HexDecoder(new StringSink(em)));
-
-        /* This decoded string can now be converted to private key object
-         * wrapped in the ECC decryption object using StringSource.
-         */
-        ECIES<ECP>::Decryptor d1;
-        StringSource ss(em, true);
-        d1.AccessPrivateKey().Load(ss);
-
-        AutoSeededRandomPool prng;
-
-        /* Apply the CryptoPP PK_DecryptorFilter transformer to decrypt the
-         * cipher buffer and store the result in a string using StringSink.
-         */
-        ArraySource ss6(
-            cipherData,
-            cipherLength,
-            true,
-            new PK_DecryptorFilter(prng, d1, new StringSink(dm0))
-        );
+        session = obj->getSession(privStr, privEncoding, pubStr,
+            pubEncoding);
 
     } catch (const std::exception& ex) {
-
+        CryptoPP::SecureWipeBuffer(&privStr[0], privStr.size());
         Nan::ThrowError(ex.what());
         return;
-
-    } catch (...) {
-
-        Nan::ThrowError("Unknown error while encrypting message");
-        return;
     }
 
-    // Copy the decrypted string message into a node.js buffer.
-    auto slowBuffer = Nan::CopyBuffer((const char*)dm0.data(),
-        dm0.size()).ToLocalChecked();
+    CryptoPP::SecureWipeBuffer(&privStr[0], privStr.size());
 
-    // Set the buffer as the value to returned to node.js.
-    info.GetReturnValue().Set(slowBuffer);
+    info.GetReturnValue().Set(Nan::CopyBuffer(
+        reinterpret_cast<const char*>(session->secret.data()),
+        session->secret.size()).ToLocalChecked());
 }
 
 
+
 // ----
 // Init
 // ----
@@ -1138,27 +3557,43 @@ NAN_METHOD(SEIFECC::decrypt) {
  *        by the addon.
  *
  * @param exports node.js module exports
+ * @param data module instance data holding the class constructors
  *
  * @return void
  */
-void SEIFECC::Init(v8::Handle<v8::Object> exports) {
+void SEIFECC::Init(v8::Local<v8::Object> exports,
+    v8::Local<v8::Object> data) {
 
     Nan::HandleScope scope;
 
     // Prepare constructor template.
-    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+    v8::Local<v8::FunctionTemplate> tpl =
+        Nan::New<v8::FunctionTemplate>(New, data);
     tpl->SetClassName(Nan::New("SEIFECC").ToLocalChecked());
     tpl->InstanceTemplate()->SetInternalFieldCount(5);
 
     // Prototype
-    Nan::SetPrototypeMethod(tpl, "loadKeys", loadKeys);
-    Nan::SetPrototypeMethod(tpl, "entropyStrength", entropyStrength);
-    Nan::SetPrototypeMethod(tpl, "generateKeys", generateKeys);
-    Nan::SetPrototypeMethod(tpl, "encrypt", encrypt);
-    Nan::SetPrototypeMethod(tpl, "decrypt", decrypt);
-
-    constructor.Reset(tpl->GetFunction());
+    Nan::SetPrototypeMethod(tpl, "loadKeys", loadKeys, data);
+    Nan::SetPrototypeMethod(tpl, "entropyStrength", entropyStrength, data);
+    Nan::SetPrototypeMethod(tpl, "generateKeys", generateKeys, data);
+    Nan::SetPrototypeMethod(tpl, "generateKeysAsync", generateKeysAsync, data);
+    Nan::SetPrototypeMethod(tpl, "encrypt", encrypt, data);
+    Nan::SetPrototypeMethod(tpl, "decrypt", decrypt, data);
+    Nan::SetPrototypeMethod(tpl, "encryptMany", encryptMany, data);
+    Nan::SetPrototypeMethod(tpl, "encryptManyAsync", encryptManyAsync, data);
+    Nan::SetPrototypeMethod(tpl, "keyCacheStats", keyCacheStats, data);
+    Nan::SetPrototypeMethod(tpl, "encryptAsync", encryptAsync, data);
+    Nan::SetPrototypeMethod(tpl, "decryptAsync", decryptAsync, data);
+    Nan::SetPrototypeMethod(tpl, "storeKeys", storeKeys, data);
+    Nan::SetPrototypeMethod(tpl, "loadStoredKeys", loadStoredKeys, data);
+    Nan::SetPrototypeMethod(tpl, "generateStoredKeys", generateStoredKeys,
+        data);
+    Nan::SetPrototypeMethod(tpl, "sessionKey", sessionKey, data);
+
+    v8::Local<v8::Function> constructor =
+        Nan::GetFunction(tpl).ToLocalChecked();
+    Binding::setConstructor(data, Binding::CLASS::SEIFECC, constructor);
 
     // Setting node.js module.exports.
-    exports->Set(Nan::New("SEIFECC").ToLocalChecked(), tpl->GetFunction());
+    Nan::Set(exports, Nan::New("SEIFECC").ToLocalChecked(), constructor);
 }
@@ -34,7 +34,11 @@
 // -----------------
 // standard includes
 // -----------------
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 // ----------------------
@@ -50,12 +54,19 @@
 #include "pubkey.h"
 using CryptoPP::PublicKey;
 using CryptoPP::PrivateKey;
+#include "eccrypto.h"
+#include "secblock.h"
 
 // ----------------
 // library includes
 // ----------------
 #include <isaacRandomPool.h>
 
+#include "keypool.h"
+#include "keystore.h"
+#include "lruCache.hpp"
+#include "securearena.h"
+
 
 // --------
 // SEIFECC
@@ -69,15 +80,168 @@ using CryptoPP::PrivateKey;
  * 		  The functions exposed to node.js are:
  *		  function loadKeys() -> returns public/private key object
  *		  function generateKeys() -> returns public/private key object
+ *		  function generateKeysAsync(curve, callback)
  *		  function encrypt(publicKey, message) -> returns cipher
  *		  function decrypt(privateKey, cipher) -> returns message
+ *		  function encryptMany(publicKey, messages, threads) -> returns ciphers
+ *		  function encryptManyAsync(publicKey, messages, threads, callback)
+ *		  function encryptAsync(publicKey, message, callback)
+ *		  function decryptAsync(privateKey, cipher, callback)
+ *		  function storeKeys(name, keys)
+ *		  function loadStoredKeys(name) -> returns public/private key object
+ *		  function generateStoredKeys(name, curve) -> returns public/private
+ *		  key object
+ *		  function sessionKey(privateKey, peerPublicKey) -> returns the
+ *		  symmetric key material shared with the peer
+ *
+ *		  Parsed keys are kept in a bounded LRU cache keyed by the digest of
+ *		  the encoded key so that repeated encrypt/decrypt calls with the same
+ *		  key skip hex decoding and BER parsing.
  */
 class SEIFECC : public Nan::ObjectWrap {
 
 	private:
 
-		// javascript object constructor
-		static Nan::Persistent<v8::Function> constructor;
+		// ECIES encryption/decryption objects holding a loaded key
+		typedef CryptoPP::ECIES<CryptoPP::ECP>::Encryptor Encryptor;
+		typedef CryptoPP::ECIES<CryptoPP::ECP>::Decryptor Decryptor;
+
+		// default number of parsed keys of each kind kept in the cache
+		static const size_t DEFAULT_KEY_CACHE_SIZE;
+
+		/* Parsed objects of one encoded key. Crypto++ curve objects keep
+		 * mutable scratch space so an object must not be used by two
+		 * threads at once; rather than serializing every user of the key
+		 * on one object, each user leases its own, parsed again from the
+		 * encoded key when none is idle, and hands it back when done.
+		 */
+		template <typename T>
+		class CachedKey {
+
+			public:
+
+				// Object leased to one thread, handed back when destroyed
+				class Lease {
+
+					private:
+
+						// key the object is handed back to
+						CachedKey* _owner;
+						// leased object, null once moved from
+						std::unique_ptr<T> _object;
+
+					public:
+
+						Lease(CachedKey& owner, std::unique_ptr<T> object):
+						_owner(&owner), _object(std::move(object)) {}
+
+						Lease(Lease&& other): _owner(other._owner),
+						_object(std::move(other._object)) {}
+
+						~Lease() {
+							if (_object) {
+								_owner->release(std::move(_object));
+							}
+						}
+
+						T& operator*() const { return *_object; }
+						T* operator->() const { return _object.get(); }
+				};
+
+			private:
+
+				// BER encoded key the objects are parsed from
+				const SecureString _encoded;
+				/* number of precomputed points of each parsed object (0
+				 * disables precomputation)
+				 */
+				const unsigned int _precomputeStorage;
+
+				// guards the fields below
+				std::mutex _mutex;
+				// parsed objects not leased at the moment
+				std::vector<std::unique_ptr<T> > _idle;
+				// parsed objects alive, idle or leased
+				size_t _objects;
+				// approximate size of the precomputation tables of one object
+				size_t _objectBytes;
+
+				// Keeps the object for the next lease, up to one per hardware
+				// thread.
+				void release(std::unique_ptr<T> object);
+
+			public:
+
+				/**
+				 * Constructor
+				 * @brief Parses the first object of the key.
+				 *
+				 * @param encoded BER encoded key
+				 * @param precomputeStorage number of precomputed points of
+				 *		  each parsed object, 0 to disable precomputation
+				 *
+				 * @throw CryptoPP::Exception if the key cannot be decoded
+				 */
+				CachedKey(const SecureString& encoded,
+					unsigned int precomputeStorage);
+
+				/**
+				 * @brief Leases an idle object, parsing a new one when all
+				 *		  of them are in use.
+				 *
+				 * @throw CryptoPP::Exception if the key cannot be decoded
+				 *
+				 * @return object leased to the calling thread
+				 */
+				Lease acquire();
+
+				/**
+				 * @brief Returns the approximate size of the precomputation
+				 *		  tables of all parsed objects of the key.
+				 *
+				 * @return size in bytes
+				 */
+				size_t precomputedBytes();
+		};
+
+		// Encoding of the keys handed to and returned to javascript
+		enum class KEY_ENCODING:int {
+			HEX,		// hex encoded BER strings
+			BINARY		// BER buffers, public keys with compressed points
+		};
+
+		// Durations of the phases of loading the keys, in milliseconds
+		struct LoadTimings {
+			// decrypting and parsing the private key file
+			double privateKey;
+			// decrypting and parsing the public key file, in parallel
+			double publicKey;
+			// encoding the keys for javascript
+			double encode;
+			// loading the keys from start to end
+			double total;
+
+			LoadTimings(): privateKey(0), publicKey(0), encode(0), total(0) {}
+		};
+
+		/* Symmetric key material derived from the ECDH shared secret of a
+		 * private key and a peer public key, reused until it expires: the
+		 * material for sending to the peer followed by the material for
+		 * receiving from it.
+		 */
+		struct SessionKey {
+			CryptoPP::SecByteBlock secret;
+			std::chrono::steady_clock::time_point expires;
+		};
+
+		// default number of session keys kept in the cache
+		static const size_t DEFAULT_SESSION_CACHE_SIZE;
+		// default lifetime of a session key, in milliseconds
+		static const unsigned int DEFAULT_SESSION_LIFETIME;
+		/* number of bytes of session key material of one direction: AES key
+		 * and AESXOR seed
+		 */
+		static const size_t SESSION_KEY_BYTES;
 
 		// Status enum for different types of errors
 		enum class STATUS:int {
@@ -85,7 +249,10 @@ class SEIFECC : public Nan::ObjectWrap {
 			FILE_NOT_FOUND = -1, 	// RNG state file not found
 			DECRYPTION_ERROR = -2, 	// Error Decrypting RNG state file
 			ENTROPY_ERROR = -3,		// Error gathering entropy
-			RNG_INIT_ERROR = -4		// RNG not initialized
+			RNG_INIT_ERROR = -4,	// RNG not initialized
+			CIPHER_ERROR = -5,		// Error encrypting/decrypting a message
+			CURVE_ERROR = -6,		// Unsupported curve
+			KEY_GENERATION_ERROR = -7	// Error validating/saving generated keys
 		};
 
 		// ----
@@ -99,6 +266,40 @@ class SEIFECC : public Nan::ObjectWrap {
 		// isaac RNG object
 		IsaacRandomPool prng;
 
+		// parsed public keys keyed by digest of the encoded key
+		LRUCache<CachedKey<Encryptor> > _encryptors;
+		// parsed private keys keyed by digest of the encoded key
+		LRUCache<CachedKey<Decryptor> > _decryptors;
+
+		// session keys keyed by digests of the private and peer public key
+		LRUCache<SessionKey> _sessions;
+		// time after which a session key is derived again
+		std::chrono::milliseconds _sessionLifetime;
+
+		/* number of precomputed points for fixed-base exponentiation of the
+		 * base point and cached public keys (0 disables precomputation)
+		 */
+		unsigned int _precomputeStorage;
+
+		// name of the curve used when generating keys
+		std::string _curve;
+
+		// encoding of the keys returned to javascript
+		KEY_ENCODING _keyEncoding;
+
+		// named key pairs kept in the folder's keystore file
+		std::shared_ptr<Keystore> _keystore;
+
+		/* key pairs on '_curve' pregenerated in the background, null when
+		 * the pool is disabled
+		 */
+		std::shared_ptr<KeyPool> _keyPool;
+
+		/* number of async key generations in progress, mining the entropy
+		 * sources
+		 */
+		unsigned int _busy;
+
 	 	// ------
 		// Worker
 		// ------
@@ -125,6 +326,12 @@ class SEIFECC : public Nan::ObjectWrap {
 		        std::string _encodedPub;
 		        // encoded private key
 		        std::string _encodedPriv;
+		        // name of the curve the loaded keys are on
+		        std::string _curve;
+		        // encoding of the returned keys
+		        KEY_ENCODING _encoding;
+		        // durations of the phases of loading the keys
+		        LoadTimings _timings;
 
 		    public:
 		    	// -----------
@@ -139,12 +346,14 @@ class SEIFECC : public Nan::ObjectWrap {
 				 * @param key disk access key for public/private keys and
 				 * 		  rng state
 				 * @param folderPath folder containing keys and rng state files
+				 * @param encoding encoding of the returned keys
 				 */
 		        // Worker(Nan::Callback* initCallback, SEIFECC* obj);
 				Worker(
 					Nan::Callback* initCallback,
 					const std::vector<uint8_t>& key,
-					const std::string& folderPath
+					const std::string& folderPath,
+					KEY_ENCODING encoding
 				);
 
 
@@ -158,7 +367,7 @@ class SEIFECC : public Nan::ObjectWrap {
 		         *		  keys as an argument.
 		         *
 		         * The keys are returned as the second argument to the callback
-		         * {enc: [publicKey], dec: [privateKey]}
+		         * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
 		         *
 		         * @return void
 		         */
@@ -197,6 +406,327 @@ class SEIFECC : public Nan::ObjectWrap {
 		};
 
 
+		// ------------
+		// KeyGenWorker
+		// ------------
+		/*
+		 * @class This class represents the node.js async worker responsible for
+		 *		  gathering entropy and generating, validating and saving the
+		 *		  public/private keys on the libuv thread pool and invoking the
+		 *		  given callback function with the status of the operation and
+		 *		  the keys if available.
+		 */
+		class KeyGenWorker: public Nan::AsyncWorker {
+
+			private:
+				// ----
+				// data
+				// ----
+
+				// object whose busy count the worker holds
+				SEIFECC* _obj;
+				// disk access key for public/private keys and rng state
+				std::vector<uint8_t> _wkey;
+				// folder containing keys and rng state files
+				std::string _wfolderPath;
+				// name of the curve to generate the keys on
+				std::string _curve;
+				// pool of pregenerated key pairs, kept alive by the worker
+				std::shared_ptr<KeyPool> _keyPool;
+				// status of generating keys
+				SEIFECC::STATUS _status;
+				// encoded public key
+				std::string _encodedPub;
+				// encoded private key
+				std::string _encodedPriv;
+				// number of entropy gathering retries
+				unsigned int _retries;
+				// entropy strength of the RNG
+				std::string _strength;
+				// encoding of the returned keys
+				KEY_ENCODING _encoding;
+
+			public:
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Initilizes and constructs internal data.
+				 *
+				 * @param callback callback to be invoked after async operation
+				 * @param obj object whose busy count the worker holds
+				 * @param key disk access key for public/private keys and
+				 * 		  rng state
+				 * @param folderPath folder containing keys and rng state files
+				 * @param curve name of the curve to generate the keys on
+				 * @param encoding encoding of the returned keys
+				 * @param keyPool pool of pregenerated key pairs, or null
+				 */
+				KeyGenWorker(
+					Nan::Callback* callback,
+					SEIFECC* obj,
+					const std::vector<uint8_t>& key,
+					const std::string& folderPath,
+					const std::string& curve,
+					KEY_ENCODING encoding,
+					const std::shared_ptr<KeyPool>& keyPool
+				);
+
+
+				// ----------------
+				// HandleOKCallback
+				// ----------------
+				/**
+				 * @brief Executed when the async work is complete without
+				 *		  error, invoking the given callback with the
+				 *		  generated keys as an argument.
+				 *
+				 * The keys are returned as the second argument to the callback
+				 * {enc: [publicKey], dec: [privateKey], curve: [curveName],
+				 *  strength: [entropyStrength], retries: [retries]}
+				 *
+				 * @return void
+				 */
+				void HandleOKCallback();
+
+
+				// -------------------
+				// HandleErrorCallback
+				// -------------------
+				/**
+				 * @brief Executed when the async work is complete with
+				 *		  error, invoking the given callback with the
+				 *		  corresponding error.
+				 *
+				 * The error is returned as the first argument to the callback
+				 * {code: [statusCode], message: [errorMessage],
+				 *  retries: [retries]}
+				 *
+				 * @return void
+				 */
+				void HandleErrorCallback();
+
+
+				// -------
+				// Execute
+				// -------
+				/**
+				 * @brief Executed in a separate thread, generating the keys.
+				 *
+				 * @return void
+				 */
+				void Execute();
+		};
+
+
+		// ------------
+		// CryptoWorker
+		// ------------
+		/*
+		 * @class This class represents the node.js async worker responsible for
+		 *		  encrypting or decrypting a message buffer on the libuv thread
+		 *		  pool and invoking the given callback function with the status
+		 *		  of the operation and the resulting buffer.
+		 */
+		class CryptoWorker: public Nan::AsyncWorker {
+
+			public:
+
+				// operation performed by the worker
+				enum class MODE:int {
+					ENCRYPT,
+					DECRYPT
+				};
+
+			private:
+				// ----
+				// data
+				// ----
+
+				// wrapped object owning the key caches
+				SEIFECC* _obj;
+				// operation performed by the worker
+				MODE _mode;
+				// encoded public or private key
+				std::string _encodedKey;
+				// encoding of the key
+				KEY_ENCODING _encoding;
+				// input data, pinned for the lifetime of the worker
+				const uint8_t* _data;
+				// length of input data
+				size_t _length;
+				// resulting cipher or message
+				SecureString _output;
+
+			public:
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Initilizes and constructs internal data.
+				 *
+				 * @param callback callback to be invoked after async operation
+				 * @param obj wrapped object owning the key caches
+				 * @param mode operation to be performed
+				 * @param encodedKey encoded public or private key
+				 * @param encoding encoding of the key
+				 * @param data input data, which must stay alive and unmodified
+				 *		  until the callback is invoked
+				 * @param length length of input data
+				 */
+				CryptoWorker(
+					Nan::Callback* callback,
+					SEIFECC* obj,
+					MODE mode,
+					const std::string& encodedKey,
+					KEY_ENCODING encoding,
+					const uint8_t* data,
+					size_t length
+				);
+
+
+				// ----------------
+				// HandleOKCallback
+				// ----------------
+				/**
+				 * @brief Executed when the async work is complete without
+				 *		  error, invoking the given callback with the status
+				 *		  and resulting buffer as arguments.
+				 *
+				 * @return void
+				 */
+				void HandleOKCallback();
+
+
+				// -------------------
+				// HandleErrorCallback
+				// -------------------
+				/**
+				 * @brief Executed when the async work is complete with
+				 *		  error, invoking the given callback with the
+				 *		  corresponding error.
+				 *
+				 * The error is returned as the first argument to the callback
+				 * {code: [statusCode], message: [errorMessage]}
+				 *
+				 * @return void
+				 */
+				void HandleErrorCallback();
+
+
+				// -------
+				// Execute
+				// -------
+				/**
+				 * @brief Executed in a separate thread, encrypting or
+				 *		  decrypting the input data.
+				 *
+				 * @return void
+				 */
+				void Execute();
+		};
+
+
+		// -----------
+		// BatchWorker
+		// -----------
+		/*
+		 * @class This class represents the node.js async worker responsible for
+		 *		  encrypting a batch of message buffers with one public key on
+		 *		  the libuv thread pool and invoking the given callback function
+		 *		  with the status of the operation and the resulting buffers.
+		 */
+		class BatchWorker: public Nan::AsyncWorker {
+
+			private:
+				// ----
+				// data
+				// ----
+
+				// wrapped object owning the key caches
+				SEIFECC* _obj;
+				// encoded public key
+				std::string _encodedKey;
+				// encoding of the key
+				KEY_ENCODING _encoding;
+				// input messages, pinned for the lifetime of the worker
+				std::vector<std::pair<const uint8_t*, size_t> > _messages;
+				// maximum number of threads to use
+				unsigned int _threads;
+				// resulting ciphers, in the order of the messages
+				std::vector<std::string> _ciphers;
+
+			public:
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Initilizes and constructs internal data.
+				 *
+				 * @param callback callback to be invoked after async operation
+				 * @param obj wrapped object owning the key caches
+				 * @param encodedKey encoded public key
+				 * @param encoding encoding of the key
+				 * @param messages pointer/length pairs of the messages, which
+				 *		  must stay alive and unmodified until the callback is
+				 *		  invoked
+				 * @param threads maximum number of threads to use
+				 */
+				BatchWorker(
+					Nan::Callback* callback,
+					SEIFECC* obj,
+					const std::string& encodedKey,
+					KEY_ENCODING encoding,
+					std::vector<std::pair<const uint8_t*, size_t> >&& messages,
+					unsigned int threads
+				);
+
+
+				// ----------------
+				// HandleOKCallback
+				// ----------------
+				/**
+				 * @brief Executed when the async work is complete without
+				 *		  error, invoking the given callback with the status
+				 *		  and an array of the resulting buffers as arguments.
+				 *
+				 * @return void
+				 */
+				void HandleOKCallback();
+
+
+				// -------------------
+				// HandleErrorCallback
+				// -------------------
+				/**
+				 * @brief Executed when the async work is complete with
+				 *		  error, invoking the given callback with the
+				 *		  corresponding error.
+				 *
+				 * The error is returned as the first argument to the callback
+				 * {code: [statusCode], message: [errorMessage]}
+				 *
+				 * @return void
+				 */
+				void HandleErrorCallback();
+
+
+				// -------
+				// Execute
+				// -------
+				/**
+				 * @brief Executed in a separate thread, encrypting the
+				 *		  messages.
+				 *
+				 * @return void
+				 */
+				void Execute();
+		};
+
+
 
 	 	// -----------
 		// Constructor
@@ -207,9 +737,172 @@ class SEIFECC : public Nan::ObjectWrap {
 		 *
 		 * @param keyData byte vector corresponding to disk access key
 		 * @param folderPath folder containing the encrypted keys
+		 * @param keyCacheSize number of parsed keys of each kind to cache
+		 * @param precomputeStorage number of precomputed points for cached
+		 *		  public keys, 0 to disable precomputation
+		 * @param curve name of the curve used when generating keys
+		 * @param keyEncoding encoding of the keys returned to javascript
+		 * @param sessionCacheSize number of session keys to cache
+		 * @param sessionLifetime lifetime of a session key in milliseconds
+		 * @param keyPoolSize number of key pairs on 'curve' to
+		 *		  pregenerate, 0 to disable the pool
+		 * @param keyPoolRate maximum number of pairs pregenerated per
+		 *		  second, 0 for no limit
 		 */
 	    explicit SEIFECC(const std::vector<uint8_t>& keyData,
-	    	const std::string& folderPath);
+	    	const std::string& folderPath, size_t keyCacheSize,
+	    	unsigned int precomputeStorage, const std::string& curve,
+	    	KEY_ENCODING keyEncoding, size_t sessionCacheSize,
+	    	unsigned int sessionLifetime, size_t keyPoolSize,
+	    	unsigned int keyPoolRate);
+
+
+	    // ------------
+		// getEncryptor
+		// ------------
+		/**
+		 * @brief Returns the encryption object for the given encoded public
+		 *		  key, parsing it only if it is not already cached. Newly
+		 *		  parsed keys get fixed-base precomputation tables for the
+		 *		  base point and public element when enabled.
+		 *
+		 * @param encodedKey encoded public key
+		 * @param encoding encoding of the key
+		 *
+		 * @throw CryptoPP::Exception if the key cannot be decoded
+		 *
+		 * @return shared encryption object holding the loaded key
+		 */
+		std::shared_ptr<CachedKey<Encryptor> > getEncryptor(
+			const std::string& encodedKey, KEY_ENCODING encoding);
+
+
+		// ------------
+		// getDecryptor
+		// ------------
+		/**
+		 * @brief Returns the decryption object for the given encoded
+		 *		  private key, parsing it only if it is not already cached.
+		 *
+		 * @param encodedKey encoded private key
+		 * @param encoding encoding of the key
+		 *
+		 * @throw CryptoPP::Exception if the key cannot be decoded
+		 *
+		 * @return shared decryption object holding the loaded key
+		 */
+		std::shared_ptr<CachedKey<Decryptor> > getDecryptor(
+			const std::string& encodedKey, KEY_ENCODING encoding);
+
+
+		// ----------
+		// getSession
+		// ----------
+		/**
+		 * @brief Returns the session key material shared by the private key
+		 *		  and the peer public key, running ECDH and the SHAKE256 KDF
+		 *		  only if no unexpired session key is cached. The KDF binds
+		 *		  both public keys and derives one key per direction: the
+		 *		  material for sending from this side comes first, the
+		 *		  material for receiving from the peer second, so the peer
+		 *		  derives the same two halves swapped.
+		 *
+		 * @param privateKey encoded private key
+		 * @param privateEncoding encoding of the private key
+		 * @param publicKey encoded peer public key
+		 * @param publicEncoding encoding of the public key
+		 *
+		 * @throw CryptoPP::Exception if a key cannot be decoded, the keys
+		 *		  are on different curves or the peer key is invalid
+		 *
+		 * @return shared session key
+		 */
+		std::shared_ptr<SessionKey> getSession(
+			const std::string& privateKey,
+			KEY_ENCODING privateEncoding,
+			const std::string& publicKey,
+			KEY_ENCODING publicEncoding
+		);
+
+
+		// --------------
+		// encryptMessage
+		// --------------
+		/**
+		 * @brief Encrypts the message with the given public key.
+		 *
+		 * @param cipher resulting cipher
+		 * @param encodedKey encoded public key
+		 * @param encoding encoding of the key
+		 * @param message message to be encrypted
+		 * @param length length of the message
+		 *
+		 * @throw CryptoPP::Exception in case of encryption errors
+		 *
+		 * @return void
+		 */
+		void encryptMessage(
+			SecureString& cipher,
+			const std::string& encodedKey,
+			KEY_ENCODING encoding,
+			const uint8_t* message,
+			size_t length
+		);
+
+
+		// ---------------
+		// encryptMessages
+		// ---------------
+		/**
+		 * @brief Encrypts a batch of messages with the same public key. The
+		 *		  key is looked up once; when more than one thread is
+		 *		  requested the batch is split into contiguous slices, each
+		 *		  encrypted on its own thread with its own object of the key.
+		 *		  The threads are capped by the number of hardware threads.
+		 *
+		 * @param ciphers resulting ciphers, in the order of the messages
+		 * @param encodedKey encoded public key
+		 * @param encoding encoding of the key
+		 * @param messages pointer/length pairs of the messages
+		 * @param threads maximum number of threads to use
+		 *
+		 * @throw CryptoPP::Exception in case of encryption errors, or
+		 *		  std::system_error if a thread could not be started
+		 *
+		 * @return void
+		 */
+		void encryptMessages(
+			std::vector<std::string>& ciphers,
+			const std::string& encodedKey,
+			KEY_ENCODING encoding,
+			const std::vector<std::pair<const uint8_t*, size_t> >& messages,
+			unsigned int threads
+		);
+
+
+		// --------------
+		// decryptMessage
+		// --------------
+		/**
+		 * @brief Decrypts the cipher with the given private key.
+		 *
+		 * @param message resulting decrypted message
+		 * @param encodedKey encoded private key
+		 * @param encoding encoding of the key
+		 * @param cipher cipher to be decrypted
+		 * @param length length of the cipher
+		 *
+		 * @throw CryptoPP::Exception in case of decryption errors
+		 *
+		 * @return void
+		 */
+		void decryptMessage(
+			SecureString& message,
+			const std::string& encodedKey,
+			KEY_ENCODING encoding,
+			const uint8_t* cipher,
+			size_t length
+		);
 
 
 	    // --------------
@@ -270,6 +963,8 @@ class SEIFECC : public Nan::ObjectWrap {
 		 * @param key disk access key for public/private keys and
 		 * 		  rng state
 		 * @param folderPath folder containing keys and rng state files
+		 * @param ber set to the decrypted BER encoding of the key when not
+		 *		  null
 		 *
 		 * @return status code indicating success or cause of error
 		 */
@@ -277,7 +972,8 @@ class SEIFECC : public Nan::ObjectWrap {
 			PrivateKey& privateKey,
 			const std::string& file,
 			const std::vector<uint8_t>& key,
-			const std::string& folderPath
+			const std::string& folderPath,
+			std::string* ber = nullptr
 		);
 
 
@@ -293,6 +989,8 @@ class SEIFECC : public Nan::ObjectWrap {
 		 * @param key disk access key for public/private keys and
 		 * 		  rng state
 		 * @param folderPath folder containing keys and rng state files
+		 * @param ber set to the decrypted BER encoding of the key when not
+		 *		  null
 		 *
 		 * @return status code indicating success or cause of error
 		 */
@@ -300,7 +998,133 @@ class SEIFECC : public Nan::ObjectWrap {
 			PublicKey& publicKey,
 			const std::string& file,
 			const std::vector<uint8_t>& key,
-			const std::string& folderPath
+			const std::string& folderPath,
+			std::string* ber = nullptr
+		);
+
+
+		// ----------
+		// encodeKeys
+		// ----------
+		/**
+		 * @brief Encodes the keys of the given decryption object and the
+		 *		  corresponding encryption object.
+		 *
+		 * @param d0 decryption object holding the private key
+		 * @param e0 encryption object holding the public key
+		 * @param encoding encoding of the keys
+		 * @param encodedPub set to the encoded public key
+		 * @param encodedPriv set to the encoded private key
+		 *
+		 * @return void
+		 */
+		static void encodeKeys(
+			const Decryptor& d0,
+			const Encryptor& e0,
+			KEY_ENCODING encoding,
+			std::string& encodedPub,
+			std::string& encodedPriv
+		);
+
+
+		// ---------
+		// unwrapKey
+		// ---------
+		/**
+		 * @brief Gets the key from a javascript value, a hex encoded string
+		 *		  or a buffer holding the BER encoded key.
+		 *
+		 * @param value javascript string or buffer
+		 * @param encodedKey set to the encoded key
+		 *
+		 * @return encoding of the key
+		 */
+		static KEY_ENCODING unwrapKey(v8::Local<v8::Value> value,
+			std::string& encodedKey);
+
+
+		// --------------
+		// unwrapMessages
+		// --------------
+		/**
+		 * @brief Gets the data of each buffer in a javascript array,
+		 *		  throwing a javascript error if an element is not a buffer.
+		 *
+		 * @param value javascript array of buffers
+		 * @param messages set to the pointer/length pairs of the buffers
+		 * @param buffers (optional) array set to the unwrapped buffer
+		 *		  objects, for async callers to pin while the pointers are
+		 *		  in use
+		 *
+		 * @return boolean indicating whether all elements were buffers
+		 */
+		static bool unwrapMessages(v8::Local<v8::Value> value,
+			std::vector<std::pair<const uint8_t*, size_t> >& messages,
+			v8::Local<v8::Array>* buffers = nullptr);
+
+
+		// ----------
+		// keysObject
+		// ----------
+		/**
+		 * @brief Creates the javascript object holding the keys, as strings
+		 *		  or buffers depending on the encoding.
+		 *
+		 * @param encodedPub encoded public key
+		 * @param encodedPriv encoded private key
+		 * @param curve name of the curve of the keys
+		 * @param encoding encoding of the keys
+		 *
+		 * @return object of the form:
+		 *		   {enc: [publicKey], dec: [privateKey], curve: [curveName]}
+		 */
+		static v8::Local<v8::Object> keysObject(
+			const std::string& encodedPub,
+			const std::string& encodedPriv,
+			const std::string& curve,
+			KEY_ENCODING encoding
+		);
+
+
+		// ---------
+		// keyRecord
+		// ---------
+		/**
+		 * @brief Serializes the key pair into a keystore record: the length
+		 *		  of the encoded private key as 4 little endian bytes
+		 *		  followed by the encoded private and public keys.
+		 *
+		 * @param d0 decryption object holding the private key
+		 * @param e0 encryption object holding the public key
+		 *
+		 * @return keystore record
+		 */
+		static std::string keyRecord(const Decryptor& d0, const Encryptor& e0);
+
+
+		// --------------
+		// loadStoredKeys
+		// --------------
+		/**
+		 * @brief Looks up the named key pair in the keystore.
+		 *
+		 * @param keystore keystore holding the key pair
+		 * @param name name of the key pair
+		 * @param encoding encoding of the returned keys
+		 * @param encodedPub set to the encoded public key
+		 * @param encodedPriv set to the encoded private key
+		 * @param curve set to the name of the curve of the keys
+		 *
+		 * @return status code of the keystore lookup, FORMAT_ERROR if the
+		 *		   record does not hold a key pair
+		 */
+		static Keystore::STATUS loadStoredKeys(
+			Keystore& keystore,
+			const std::string& name,
+			KEY_ENCODING encoding,
+			std::string& encodedPub,
+			std::string& encodedPriv,
+			std::string& curve
 		);
 
 
@@ -308,23 +1132,29 @@ class SEIFECC : public Nan::ObjectWrap {
 		// loadKeys
 		// --------
 		/**
-		 * @brief Loads the keys by decrypting existing files and initializes
-		 *		  the random number generator.
+		 * @brief Loads the keys by decrypting the existing files, the
+		 *		  public key file on a second thread while the private key
+		 *		  file is read on the calling one.
 		 *
 		 * @param encodedPub public key to be loaded from encrypted file
 		 * @param encodedPriv private key to be loaded from encrypted file
-		 * @param prng isaac rng object reference
+		 * @param curve name of the curve recorded in the key files
 		 * @param key disk access key for public/private keys and
 		 * 		  rng state
 		 * @param folderPath folder containing keys and rng state files
+		 * @param encoding encoding of the returned keys
+		 * @param timings set to the durations of the phases of loading
 		 *
 		 * @return status code indicating success or cause of error
 		 */
 		static STATUS loadKeys(
 			std::string& encodedPub,
 			std::string& encodedPriv,
+			std::string& curve,
 			const std::vector<uint8_t>& key,
-			const std::string& folderPath
+			const std::string& folderPath,
+			KEY_ENCODING encoding,
+			LoadTimings& timings
 		);
 
 
@@ -332,26 +1162,71 @@ class SEIFECC : public Nan::ObjectWrap {
 		// generateKeys
 		// ------------
 		/**
-		 * @brief Initialize the RNG and use it to generate the public and
-		 *		  private keys, encrypt them and save to disk.
+		 * @brief Takes a pregenerated key pair from the pool, or
+		 *		  initializes the RNG and uses it to generate the public and
+		 *		  private keys, then encrypts them and saves them to disk.
 		 *
 		 * @param encodedPub public key to be generated
 		 * @param encodedPriv private key to be generated
-		 * @param prng isaac rng object reference
+		 * @param curve name of the curve to generate the keys on
 		 * @param key disk access key for public/private keys and
 		 * 		  rng state
 		 * @param folderPath folder containing keys and rng state files
+		 * @param keystore keystore to save the keys in under 'name', or
+		 *		  null to save them to the key files of the folder
+		 * @param name name of the keys in the keystore
+		 * @param pool pool of pregenerated key pairs, or null to generate
+		 *		  them
+		 * @param encoding encoding of the returned keys
+		 * @param retries set to the number of entropy gathering retries
+		 * @param strength set to the entropy strength of the RNG
+		 * @param error set to the error message on failure
 		 *
-		 * @return boolean indicating success/failure
+		 * @return status code indicating success or cause of error
 		 */
-		static bool generateKeys(
+		static STATUS generateKeys(
 			std::string& encodedPub,
 			std::string& encodedPriv,
+			const std::string& curve,
 			const std::vector<uint8_t>& key,
-    		const std::string& folderPath
+    		const std::string& folderPath,
+    		Keystore* keystore,
+    		const std::string& name,
+    		KeyPool* pool,
+    		KEY_ENCODING encoding,
+    		unsigned int& retries,
+    		std::string& strength,
+    		std::string& error
     	);
 
 
+		// -------------
+		// createKeyPair
+		// -------------
+		/**
+		 * @brief Initializes a new isaac RNG from the folder's state file
+		 *		  and uses it to generate and validate a key pair. Must be
+		 *		  called with the key generation lock held.
+		 *
+		 * @param pair set to the validated key pair
+		 * @param oid curve to generate the keys on
+		 * @param folderPath folder containing the rng state file
+		 * @param retries set to the number of entropy gathering retries
+		 * @param strength set to the entropy strength of the RNG
+		 * @param error set to the error message on failure
+		 *
+		 * @return status code indicating success or cause of error
+		 */
+		static STATUS createKeyPair(
+			std::unique_ptr<KeyPool::KeyPair>& pair,
+			const CryptoPP::OID& oid,
+			const std::string& folderPath,
+			unsigned int& retries,
+			std::string& strength,
+			std::string& error
+		);
+
+
 
 		// ---
 		// New
@@ -362,10 +1237,21 @@ class SEIFECC : public Nan::ObjectWrap {
 		 *		  containing the encrypted keys.
 		 *
 		 * Invoked as:
-		 * 'let obj = new SEIFECC(diskKey, folder)' or
-		 * 'let obj = SEIFECC(diskKey, folder)' where
+		 * 'let obj = new SEIFECC(diskKey, folder, options)' or
+		 * 'let obj = SEIFECC(diskKey, folder, options)' where
 		 * 'diskKey' is the key used to encrypt the keys and rng state
 		 * 'folder' is the folder where the keys and rng state are saved on disk
+		 * 'options' (optional) is of the form:
+		 * {keyCacheSize: [number of parsed keys of each kind to cache],
+		 *  precomputeStorage: [number of precomputed points per public key],
+		 *  curve: [secp256r1, secp384r1 or secp521r1 (default)],
+		 *  keyEncoding: [hex (default) or binary],
+		 *  sessionCacheSize: [number of session keys to cache],
+		 *  sessionLifetime: [milliseconds a session key is reused],
+		 *  keyPoolSize: [number of key pairs on 'curve' to pregenerate,
+		 *  0 (default) disables the pool],
+		 *  keyPoolRate: [maximum pairs pregenerated per second, 0
+		 *  (default) for no limit]}
 		 *
 		 * @param info node.js arguments wrapper containing the disk access key
 		 * 		  and folder path
@@ -388,7 +1274,7 @@ class SEIFECC : public Nan::ObjectWrap {
 		 * 'status' (if applicable) is of the form:
 		 * {code: [statusCode], message: [statusMessage]}
 		 * 'keys' (if available) is of the form:
-		 * {enc: [publicKey], dec: [privateKey]}
+		 * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
 		 *
 		 * @param info node.js arguments wrapper
 		 *
@@ -407,7 +1293,8 @@ class SEIFECC : public Nan::ObjectWrap {
 		 *		   source of entropy is the OS this makes the module's strength
 		 *		   WEAK w.r.t entropy, access to either the microphone or camera
 		 *		   results in Medium strength and finally access to the OS, camera,
-		 *		   microphone and more enables STRONG strength.
+		 *		   microphone and more enables STRONG strength. Throws while a
+		 *		   generateKeysAsync call on the object is gathering entropy.
 		 */
 		static NAN_METHOD(entropyStrength);
 
@@ -417,12 +1304,14 @@ class SEIFECC : public Nan::ObjectWrap {
 		// ------------
 		/**
 		 * @brief Initializes the isaac RNG and uses it to generate the
-		 *		  public/private keys and return them to the caller.
+		 *		  public/private keys, or takes a pair from the key pool,
+		 *		  and returns them to the caller.
 		 *
 		 * Invoked as:
-		 * 'let keys = obj.generateKeys()' where
+		 * 'let keys = obj.generateKeys(curve)' where
+		 * 'curve' (optional) overrides the curve given at construction
 		 * 'keys' (if available) is of the form:
-		 * {enc: [publicKey], dec: [privateKey]}
+		 * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
 		 *
 		 * @param info node.js arguments wrapper
 		 *
@@ -431,6 +1320,30 @@ class SEIFECC : public Nan::ObjectWrap {
 		static NAN_METHOD(generateKeys);
 
 
+		// -----------------
+		// generateKeysAsync
+		// -----------------
+		/**
+		 * @brief Creates an async worker which initializes the isaac RNG and
+		 *		  uses it to generate the public/private keys on the libuv
+		 *		  thread pool, invoking the callback function with the status
+		 *		  and the keys.
+		 *
+		 * Invoked as:
+		 * 'obj.generateKeysAsync(curve, function(status, keys){})' where
+		 * 'curve' (optional) overrides the curve given at construction
+		 * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+		 * 'keys' (if available) is of the form:
+		 * {enc: [publicKey], dec: [privateKey], curve: [curveName],
+		 *  strength: [entropyStrength], retries: [retries]}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(generateKeysAsync);
+
+
 		// -------
 		// encrypt
 		// -------
@@ -440,7 +1353,7 @@ class SEIFECC : public Nan::ObjectWrap {
 		 *
 		 * Invoked as:
 		 * 'let cipher = obj.encrypt(key, message)'
-		 * 'key' is the string containing the hex encoded ECC public key
+		 * 'key' is the hex encoded string or BER buffer of the ECC public key
  		 * 'message' is the buffer containing the message to be encrypted
  		 * 'cipher' is the string containing the encrypted cipher
  		 *
@@ -462,7 +1375,7 @@ class SEIFECC : public Nan::ObjectWrap {
 		 *
 		 * Invoked as:
 		 * 'let message = obj.decrypt(key, cipher)'
-		 * 'key' is the string containing the hex encoded ECC private key
+		 * 'key' is the hex encoded string or BER buffer of the ECC private key
  		 * 'cipher' is the string containing the cipher to be decrypted
  		 * 'message' is the buffer containing the decrypted message
  		 *
@@ -473,6 +1386,213 @@ class SEIFECC : public Nan::ObjectWrap {
 		 */
 		static NAN_METHOD(decrypt);
 
+
+		// -----------
+		// encryptMany
+		// -----------
+		/**
+		 * @brief Unwraps the arguments to get the public key and an array of
+		 *		  messages and encrypts all of them with the same key in a
+		 *		  single call.
+		 *
+		 * Invoked as:
+		 * 'let ciphers = obj.encryptMany(key, messages, threads)'
+		 * 'key' is the hex encoded string or BER buffer of the ECC public key
+		 * 'messages' is an array of buffers to be encrypted
+		 * 'threads' (optional) is the maximum number of threads to spread the
+		 * batch across (default 1, capped by the number of hardware threads)
+		 * 'ciphers' is an array of cipher buffers in the order of 'messages'
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(encryptMany);
+
+
+		// ----------------
+		// encryptManyAsync
+		// ----------------
+		/**
+		 * @brief Unwraps the arguments to get the public key, an array of
+		 *		  messages and callback and creates an async worker which
+		 *		  encrypts all of them on the libuv thread pool.
+		 *
+		 * Invoked as:
+		 * 'obj.encryptManyAsync(key, messages, threads,
+		 *	function(status, ciphers){})'
+		 * 'key' is the hex encoded string or BER buffer of the ECC public key
+		 * 'messages' is an array of buffers to be encrypted; neither the
+		 * array nor the buffers may be modified until the callback is invoked
+		 * 'threads' (optional) is the maximum number of threads to spread the
+		 * batch across (default 1, capped by the number of hardware threads)
+		 * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+		 * 'ciphers' (if available) is an array of cipher buffers in the order
+		 * of 'messages'
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(encryptManyAsync);
+
+
+		// -------------
+		// keyCacheStats
+		// -------------
+		/**
+		 * @brief Returns the state of the parsed key cache.
+		 *
+		 * Invoked as:
+		 * 'let stats = obj.keyCacheStats()' where 'stats' is of the form:
+		 * {publicKeys: [cached public keys], privateKeys: [cached private
+		 *  keys], capacity: [capacity per kind], precomputeStorage:
+		 *  [precomputed points per key], precomputedBytes: [approximate
+		 *  memory used by precomputation tables], sessions: [cached
+		 *  session keys], keyPool: {size, available, generated, taken,
+		 *  misses, state}} with 'state' one of "disabled", "seeding",
+		 *  "ready" or "failed"
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(keyCacheStats);
+
+
+		// ------------
+		// encryptAsync
+		// ------------
+		/**
+		 * @brief Unwraps the arguments to get the public key, message and
+		 *		  callback and creates an async worker which encrypts the
+		 *		  message on the libuv thread pool.
+		 *
+		 * Invoked as:
+		 * 'obj.encryptAsync(key, message, function(status, cipher){})'
+		 * 'key' is the hex encoded string or BER buffer of the ECC public key
+		 * 'message' is the buffer containing the message to be encrypted; it
+		 * must not be modified until the callback is invoked
+		 * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+		 * 'cipher' (if available) is the buffer containing the cipher
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(encryptAsync);
+
+
+		// ------------
+		// decryptAsync
+		// ------------
+		/**
+		 * @brief Unwraps the arguments to get the private key, cipher and
+		 *		  callback and creates an async worker which decrypts the
+		 *		  cipher on the libuv thread pool.
+		 *
+		 * Invoked as:
+		 * 'obj.decryptAsync(key, cipher, function(status, message){})'
+		 * 'key' is the hex encoded string or BER buffer of the ECC private key
+		 * 'cipher' is the buffer containing the cipher to be decrypted; it
+		 * must not be modified until the callback is invoked
+		 * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+		 * 'message' (if available) is the buffer containing the message
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(decryptAsync);
+
+		// ---------
+		// storeKeys
+		// ---------
+		/**
+		 * @brief Unwraps the arguments to get the name and the keys and
+		 *		  saves the keys in the keystore file of the folder under the
+		 *		  given name, replacing any keys of the same name.
+		 *
+		 * Invoked as:
+		 * 'obj.storeKeys(name, keys)' where
+		 * 'name' is the string naming the key pair
+		 * 'keys' is of the form: {enc: [publicKey], dec: [privateKey]}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(storeKeys);
+
+
+		// --------------
+		// loadStoredKeys
+		// --------------
+		/**
+		 * @brief Returns the named keys from the keystore file of the
+		 *		  folder.
+		 *
+		 * Invoked as:
+		 * 'let keys = obj.loadStoredKeys(name)' where
+		 * 'name' is the string naming the key pair
+		 * 'keys' is undefined if there are no keys with the given name, or
+		 * of the form: {enc: [publicKey], dec: [privateKey],
+		 * curve: [curveName]}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(loadStoredKeys);
+
+
+		// ------------------
+		// generateStoredKeys
+		// ------------------
+		/**
+		 * @brief Initializes the isaac RNG and uses it to generate the
+		 *		  public/private keys, saving them in the keystore file of
+		 *		  the folder under the given name instead of the key files.
+		 *
+		 * Invoked as:
+		 * 'let keys = obj.generateStoredKeys(name, curve)' where
+		 * 'name' is the string naming the key pair
+		 * 'curve' (optional) overrides the curve given at construction
+		 * 'keys' (if available) is of the form:
+		 * {enc: [publicKey], dec: [privateKey], curve: [curveName]}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(generateStoredKeys);
+
+
+		// ----------
+		// sessionKey
+		// ----------
+		/**
+		 * @brief Unwraps the arguments to get the private key and the peer
+		 *		  public key and returns the session key material they
+		 *		  share, from the session cache when possible.
+		 *
+		 * Invoked as:
+		 * 'let secret = obj.sessionKey(privateKey, peerPublicKey)' where
+		 * 'privateKey' is the hex encoded string or BER buffer of the ECC
+		 * private key
+		 * 'peerPublicKey' is the hex encoded string or BER buffer of the
+		 * peer's ECC public key, on the same curve
+		 * 'secret' is a buffer of 96 bytes: the 48 bytes keying messages
+		 * sent to the peer followed by the 48 bytes keying messages
+		 * received from it, each an AES-256 key followed by an AESXOR256
+		 * seed; the peer gets the two halves swapped
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(sessionKey);
+
 	public:
 
 		// ----
@@ -483,10 +1603,12 @@ class SEIFECC : public Nan::ObjectWrap {
 		 * 		  by the addon.
 		 *
 		 * @param exports node.js module exports
+		 * @param data module instance data holding the class constructors
 		 *
 		 * @return void
 		 */
-		static void Init(v8::Handle<v8::Object> exports);
+		static void Init(v8::Local<v8::Object> exports,
+			v8::Local<v8::Object> data);
 
 };
 
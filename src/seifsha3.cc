@@ -33,29 +33,264 @@
 #include <iostream>
 #include <string>
 #include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 // ----------------------
 // node.js addon includes
 // ----------------------
 #include <node_buffer.h>
 
-// -----------------
-// cryptopp includes
-// -----------------
-#include "sha3.h"
-using CryptoPP::SHA3_256;
-
 // ----------------
 // library includes
 // ----------------
 #include <isaacRandomPool.h>
 
+#include "binding.h"
+#include "keccak.h"
+#include "parallel.hpp"
 #include "seifsha3.h"
-#include "util.h"
 
 
-// javascript object constructor
-Nan::Persistent<v8::Function> SEIFSHA3::constructor;
+// supported hash functions, SHA3-256 first as the default
+const SEIFSHA3::Algorithm SEIFSHA3::ALGORITHMS[] = {
+    {"sha3-256", 136, 0x06, 32, false},
+    {"sha3-224", 144, 0x06, 28, false},
+    {"sha3-384", 104, 0x06, 48, false},
+    {"sha3-512", 72, 0x06, 64, false},
+    {"shake128", 168, 0x1F, 16, true},
+    {"shake256", 136, 0x1F, 32, true}
+};
+
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initilizes and constructs internal data. String data is
+ *        converted to UTF-8 here, on the main thread.
+ *
+ * @param callback callback to be invoked after async operation
+ * @param algorithm hash function parameters
+ * @param outputLength number of output bytes
+ * @param data string, or buffer which must stay alive and unmodified
+ *        until the callback is invoked
+ */
+SEIFSHA3::HashWorker::HashWorker(
+    Nan::Callback* callback,
+    const Algorithm* algorithm,
+    size_t outputLength,
+    v8::Local<v8::Value> data
+): Nan::AsyncWorker(callback),
+_algorithm(algorithm),
+_data(nullptr),
+_length(0),
+_digest(outputLength) {
+
+    if (Binding::isBytes(data)) {
+        v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(data).ToLocalChecked();
+
+        _data = Binding::data(bufferObj);
+        _length = Binding::length(bufferObj);
+
+        // Keep the buffer alive until the worker completes.
+        SaveToPersistent("data", bufferObj);
+    } else {
+        v8::Local<v8::String> str = Nan::To<v8::String>(data).ToLocalChecked();
+
+        stringBytes(str, _string, _data, _length);
+
+        // Keep an external string alive until the worker completes.
+        SaveToPersistent("data", str);
+    }
+}
+
+
+
+// ----------------
+// HandleOKCallback
+// ----------------
+/**
+ * @brief Executed when the async work is complete, invoking
+ *        the given callback with the status and the buffer
+ *        containing the hash.
+ *
+ * @return void
+ */
+void SEIFSHA3::HashWorker::HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    v8::Local<v8::Object> status = Nan::New<v8::Object>();
+    Nan::Set(status,
+        Nan::New<v8::String>("code").ToLocalChecked(),
+        Nan::New<v8::Integer>(0));
+    Nan::Set(status,
+        Nan::New<v8::String>("message").ToLocalChecked(),
+        Nan::New<v8::String>("Success").ToLocalChecked());
+
+    v8::Local<v8::Value> argv[] = {
+        status,
+        Nan::CopyBuffer((const char*)_digest.data(), _digest.size())
+            .ToLocalChecked()
+    };
+
+    callback->Call(2, argv);
+}
+
+
+
+// -------
+// Execute
+// -------
+/**
+ * @brief Executed in a separate thread, hashing the data.
+ *
+ * @return void
+ */
+void SEIFSHA3::HashWorker::Execute() {
+    Keccak sponge(_algorithm->rate, _algorithm->suffix);
+    sponge.update(_data, _length);
+    sponge.finish(_digest.data(), _digest.size());
+}
+
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Initializes the running hash of the given function.
+ *
+ * @param algorithm hash function parameters
+ * @param outputLength number of output bytes
+ */
+SEIFSHA3::SEIFSHA3(
+    const Algorithm* algorithm,
+    size_t outputLength
+): _algorithm(algorithm),
+_outputLength(outputLength),
+_sponge(algorithm->rate, algorithm->suffix) {
+
+}
+
+
+
+// -------------
+// findAlgorithm
+// -------------
+/**
+ * @brief Looks up the parameters of the named hash function.
+ *
+ * @param name one of sha3-224, sha3-256, sha3-384, sha3-512, shake128
+ *        or shake256
+ *
+ * @return parameters or nullptr if not supported
+ */
+const SEIFSHA3::Algorithm* SEIFSHA3::findAlgorithm(const std::string& name) {
+    for (size_t i = 0; i < sizeof(ALGORITHMS) / sizeof(ALGORITHMS[0]); ++i) {
+        if (name == ALGORITHMS[i].name) {
+            return &ALGORITHMS[i];
+        }
+    }
+
+    return nullptr;
+}
+
+
+
+// -----------
+// stringBytes
+// -----------
+/**
+ * @brief Locates the UTF-8 bytes of the string without copying them
+ *        again. External ASCII strings are read in place, any other
+ *        string is converted into the given holder.
+ *
+ * @param str string to be hashed
+ * @param holder receives the UTF-8 conversion when one is needed
+ * @param data receives the address of the bytes
+ * @param length receives the number of bytes
+ *
+ * @return void
+ */
+void SEIFSHA3::stringBytes(
+    v8::Local<v8::String> str,
+    std::unique_ptr<Nan::Utf8String>& holder,
+    const uint8_t*& data,
+    size_t& length
+) {
+    if (str->IsExternalOneByte()) {
+        const v8::String::ExternalOneByteStringResource* resource =
+            str->GetExternalOneByteStringResource();
+
+        const uint8_t* bytes = (const uint8_t*)resource->data();
+        const size_t size = resource->length();
+
+        // Latin-1 and UTF-8 only agree on the ASCII range.
+        if (std::all_of(bytes, bytes + size,
+                [](uint8_t c) { return c < 0x80; })) {
+            data = bytes;
+            length = size;
+            return;
+        }
+    }
+
+    holder.reset(new Nan::Utf8String(str));
+    data = (const uint8_t*)**holder;
+    length = holder->length();
+}
+
+
+
+// ------------
+// hashMessages
+// ------------
+/**
+ * @brief Hashes each message independently, writing the hashes one
+ *        after the other and spreading the messages across the given
+ *        number of threads, capped by the number of hardware threads.
+ *
+ * @param algorithm hash function parameters
+ * @param outputLength number of output bytes per message
+ * @param output container of 'count * outputLength' bytes
+ * @param messages pointers to the messages
+ * @param lengths lengths of the messages
+ * @param count number of messages
+ * @param threads maximum number of threads to use
+ *
+ * @throw std::system_error if a thread could not be started
+ *
+ * @return void
+ */
+void SEIFSHA3::hashMessages(
+    const Algorithm* algorithm,
+    size_t outputLength,
+    uint8_t* output,
+    const uint8_t* const* messages,
+    const size_t* lengths,
+    size_t count,
+    unsigned int threads
+) {
+    const size_t rate = algorithm->rate;
+    const uint8_t suffix = algorithm->suffix;
+
+    if (Parallel::threadCount(count, threads) == 1) {
+        Keccak::hashMany(rate, suffix, messages, lengths, count, output,
+            outputLength);
+        return;
+    }
+
+    // Slices are kept a multiple of four so every lane of the kernel is used.
+    Parallel::forEachSlice(count, threads, 4, [=](size_t begin, size_t end) {
+        Keccak::hashMany(rate, suffix, messages + begin, lengths + begin,
+            end - begin, output + begin * outputLength, outputLength);
+    });
+}
 
 
 
@@ -66,8 +301,13 @@ Nan::Persistent<v8::Function> SEIFSHA3::constructor;
  * @brief Creates the node object and corresponding underlying object.
  *
  * Invoked as:
- * 'let obj = new SEIFSHA3()' or
- * 'let obj = SEIFSHA3()'
+ * 'let obj = new SEIFSHA3(options)' or
+ * 'let obj = SEIFSHA3(options)' where
+ * 'options' (optional) is of the form:
+ * {algorithm: [sha3-224, sha3-256 (default), sha3-384, sha3-512, shake128
+ *  or shake256],
+ *  outputLength: [number of output bytes, SHAKE only; the fixed digest
+ *                 size is also accepted for the SHA3 functions]}
  *
  * @param info node.js arguments wrapper
  *
@@ -77,8 +317,51 @@ NAN_METHOD(SEIFSHA3::New) {
 
     if (info.IsConstructCall()) {
 
-        // Invoked as constructor: 'let obj = new SEIFSHA3()'.
-        SEIFSHA3* obj = new SEIFSHA3();
+        const Algorithm* algorithm = &ALGORITHMS[0];
+        size_t outputLength = algorithm->outputLength;
+
+        // Unwrap the optional first argument to get the hash function.
+        if (info[0]->IsObject()) {
+            v8::Local<v8::Object> options =
+                Nan::To<v8::Object>(info[0]).ToLocalChecked();
+
+            v8::Local<v8::Value> name = Nan::Get(options,
+                Nan::New("algorithm").ToLocalChecked()).ToLocalChecked();
+            if (!name->IsUndefined()) {
+                algorithm = findAlgorithm(*Nan::Utf8String(name));
+                if (algorithm == nullptr) {
+                    Nan::ThrowError("Unsupported algorithm");
+                    return;
+                }
+                outputLength = algorithm->outputLength;
+            }
+
+            v8::Local<v8::Value> length = Nan::Get(options,
+                Nan::New("outputLength").ToLocalChecked()).ToLocalChecked();
+            if (!length->IsUndefined()) {
+                const double value = Nan::To<double>(length).FromJust();
+                if (!(value >= 1 && value <= node::Buffer::kMaxLength) ||
+                    value != static_cast<double>(static_cast<size_t>(value))) {
+                    Nan::ThrowError("Incorrect Arguments. Output length must "
+                                    "be a positive integer");
+                    return;
+                }
+
+                /* The fixed length digests only accept their own size, so
+                 * the options returned by 'algorithm()' can be passed back.
+                 */
+                if (!algorithm->extendable &&
+                    static_cast<size_t>(value) != algorithm->outputLength) {
+                    Nan::ThrowError("Incorrect Arguments. Output length can "
+                                    "only be chosen for SHAKE");
+                    return;
+                }
+                outputLength = static_cast<size_t>(value);
+            }
+        }
+
+        // Invoked as constructor: 'let obj = new SEIFSHA3(options)'.
+        SEIFSHA3* obj = new SEIFSHA3(algorithm, outputLength);
 
         obj->Wrap(info.This());
         info.GetReturnValue().Set(info.This());
@@ -95,8 +378,10 @@ NAN_METHOD(SEIFSHA3::New) {
             argv.push_back(info[i]);
         }
 
-        v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
-        info.GetReturnValue().Set(cons->NewInstance(argc, argv.data()));
+        v8::Local<v8::Function> cons =
+            Binding::constructor(info.Data(), Binding::CLASS::SEIFSHA3);
+        info.GetReturnValue().Set(
+            Nan::NewInstance(cons, argc, argv.data()).ToLocalChecked());
 
     }
 }
@@ -107,60 +392,298 @@ NAN_METHOD(SEIFSHA3::New) {
 // hash
 // ----
 /**
- * @brief Unwraps the arguments to get the string data and returns
- *        the hash of the given input as a buffer object.
+ * @brief Unwraps the arguments to get the string or buffer data and
+ *        returns the hash of the given input as a buffer object.
  *
  * Invoked as:
- * 'let hash = obj.hash(stringData)' where
- * 'stringData' is the string data to be hashed
- * 'hash' is the output buffer containing the SHA3-256 hash
- * To generate the output we are using Crypto++ SHA3-256 hash functions
+ * 'let hash = obj.hash(data)' where
+ * 'data' is the string (hashed as UTF-8) or buffer to be hashed
+ * 'hash' is the output buffer containing the hash
  *
- * @param info node.js arguments wrapper containing string value to be
+ * @param info node.js arguments wrapper containing value to be
  *        hashed
  *
  * @return void
  */
 NAN_METHOD(SEIFSHA3::hash) {
 
-    // Checking arguments and unwrapping them to get the string data.
+    SEIFSHA3* obj = ObjectWrap::Unwrap<SEIFSHA3>(info.Holder());
+
+    // Checking arguments and unwrapping them to get the data.
     if (info[0]->IsUndefined()) {
         Nan::ThrowError("Incorrect Arguments. Value to be hashed not "
                         "provided");
         return;
     }
 
-    // Output buffer containing the hash
-    std::vector<uint8_t> digest(CryptoPP::SHA3_256::DIGESTSIZE);
+    // Buffers are hashed in place, strings from their UTF-8 bytes.
+    std::unique_ptr<Nan::Utf8String> holder;
+    const uint8_t* data;
+    size_t length;
 
-    // Check if first argument is a buffer or a string and hash accordingly.
-    if (!node::Buffer::HasInstance(info[0])) {
-        v8::String::Utf8Value str(info[0]->ToString());
+    if (Binding::isBytes(info[0])) {
+        v8::Local<v8::Object> bufferObj =
+            Nan::To<v8::Object>(info[0]).ToLocalChecked();
 
-        /* Using crypto++ sha3-256 hash function to hash data and store in
-         * 'digest' array. Definition of 'hashString' can be found in 'util.h'.
-         */
-        hashString(digest, *str);
+        data = Binding::data(bufferObj);
+        length = Binding::length(bufferObj);
     } else {
-        // Unwrap the first argument to get the input buffer to be hashed
+        stringBytes(Nan::To<v8::String>(info[0]).ToLocalChecked(), holder,
+            data, length);
+    }
+
+    // Write the hash straight into the node.js buffer.
+    v8::Local<v8::Object> buffer =
+        Nan::NewBuffer(obj->_outputLength).ToLocalChecked();
+
+    Keccak::hashMany(obj->_algorithm->rate, obj->_algorithm->suffix, &data,
+        &length, 1, Binding::data(buffer), obj->_outputLength);
+
+    // Set node.js buffer as return value of the function.
+    info.GetReturnValue().Set(buffer);
+}
+
+
+
+// ------
+// update
+// ------
+/**
+ * @brief Unwraps the arguments to get the string or buffer data and
+ *        adds it to the running hash of the object. Strings are
+ *        hashed as UTF-8.
+ *
+ * Invoked as:
+ * 'obj.update(data)' where
+ * 'data' is the string or buffer chunk to be hashed
+ * The object is returned so calls can be chained.
+ *
+ * @param info node.js arguments wrapper containing the data
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFSHA3::update) {
+
+    SEIFSHA3* obj = ObjectWrap::Unwrap<SEIFSHA3>(info.Holder());
+
+    // Checking arguments and unwrapping them to get the data.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Value to be hashed not "
+                        "provided");
+        return;
+    }
+
+    if (Binding::isBytes(info[0])) {
+        // Hash the buffer contents in place.
         v8::Local<v8::Object> bufferObj =
             Nan::To<v8::Object>(info[0]).ToLocalChecked();
 
-        uint8_t* bufferData = (uint8_t*)node::Buffer::Data(bufferObj);
-        size_t bufferLength = node::Buffer::Length(bufferObj);
+        obj->_sponge.update(Binding::data(bufferObj),
+            Binding::length(bufferObj));
+    } else {
+        std::unique_ptr<Nan::Utf8String> holder;
+        const uint8_t* data;
+        size_t length;
+
+        stringBytes(Nan::To<v8::String>(info[0]).ToLocalChecked(), holder,
+            data, length);
 
-        /* Using crypto++ sha3-256 hash function to hash data and store in
-         * 'digest' array. Definition of 'hashBuffer' can be found in 'util.h'.
-         */
-        hashBuffer(digest, bufferData, bufferLength);
+        obj->_sponge.update(data, length);
     }
 
-    // Copying digest hash value to node.js buffer.
-    auto slowBuffer = Nan::CopyBuffer((const char*)digest.data(),
-        digest.size()).ToLocalChecked();
+    info.GetReturnValue().Set(info.Holder());
+}
 
-    // Set node.js buffer as return value of the function.
-    info.GetReturnValue().Set(slowBuffer);
+
+
+// ------
+// digest
+// ------
+/**
+ * @brief Returns the hash of all data given to 'update' since the
+ *        object was created or 'digest' was last called, and resets
+ *        the running hash.
+ *
+ * Invoked as:
+ * 'let hash = obj.digest()' where
+ * 'hash' is the output buffer containing the hash
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFSHA3::digest) {
+
+    SEIFSHA3* obj = ObjectWrap::Unwrap<SEIFSHA3>(info.Holder());
+
+    /* Write the digest straight into the node.js buffer, which also resets
+     * the running hash.
+     */
+    v8::Local<v8::Object> buffer =
+        Nan::NewBuffer(obj->_outputLength).ToLocalChecked();
+
+    obj->_sponge.finish(Binding::data(buffer),
+        obj->_outputLength);
+
+    info.GetReturnValue().Set(buffer);
+}
+
+
+
+// ---------
+// hashAsync
+// ---------
+/**
+ * @brief Unwraps the arguments to get the string or buffer data and
+ *        the callback and creates an async worker which hashes the
+ *        data on the libuv thread pool.
+ *
+ * Invoked as:
+ * 'obj.hashAsync(data, function(status, hash){})' where
+ * 'data' is the string or buffer to be hashed; a buffer must not be
+ * modified until the callback is invoked
+ * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+ * 'hash' is the output buffer containing the hash
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFSHA3::hashAsync) {
+
+    SEIFSHA3* obj = ObjectWrap::Unwrap<SEIFSHA3>(info.Holder());
+
+    // Checking arguments.
+    if (info[0]->IsUndefined()) {
+        Nan::ThrowError("Incorrect Arguments. Value to be hashed not "
+                        "provided");
+        return;
+    }
+
+    if (!info[1]->IsFunction()) {
+        Nan::ThrowError("Incorrect Arguments. Callback function not provided");
+        return;
+    }
+
+    Nan::Callback* callback = new Nan::Callback(info[1].As<v8::Function>());
+
+    Nan::AsyncQueueWorker(new HashWorker(callback, obj->_algorithm,
+        obj->_outputLength, info[0]));
+}
+
+
+
+// --------
+// hashMany
+// --------
+/**
+ * @brief Unwraps the arguments to get an array of strings or buffers
+ *        and returns their hashes concatenated in a single buffer.
+ *        Messages are optionally spread across threads and hashed
+ *        four at a time where AVX2 is available.
+ *
+ * Invoked as:
+ * 'let hashes = obj.hashMany(values, threads)' where
+ * 'values' is the array of strings or buffers to be hashed
+ * 'threads' (optional) is the maximum number of threads, 1 by default,
+ * capped by the number of hardware threads
+ * 'hashes' is the buffer containing the hash of 'values[i]' at offset
+ * 'outputLength * i'
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFSHA3::hashMany) {
+
+    SEIFSHA3* obj = ObjectWrap::Unwrap<SEIFSHA3>(info.Holder());
+
+    if (!info[0]->IsArray()) {
+        Nan::ThrowError("Incorrect Arguments. Array of values to be hashed "
+                        "not provided");
+        return;
+    }
+
+    v8::Local<v8::Array> array = info[0].As<v8::Array>();
+    const uint32_t count = array->Length();
+
+    if (count > node::Buffer::kMaxLength / obj->_outputLength) {
+        Nan::ThrowError("Incorrect Arguments. Too many values to be hashed");
+        return;
+    }
+
+    // Buffers are hashed in place, strings from their UTF-8 bytes.
+    std::vector<const uint8_t*> messages(count);
+    std::vector<size_t> lengths(count);
+    std::vector<std::unique_ptr<Nan::Utf8String> > holders(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        v8::Local<v8::Value> value = Nan::Get(array, i).ToLocalChecked();
+
+        if (Binding::isBytes(value)) {
+            v8::Local<v8::Object> bufferObj =
+                Nan::To<v8::Object>(value).ToLocalChecked();
+            messages[i] = Binding::data(bufferObj);
+            lengths[i] = Binding::length(bufferObj);
+        } else {
+            stringBytes(Nan::To<v8::String>(value).ToLocalChecked(),
+                holders[i], messages[i], lengths[i]);
+        }
+    }
+
+    // Unwrap the optional second argument to get the number of threads.
+    unsigned int threads = 1;
+    if (info[1]->IsNumber()) {
+        threads = Nan::To<uint32_t>(info[1]).FromJust();
+    }
+
+    v8::Local<v8::Object> output =
+        Nan::NewBuffer(count * obj->_outputLength).ToLocalChecked();
+
+    try {
+
+        hashMessages(obj->_algorithm, obj->_outputLength,
+            Binding::data(output), messages.data(), lengths.data(),
+            count, threads);
+
+    } catch (const std::exception& ex) {
+        Nan::ThrowError(ex.what());
+        return;
+    }
+
+    info.GetReturnValue().Set(output);
+}
+
+
+
+// ---------
+// algorithm
+// ---------
+/**
+ * @brief Returns the options selecting the object's hash function.
+ *
+ * Invoked as:
+ * 'let options = obj.algorithm()' where
+ * 'options' is of the form:
+ * {algorithm: [name], outputLength: [number of output bytes]}
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(SEIFSHA3::algorithm) {
+
+    SEIFSHA3* obj = ObjectWrap::Unwrap<SEIFSHA3>(info.Holder());
+
+    v8::Local<v8::Object> options = Nan::New<v8::Object>();
+    Nan::Set(options,
+        Nan::New<v8::String>("algorithm").ToLocalChecked(),
+        Nan::New<v8::String>(obj->_algorithm->name).ToLocalChecked());
+    Nan::Set(options,
+        Nan::New<v8::String>("outputLength").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(obj->_outputLength)));
+
+    info.GetReturnValue().Set(options);
 }
 
 
@@ -173,23 +696,33 @@ NAN_METHOD(SEIFSHA3::hash) {
  *        by the addon.
  *
  * @param exports node.js module exports
+ * @param data module instance data holding the class constructors
  *
  * @return void
  */
-void SEIFSHA3::Init(v8::Handle<v8::Object> exports) {
+void SEIFSHA3::Init(v8::Local<v8::Object> exports,
+    v8::Local<v8::Object> data) {
 
     Nan::HandleScope scope;
 
     // Prepare constructor template.
-    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+    v8::Local<v8::FunctionTemplate> tpl =
+        Nan::New<v8::FunctionTemplate>(New, data);
     tpl->SetClassName(Nan::New("SEIFSHA3").ToLocalChecked());
     tpl->InstanceTemplate()->SetInternalFieldCount(1);
 
     // Prototype
-    Nan::SetPrototypeMethod(tpl, "hash", hash);
+    Nan::SetPrototypeMethod(tpl, "hash", hash, data);
+    Nan::SetPrototypeMethod(tpl, "update", update, data);
+    Nan::SetPrototypeMethod(tpl, "digest", digest, data);
+    Nan::SetPrototypeMethod(tpl, "hashAsync", hashAsync, data);
+    Nan::SetPrototypeMethod(tpl, "hashMany", hashMany, data);
+    Nan::SetPrototypeMethod(tpl, "algorithm", algorithm, data);
 
-    constructor.Reset(tpl->GetFunction());
+    v8::Local<v8::Function> constructor =
+        Nan::GetFunction(tpl).ToLocalChecked();
+    Binding::setConstructor(data, Binding::CLASS::SEIFSHA3, constructor);
 
     // Setting node.js module.exports.
-    exports->Set(Nan::New("SEIFSHA3").ToLocalChecked(), tpl->GetFunction());
+    Nan::Set(exports, Nan::New("SEIFSHA3").ToLocalChecked(), constructor);
 }
@@ -31,6 +31,13 @@
 #ifndef SEIFSHA3_H
 #define SEIFSHA3_H
 
+// -----------------
+// standard includes
+// -----------------
+#include <memory>
+#include <string>
+#include <vector>
+
 // ----------------------
 // node.js addon includes
 // ----------------------
@@ -38,6 +45,12 @@
 #include <node_object_wrap.h>
 #include <nan.h>
 
+// ----------------
+// library includes
+// ----------------
+#include "keccak.h"
+#include "securearena.h"
+
 
 // --------
 // SEIFSHA3
@@ -45,17 +58,206 @@
 
 /*
  * @class This class represents native object wrapped inside a javascript
- * 		  object, exposing Crypto++ SHA3 function.
+ * 		  object, exposing the SHA3 hash functions and SHAKE extendable
+ *		  output functions. The function is selected at construction,
+ *		  SHA3-256 by default.
  *
  *		  The functions exposed to node.js are:
- *		  function hash(data) -> returns SHA3-256 hash of the data
+ *		  function hash(data) -> returns the hash of the data
+ *		  function update(data) -> adds the data to the running hash
+ *		  function digest() -> returns the running hash and resets it
+ *		  function hashAsync(data, callback)
+ *		  function hashMany(values, threads) -> returns concatenated hashes
+ *		  function algorithm() -> returns the construction options
  */
 class SEIFSHA3 : public Nan::ObjectWrap {
 
 	private:
 
-		// javascript object constructor
-		static Nan::Persistent<v8::Function> constructor;
+		// Parameters of a supported hash function
+		struct Algorithm {
+			// name accepted by the constructor
+			const char* name;
+			// number of bytes absorbed per permutation
+			size_t rate;
+			// domain separation suffix
+			uint8_t suffix;
+			// default number of output bytes
+			size_t outputLength;
+			// whether the output length can be chosen (SHAKE)
+			bool extendable;
+		};
+
+		// supported hash functions, SHA3-256 first
+		static const Algorithm ALGORITHMS[];
+
+		// ----
+		// data
+		// ----
+		// selected hash function
+		const Algorithm* _algorithm;
+		// number of output bytes
+		size_t _outputLength;
+		// running hash of the data given to 'update'
+		Keccak _sponge;
+
+
+		// ----------
+		// HashWorker
+		// ----------
+		/*
+		 * @class This class represents the node.js async worker hashing
+		 *		  data on the libuv thread pool and invoking the given
+		 *		  callback function with the status of the operation and the
+		 *		  hash.
+		 */
+		class HashWorker: public Nan::AsyncWorker {
+
+			private:
+				// ----
+				// data
+				// ----
+
+				// hash function parameters
+				const Algorithm* _algorithm;
+				// UTF-8 conversion of string data, released on the main thread
+				std::unique_ptr<Nan::Utf8String> _string;
+				// data to be hashed, pinned for the lifetime of the worker
+				const uint8_t* _data;
+				// length of the data
+				size_t _length;
+				// resulting hash, in the secure arena
+				SecureBuffer _digest;
+
+			public:
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Initilizes and constructs internal data. String
+				 *		  data is converted to UTF-8 here, on the main thread.
+				 *
+				 * @param callback callback to be invoked after async operation
+				 * @param algorithm hash function parameters
+				 * @param outputLength number of output bytes
+				 * @param data string, or buffer which must stay alive and
+				 *		  unmodified until the callback is invoked
+				 */
+				HashWorker(
+					Nan::Callback* callback,
+					const Algorithm* algorithm,
+					size_t outputLength,
+					v8::Local<v8::Value> data
+				);
+
+
+				// ----------------
+				// HandleOKCallback
+				// ----------------
+				/**
+				 * @brief Executed when the async work is complete, invoking
+				 *		  the given callback with the status and the buffer
+				 *		  containing the hash.
+				 *
+				 * @return void
+				 */
+				void HandleOKCallback();
+
+
+				// -------
+				// Execute
+				// -------
+				/**
+				 * @brief Executed in a separate thread, hashing the data.
+				 *
+				 * @return void
+				 */
+				void Execute();
+		};
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Initializes the running hash of the given function.
+		 *
+		 * @param algorithm hash function parameters
+		 * @param outputLength number of output bytes
+		 */
+		SEIFSHA3(const Algorithm* algorithm, size_t outputLength);
+
+
+		// -------------
+		// findAlgorithm
+		// -------------
+		/**
+		 * @brief Looks up the parameters of the named hash function.
+		 *
+		 * @param name one of sha3-224, sha3-256, sha3-384, sha3-512,
+		 *		  shake128 or shake256
+		 *
+		 * @return parameters or nullptr if not supported
+		 */
+		static const Algorithm* findAlgorithm(const std::string& name);
+
+
+		// -----------
+		// stringBytes
+		// -----------
+		/**
+		 * @brief Locates the UTF-8 bytes of the string without copying
+		 *		  them again. External ASCII strings are read in place, any
+		 *		  other string is converted into the given holder.
+		 *
+		 * @param str string to be hashed
+		 * @param holder receives the UTF-8 conversion when one is needed
+		 * @param data receives the address of the bytes
+		 * @param length receives the number of bytes
+		 *
+		 * @return void
+		 */
+		static void stringBytes(
+			v8::Local<v8::String> str,
+			std::unique_ptr<Nan::Utf8String>& holder,
+			const uint8_t*& data,
+			size_t& length
+		);
+
+
+		// ------------
+		// hashMessages
+		// ------------
+		/**
+		 * @brief Hashes each message independently, writing the hashes one
+		 *		  after the other and spreading the messages across the
+		 *		  given number of threads, capped by the number of hardware
+		 *		  threads.
+		 *
+		 * @param algorithm hash function parameters
+		 * @param outputLength number of output bytes per message
+		 * @param output container of 'count * outputLength' bytes
+		 * @param messages pointers to the messages
+		 * @param lengths lengths of the messages
+		 * @param count number of messages
+		 * @param threads maximum number of threads to use
+		 *
+		 * @throw std::system_error if a thread could not be started
+		 *
+		 * @return void
+		 */
+		static void hashMessages(
+			const Algorithm* algorithm,
+			size_t outputLength,
+			uint8_t* output,
+			const uint8_t* const* messages,
+			const size_t* lengths,
+			size_t count,
+			unsigned int threads
+		);
+
 
 		// ---
 		// New
@@ -64,8 +266,12 @@ class SEIFSHA3 : public Nan::ObjectWrap {
 		 * @brief Creates the node object and corresponding underlying object.
 		 *
 		 * Invoked as:
-		 * 'let obj = new SEIFSHA3()' or
-		 * 'let obj = SEIFSHA3()'
+		 * 'let obj = new SEIFSHA3(options)' or
+		 * 'let obj = SEIFSHA3(options)' where
+		 * 'options' (optional) is of the form:
+		 * {algorithm: [sha3-224, sha3-256 (default), sha3-384, sha3-512,
+		 *  shake128 or shake256],
+		 *  outputLength: [number of output bytes, SHAKE only]}
 		 *
 		 * @param info node.js arguments wrapper
 		 *
@@ -78,22 +284,124 @@ class SEIFSHA3 : public Nan::ObjectWrap {
 		// hash
 		// ----
 		/**
-		 * @brief Unwraps the arguments to get the string data and returns
-		 *        the hash of the given input as a buffer object.
+		 * @brief Unwraps the arguments to get the string or buffer data and
+		 *        returns the hash of the given input as a buffer object.
 		 *
 		 * Invoked as:
-		 * 'let hash = obj.hash(stringData)' where
-		 * 'stringData' is the string data to be hashed
-		 * 'hash' is the output buffer containing the SHA3-256 hash
-		 * To generate the output we are using Crypto++ SHA3-256 hash functions
+		 * 'let hash = obj.hash(data)' where
+		 * 'data' is the string (hashed as UTF-8) or buffer to be hashed
+		 * 'hash' is the output buffer containing the hash
 		 *
-		 * @param info node.js arguments wrapper containing string value to be
+		 * @param info node.js arguments wrapper containing value to be
 		 *        hashed
 		 *
 		 * @return void
 		 */
 		static NAN_METHOD(hash);
 
+
+		// ------
+		// update
+		// ------
+		/**
+		 * @brief Unwraps the arguments to get the string or buffer data and
+		 *		  adds it to the running hash of the object. Strings are
+		 *		  hashed as UTF-8.
+		 *
+		 * Invoked as:
+		 * 'obj.update(data)' where
+		 * 'data' is the string or buffer chunk to be hashed
+		 * The object is returned so calls can be chained.
+		 *
+		 * @param info node.js arguments wrapper containing the data
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(update);
+
+
+		// ------
+		// digest
+		// ------
+		/**
+		 * @brief Returns the hash of all data given to 'update' since the
+		 *		  object was created or 'digest' was last called, and resets
+		 *		  the running hash.
+		 *
+		 * Invoked as:
+		 * 'let hash = obj.digest()' where
+		 * 'hash' is the output buffer containing the hash
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(digest);
+
+
+		// ---------
+		// hashAsync
+		// ---------
+		/**
+		 * @brief Unwraps the arguments to get the string or buffer data and
+		 *		  the callback and creates an async worker which hashes the
+		 *		  data on the libuv thread pool.
+		 *
+		 * Invoked as:
+		 * 'obj.hashAsync(data, function(status, hash){})' where
+		 * 'data' is the string or buffer to be hashed; a buffer must not be
+		 * modified until the callback is invoked
+		 * 'status' is of the form: {code: [statusCode], message: [statusMessage]}
+		 * 'hash' is the output buffer containing the hash
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(hashAsync);
+
+
+		// --------
+		// hashMany
+		// --------
+		/**
+		 * @brief Unwraps the arguments to get an array of strings or buffers
+		 *		  and returns their hashes concatenated in a single buffer.
+		 *		  Messages are optionally spread across threads and hashed
+		 *		  four at a time where AVX2 is available.
+		 *
+		 * Invoked as:
+		 * 'let hashes = obj.hashMany(values, threads)' where
+		 * 'values' is the array of strings or buffers to be hashed
+		 * 'threads' (optional) is the maximum number of threads, 1 by default,
+		 * capped by the number of hardware threads
+		 * 'hashes' is the buffer containing the hash of 'values[i]' at offset
+		 * 'outputLength * i'
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(hashMany);
+
+
+		// ---------
+		// algorithm
+		// ---------
+		/**
+		 * @brief Returns the options selecting the object's hash function.
+		 *
+		 * Invoked as:
+		 * 'let options = obj.algorithm()' where
+		 * 'options' is of the form:
+		 * {algorithm: [name], outputLength: [number of output bytes]}
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(algorithm);
+
 	public:
 
 		// ----
@@ -104,10 +412,12 @@ class SEIFSHA3 : public Nan::ObjectWrap {
 		 * 		  by the addon.
 		 *
 		 * @param exports node.js module exports
+		 * @param data module instance data holding the class constructors
 		 *
 		 * @return void
 		 */
-    	static void Init(v8::Handle<v8::Object> exports);
+    	static void Init(v8::Local<v8::Object> exports,
+			v8::Local<v8::Object> data);
 
 };
 
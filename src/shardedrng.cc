@@ -0,0 +1,514 @@
+/** @file shardedrng.cc
+ *  @brief Definition of the class functions provided in shardedrng.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "aes.h"
+#include "modes.h"
+#include "secblock.h"
+
+// ----------------
+// library includes
+// ----------------
+#include "fileutil.h"
+#include "shardedrng.h"
+#include "stats.h"
+
+
+// number of output bytes after which a shard is rekeyed (1 MiB)
+const size_t ShardedRandomPool::RESHARD_INTERVAL_BYTES = 1 << 20;
+
+// suffix of the previous state kept during an atomic save
+const char* const ShardedRandomPool::BACKUP_SUFFIX = ".bak";
+
+namespace {
+    // guards 'pools'
+    std::mutex poolsMutex;
+    // pools keyed by the file identifier of their saved state
+    std::map<std::string, std::shared_ptr<ShardedRandomPool> > pools;
+    // source of pool identifiers
+    std::atomic<uint64_t> nextPoolId(1);
+
+    // AES-256 key of a shard and the epoch it was derived in
+    struct Shard {
+        CryptoPP::FixedSizeSecBlock<uint8_t, 32> key;
+        uint64_t epoch;
+        size_t generated;
+
+        Shard(): epoch(0), generated(0) {}
+    };
+
+    /* Shards of the calling thread keyed by pool identifier, wiped when the
+     * thread exits.
+     */
+    std::unordered_map<uint64_t, Shard>& threadShards() {
+        static thread_local std::unordered_map<uint64_t, Shard> shards;
+        return shards;
+    }
+}
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Creates an unseeded pool for the given state file.
+ *
+ * @param fileId file identifier of the saved state on disk
+ */
+ShardedRandomPool::ShardedRandomPool(const std::string& fileId):
+_fileId(fileId),
+_initialized(false),
+_attached(0),
+_epoch(1),
+_id(nextPoolId++),
+_changes(0),
+_savedChanges(0),
+_savedSync(SYNC::NONE) {
+
+}
+
+
+
+// -------
+// recover
+// -------
+/**
+ * @brief Restores the previous state kept by an interrupted atomic
+ *        save if the state file cannot be loaded, and removes it
+ *        once the state file is known to be complete. Must be
+ *        called with '_mutex' held.
+ *
+ * @param digest key used to encrypt/decrypt the saved state
+ *
+ * @return status of loading the saved state
+ */
+IsaacRandomPool::STATUS ShardedRandomPool::recover(
+    const std::vector<uint8_t>& digest
+) {
+    const std::string backup = _fileId + BACKUP_SUFFIX;
+
+    IsaacRandomPool::STATUS status = _master.IsInitialized(_fileId, digest);
+    if (!FileUtil::isFile(backup)) {
+        return status;
+    }
+
+    if (status == IsaacRandomPool::STATUS::SUCCESS) {
+        // The save completed, only the removal of the backup was missed.
+        std::remove(backup.c_str());
+        return status;
+    }
+
+    /* Set the incomplete state aside and try the previous one, putting both
+     * back if that fails too (e.g. for a wrong key).
+     */
+    const std::string partial = _fileId + ".partial";
+    bool hadFile = FileUtil::isFile(_fileId) &&
+        FileUtil::replaceFile(_fileId, partial);
+    if (!FileUtil::replaceFile(backup, _fileId)) {
+        if (hadFile) {
+            FileUtil::replaceFile(partial, _fileId);
+        }
+        return status;
+    }
+
+    IsaacRandomPool::STATUS restored = _master.IsInitialized(_fileId, digest);
+    if (restored == IsaacRandomPool::STATUS::SUCCESS) {
+        std::remove(partial.c_str());
+        return restored;
+    }
+
+    FileUtil::replaceFile(_fileId, backup);
+    if (hadFile) {
+        FileUtil::replaceFile(partial, _fileId);
+    }
+    return status;
+}
+
+
+// -------
+// forFile
+// -------
+/**
+ * @brief Returns the pool of the given state file, creating it on
+ *        first use.
+ *
+ * @param fileId file identifier of the saved state on disk
+ *
+ * @return pool shared by all users of the state file
+ */
+std::shared_ptr<ShardedRandomPool> ShardedRandomPool::forFile(
+    const std::string& fileId
+) {
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    std::shared_ptr<ShardedRandomPool>& pool = pools[fileId];
+    if (!pool) {
+        pool.reset(new ShardedRandomPool(fileId));
+    }
+    return pool;
+}
+
+
+// ----
+// load
+// ----
+/**
+ * @brief Seeds the master pool from the saved state unless it has
+ *        already been seeded in this process, in which case the key
+ *        is only checked.
+ *
+ * @param digest key used to encrypt/decrypt the saved state
+ *
+ * @return status of loading the saved state
+ */
+IsaacRandomPool::STATUS ShardedRandomPool::load(
+    const std::vector<uint8_t>& digest
+) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_initialized) {
+        return digest == _digest ? IsaacRandomPool::STATUS::SUCCESS :
+            IsaacRandomPool::STATUS::DECRYPTION_ERROR;
+    }
+
+    IsaacRandomPool::STATUS status;
+    {
+        Stats::Timer timer(Stats::OPERATION::DISK_READ, 0);
+        status = recover(digest);
+    }
+    if (status == IsaacRandomPool::STATUS::SUCCESS) {
+        _initialized = true;
+        _digest = digest;
+        ++_epoch;
+        // The state in memory is the state on disk, maybe not synced yet.
+        _savedChanges = _changes;
+        _savedSync = SYNC::NONE;
+    }
+    return status;
+}
+
+
+// ----------
+// initialize
+// ----------
+/**
+ * @brief Seeds the master pool by gathering entropy.
+ *
+ * @param multiplier amount of entropy data to collect
+ * @param digest key used to encrypt/decrypt the saved state
+ *
+ * @throw std::exception in case of hardware errors
+ *
+ * @return boolean indicating whether enough entropy was gathered
+ */
+bool ShardedRandomPool::initialize(
+    int multiplier,
+    const std::vector<uint8_t>& digest
+) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Stats::Timer timer(Stats::OPERATION::RNG_RESEED, 0);
+
+    if (!_master.Initialize(_fileId, multiplier, digest)) {
+        return false;
+    }
+
+    _initialized = true;
+    _digest = digest;
+    ++_epoch;
+    ++_changes;
+    return true;
+}
+
+
+// ---------
+// saveState
+// ---------
+/**
+ * @brief Encrypts and saves the state of the master pool to disk
+ *        unless it has not changed since it was last saved or
+ *        loaded. Concurrent calls are coalesced: a call waiting for
+ *        a write in progress returns without writing again when
+ *        that write included its changes. An unchanged state saved
+ *        with a weaker sync level is synced again without being
+ *        rewritten. Atomic saves always sync the new state and its
+ *        folder entry before the previous state is removed.
+ *
+ * @param options sync, atomic and force options
+ * @param written set to whether the state was written
+ *
+ * @throw std::runtime_error if the state could not be synced
+ *
+ * @return status of saving the state
+ */
+IsaacRandomPool::STATUS ShardedRandomPool::saveState(
+    const SaveOptions& options,
+    bool& written
+) {
+    written = false;
+
+    uint64_t requested;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        requested = _changes;
+    }
+
+    std::lock_guard<std::mutex> saveLock(_saveMutex);
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (!options.force && _initialized && _savedChanges >= requested) {
+        if (_savedSync >= options.sync) {
+            return IsaacRandomPool::STATUS::SUCCESS;
+        }
+
+        // Unchanged but synced less than requested, sync what was saved.
+        lock.unlock();
+        syncSaved(options.sync, options.sync);
+        lock.lock();
+        if (_savedSync < options.sync) {
+            _savedSync = options.sync;
+        }
+        return IsaacRandomPool::STATUS::SUCCESS;
+    }
+
+    // Timed until the state is synced.
+    Stats::Timer timer(Stats::OPERATION::DISK_WRITE, 0);
+
+    // Keep the previous state until the new one is completely written.
+    const std::string backup = _fileId + BACKUP_SUFFIX;
+    bool backedUp = options.atomic && FileUtil::isFile(_fileId) &&
+        FileUtil::replaceFile(_fileId, backup);
+
+    const uint64_t snapshot = _changes;
+    IsaacRandomPool::STATUS status = _master.SaveState();
+
+    if (status != IsaacRandomPool::STATUS::SUCCESS) {
+        if (backedUp) {
+            FileUtil::replaceFile(backup, _fileId);
+        }
+        return status;
+    }
+
+    // Sync without blocking generation, later saves wait on '_saveMutex'.
+    lock.unlock();
+
+    SYNC level = options.sync;
+    if (backedUp) {
+        /* The backup may only go once the new state and its folder entry
+         * are on the disk, otherwise a crash could lose both.
+         */
+        syncSaved(level < SYNC::DATA ? SYNC::DATA : level, SYNC::FULL);
+        std::remove(backup.c_str());
+
+        if (level == SYNC::FULL && !FileUtil::syncFolder(_fileId)) {
+            throw std::runtime_error("State could not be synced to disk");
+        }
+    } else {
+        syncSaved(level, level);
+    }
+
+    lock.lock();
+    _savedChanges = snapshot;
+    _savedSync = backedUp && level < SYNC::DATA ? SYNC::DATA : level;
+    written = true;
+    return status;
+}
+
+
+// ---------
+// syncSaved
+// ---------
+/**
+ * @brief Flushes the saved state file to the disk and, if asked, the
+ *        folder entry pointing to it.
+ *
+ * @param file how far the file is synced
+ * @param folder FULL to sync the folder as well
+ *
+ * @throw std::runtime_error if the state could not be synced
+ *
+ * @return void
+ */
+void ShardedRandomPool::syncSaved(SYNC file, SYNC folder) {
+    if (file != SYNC::NONE &&
+        !FileUtil::syncFile(_fileId, file == SYNC::DATA)) {
+        throw std::runtime_error("State could not be synced to disk");
+    }
+
+    if (folder == SYNC::FULL && !FileUtil::syncFolder(_fileId)) {
+        throw std::runtime_error("State could not be synced to disk");
+    }
+}
+
+
+// ------
+// attach
+// ------
+/**
+ * @brief Registers an RNG object using the seeded pool.
+ *
+ * @return void
+ */
+void ShardedRandomPool::attach() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_attached;
+}
+
+
+// ------
+// detach
+// ------
+/**
+ * @brief Unregisters an RNG object, keeping the pool seeded.
+ *
+ * @return void
+ */
+void ShardedRandomPool::detach() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_attached > 0) {
+        --_attached;
+    }
+}
+
+
+// -------
+// release
+// -------
+/**
+ * @brief Unregisters an RNG object, saving the state to disk and
+ *        destroying the master pool once no object is using it.
+ *
+ * @return void
+ */
+void ShardedRandomPool::release() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_attached > 0) {
+        --_attached;
+    }
+
+    if (_attached == 0 && _initialized) {
+        _master.Destroy();
+        _savedChanges = _changes;
+        _initialized = false;
+        _digest.clear();
+        // Shards derived from the destroyed state must not be used again.
+        ++_epoch;
+    }
+}
+
+
+// ---------------
+// entropyStrength
+// ---------------
+/**
+ * @brief Strength of the entropy available to the master pool.
+ *
+ * @return "WEAK", "MEDIUM" or "STRONG"
+ */
+std::string ShardedRandomPool::entropyStrength() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _master.EntropyStrength();
+}
+
+
+// ------
+// fileId
+// ------
+/**
+ * @brief File identifier of the saved state on disk.
+ *
+ * @return file identifier
+ */
+const std::string& ShardedRandomPool::fileId() const {
+    return _fileId;
+}
+
+
+// -------------
+// GenerateBlock
+// -------------
+/**
+ * @brief Fills the output with random bytes from the calling
+ *        thread's shard, rekeying it from the master pool first if
+ *        needed. Safe to call from any number of threads at once.
+ *
+ * @param output container for resulting random bytes
+ * @param size number of random bytes required
+ *
+ * @throw std::runtime_error if the master pool is not seeded
+ *
+ * @return void
+ */
+void ShardedRandomPool::GenerateBlock(uint8_t* output, size_t size) {
+
+    Shard& shard = threadShards()[_id];
+
+    if (shard.epoch != _epoch.load() ||
+        shard.generated >= RESHARD_INTERVAL_BYTES) {
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_initialized) {
+            throw std::runtime_error("RNG not initialized");
+        }
+
+        Stats::Timer timer(Stats::OPERATION::RNG_RESEED, shard.key.size());
+        _master.GenerateBlock(shard.key.BytePtr(), shard.key.size());
+        ++_changes;
+        shard.epoch = _epoch.load();
+        shard.generated = 0;
+    }
+
+    /* Key the keystream with the shard key, replace the key with the first
+     * 32 bytes and output the rest (fast key erasure).
+     */
+    const uint8_t iv[CryptoPP::AES::BLOCKSIZE] = {0};
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption ctr;
+    ctr.SetKeyWithIV(shard.key.BytePtr(), shard.key.size(), iv, sizeof(iv));
+
+    std::memset(shard.key.BytePtr(), 0, shard.key.size());
+    ctr.ProcessString(shard.key.BytePtr(), shard.key.size());
+
+    std::memset(output, 0, size);
+    ctr.ProcessString(output, size);
+
+    shard.generated += size;
+}
@@ -0,0 +1,332 @@
+/** @file shardedrng.h
+ *  @brief Class header for the ISAAC master pool shared by all RNG objects
+ *		   using the same state file, handing out per-thread generators
+ *		   derived from it.
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef SHARDEDRNG_H
+#define SHARDEDRNG_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "cryptlib.h"
+
+// ----------------
+// library includes
+// ----------------
+#include <isaacRandomPool.h>
+
+
+// -----------------
+// ShardedRandomPool
+// -----------------
+
+/*
+ * @class ISAAC random pool shared process wide by every RNG object using the
+ *		  same state file, including objects created on other threads, so
+ *		  the state is loaded or gathered only once. The master pool is
+ *		  guarded by a lock and only used to key one generator (shard) per
+ *		  thread. A shard is an AES-256 CTR generator which replaces its key
+ *		  with fresh keystream on every call (fast key erasure), so neither a
+ *		  shard nor the master state reveals earlier output. Shards are
+ *		  rekeyed from the master after RESHARD_INTERVAL_BYTES bytes and
+ *		  whenever the master is reseeded or destroyed, so generation only
+ *		  takes the lock once per interval.
+ */
+class ShardedRandomPool : public CryptoPP::RandomNumberGenerator {
+
+	public:
+
+		// how far 'saveState' makes the written state durable
+		enum class SYNC : int {
+			// leave flushing to the operating system
+			NONE,
+			// flush the file data (fdatasync)
+			DATA,
+			// flush the file data and metadata and the folder entry (fsync)
+			FULL
+		};
+
+		// options of 'saveState'
+		struct SaveOptions {
+			// how far the written state is synced to the disk
+			SYNC sync;
+			/* keep the previous state next to the file until the new state
+			 * is completely written, so an interrupted save is recovered
+			 */
+			bool atomic;
+			// write even if the state has not changed since the last save
+			bool force;
+
+			SaveOptions(): sync(SYNC::NONE), atomic(false), force(false) {}
+		};
+
+	private:
+
+		// ----
+		// data
+		// ----
+		// guards the master pool and the fields below
+		std::mutex _mutex;
+		// master isaac RNG
+		IsaacRandomPool _master;
+		// file identifier of the saved state on disk
+		std::string _fileId;
+		// key used to encrypt/decrypt the saved state
+		std::vector<uint8_t> _digest;
+		// whether the master pool has been seeded
+		bool _initialized;
+		// number of RNG objects using the pool
+		unsigned int _attached;
+		// incremented whenever existing shards must be rekeyed
+		std::atomic<uint64_t> _epoch;
+		// identifier of the pool among the shards of a thread
+		const uint64_t _id;
+		// incremented whenever the master state changes
+		uint64_t _changes;
+		// value of '_changes' the state on disk corresponds to
+		uint64_t _savedChanges;
+		// how far the state on disk is known to be synced
+		SYNC _savedSync;
+		/* serializes writes of the state, so requests arriving during a
+		 * write wait for it instead of writing again
+		 */
+		std::mutex _saveMutex;
+
+		// number of output bytes after which a shard is rekeyed
+		static const size_t RESHARD_INTERVAL_BYTES;
+
+		// suffix of the previous state kept during an atomic save
+		static const char* const BACKUP_SUFFIX;
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Creates an unseeded pool for the given state file.
+		 *
+		 * @param fileId file identifier of the saved state on disk
+		 */
+		explicit ShardedRandomPool(const std::string& fileId);
+
+
+		// -------
+		// recover
+		// -------
+		/**
+		 * @brief Restores the previous state kept by an interrupted atomic
+		 *		  save if the state file cannot be loaded, and removes it
+		 *		  once the state file is known to be complete. Must be
+		 *		  called with '_mutex' held.
+		 *
+		 * @param digest key used to encrypt/decrypt the saved state
+		 *
+		 * @return status of loading the saved state
+		 */
+		IsaacRandomPool::STATUS recover(const std::vector<uint8_t>& digest);
+
+
+		// ---------
+		// syncSaved
+		// ---------
+		/**
+		 * @brief Flushes the saved state file to the disk and, if asked,
+		 *		  the folder entry pointing to it.
+		 *
+		 * @param file how far the file is synced
+		 * @param folder FULL to sync the folder as well
+		 *
+		 * @throw std::runtime_error if the state could not be synced
+		 *
+		 * @return void
+		 */
+		void syncSaved(SYNC file, SYNC folder);
+
+	public:
+
+		// -------
+		// forFile
+		// -------
+		/**
+		 * @brief Returns the pool of the given state file, creating it on
+		 *		  first use.
+		 *
+		 * @param fileId file identifier of the saved state on disk
+		 *
+		 * @return pool shared by all users of the state file
+		 */
+		static std::shared_ptr<ShardedRandomPool> forFile(
+			const std::string& fileId);
+
+
+		// ----
+		// load
+		// ----
+		/**
+		 * @brief Seeds the master pool from the saved state unless it has
+		 *		  already been seeded in this process, in which case the key
+		 *		  is only checked.
+		 *
+		 * @param digest key used to encrypt/decrypt the saved state
+		 *
+		 * @return status of loading the saved state
+		 */
+		IsaacRandomPool::STATUS load(const std::vector<uint8_t>& digest);
+
+
+		// ----------
+		// initialize
+		// ----------
+		/**
+		 * @brief Seeds the master pool by gathering entropy.
+		 *
+		 * @param multiplier amount of entropy data to collect
+		 * @param digest key used to encrypt/decrypt the saved state
+		 *
+		 * @throw std::exception in case of hardware errors
+		 *
+		 * @return boolean indicating whether enough entropy was gathered
+		 */
+		bool initialize(int multiplier, const std::vector<uint8_t>& digest);
+
+
+		// ---------
+		// saveState
+		// ---------
+		/**
+		 * @brief Encrypts and saves the state of the master pool to disk
+		 *		  unless it has not changed since it was last saved or
+		 *		  loaded. Concurrent calls are coalesced: a call waiting for
+		 *		  a write in progress returns without writing again when
+		 *		  that write included its changes. An unchanged state saved
+		 *		  with a weaker sync level is synced again without being
+		 *		  rewritten. Atomic saves always sync the new state and its
+		 *		  folder entry before the previous state is removed.
+		 *
+		 * @param options sync, atomic and force options
+		 * @param written set to whether the state was written
+		 *
+		 * @throw std::runtime_error if the state could not be synced
+		 *
+		 * @return status of saving the state
+		 */
+		IsaacRandomPool::STATUS saveState(const SaveOptions& options,
+			bool& written);
+
+
+		// ------
+		// attach
+		// ------
+		/**
+		 * @brief Registers an RNG object using the seeded pool.
+		 *
+		 * @return void
+		 */
+		void attach();
+
+
+		// ------
+		// detach
+		// ------
+		/**
+		 * @brief Unregisters an RNG object, keeping the pool seeded.
+		 *
+		 * @return void
+		 */
+		void detach();
+
+
+		// -------
+		// release
+		// -------
+		/**
+		 * @brief Unregisters an RNG object, saving the state to disk and
+		 *		  destroying the master pool once no object is using it.
+		 *
+		 * @return void
+		 */
+		void release();
+
+
+		// ---------------
+		// entropyStrength
+		// ---------------
+		/**
+		 * @brief Strength of the entropy available to the master pool.
+		 *
+		 * @return "WEAK", "MEDIUM" or "STRONG"
+		 */
+		std::string entropyStrength();
+
+
+		// ------
+		// fileId
+		// ------
+		/**
+		 * @brief File identifier of the saved state on disk.
+		 *
+		 * @return file identifier
+		 */
+		const std::string& fileId() const;
+
+
+		// -------------
+		// GenerateBlock
+		// -------------
+		/**
+		 * @brief Fills the output with random bytes from the calling
+		 *		  thread's shard, rekeying it from the master pool first if
+		 *		  needed. Safe to call from any number of threads at once.
+		 *
+		 * @param output container for resulting random bytes
+		 * @param size number of random bytes required
+		 *
+		 * @throw std::runtime_error if the master pool is not seeded
+		 *
+		 * @return void
+		 */
+		void GenerateBlock(uint8_t* output, size_t size);
+
+};
+
+#endif
@@ -0,0 +1,506 @@
+/** @file stats.cc
+ *  @brief Definition of the runtime switchable instrumentation of the
+ *         native hot paths
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// -----------------
+// standard includes
+// -----------------
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+// ----------------
+// library includes
+// ----------------
+#include "securearena.h"
+#include "stats.h"
+#include "threadrng.h"
+
+
+// number of operations being recorded
+static const size_t OPERATIONS = static_cast<size_t>(Stats::OPERATION::COUNT);
+
+// names of the operations reported to javascript, in OPERATION order
+static const char* const OPERATION_NAMES[OPERATIONS] = {
+    "ecc.encrypt",
+    "ecc.decrypt",
+    "aes.encrypt",
+    "aes.decrypt",
+    "rng.getBytes",
+    "rng.reseed",
+    "disk.read",
+    "disk.write"
+};
+
+// whether calls are being recorded
+std::atomic<bool> Stats::_enabled(false);
+
+
+// Counters of one operation, written only by the owning thread.
+struct Counters {
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> totalNs;
+    std::atomic<uint64_t> buckets[Stats::BUCKETS];
+};
+
+// Plain copy of the counters of one operation.
+struct Totals {
+    uint64_t bytes;
+    uint64_t totalNs;
+    uint64_t buckets[Stats::BUCKETS];
+};
+
+struct ThreadRecord;
+
+// Records of the running threads and the totals of the exited ones.
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadRecord*> threads;
+    // totals of the threads that exited
+    Totals retired[OPERATIONS];
+    // totals at the last reset, subtracted when reading
+    Totals baseline[OPERATIONS];
+};
+
+
+// --------
+// registry
+// --------
+/**
+ * @brief Returns the process wide registry. It is never destroyed so
+ *        threads exiting during shutdown can still retire their record.
+ *
+ * @return registry
+ */
+static Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+
+// ---
+// add
+// ---
+/**
+ * @brief Adds the counters into the totals.
+ *
+ * @param totals totals to be added to
+ * @param counters counters being read
+ *
+ * @return void
+ */
+static void add(Totals& totals, const Counters& counters) {
+    totals.bytes += counters.bytes.load(std::memory_order_relaxed);
+    totals.totalNs += counters.totalNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < Stats::BUCKETS; ++i) {
+        totals.buckets[i] +=
+            counters.buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+
+// Counters of all operations owned by one thread, registered for its
+// lifetime and retired into the registry when it exits.
+struct ThreadRecord {
+    Counters counters[OPERATIONS];
+
+    ThreadRecord() {
+        for (Counters& c : counters) {
+            c.bytes.store(0, std::memory_order_relaxed);
+            c.totalNs.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t>& b : c.buckets) {
+                b.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(this);
+    }
+
+    ~ThreadRecord() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            add(r.retired[i], counters[i]);
+        }
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+    }
+};
+
+
+// ------------
+// threadRecord
+// ------------
+/**
+ * @brief Returns the record of the calling thread, creating it on first
+ *        use.
+ *
+ * @return record of the calling thread
+ */
+static ThreadRecord& threadRecord() {
+    static thread_local ThreadRecord record;
+    return record;
+}
+
+
+// --------
+// snapshot
+// --------
+/**
+ * @brief Merges the records of all threads, running and exited. The
+ *        registry must be locked.
+ *
+ * @param r registry
+ * @param totals output of OPERATIONS totals
+ *
+ * @return void
+ */
+static void snapshot(Registry& r, Totals* totals) {
+    std::copy(r.retired, r.retired + OPERATIONS, totals);
+    for (const ThreadRecord* record : r.threads) {
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            add(totals[i], record->counters[i]);
+        }
+    }
+}
+
+
+// -----
+// Timer
+// -----
+/**
+ * Constructor
+ * @brief Starts timing when recording is enabled.
+ *
+ * @param operation operation being timed
+ * @param bytes bytes processed by the operation
+ */
+Stats::Timer::Timer(OPERATION operation, size_t bytes):
+_operation(operation),
+_bytes(bytes),
+_active(Stats::enabled()) {
+
+    if (_active) {
+        _start = std::chrono::steady_clock::now();
+    }
+}
+
+
+// ----------
+// Destructor
+// ----------
+/**
+ * Destructor
+ * @brief Records the call with the elapsed time.
+ */
+Stats::Timer::~Timer() {
+
+    if (_active) {
+        std::chrono::nanoseconds elapsed =
+            std::chrono::steady_clock::now() - _start;
+        Stats::record(_operation, _bytes, elapsed.count());
+    }
+}
+
+
+// ------
+// record
+// ------
+/**
+ * @brief Records one call of the operation in the calling thread's
+ *        record.
+ *
+ * @param operation operation being recorded
+ * @param bytes bytes processed by the call
+ * @param nanoseconds latency of the call
+ *
+ * @return void
+ */
+void Stats::record(OPERATION operation, size_t bytes, uint64_t nanoseconds) {
+
+    Counters& c = threadRecord().counters[static_cast<size_t>(operation)];
+
+    // Only this thread writes its counters, no read-modify-write needed.
+    c.bytes.store(c.bytes.load(std::memory_order_relaxed) + bytes,
+        std::memory_order_relaxed);
+    c.totalNs.store(c.totalNs.load(std::memory_order_relaxed) + nanoseconds,
+        std::memory_order_relaxed);
+
+    std::atomic<uint64_t>& b = c.buckets[bucket(nanoseconds)];
+    b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+
+// ------
+// bucket
+// ------
+/**
+ * @brief Histogram bucket of the given latency. Latencies below 8ns
+ *        have a bucket each, larger ones 8 buckets per power of two,
+ *        the last bucket also taking anything longer than about 34
+ *        minutes.
+ *
+ * @param nanoseconds latency
+ *
+ * @return bucket index below BUCKETS
+ */
+size_t Stats::bucket(uint64_t nanoseconds) {
+
+    if (nanoseconds < 8) {
+        return static_cast<size_t>(nanoseconds);
+    }
+
+    // Shift the latency into [8, 16), the shift selecting the power of two
+    // and the remaining value the bucket within it.
+#if defined(__GNUC__)
+    size_t exponent = 60 - __builtin_clzll(nanoseconds);
+#else
+    size_t exponent = 0;
+    while ((nanoseconds >> exponent) >= 16) {
+        ++exponent;
+    }
+#endif
+
+    size_t index = 8 + exponent * 8 +
+        static_cast<size_t>((nanoseconds >> exponent) - 8);
+    return std::min(index, BUCKETS - 1);
+}
+
+
+// ----------
+// upperBound
+// ----------
+/**
+ * @brief Largest latency falling into the given bucket.
+ *
+ * @param index bucket index below BUCKETS
+ *
+ * @return latency in nanoseconds
+ */
+uint64_t Stats::upperBound(size_t index) {
+
+    if (index < 8) {
+        return index;
+    }
+
+    const size_t exponent = (index - 8) / 8;
+    const uint64_t next = 8 + (index - 8) % 8 + 1;
+    return (next << exponent) - 1;
+}
+
+
+// -----
+// stats
+// -----
+/**
+ * @brief Merges the records of all threads and returns them along
+ *        with the percentiles derived from the histograms.
+ *
+ * Invoked as:
+ * 'let stats = seifnode.stats(reset)' where
+ * 'reset' (optional) clears the records after reading them
+ * 'stats' is of the form:
+ * {enabled: [boolean], operations: {[name]: {calls, bytes, totalNs,
+ *  meanNs, maxNs, p50Ns, p90Ns, p99Ns, p999Ns,
+ *  buckets: [[upperNs, count], ...]}}}
+ * with the names ecc.encrypt, ecc.decrypt, aes.encrypt, aes.decrypt,
+ * rng.getBytes, rng.reseed, disk.read and disk.write
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(Stats::stats) {
+
+    bool reset = info.Length() > 0 && Nan::To<bool>(info[0]).FromJust();
+
+    std::vector<Totals> totals(OPERATIONS);
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        snapshot(r, totals.data());
+
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            Totals& t = totals[i];
+            const Totals& base = r.baseline[i];
+            if (reset) {
+                r.baseline[i] = t;
+            }
+
+            // Report what was recorded since the last reset.
+            t.bytes -= base.bytes;
+            t.totalNs -= base.totalNs;
+            for (size_t j = 0; j < BUCKETS; ++j) {
+                t.buckets[j] -= base.buckets[j];
+            }
+        }
+    }
+
+    // Quantiles reported, with the name of their field.
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+    static const char* const QUANTILE_NAMES[] = {
+        "p50Ns", "p90Ns", "p99Ns", "p999Ns"
+    };
+
+    v8::Local<v8::Object> operations = Nan::New<v8::Object>();
+
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+        const Totals& t = totals[i];
+
+        uint64_t calls = 0;
+        size_t last = 0;
+        v8::Local<v8::Array> buckets = Nan::New<v8::Array>();
+        for (size_t j = 0; j < BUCKETS; ++j) {
+            if (t.buckets[j] == 0) {
+                continue;
+            }
+
+            v8::Local<v8::Array> pair = Nan::New<v8::Array>(2);
+            Nan::Set(pair, 0, Nan::New<v8::Number>(
+                static_cast<double>(upperBound(j))));
+            Nan::Set(pair, 1, Nan::New<v8::Number>(
+                static_cast<double>(t.buckets[j])));
+            Nan::Set(buckets, buckets->Length(), pair);
+
+            calls += t.buckets[j];
+            last = j;
+        }
+
+        v8::Local<v8::Object> operation = Nan::New<v8::Object>();
+        Nan::Set(operation, Nan::New("calls").ToLocalChecked(),
+            Nan::New<v8::Number>(static_cast<double>(calls)));
+        Nan::Set(operation, Nan::New("bytes").ToLocalChecked(),
+            Nan::New<v8::Number>(static_cast<double>(t.bytes)));
+        Nan::Set(operation, Nan::New("totalNs").ToLocalChecked(),
+            Nan::New<v8::Number>(static_cast<double>(t.totalNs)));
+        Nan::Set(operation, Nan::New("meanNs").ToLocalChecked(),
+            Nan::New<v8::Number>(calls == 0 ? 0 :
+                static_cast<double>(t.totalNs) / calls));
+        Nan::Set(operation, Nan::New("maxNs").ToLocalChecked(),
+            Nan::New<v8::Number>(calls == 0 ? 0 :
+                static_cast<double>(upperBound(last))));
+
+        // Walk the histogram once, reporting each quantile's bucket.
+        uint64_t seen = 0;
+        size_t j = 0;
+        for (size_t q = 0; q < 4; ++q) {
+            uint64_t rank = static_cast<uint64_t>(
+                std::ceil(QUANTILES[q] * calls));
+            if (rank == 0) {
+                rank = 1;
+            }
+            while (calls > 0 && seen + t.buckets[j] < rank) {
+                seen += t.buckets[j];
+                ++j;
+            }
+            Nan::Set(operation, Nan::New(QUANTILE_NAMES[q]).ToLocalChecked(),
+                Nan::New<v8::Number>(calls == 0 ? 0 :
+                    static_cast<double>(upperBound(j))));
+        }
+
+        Nan::Set(operation, Nan::New("buckets").ToLocalChecked(), buckets);
+        Nan::Set(operations, Nan::New(OPERATION_NAMES[i]).ToLocalChecked(),
+            operation);
+    }
+
+    v8::Local<v8::Object> result = Nan::New<v8::Object>();
+    Nan::Set(result, Nan::New("enabled").ToLocalChecked(),
+        Nan::New<v8::Boolean>(enabled()));
+    Nan::Set(result, Nan::New("operations").ToLocalChecked(), operations);
+
+    // Usage of the secure arenas, recorded whether or not stats are enabled.
+    const SecureArena::Usage usage = SecureArena::usage();
+    v8::Local<v8::Object> arena = Nan::New<v8::Object>();
+    Nan::Set(arena, Nan::New("regions").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(usage.regions)));
+    Nan::Set(arena, Nan::New("mappedBytes").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(usage.mappedBytes)));
+    Nan::Set(arena, Nan::New("lockedBytes").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(usage.lockedBytes)));
+    Nan::Set(arena, Nan::New("heapBytes").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(usage.heapBytes)));
+    Nan::Set(arena, Nan::New("liveBlocks").ToLocalChecked(),
+        Nan::New<v8::Number>(static_cast<double>(usage.liveBlocks)));
+    Nan::Set(result, Nan::New("arena").ToLocalChecked(), arena);
+
+    // Reseeds of the per-thread ECIES random pools, also always counted.
+    v8::Local<v8::Object> threadRng = Nan::New<v8::Object>();
+    Nan::Set(threadRng, Nan::New("reseeds").ToLocalChecked(),
+        Nan::New<v8::Number>(
+            static_cast<double>(ThreadRandomPool::reseeds())));
+    Nan::Set(result, Nan::New("threadRng").ToLocalChecked(), threadRng);
+
+    info.GetReturnValue().Set(result);
+}
+
+
+// -----------
+// enableStats
+// -----------
+/**
+ * @brief Switches recording on or off. The records are kept.
+ *
+ * Invoked as:
+ * 'seifnode.enableStats(enabled)' where
+ * 'enabled' (optional) is true by default
+ *
+ * @param info node.js arguments wrapper
+ *
+ * @return void
+ */
+NAN_METHOD(Stats::enableStats) {
+
+    bool enable = info.Length() == 0 || info[0]->IsUndefined() ||
+        Nan::To<bool>(info[0]).FromJust();
+
+    _enabled.store(enable, std::memory_order_relaxed);
+}
+
+
+// ----
+// Init
+// ----
+/**
+ * @brief Initialization function for the functions exported by the
+ *        addon.
+ *
+ * @param exports node.js module exports
+ *
+ * @return void
+ */
+void Stats::Init(v8::Local<v8::Object> exports) {
+
+    Nan::HandleScope scope;
+
+    // Setting node.js module.exports.
+    Nan::SetMethod(exports, "stats", stats);
+    Nan::SetMethod(exports, "enableStats", enableStats);
+}
@@ -0,0 +1,284 @@
+/** @file stats.h
+ *  @brief Class header for the runtime switchable instrumentation of the
+ *		   native hot paths: per-thread call and byte counters and latency
+ *		   histograms exposed to javascript
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// ----------------------
+// node.js addon includes
+// ----------------------
+#include <node.h>
+#include <nan.h>
+
+
+// -----
+// Stats
+// -----
+
+/*
+ * @class Instrumentation of the native hot paths. Each thread counts the
+ *		  calls, bytes and latency of every operation in its own record, so
+ *		  recording never contends across threads; records are merged when
+ *		  read and kept after their thread exits. Latencies go into a
+ *		  log-linear histogram (8 buckets per power of two, at most 12.5%
+ *		  relative error) from which the percentiles are derived. Recording
+ *		  is compiled in but disabled by default, costing a single relaxed
+ *		  load until enabled.
+ *
+ *		  The functions exposed to node.js are:
+ *		  function stats(reset) -> returns the recorded operations
+ *		  function enableStats(enabled) -> switches recording on or off
+ */
+class Stats {
+
+	public:
+
+		// operations being recorded
+		enum class OPERATION {
+			ECC_ENCRYPT,
+			ECC_DECRYPT,
+			AES_ENCRYPT,
+			AES_DECRYPT,
+			RNG_GET_BYTES,
+			RNG_RESEED,
+			DISK_READ,
+			DISK_WRITE,
+			COUNT
+		};
+
+		// number of latency histogram buckets
+		static const size_t BUCKETS = 312;
+
+
+		// -----
+		// Timer
+		// -----
+
+		/*
+		 * @class Records the latency of the enclosing scope as one call of
+		 *		  the operation when recording is enabled, including scopes
+		 *		  left by an exception.
+		 */
+		class Timer {
+
+			private:
+
+				// ----
+				// data
+				// ----
+				// operation being timed
+				OPERATION _operation;
+				// bytes processed by the operation
+				size_t _bytes;
+				// whether recording was enabled when the scope was entered
+				bool _active;
+				// time the scope was entered
+				std::chrono::steady_clock::time_point _start;
+
+			public:
+
+				// -----------
+				// Constructor
+				// -----------
+				/**
+				 * Constructor
+				 * @brief Starts timing when recording is enabled.
+				 *
+				 * @param operation operation being timed
+				 * @param bytes bytes processed by the operation
+				 */
+				Timer(OPERATION operation, size_t bytes);
+
+
+				// ----------
+				// Destructor
+				// ----------
+				/**
+				 * Destructor
+				 * @brief Records the call with the elapsed time.
+				 */
+				~Timer();
+
+
+				// --------
+				// setBytes
+				// --------
+				/**
+				 * @brief Sets the bytes processed when only known once the
+				 *		  operation is done.
+				 *
+				 * @param bytes bytes processed by the operation
+				 *
+				 * @return void
+				 */
+				void setBytes(size_t bytes) {
+					_bytes = bytes;
+				}
+
+				Timer(const Timer&) = delete;
+				Timer& operator=(const Timer&) = delete;
+		};
+
+
+		// -------
+		// enabled
+		// -------
+		/**
+		 * @brief Whether recording is enabled.
+		 *
+		 * @return true if calls are being recorded
+		 */
+		static bool enabled() {
+			return _enabled.load(std::memory_order_relaxed);
+		}
+
+
+		// ------
+		// record
+		// ------
+		/**
+		 * @brief Records one call of the operation in the calling thread's
+		 *		  record.
+		 *
+		 * @param operation operation being recorded
+		 * @param bytes bytes processed by the call
+		 * @param nanoseconds latency of the call
+		 *
+		 * @return void
+		 */
+		static void record(OPERATION operation, size_t bytes,
+			uint64_t nanoseconds);
+
+
+		// ----
+		// Init
+		// ----
+		/**
+		 * @brief Initialization function for the functions exported by the
+		 * 		  addon.
+		 *
+		 * @param exports node.js module exports
+		 *
+		 * @return void
+		 */
+		static void Init(v8::Local<v8::Object> exports);
+
+	private:
+
+		// whether calls are being recorded
+		static std::atomic<bool> _enabled;
+
+
+		// ------
+		// bucket
+		// ------
+		/**
+		 * @brief Histogram bucket of the given latency. Latencies below 8ns
+		 *		  have a bucket each, larger ones 8 buckets per power of two,
+		 *		  the last bucket also taking anything longer than about 34
+		 *		  minutes.
+		 *
+		 * @param nanoseconds latency
+		 *
+		 * @return bucket index below BUCKETS
+		 */
+		static size_t bucket(uint64_t nanoseconds);
+
+
+		// ----------
+		// upperBound
+		// ----------
+		/**
+		 * @brief Largest latency falling into the given bucket.
+		 *
+		 * @param index bucket index below BUCKETS
+		 *
+		 * @return latency in nanoseconds
+		 */
+		static uint64_t upperBound(size_t index);
+
+
+		// -----
+		// stats
+		// -----
+		/**
+		 * @brief Merges the records of all threads and returns them along
+		 *		  with the percentiles derived from the histograms.
+		 *
+		 * Invoked as:
+		 * 'let stats = seifnode.stats(reset)' where
+		 * 'reset' (optional) clears the records after reading them
+		 * 'stats' is of the form:
+		 * {enabled: [boolean], operations: {[name]: {calls, bytes, totalNs,
+		 *  meanNs, maxNs, p50Ns, p90Ns, p99Ns, p999Ns,
+		 *  buckets: [[upperNs, count], ...]}},
+		 *  arena: {regions, mappedBytes, lockedBytes, heapBytes,
+		 *  liveBlocks}, threadRng: {reseeds}}
+		 * with the names ecc.encrypt, ecc.decrypt, aes.encrypt, aes.decrypt,
+		 * rng.getBytes, rng.reseed, disk.read and disk.write; 'arena' is the
+		 * usage of the secure memory holding key material and 'threadRng'
+		 * counts the reseeds of the per-thread random pools since the
+		 * module was loaded
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(stats);
+
+
+		// -----------
+		// enableStats
+		// -----------
+		/**
+		 * @brief Switches recording on or off. The records are kept.
+		 *
+		 * Invoked as:
+		 * 'seifnode.enableStats(enabled)' where
+		 * 'enabled' (optional) is true by default
+		 *
+		 * @param info node.js arguments wrapper
+		 *
+		 * @return void
+		 */
+		static NAN_METHOD(enableStats);
+
+};
+
+#endif
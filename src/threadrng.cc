@@ -0,0 +1,106 @@
+/** @file threadrng.cc
+ *  @brief Definition of the class functions provided in threadrng.h
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *  The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ */
+
+// ----------------
+// library includes
+// ----------------
+#include "threadrng.h"
+
+
+// number of output bytes after which the pool is reseeded (1 MiB)
+const size_t ThreadRandomPool::RESEED_INTERVAL_BYTES = 1 << 20;
+// number of reseeds of all instances
+std::atomic<uint64_t> ThreadRandomPool::_reseeds(0);
+
+
+// -----------
+// Constructor
+// -----------
+/**
+ * Constructor
+ * @brief Seeds the underlying pool from the OS.
+ */
+ThreadRandomPool::ThreadRandomPool(): _generated(0) {
+
+}
+
+
+// --------
+// instance
+// --------
+/**
+ * @brief Returns the generator belonging to the calling thread,
+ *        creating it on first use.
+ *
+ * @return generator of the calling thread
+ */
+ThreadRandomPool& ThreadRandomPool::instance() {
+    static thread_local ThreadRandomPool pool;
+    return pool;
+}
+
+
+// -------------
+// GenerateBlock
+// -------------
+/**
+ * @brief Fills the output with random bytes, reseeding the pool from
+ *        the OS first if the reseed interval has elapsed.
+ *
+ * @param output container for resulting random bytes
+ * @param size number of random bytes required
+ *
+ * @return void
+ */
+void ThreadRandomPool::GenerateBlock(uint8_t* output, size_t size) {
+
+    if (_generated >= RESEED_INTERVAL_BYTES) {
+        // Mix fresh OS entropy into the pool (non blocking).
+        _pool.Reseed(false);
+        _generated = 0;
+        _reseeds.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    _pool.GenerateBlock(output, size);
+    _generated += size;
+}
+
+
+// -------
+// reseeds
+// -------
+/**
+ * @brief Returns the number of times any instance was reseeded since the
+ *        module was loaded.
+ *
+ * @return number of reseeds
+ */
+uint64_t ThreadRandomPool::reseeds() {
+    return _reseeds.load(std::memory_order_relaxed);
+}
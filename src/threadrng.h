@@ -0,0 +1,129 @@
+/** @file threadrng.h
+ *  @brief Class header for the per-thread Crypto++ random number generator
+ *		   shared by the native objects for ephemeral randomness (e.g. ECIES
+ *		   ephemeral keys), avoiding an OS entropy read on every call.
+ *
+ *  @author Aashish Sheshadri
+ *  @author Rohit Harchandani
+ *
+ *	The MIT License (MIT)
+ *
+ *  Copyright (c) 2015, 2016, 2017 PayPal
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to
+ *	deal in the Software without restriction, including without limitation the
+ *	rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in
+ *	all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *	DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef THREADRNG_H
+#define THREADRNG_H
+
+// -----------------
+// standard includes
+// -----------------
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// -----------------
+// cryptopp includes
+// -----------------
+#include "cryptlib.h"
+#include "osrng.h"
+
+
+// ----------------
+// ThreadRandomPool
+// ----------------
+
+/*
+ * @class Crypto++ random number generator with one instance per thread. Each
+ *		  instance is an AutoSeededRandomPool seeded from the OS once, which
+ *		  reseeds itself after RESEED_INTERVAL_BYTES bytes of output. Since
+ *		  instances are never shared between threads no locking is needed, so
+ *		  it is safe to use from the main thread and async workers alike.
+ */
+class ThreadRandomPool : public CryptoPP::RandomNumberGenerator {
+
+	private:
+
+		// ----
+		// data
+		// ----
+		// underlying auto seeded pool
+		CryptoPP::AutoSeededRandomPool _pool;
+		// number of bytes generated since the last reseed
+		size_t _generated;
+
+		// number of output bytes after which the pool is reseeded
+		static const size_t RESEED_INTERVAL_BYTES;
+		// number of reseeds of all instances
+		static std::atomic<uint64_t> _reseeds;
+
+
+		// -----------
+		// Constructor
+		// -----------
+		/**
+		 * Constructor
+		 * @brief Seeds the underlying pool from the OS.
+		 */
+		ThreadRandomPool();
+
+	public:
+
+		// --------
+		// instance
+		// --------
+		/**
+		 * @brief Returns the generator belonging to the calling thread,
+		 *		  creating it on first use.
+		 *
+		 * @return generator of the calling thread
+		 */
+		static ThreadRandomPool& instance();
+
+
+		// -------------
+		// GenerateBlock
+		// -------------
+		/**
+		 * @brief Fills the output with random bytes, reseeding the pool from
+		 *		  the OS first if the reseed interval has elapsed.
+		 *
+		 * @param output container for resulting random bytes
+		 * @param size number of random bytes required
+		 *
+		 * @return void
+		 */
+		void GenerateBlock(uint8_t* output, size_t size);
+
+
+		// -------
+		// reseeds
+		// -------
+		/**
+		 * @brief Returns the number of times any instance was reseeded
+		 *		  since the module was loaded.
+		 *
+		 * @return number of reseeds
+		 */
+		static uint64_t reseeds();
+
+};
+
+#endif
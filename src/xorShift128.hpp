@@ -6,6 +6,9 @@ worldwide. This software is distributed without any warranty.
 
 See <http://creativecommons.org/publicdomain/zero/1.0/>. */
 
+#ifndef XORSHIFT128_HPP
+#define XORSHIFT128_HPP
+
 #include <stdint.h>
 #include <vector>
 
@@ -33,9 +36,92 @@ static inline uint64_t rotl(const uint64_t x, int k) {
 }
 
 class XORShift128 {
-    std::vector<uint64_t> _state;
+    uint64_t _state[2];
+
+    // Characteristic polynomial of the generator, without its x^128 term.
+    // Coefficient i is bit (i % 64) of word (i / 64).
+    static const uint64_t POLYNOMIAL_LOW = 0x5fd66762f0e1c001ULL;
+    static const uint64_t POLYNOMIAL_HIGH = 0x00653ced7f29f88aULL;
+
+    // Below this number of outputs 'discard' steps the generator instead of
+    // computing a jump polynomial.
+    static const unsigned long long JUMP_THRESHOLD = 1ULL << 14;
+
+    // Multiplies the polynomial by x modulo the characteristic polynomial.
+    static void multiplyByX(uint64_t p[2]) {
+    	const uint64_t carry = p[1] >> 63;
+    	p[1] = (p[1] << 1) | (p[0] >> 63);
+    	p[0] <<= 1;
+    	if (carry != 0) {
+    		p[0] ^= POLYNOMIAL_LOW;
+    		p[1] ^= POLYNOMIAL_HIGH;
+    	}
+    }
+
+    // Sets 'r' to a * b modulo the characteristic polynomial; 'r' may alias
+    // either input.
+    static void multiply(uint64_t r[2], const uint64_t a[2],
+    	const uint64_t b[2]) {
+    	uint64_t result[2] = {0, 0};
+    	for (int i = 127; i >= 0; --i) {
+    		const uint64_t carry = 0 - (result[1] >> 63);
+    		const uint64_t bit = 0 - ((b[i / 64] >> (i % 64)) & 1);
+    		result[1] = ((result[1] << 1) | (result[0] >> 63)) ^
+    			(carry & POLYNOMIAL_HIGH) ^ (bit & a[1]);
+    		result[0] = (result[0] << 1) ^ (carry & POLYNOMIAL_LOW) ^
+    			(bit & a[0]);
+    	}
+    	r[0] = result[0];
+    	r[1] = result[1];
+    }
+
+    // Sets 'r' to x^n modulo the characteristic polynomial.
+    static void powerOfX(uint64_t r[2], unsigned long long n) {
+    	r[0] = 1;
+    	r[1] = 0;
+    	int i = 63;
+    	while (i >= 0 && ((n >> i) & 1) == 0) {
+    		--i;
+    	}
+    	for (; i >= 0; --i) {
+    		multiply(r, r, r);
+    		if ((n >> i) & 1) {
+    			multiplyByX(r);
+    		}
+    	}
+    }
+
+    // Moves the generator forward by the number of outputs whose jump
+    // polynomial is given, i.e. replaces the state s with J(M) s where M is
+    // the transition matrix. Costs 128 steps of the generator.
+    void apply(const uint64_t poly[2]) {
+    	uint64_t s0 = 0;
+    	uint64_t s1 = 0;
+    	for (int i = 0; i < 2; i++) {
+    		for (int b = 0; b < 64; b++) {
+    			if (poly[i] & UINT64_C(1) << b) {
+    				s0 ^= _state[0];
+    				s1 ^= _state[1];
+    			}
+    			operator()();
+    		}
+    	}
+    	_state[0] = s0;
+    	_state[1] = s1;
+    }
+
     public:
-        XORShift128(std::vector<uint64_t> seed):_state(seed) {
+        XORShift128(std::vector<uint64_t> seed) {
+            _state[0] = seed[0];
+            _state[1] = seed[1];
+            for (int i = 0; i < 100; i++) {
+                operator()();
+            }
+        }
+
+        XORShift128(uint64_t seed0, uint64_t seed1) {
+            _state[0] = seed0;
+            _state[1] = seed1;
             for (int i = 0; i < 100; i++) {
                 operator()();
             }
@@ -53,4 +139,70 @@ class XORShift128 {
         	return result;
         }
 
+        /* This is the jump function for the generator. It is equivalent
+           to 2^64 calls to next(); it can be used to generate 2^64
+           non-overlapping subsequences for parallel computations. */
+        void jump() {
+        	static const uint64_t JUMP[] = { 0xbeac0467eba5facbULL,
+        		0xd86b048b86aa9922ULL };
+        	apply(JUMP);
+        }
+
+        /* This is the long-jump function for the generator. It is
+           equivalent to 2^96 calls to next(); it can be used to generate
+           2^32 starting points, from each of which jump() will generate
+           2^32 non-overlapping subsequences for parallel distributed
+           computations. */
+        void long_jump() {
+        	static const uint64_t LONG_JUMP[] = { 0x18f7c399ccebda8dULL,
+        		0xf2deac28bef3bb07ULL };
+        	apply(LONG_JUMP);
+        }
+
+        // Advances the generator by 'n' outputs, jumping ahead in
+        // logarithmic time when 'n' is large.
+        void discard(unsigned long long n) {
+        	if (n >= JUMP_THRESHOLD) {
+        		uint64_t poly[2];
+        		powerOfX(poly, n);
+        		apply(poly);
+        		return;
+        	}
+        	for (; n > 0; --n) {
+        		operator()();
+        	}
+        }
+
+        // Advances the generator by 'blocks' blocks of 'blockWords' outputs
+        // each. On a generator fresh from its seed this positions it at the
+        // start of block 'blocks' of the stream, in time logarithmic in the
+        // offset and without overflow for any offset.
+        void seek(unsigned long long blocks, unsigned long long blockWords) {
+        	if (blocks == 0 || blockWords == 0) {
+        		return;
+        	}
+
+        	uint64_t poly[2];
+        	if (blocks <= ~0ULL / blockWords) {
+        		powerOfX(poly, blocks * blockWords);
+        		apply(poly);
+        		return;
+        	}
+
+        	uint64_t block[2];
+        	powerOfX(block, blockWords);
+
+        	poly[0] = 1;
+        	poly[1] = 0;
+        	for (int i = 63; i >= 0; --i) {
+        		multiply(poly, poly, poly);
+        		if ((blocks >> i) & 1) {
+        			multiply(poly, poly, block);
+        		}
+        	}
+        	apply(poly);
+        }
+
 };
+
+#endif
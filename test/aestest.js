@@ -60,6 +60,169 @@ describe("seifnode AESXOR object", function() {
 		});
 	});
 
+	// Testing 'encryptInto' and 'decryptInto' functionality.
+	describe("#encryptInto() / #decryptInto()", function() {
+
+		/* Test should write the same cipher as 'encrypt' into the given buffer
+		 * at the given offset and decrypt it back in place.
+		 */
+		it("should encrypt into and decrypt from a caller supplied buffer",
+			function() {
+
+			let expected = addon.AESXOR256(seedBuffer).encrypt(key, msg);
+
+			let enc = addon.AESXOR256(seedBuffer);
+			let out = Buffer.alloc(4 + msg.length + 16);
+
+			let written = enc.encryptInto(key, msg, out, 4);
+			assert.equal(msg.length + 16, written);
+			assert.equal(true, out.slice(4).equals(expected));
+
+			// Decrypting in place over the cipher region.
+			let dec = addon.AESXOR256(seedBuffer);
+			let region = out.slice(4);
+			written = dec.decryptInto(key, region, region);
+			assert.equal(msg.length, written);
+			assert.equal(true, region.slice(0, written).equals(msg));
+		});
+
+		/* Test should encrypt in place when the message is a view of the
+		 * output buffer.
+		 */
+		it("should encrypt in place", function() {
+
+			let out = Buffer.alloc(msg.length + 16);
+			msg.copy(out);
+
+			addon.AESXOR256(seedBuffer).encryptInto(key,
+				out.slice(0, msg.length), out);
+
+			let decrypted = addon.AESXOR256(seedBuffer).decrypt(key, out);
+			assert.equal(true, decrypted.equals(msg));
+		});
+
+		// Test should throw an exception when the output buffer is too small.
+		it("should give an error when the output buffer is too small",
+			function() {
+
+			let test = addon.AESXOR256(seedBuffer);
+
+			assert.throws(function() {
+				test.encryptInto(key, msg, Buffer.alloc(msg.length));
+			}, /Output buffer too small/);
+		});
+	});
+
+	// Testing 'setKey' functionality.
+	describe("#setKey()", function() {
+
+		/* Test should produce the same cipher with the bound key, whether it is
+		 * passed as null or explicitly, as without a bound key.
+		 */
+		it("should encrypt and decrypt with the bound key", function() {
+
+			let plain = addon.AESXOR256(seedBuffer);
+			let expected = [plain.encrypt(key, msg), plain.encrypt(key, msg)];
+
+			let test = addon.AESXOR256(seedBuffer);
+			test.setKey(key);
+			assert.equal(true, test.encrypt(null, msg).equals(expected[0]));
+			assert.equal(true, test.encrypt(key, msg).equals(expected[1]));
+
+			let dec = addon.AESXOR256(seedBuffer);
+			dec.setKey(key);
+			assert.equal(true, dec.decrypt(null, expected[0]).equals(msg));
+			assert.equal(true, dec.decrypt(key, expected[1]).equals(msg));
+		});
+
+		// Test should throw an exception when no key is bound.
+		it("should give an error when using null without a bound key",
+			function() {
+
+			let test = addon.AESXOR256(seedBuffer);
+			test.setKey(key);
+			test.setKey(null);
+
+			assert.throws(function() {
+				test.encrypt(null, msg);
+			}, /No key bound/);
+		});
+	});
+
+	// Testing 'createCipher' and 'createDecipher' functionality.
+	describe("#createCipher() / #createDecipher()", function() {
+
+		// message spanning several uneven chunks
+		let large = Buffer.alloc(1000);
+		for (let i = 0; i < large.length; ++i) {
+			large[i] = i & 0xff;
+		}
+
+		/* Test should produce the same cipher as 'encrypt' when encrypting the
+		 * message in uneven chunks, and decrypt it back chunk by chunk.
+		 */
+		it("should encrypt and decrypt in chunks like the one-shot functions",
+			function() {
+
+			let expected = addon.AESXOR256(seedBuffer).encrypt(key, large);
+
+			let cipher = addon.AESXOR256(seedBuffer).createCipher(key);
+			let parts = [];
+			for (let i = 0; i < large.length; i += 13) {
+				parts.push(cipher.update(large.slice(i, i + 13)));
+			}
+			parts.push(cipher.final());
+			assert.equal(true, Buffer.concat(parts).equals(expected));
+
+			let decipher = addon.AESXOR256(seedBuffer).createDecipher(key);
+			parts = [];
+			for (let i = 0; i < expected.length; i += 7) {
+				parts.push(decipher.update(expected.slice(i, i + 7)));
+			}
+			parts.push(decipher.final());
+			assert.equal(true, Buffer.concat(parts).equals(large));
+		});
+
+		/* Test should process chunks off the event loop and reject a modified
+		 * cipher in 'final'.
+		 */
+		it("should update asynchronously and detect a modified cipher",
+			function(done) {
+
+			let expected = addon.AESXOR256(seedBuffer).encrypt(key, large);
+			expected[3] ^= 1;
+
+			let decipher = addon.AESXOR256(seedBuffer).createDecipher(key);
+			decipher.update(expected, function(status, output) {
+				assert.equal(0, status.code);
+				assert.equal(large.length, output.length);
+				assert.throws(function() {
+					decipher.final();
+				});
+				done();
+			});
+		});
+
+		// Test should encrypt through the Transform stream wrapper.
+		it("should encrypt through a Transform stream", function(done) {
+
+			let expected = addon.AESXOR256(seedBuffer).encrypt(key, large);
+
+			let cipher = addon.AESXOR256(seedBuffer).createCipherStream(key);
+			let parts = [];
+			cipher.on("data", function(data) {
+				parts.push(data);
+			});
+			cipher.on("end", function() {
+				assert.equal(true, Buffer.concat(parts).equals(expected));
+				done();
+			});
+
+			cipher.write(large.slice(0, 100));
+			cipher.end(large.slice(100));
+		});
+	});
+
 	// Testing 'decrypt' functionality.
 	describe("#decrypt()", function() {
 
@@ -125,4 +288,243 @@ describe("seifnode AESXOR object", function() {
 			"Error thrown");
 		});
 	});
+
+	// Testing the segmented cipher format.
+	describe("#encryptSegments() / #decryptSegments() / #decryptRange()",
+		function() {
+
+		let segmentKey = Buffer.alloc(32, 0x5a);
+		let large = Buffer.alloc(5000);
+		for (let i = 0; i < large.length; ++i) {
+			large[i] = (i * 7 + 3) & 0xff;
+		}
+
+		/* Test should split the message into 1KB segments sealed on several
+		 * threads, and decrypt all of them or any range on its own.
+		 */
+		it("should encrypt in segments and decrypt the whole or a range",
+			function() {
+
+			let test = addon.AESXOR256(seedBuffer);
+
+			let segmented = test.encryptSegments(segmentKey, large,
+				{segmentSize: 1024, threads: 3});
+
+			// header, message and one tag per segment
+			assert.equal(32 + large.length + 5 * 16, segmented.length);
+
+			assert.equal(true,
+				test.decryptSegments(segmentKey, segmented, 2).equals(large));
+			assert.equal(true,
+				test.decryptSegments(segmentKey, segmented, 1e6).equals(large));
+			assert.equal(true, test.decryptRange(segmentKey, segmented,
+				1000, 3000).equals(large.slice(1000, 3000)));
+			assert.equal(0,
+				test.decryptRange(segmentKey, segmented, 10, 10).length);
+
+			// Another object with the same seed decrypts in any order.
+			let other = addon.AESXOR256(seedBuffer);
+			assert.equal(true, other.decryptRange(segmentKey, segmented,
+				4500).equals(large.slice(4500)));
+		});
+
+		/* Test should reject a modified segment and invalid arguments.
+		 */
+		it("should give an error for a modified cipher or a bad range",
+			function() {
+
+			let test = addon.AESXOR256(seedBuffer);
+
+			let segmented = test.encryptSegments(segmentKey, large,
+				{segmentSize: 1024});
+			segmented[32 + 2 * (1024 + 16)] ^= 1;
+
+			assert.throws(function() {
+				test.decryptSegments(segmentKey, segmented);
+			});
+			assert.throws(function() {
+				test.decryptRange(segmentKey, segmented, 2048, 2049);
+			});
+
+			// untouched segments still decrypt
+			assert.equal(true, test.decryptRange(segmentKey, segmented,
+				0, 2048).equals(large.slice(0, 2048)));
+
+			assert.throws(function() {
+				test.decryptRange(segmentKey, segmented, 0, large.length + 1);
+			});
+			assert.throws(function() {
+				test.encryptSegments(segmentKey, large, {segmentSize: 1000});
+			});
+			assert.throws(function() {
+				test.decryptSegments(segmentKey, Buffer.alloc(64));
+			});
+		});
+	});
+
+	// Testing the positioning of the XORShift128 keystream.
+	describe("XORShift128 keystream", function() {
+
+		// 'discard' jumps instead of stepping from this many uint64 values on
+		let jumpThreshold = 1 << 14;
+
+		function pattern(length) {
+			let data = Buffer.alloc(length);
+			for (let i = 0; i < length; ++i) {
+				data[i] = (i * 7 + 3) & 0xff;
+			}
+			return data;
+		}
+
+		/* Test should reproduce the ciphers of the generator as it was before
+		 * it learnt to jump, covering whole values and a partial tail.
+		 */
+		it("should produce the same ciphers as the original generator",
+			function() {
+
+			let test = addon.AESXOR256(seedBuffer);
+			assert.equal("99a95a53528ab5edd2eaa7baa0ca6140" +
+				"382dda3d7d9e95b2207758d0a7ff471f",
+				test.encrypt(key, msg).toString("hex"));
+
+			test = addon.AESXOR256(seedBuffer);
+			assert.equal("655cb4b4b2536726e9a8eeeaf794042c" +
+				"b809e041748f214ce668af20598fb29e" +
+				"a655330d4d1fa5e5a8315072ffb4b2f9" +
+				"37dcac4297f3956cb0464fd3dc",
+				test.encrypt(key, pattern(45)).toString("hex"));
+		});
+
+		/* Test should skip the keystream of an asynchronous chunk the same way
+		 * encrypting it step by step does, below and above the number of
+		 * values from which 'discard' jumps.
+		 */
+		[100, 8 * jumpThreshold + 1000].forEach(function(length) {
+			it("should discard " + length + " bytes like stepping over them",
+				function(done) {
+
+				let message = pattern(length + 1000);
+				let expected = addon.AESXOR256(seedBuffer)
+					.encrypt(key, message);
+
+				let cipher = addon.AESXOR256(seedBuffer).createCipher(key);
+				let head = message.slice(0, length);
+				cipher.update(head, function(status, output) {
+					assert.equal(0, status.code);
+
+					// The rest is encrypted by the generator moved past 'head'.
+					let tail = cipher.update(message.slice(length));
+					let parts = [output, tail, cipher.final()];
+					assert.equal(true, Buffer.concat(parts).equals(expected));
+					done();
+				});
+			});
+		});
+
+		/* Test should XOR whole values with the kernel selected for this CPU
+		 * exactly like the byte by byte path of a cipher fed one byte at a
+		 * time, at lengths which are not multiples of the vector width, at
+		 * unaligned output offsets and from any position of the keystream.
+		 */
+		it("should XOR with the " + addon.capabilities().kernels.keystream +
+			" kernel like byte by byte", function() {
+
+			let lengths = [1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65,
+				511, 512, 513, 4099];
+			let offsets = [0, 1, 3, 8, 13, 31];
+
+			// Both objects draw the same keystream, message after message.
+			let vector = addon.AESXOR256(seedBuffer);
+			let scalar = addon.AESXOR256(seedBuffer);
+
+			lengths.forEach(function(length) {
+				offsets.forEach(function(offset) {
+					let message = pattern(length);
+
+					let out = Buffer.alloc(offset + length + 16, 0xee);
+					vector.encryptInto(key, message, out, offset);
+
+					let cipher = scalar.createCipher(key);
+					let parts = [];
+					for (let i = 0; i < length; ++i) {
+						parts.push(cipher.update(message.slice(i, i + 1)));
+					}
+					parts.push(cipher.final());
+
+					assert.equal(true,
+						out.slice(offset).equals(Buffer.concat(parts)),
+						"length " + length + " at offset " + offset);
+					assert.equal(0xee, offset > 0 ? out[offset - 1] : 0xee);
+				});
+			});
+		});
+
+		/* Test should seek straight to any segment of a segmented cipher and
+		 * find the keystream a single thread reaches by stepping through the
+		 * segments before it.
+		 */
+		it("should seek segments like stepping through them", function() {
+
+			let segmentKey = Buffer.alloc(32, 0x3c);
+			let segmentSize = 4096;
+			// the last segments start beyond the jump threshold
+			let message = pattern(40 * segmentSize + 100);
+
+			let test = addon.AESXOR256(seedBuffer);
+			let stepped = test.encryptSegments(segmentKey, message,
+				{segmentSize: segmentSize, threads: 1});
+
+			[0, 1, 31, 32, 39, 40].forEach(function(segment) {
+				let start = segment * segmentSize;
+				assert.equal(true, test.decryptRange(segmentKey, stepped,
+					start).equals(message.slice(start)));
+			});
+
+			// Slices sealed on several threads seek as well.
+			let sought = test.encryptSegments(segmentKey, message,
+				{segmentSize: segmentSize, threads: 4});
+			assert.equal(true, test.decryptSegments(segmentKey, sought, 1)
+				.equals(message));
+		});
+	});
+
+	// Testing the instrumentation of 'encrypt' and 'decrypt'.
+	describe("seifnode.stats()", function() {
+
+		/* Test should record the calls and bytes of encryption and
+		 * decryption once enabled, and clear them when reset.
+		 */
+		it("should record encrypt and decrypt calls once enabled",
+			function() {
+
+			let test = addon.AESXOR256(seedBuffer);
+
+			addon.enableStats(true);
+			addon.stats(true);
+
+			let encrypted = test.encrypt(key, msg);
+			test.decrypt(key, encrypted);
+
+			let stats = addon.stats(true);
+			addon.enableStats(false);
+
+			assert.equal(true, stats.enabled);
+
+			let encrypt = stats.operations["aes.encrypt"];
+			assert.equal(1, encrypt.calls);
+			assert.equal(msg.length, encrypt.bytes);
+			assert.equal(true, encrypt.p50Ns <= encrypt.maxNs);
+			assert.equal(1, encrypt.buckets.length);
+			assert.equal(1, stats.operations["aes.decrypt"].calls);
+
+			// reset by the previous call
+			assert.equal(0, addon.stats().operations["aes.encrypt"].calls);
+
+			// usage of the secure arena holding key material
+			assert.equal("number", typeof stats.arena.liveBlocks);
+			assert.equal(true, stats.arena.lockedBytes <=
+				stats.arena.mappedBytes);
+			assert.equal("number", typeof stats.arena.heapBytes);
+		});
+	});
 });
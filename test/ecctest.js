@@ -104,6 +104,108 @@ describe("seifnode SEIFECC object", function() {
 
 		});
 
+		/* Test should generate keys on the curve given at construction, restore
+		 * the curve when loading them and use them to encrypt and decrypt.
+		 */
+		it("should generate and load keys on the selected curve",
+			function(done) {
+
+			var folder = eccFolder + "/ecies.p256.";
+			var test = new addon.SEIFECC(hash, folder, {curve: "secp256r1"});
+
+			this.timeout(150000);
+
+			var generatedKeys = test.generateKeys();
+			assert.equal("secp256r1", generatedKeys.curve);
+
+			test.loadKeys(function(status, keys) {
+				assert.equal(0, status.code);
+				assert.equal("secp256r1", keys.curve);
+				assert.equal(generatedKeys.enc, keys.enc);
+				assert.equal(generatedKeys.dec, keys.dec);
+
+				// Startup phases are timed.
+				["privateKey", "publicKey", "encode", "total"].forEach(
+					function(phase) {
+						assert.equal("number", typeof keys.timings[phase]);
+					});
+				assert.equal(true,
+					keys.timings.total >= keys.timings.privateKey);
+
+				var c = test.encrypt(keys.enc, msg);
+				assert.equal(true, test.decrypt(keys.dec, c).equals(msg));
+
+				var binary = new addon.SEIFECC(hash, folder,
+					{keyEncoding: "binary"});
+				binary.loadKeys(function(status, binaryKeys) {
+					assert.equal(0, status.code);
+					assert.equal(true, Buffer.isBuffer(binaryKeys.dec));
+					assert.equal(true, binary.decrypt(binaryKeys.dec,
+						binary.encrypt(binaryKeys.enc, msg)).equals(msg));
+					done();
+				});
+			});
+
+		});
+
+		// Test should throw an exception when given an unsupported curve.
+		it("should throw an error for an unsupported curve", function() {
+
+			assert.throws(function() {
+				new addon.SEIFECC(hash, eccFolder, {curve: "secp112r1"});
+			});
+
+		});
+
+	});
+
+	// Testing 'generateKeysAsync' functionality.
+	describe("#generateKeysAsync()", function() {
+
+		/* Test should generate keys off the event loop and report the entropy
+		 * strength and number of retries along with the keys.
+		 */
+		it("should generate keys asynchronously", function(done) {
+
+			var folder = eccFolder + "/ecies.async.";
+			var test = new addon.SEIFECC(hash, folder);
+
+			this.timeout(150000);
+
+			test.generateKeysAsync("secp256r1", function(status, keys) {
+				assert.equal(0, status.code);
+				assert.equal("secp256r1", keys.curve);
+				assert.notEqual(-1, ["WEAK", "MEDIUM", "STRONG"]
+					.indexOf(keys.strength));
+				assert.equal("number", typeof keys.retries);
+
+				var c = test.encrypt(keys.enc, msg);
+				assert.equal(true, test.decrypt(keys.dec, c).equals(msg));
+				assert.notEqual(-1, ["WEAK", "MEDIUM", "STRONG"]
+					.indexOf(test.entropyStrength()));
+				done();
+			});
+
+			// The entropy sources must not be probed while they are mined.
+			assert.throws(function() {
+				test.entropyStrength();
+			}, /in progress/);
+		});
+
+		// Test should report an unsupported curve through the status.
+		it("should return an error status for an unsupported curve",
+			function() {
+
+			var test = new addon.SEIFECC(hash, eccFolder + "/ecies.async.");
+
+			return test.generateKeysAsync("secp112r1").then(function() {
+				assert.fail("Expected an error");
+			}, function(err) {
+				assert.equal(-6, err.code);
+			});
+
+		});
+
 	});
 
 	// Testing 'loadKeys' functionality after keys have been generated.
@@ -126,6 +228,143 @@ describe("seifnode SEIFECC object", function() {
 
 	});
 
+	// Testing the keystore holding named key pairs in a single file.
+	describe("#storeKeys() and #loadStoredKeys()", function() {
+
+		/* Test should save generated and given keys under their names and
+		 * return them from the keystore, also through another object.
+		 */
+		it("should store and load named keys", function() {
+
+			var test = new addon.SEIFECC(hash, eccFolder, {curve: "secp256r1"});
+
+			this.timeout(150000);
+
+			assert.equal(undefined, test.loadStoredKeys("tenant1"));
+
+			var tenant1 = test.generateStoredKeys("tenant1");
+			assert.equal("secp256r1", tenant1.curve);
+
+			var tenant2 = test.generateStoredKeys("tenant2", "secp384r1");
+			test.storeKeys("tenant3", tenant1);
+
+			var other = new addon.SEIFECC(hash, eccFolder);
+			["tenant1", "tenant2", "tenant3"].forEach(function(name, i) {
+				var keys = other.loadStoredKeys(name);
+				var expected = i === 1 ? tenant2 : tenant1;
+
+				assert.equal(expected.enc, keys.enc);
+				assert.equal(expected.dec, keys.dec);
+				assert.equal(expected.curve, keys.curve);
+			});
+
+			// Replacing keys is seen by the other object right away.
+			test.storeKeys("tenant1", tenant2);
+			assert.equal(tenant2.enc, other.loadStoredKeys("tenant1").enc);
+
+			var c = other.encrypt(tenant2.enc, msg);
+			assert.equal(true, other.decrypt(
+				other.loadStoredKeys("tenant2").dec, c).equals(msg));
+		});
+
+		/* Test should keep the keys stored by several processes updating
+		 * the keystore at the same time.
+		 */
+		it("should keep keys stored concurrently by other processes",
+			function(done) {
+
+			var childProcess = require("child_process");
+			var keys = new addon.SEIFECC(hash, eccFolder)
+				.loadStoredKeys("tenant2");
+			var processes = 4;
+			var names = 10;
+
+			this.timeout(60000);
+
+			var source =
+				"const addon = require(" +
+				JSON.stringify(require.resolve("seifnode")) + ");" +
+				"const args = JSON.parse(process.argv[1]);" +
+				"const ecc = new addon.SEIFECC(Buffer.from(args.hash, 'hex')," +
+				" args.folder);" +
+				"for (let i = 0; i < args.names; ++i) {" +
+				"  ecc.storeKeys('child' + args.id + '.' + i, args.keys);" +
+				"}";
+
+			var pending = processes;
+			for (var id = 0; id < processes; ++id) {
+				var args = JSON.stringify({hash: hash.toString("hex"),
+					folder: eccFolder, id: id, names: names, keys: keys});
+				var child = childProcess.spawn(process.execPath,
+					["-e", source, args], {stdio: "inherit"});
+
+				child.on("error", done);
+				child.on("exit", function(code) {
+					assert.equal(0, code);
+					if (--pending > 0) {
+						return;
+					}
+
+					var test = new addon.SEIFECC(hash, eccFolder);
+					for (var i = 0; i < processes; ++i) {
+						for (var j = 0; j < names; ++j) {
+							var stored = test.loadStoredKeys(
+								"child" + i + "." + j);
+							assert.equal(keys.enc, stored.enc);
+						}
+					}
+					assert.equal(keys.enc, test.loadStoredKeys("tenant2").enc);
+					done();
+				});
+			}
+		});
+
+		/* Test should return binary keys with a compressed public point
+		 * that work with encrypt/decrypt alongside the hex encoded keys.
+		 */
+		it("should return and accept binary keys", function() {
+
+			var test = new addon.SEIFECC(hash, eccFolder,
+				{curve: "secp256r1", keyEncoding: "binary"});
+
+			var keys = test.generateStoredKeys("binary1");
+			assert.equal(true, Buffer.isBuffer(keys.enc));
+			assert.equal(true, Buffer.isBuffer(keys.dec));
+
+			var hexKeys = new addon.SEIFECC(hash, eccFolder)
+				.loadStoredKeys("binary1");
+			assert.equal(true, keys.enc.length < hexKeys.enc.length / 2);
+
+			var c = test.encrypt(keys.enc, msg);
+			assert.equal(true, test.decrypt(keys.dec, c).equals(msg));
+			assert.equal(true, test.decrypt(hexKeys.dec, c).equals(msg));
+
+			c = test.encrypt(hexKeys.enc, msg);
+			assert.equal(true, test.decrypt(keys.dec, c).equals(msg));
+
+			assert.throws(function() {
+				new addon.SEIFECC(hash, eccFolder, {keyEncoding: "base64"});
+			});
+		});
+
+		// Test should throw when the keystore is opened with the wrong key.
+		it("should throw an error when loading with wrong key", function() {
+
+			var testhash = new Buffer([0xB2,0x8F,0xE4,0x3F,0x0D]);
+			var test = new addon.SEIFECC(testhash, eccFolder);
+
+			assert.throws(function() {
+				test.loadStoredKeys("tenant1");
+			});
+			var keys = new addon.SEIFECC(hash, eccFolder)
+				.loadStoredKeys("tenant2");
+			assert.throws(function() {
+				test.storeKeys("tenant4", keys);
+			});
+		});
+
+	});
+
 	// Testing 'encrypt' functionality.
 	describe("#encrypt()", function() {
 
@@ -194,6 +433,80 @@ describe("seifnode SEIFECC object", function() {
 
 		});
 
+		/* Test should decrypt the cipher repeatedly using the cached parsed
+		 * key as well as with the key cache disabled.
+		 */
+		it("should decrypt cipher repeatedly with and without the key cache",
+			function(done) {
+
+			var cached = new addon.SEIFECC(hash, eccFolder);
+			var uncached = new addon.SEIFECC(hash, eccFolder,
+				{keyCacheSize: 0});
+
+			cached.loadKeys(function(status, keys) {
+				for (var i = 0; i < 3; ++i) {
+					var c = cached.encrypt(keys.enc, msg);
+					assert.equal(true, cached.decrypt(keys.dec, c).equals(msg));
+					assert.equal(true,
+						uncached.decrypt(keys.dec, c).equals(msg));
+				}
+				done();
+			});
+
+		});
+
+		/* Test should reject counts that are not non-negative integers
+		 * instead of wrapping them around.
+		 */
+		it("should throw an error for invalid cache and pool sizes",
+			function() {
+
+			var options = ["keyCacheSize", "precomputeStorage",
+				"sessionCacheSize", "sessionLifetime", "keyPoolSize",
+				"keyPoolRate"];
+			options.forEach(function(option) {
+				[-1, 1.5, NaN, Infinity, Math.pow(2, 32), "4", null]
+					.forEach(function(value) {
+
+					var opts = {};
+					opts[option] = value;
+					assert.throws(function() {
+						new addon.SEIFECC(hash, eccFolder, opts);
+					}, new RegExp("Invalid " + option));
+				});
+			});
+
+			assert.doesNotThrow(function() {
+				new addon.SEIFECC(hash, eccFolder,
+					{keyCacheSize: 4, sessionCacheSize: 0});
+			});
+		});
+
+		/* Test should encrypt using precomputed tables for the cached public
+		 * key and report their memory usage.
+		 */
+		it("should encrypt with precomputed public key tables",
+			function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder,
+				{precomputeStorage: 16});
+
+			test.loadKeys(function(status, keys) {
+				for (var i = 0; i < 3; ++i) {
+					var c = test.encrypt(keys.enc, msg);
+					assert.equal(true, test.decrypt(keys.dec, c).equals(msg));
+				}
+
+				var stats = test.keyCacheStats();
+				assert.equal(1, stats.publicKeys);
+				assert.equal(1, stats.privateKeys);
+				assert.equal(16, stats.precomputeStorage);
+				assert.equal(true, stats.precomputedBytes > 0);
+				done();
+			});
+
+		});
+
 		/* Test should take a different key from the one used to encrypt the
 		 * message and throw an exception when trying to decrypt the corresponding
 		 * cipher with it
@@ -229,6 +542,380 @@ describe("seifnode SEIFECC object", function() {
 		});
 	});
 
+	// Testing 'encryptMany' functionality.
+	describe("#encryptMany()", function() {
+
+		/* Test should encrypt a batch of messages, on one and on several
+		 * threads, returning ciphers that decrypt to the original messages.
+		 */
+		it("should encrypt a batch of messages with one key", function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+			var messages = [];
+			for (var i = 0; i < 8; ++i) {
+				messages.push(Buffer.concat([msg, new Buffer([i])]));
+			}
+
+			test.loadKeys(function(status, keys) {
+				[1, 4, 1e6].forEach(function(threads) {
+					var ciphers = test.encryptMany(keys.enc, messages, threads);
+					assert.equal(messages.length, ciphers.length);
+					ciphers.forEach(function(c, i) {
+						assert.equal(true,
+							test.decrypt(keys.dec, c).equals(messages[i]));
+					});
+				});
+				done();
+			});
+		});
+
+		// Test should encrypt the batch on the thread pool.
+		it("should encrypt a batch of messages asynchronously", function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+			var messages = [msg, new Buffer([0]), Buffer.concat([msg, msg])];
+
+			test.loadKeys(function(status, keys) {
+				test.encryptManyAsync(keys.enc, messages, 2,
+					function(status, ciphers) {
+
+					assert.equal(0, status.code);
+					assert.equal(messages.length, ciphers.length);
+					ciphers.forEach(function(c, i) {
+						assert.equal(true,
+							test.decrypt(keys.dec, c).equals(messages[i]));
+					});
+
+					test.encryptManyAsync(keys.enc, messages).then(
+						function(ciphers) {
+						assert.equal(messages.length, ciphers.length);
+						done();
+					}, done);
+				});
+			});
+		});
+
+		/* Test should keep encrypting the original buffers when the array
+		 * elements are replaced before the work completes.
+		 */
+		it("should pin the message buffers of an async batch",
+			function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+			var messages = [];
+			var expected = [];
+			for (var i = 0; i < 64; ++i) {
+				messages.push(Buffer.alloc(4096, i));
+				expected.push(Buffer.alloc(4096, i));
+			}
+
+			test.loadKeys(function(status, keys) {
+				test.encryptManyAsync(keys.enc, messages, 2,
+					function(status, ciphers) {
+
+					assert.equal(0, status.code);
+					ciphers.forEach(function(c, i) {
+						assert.equal(true,
+							test.decrypt(keys.dec, c).equals(expected[i]));
+					});
+					done();
+				});
+
+				// Drop the only references to the buffers being encrypted.
+				for (var i = 0; i < messages.length; ++i) {
+					messages[i] = null;
+				}
+				if (global.gc) {
+					global.gc();
+				}
+			});
+		});
+	});
+
+	// Testing 'encryptAsync' and 'decryptAsync' functionality.
+	describe("#encryptAsync() and #decryptAsync()", function() {
+
+		/* Test should encrypt and decrypt the message on the thread pool and
+		 * invoke the callbacks with a success status.
+		 */
+		it("should encrypt and decrypt msg asynchronously using callbacks",
+			function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+
+			test.loadKeys(function(status, keys) {
+				test.encryptAsync(keys.enc, msg, function(status, c) {
+					assert.equal(0, status.code);
+
+					test.decryptAsync(keys.dec, c, function(status, m) {
+						assert.equal(0, status.code);
+						assert.equal(true, m.equals(msg));
+						done();
+					});
+				});
+			});
+		});
+
+		/* Test should return promises when the callback is omitted and reject
+		 * when decrypting with the wrong key.
+		 */
+		it("should return promises when callback is omitted", function() {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+
+			return new Promise(function(resolve) {
+				test.loadKeys(function(status, keys) {
+					resolve(keys);
+				});
+			}).then(function(keys) {
+				return test.encryptAsync(keys.enc, msg).then(function(c) {
+					// Flip the low bit of the last digit of the private key.
+					var last = keys.dec.length - 1;
+					var wrongKey = keys.dec.substr(0, last) +
+						(parseInt(keys.dec[last], 16) ^ 1).toString(16);
+					return test.decryptAsync(wrongKey, c).then(function() {
+						assert.fail("decryption with wrong key succeeded");
+					}, function(err) {
+						assert.equal(-5, err.code);
+						return test.decryptAsync(keys.dec, c);
+					});
+				});
+			}).then(function(m) {
+				assert.equal(true, m.equals(msg));
+			});
+		});
+	});
+
+	// Testing the per-thread random pools drawn from by ECIES.
+	describe("per-thread random pool", function() {
+
+		/* Test should encrypt the same message to different ciphers on the
+		 * main thread, the libuv workers and the encryptMany threads, so no
+		 * two pools produce the same output.
+		 */
+		it("should draw different randomness on every thread", function() {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+
+			return new Promise(function(resolve) {
+				test.loadKeys(function(status, keys) {
+					resolve(keys);
+				});
+			}).then(function(keys) {
+				var pending = [];
+				for (var i = 0; i < 16; ++i) {
+					pending.push(test.encryptAsync(keys.enc, msg));
+				}
+
+				var messages = [];
+				for (var j = 0; j < 8; ++j) {
+					messages.push(msg);
+				}
+				var many = test.encryptMany(keys.enc, messages, 4);
+
+				return Promise.all(pending).then(function(ciphers) {
+					ciphers = ciphers.concat(many,
+						[test.encrypt(keys.enc, msg)]);
+
+					var seen = {};
+					ciphers.forEach(function(c) {
+						assert.equal(undefined, seen[c.toString("hex")]);
+						seen[c.toString("hex")] = true;
+						assert.equal(true,
+							test.decrypt(keys.dec, c).equals(msg));
+					});
+				});
+			});
+		});
+
+		/* Test should reseed the pool of the main thread once it produced
+		 * 1MB, drawing 16 byte salts for segmented ciphers, and keep
+		 * producing fresh output afterwards.
+		 */
+		it("should reseed after 1MB of output", function() {
+
+			this.timeout(60000);
+
+			var aes = addon.AESXOR256(Buffer.alloc(16, 1));
+			var aesKey = Buffer.alloc(32, 7);
+			var empty = Buffer.alloc(0);
+
+			var reseeds = addon.stats().threadRng.reseeds;
+
+			var salts = {};
+			for (var i = 0; i < (1 << 16) + 100; ++i) {
+				var salt = aes.encryptSegments(aesKey, empty).slice(16, 32)
+					.toString("hex");
+				assert.equal(undefined, salts[salt]);
+				salts[salt] = true;
+			}
+
+			assert.equal(true, addon.stats().threadRng.reseeds > reseeds);
+		});
+	});
+
+	// Testing the ECIES wrapped AES envelope.
+	describe("#encryptEnvelope() and #decryptEnvelope()", function() {
+
+		/* Test should round trip a large message through the envelope and
+		 * reject a modified body.
+		 */
+		it("should encrypt and decrypt a large message in an envelope",
+			function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+
+			test.loadKeys(function(status, keys) {
+				var large = Buffer.alloc(1024 * 1024 + 3, 0x41);
+				var envelope = test.encryptEnvelope(keys.enc, large);
+
+				assert.equal(true,
+					test.decryptEnvelope(keys.dec, envelope).equals(large));
+				assert.equal(0, test.decryptEnvelope(keys.dec,
+					test.encryptEnvelope(keys.enc, Buffer.alloc(0))).length);
+
+				envelope[envelope.length - 20] ^= 1;
+				assert.throws(function() {
+					test.decryptEnvelope(keys.dec, envelope);
+				});
+				done();
+			});
+		});
+
+		/* Test should produce envelopes from a cipher stream which the one
+		 * shot and stream decryption both accept, whatever the chunking.
+		 */
+		it("should encrypt and decrypt envelopes as streams", function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder);
+
+			function collect(stream, input, size, callback) {
+				var parts = [];
+				stream.on("data", function(data) {
+					parts.push(data);
+				});
+				stream.on("error", callback);
+				stream.on("end", function() {
+					callback(null, Buffer.concat(parts));
+				});
+				for (var i = 0; i < input.length; i += size) {
+					stream.write(input.slice(i, i + size));
+				}
+				stream.end();
+			}
+
+			test.loadKeys(function(status, keys) {
+				var large = Buffer.alloc(200000, 0x42);
+
+				collect(test.createEnvelopeCipherStream(keys.enc), large,
+					7000, function(err, envelope) {
+
+					assert.ifError(err);
+					assert.equal(true,
+						test.decryptEnvelope(keys.dec, envelope).equals(large));
+
+					collect(test.createEnvelopeDecipherStream(keys.dec),
+						envelope, 5, function(err, message) {
+
+						assert.ifError(err);
+						assert.equal(true, message.equals(large));
+						done();
+					});
+				});
+			});
+		});
+	});
+
+	// Testing ECDH sessions between two key pairs.
+	describe("#sessionKey() and #createSession()", function() {
+
+		/* Test should derive the same session on both sides, cache it and
+		 * reject a peer key on another curve.
+		 */
+		it("should share a cached session between two key pairs", function() {
+
+			var test = new addon.SEIFECC(hash, eccFolder, {curve: "secp256r1"});
+
+			this.timeout(150000);
+
+			var alice = test.generateStoredKeys("alice");
+			var bob = test.generateStoredKeys("bob");
+
+			var secret = test.sessionKey(alice.dec, bob.enc);
+			assert.equal(96, secret.length);
+			assert.equal(false,
+				secret.slice(0, 48).equals(secret.slice(48)));
+
+			// Bob receives with the key Alice sends with and vice versa.
+			var peer = test.sessionKey(bob.dec, alice.enc);
+			assert.equal(true, peer.slice(0, 48).equals(secret.slice(48)));
+			assert.equal(true, peer.slice(48).equals(secret.slice(0, 48)));
+			assert.equal(2, test.keyCacheStats().sessions);
+
+			var toBob = test.createSession(alice.dec, bob.enc);
+			var fromAlice = test.createSession(bob.dec, alice.enc);
+			var c1 = toBob.encrypt(msg);
+			var c2 = toBob.encrypt(msg);
+			assert.equal(false, c1.equals(c2));
+			assert.equal(true, fromAlice.decrypt(c1).equals(msg));
+			assert.equal(true, fromAlice.decrypt(c2).equals(msg));
+
+			// A cipher reflected back to its sender is rejected.
+			assert.throws(function() {
+				toBob.decrypt(c1);
+			});
+			assert.equal(true, toBob.decrypt(fromAlice.encrypt(msg))
+				.equals(msg));
+
+			// The keys stored as "tenant2" are on secp384r1.
+			assert.throws(function() {
+				test.sessionKey(alice.dec, test.loadStoredKeys("tenant2").enc);
+			});
+		});
+	});
+
+	// Testing the pool of pregenerated key pairs.
+	describe("keyPoolSize option", function() {
+
+		/* Test should save a pregenerated pair once the pool is filled and
+		 * generate keys on other curves on demand.
+		 */
+		it("should generate keys from the pregenerated pool", function(done) {
+
+			var test = new addon.SEIFECC(hash, eccFolder,
+				{curve: "secp256r1", keyPoolSize: 2});
+
+			this.timeout(150000);
+
+			assert.notEqual("disabled", test.keyCacheStats().keyPool.state);
+
+			(function whenFilled() {
+				var filling = test.keyCacheStats().keyPool;
+				// A failed pool never fills, report it instead of timing out.
+				assert.notEqual("failed", filling.state);
+				if (filling.available < 2) {
+					setTimeout(whenFilled, 50);
+					return;
+				}
+
+				var carol = test.generateStoredKeys("carol");
+				var pool = test.keyCacheStats().keyPool;
+				assert.equal(2, pool.size);
+				assert.equal(1, pool.taken);
+				assert.equal(0, pool.misses);
+				assert.equal("ready", pool.state);
+
+				var stored = test.loadStoredKeys("carol");
+				assert.equal(true, test.decrypt(carol.dec,
+					test.encrypt(stored.enc, msg)).equals(msg));
+
+				test.generateStoredKeys("dave", "secp384r1");
+				assert.equal(1, test.keyCacheStats().keyPool.taken);
+				done();
+			})();
+		});
+	});
+
 	after(function() {
 		var filenames = glob.sync(eccFolder + "/ecies*");
 		filenames.forEach(function(val, index, arr) {
@@ -84,6 +84,41 @@ describe("seifnode RNG object", function() {
 		});
 	});
 
+	// Testing 'initializeAsync' functionality.
+	describe("#initializeAsync()", function() {
+
+		/* RNG should be initialized off the event loop, reporting the entropy
+		 * strength and number of retries.
+		 */
+		it("should initialize rng object asynchronously", function(done) {
+			let test = new addon.RNG();
+			let asyncStateFile = stateFile + ".async";
+			this.timeout(150000);
+
+			test.initializeAsync(hash, asyncStateFile, function(status, result) {
+				assert.equal(0, status.code);
+				assert.notEqual(-1, ["WEAK", "MEDIUM", "STRONG"]
+					.indexOf(result.strength));
+				assert.equal("number", typeof result.retries);
+				assert.equal(numBytes, test.getBytes(numBytes).length);
+
+				test.destroy();
+				if (fs.existsSync(asyncStateFile)) {
+					fs.unlinkSync(asyncStateFile);
+				}
+				done();
+			});
+
+			// The RNG must not be used while it is being initialized.
+			assert.throws(function() {
+				test.getBytes(numBytes);
+			}, /in progress/);
+			assert.throws(function() {
+				test.entropyStrength();
+			}, /in progress/);
+		});
+	});
+
 	// Testing 'isInitialized' functionality after initializing the RNG.
 	describe("#isInitialized() after", function() {
 
@@ -148,6 +183,131 @@ describe("seifnode RNG object", function() {
 		});
 	});
 
+	// Testing RNG objects sharing a state file.
+	describe("#shared state", function() {
+
+		/* Objects loading the same state file should share one master pool,
+		 * which stays usable until its last user is destroyed.
+		 */
+		it("should share the master pool between objects", function(done) {
+			let first = new addon.RNG();
+			let second = new addon.RNG();
+
+			first.isInitialized(hash, stateFile, function(result) {
+				assert.equal(0, result.code);
+
+				second.isInitialized(hash, stateFile, function(result) {
+					assert.equal(0, result.code);
+
+					assert.equal(false, first.getBytes(numBytes)
+						.equals(second.getBytes(numBytes)));
+
+					first.destroy();
+					assert.throws(function() {
+						first.getBytes(numBytes);
+					});
+					assert.equal(numBytes, second.getBytes(numBytes).length);
+
+					second.destroy();
+					done();
+				});
+			});
+		});
+	});
+
+	// Testing 'fillBytes' functionality.
+	describe("#fillBytes()", function() {
+
+		/* Only the requested part of the buffer should be filled, with
+		 * requests spanning reservoir refills still being served.
+		 */
+		it("should fill the given part of the buffer with random bytes",
+			function(done) {
+
+			let test = new addon.RNG();
+
+			test.isInitialized(hash, stateFile, function(result) {
+				assert.equal(0, result.code);
+
+				let buffer = Buffer.alloc(numBytes * 3);
+				assert.strictEqual(buffer,
+					test.fillBytes(buffer, numBytes, numBytes));
+
+				assert.equal(true, buffer.slice(0, numBytes)
+					.equals(Buffer.alloc(numBytes)));
+				assert.equal(false, buffer.slice(numBytes, 2 * numBytes)
+					.equals(Buffer.alloc(numBytes)));
+				assert.equal(true, buffer.slice(2 * numBytes)
+					.equals(Buffer.alloc(numBytes)));
+
+				// Drain more than one reservoir worth of small requests.
+				let previous = test.getBytes(numBytes);
+				for (let i = 0; i < 4096; ++i) {
+					let next = test.getBytes(numBytes);
+					assert.equal(false, next.equals(previous));
+					previous = next;
+				}
+
+				assert.throws(function() {
+					test.fillBytes(buffer, numBytes * 2, numBytes + 1);
+				});
+				assert.throws(function() {
+					test.fillBytes(buffer, "1");
+				}, /Offset must be a number/);
+				assert.throws(function() {
+					test.fillBytes(buffer, 0, null);
+				}, /Length must be a number/);
+				assert.throws(function() {
+					test.fillBytes(buffer, NaN);
+				}, /Offset out of range/);
+
+				done();
+			});
+		});
+	});
+
+	// Testing 'saveState' functionality.
+	describe("#saveState()", function() {
+
+		/* Saving should be skipped while the state is unchanged, and a forced
+		 * atomic save should not leave the previous state behind.
+		 */
+		it("should save the state only when required", function(done) {
+			let test = new addon.RNG();
+
+			test.isInitialized(hash, stateFile, function(result) {
+				assert.equal(0, result.code);
+
+				test.saveState({force: true, atomic: true, sync: "full"},
+					function(result) {
+
+					assert.equal(0, result.code);
+					assert.equal(true, result.written);
+					assert.equal(false, fs.existsSync(stateFile + ".bak"));
+
+					let pending = 2;
+					let check = function(result) {
+						assert.equal(0, result.code);
+						assert.equal(false, result.written);
+						if (--pending === 0) {
+							assert.throws(function() {
+								test.saveState({sync: "always"},
+									function() {});
+							});
+							assert.throws(function() {
+								test.saveState({sync: "full"});
+							});
+							test.destroy();
+							done();
+						}
+					};
+					test.saveState(check);
+					test.saveState({sync: "data"}, check);
+				});
+			});
+		});
+	});
+
 	after(function() {
 		if (fs.existsSync(stateFile)) {
 			fs.unlinkSync(stateFile);
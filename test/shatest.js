@@ -1,6 +1,10 @@
 let addon = require('seifnode');
 let assert = require("assert");
 
+// SHA3-256("abc")
+let abcHash = new Buffer(
+	"3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532", "hex");
+
 // Mocha tests for SEIFSHA3 object.
 describe("seifnode SEIFSHA3 hash object", function() {
 
@@ -19,4 +23,207 @@ describe("seifnode SEIFSHA3 hash object", function() {
 		// Comparing returned hash buffer with the known hash value buffer.
 		assert.equal(true, hash.equals(testhash));
 	});
+
+	// Test should hash data given in chunks like the whole input.
+	it("should compute the hash incrementally", function() {
+		let test = new addon.SEIFSHA3();
+
+		let hash = test.update("a").update(new Buffer("b")).update("c").digest();
+		assert.equal(true, hash.equals(abcHash));
+
+		// The running hash is reset by 'digest'.
+		assert.equal(true, test.update("abc").digest().equals(abcHash));
+	});
+
+	// Test should emit the hash of everything written to the stream.
+	it("should hash a stream", function(done) {
+		let test = new addon.SEIFSHA3();
+		let hasher = test.createHashStream();
+
+		hasher.on("data", function(hash) {
+			assert.equal(true, hash.equals(abcHash));
+			done();
+		});
+
+		hasher.write("ab");
+		hasher.end("c");
+	});
+
+	// Test should stream hash with every supported hash function.
+	it("should hash a stream with every algorithm", function(done) {
+		let options = [
+			{algorithm: "sha3-224"}, {algorithm: "sha3-256"},
+			{algorithm: "sha3-384"}, {algorithm: "sha3-512"},
+			{algorithm: "shake128"}, {algorithm: "shake256", outputLength: 64}
+		];
+		let pending = options.length;
+
+		options.forEach(function(option) {
+			let test = new addon.SEIFSHA3(option);
+			let expected = test.hash("abc");
+			let hasher = test.createHashStream();
+
+			hasher.on("data", function(hash) {
+				assert.equal(true, hash.equals(expected));
+				if (--pending === 0) {
+					done();
+				}
+			});
+
+			hasher.write("a");
+			hasher.end(new Buffer("bc"));
+		});
+	});
+
+	// Test should hash off the event loop.
+	it("should compute the hash asynchronously", function(done) {
+		let test = new addon.SEIFSHA3();
+
+		test.hashAsync(new Buffer("abc"), function(status, hash) {
+			assert.equal(0, status.code);
+			assert.equal(true, hash.equals(abcHash));
+			done();
+		});
+	});
+
+	/* Test should return the concatenated hashes in input order, with the
+	 * same result whether or not the messages are split across threads.
+	 */
+	it("should hash many values at once", function() {
+		let test = new addon.SEIFSHA3();
+
+		let values = [];
+		for (let i = 0; i < 37; ++i) {
+			values.push(i % 3 === 0 ? "value" + i : new Buffer(i * 11).fill(i));
+		}
+		values[5] = "abc";
+
+		let hashes = test.hashMany(values);
+		assert.equal(values.length * 32, hashes.length);
+		assert.equal(true, hashes.slice(5 * 32, 6 * 32).equals(abcHash));
+
+		for (let i = 0; i < values.length; ++i) {
+			assert.equal(true, hashes.slice(i * 32, (i + 1) * 32)
+				.equals(test.hash(values[i])));
+		}
+
+		assert.equal(true, test.hashMany(values, 4).equals(hashes));
+		assert.equal(true, test.hashMany(values, 1e6).equals(hashes));
+	});
+
+	// Test should return known hashes for the other SHA3 digest sizes.
+	it("should compute SHA3-224, SHA3-384 and SHA3-512 hash values", function() {
+		let expected = {
+			"sha3-224": "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf",
+			"sha3-384": "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c25" +
+				"96da7cf0e49be4b298d88cea927ac7f539f1edf228376d25",
+			"sha3-512": "b751850b1a57168a5693cd924b6b096e08f621827444f70d" +
+				"884f5d0240d2712e10e116e9192af3c91a7ec57647e3934057340b4c" +
+				"f408d5a56592f8274eec53f0"
+		};
+
+		Object.keys(expected).forEach(function(algorithm) {
+			let test = new addon.SEIFSHA3({algorithm: algorithm});
+			assert.equal(expected[algorithm], test.hash("abc").toString("hex"));
+			assert.equal(expected[algorithm],
+				test.update("a").update("bc").digest().toString("hex"));
+		});
+	});
+
+	// Test should return SHAKE output of the requested length.
+	it("should compute SHAKE128 and SHAKE256 output", function() {
+		let shake128 = new addon.SEIFSHA3({algorithm: "shake128",
+			outputLength: 32});
+		assert.equal(
+			"7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26",
+			shake128.hash("").toString("hex"));
+		assert.deepEqual({algorithm: "shake128", outputLength: 32},
+			shake128.algorithm());
+
+		let shake256 = new addon.SEIFSHA3({algorithm: "shake256",
+			outputLength: 64});
+		let expected = "483366601360a8771c6863080cc4114d8db44530f8f1e1ee" +
+			"4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa9f8726e462a1" +
+			"2a4feb06bd8801e751e4";
+		assert.equal(expected, shake256.hash("abc").toString("hex"));
+		assert.equal(expected.slice(0, 64), new addon.SEIFSHA3(
+			{algorithm: "shake256"}).hash("abc").toString("hex"));
+		assert.equal(128, shake256.hashMany(["abc", "abc"]).length);
+
+		assert.throws(function() {
+			new addon.SEIFSHA3({algorithm: "sha3-256", outputLength: 64});
+		});
+		assert.throws(function() {
+			new addon.SEIFSHA3({algorithm: "md5"});
+		});
+	});
+
+	// Test should hash strings by their full UTF-8 encoding.
+	it("should hash strings containing NUL and non-ASCII characters", function() {
+		let test = new addon.SEIFSHA3();
+		let values = ["a\u0000b", "h\u00e9llo \u263a"];
+
+		values.forEach(function(value) {
+			assert.equal(true,
+				test.hash(value).equals(test.hash(new Buffer(value, "utf8"))));
+		});
+		assert.equal(
+			"b476fd9cc202c304856e5b838839a737fbaaa96a2f44808f8c28c8cff135db22",
+			test.hash(values[0]).toString("hex"));
+	});
+
+	// Test should hash the bytes viewed by typed arrays and array buffers.
+	it("should hash TypedArray, DataView and ArrayBuffer input", function() {
+		let test = new addon.SEIFSHA3();
+		let bytes = new Uint8Array([0x78, 0x61, 0x62, 0x63, 0x78]);
+
+		assert.equal(true, test.hash(bytes.subarray(1, 4)).equals(abcHash));
+		assert.equal(true,
+			test.hash(new DataView(bytes.buffer, 1, 3)).equals(abcHash));
+		assert.equal(true,
+			test.hash(bytes.buffer.slice(1, 4)).equals(abcHash));
+	});
+
+	// Test should load the addon in several worker threads of the process.
+	it("should hash in several worker threads at once", function(done) {
+		let workerThreads;
+		try {
+			workerThreads = require("worker_threads");
+		} catch (e) {
+			// worker_threads are not available on this node.js version
+			this.skip();
+		}
+
+		let source =
+			"const parentPort = require('worker_threads').parentPort;" +
+			"const addon = require(" +
+			JSON.stringify(require.resolve("seifnode")) + ");" +
+			"parentPort.postMessage(new addon.SEIFSHA3().hash('abc'));";
+
+		let pending = 2;
+		for (let i = 0; i < 2; ++i) {
+			let worker = new workerThreads.Worker(source, {eval: true});
+			worker.on("error", done);
+			worker.on("message", function(hash) {
+				assert.equal(true, Buffer.from(hash).equals(abcHash));
+				if (--pending === 0) {
+					done();
+				}
+			});
+		}
+	});
+
+	// Test should report the selected kernels along with the CPU features.
+	it("should report the kernels in use from seifnode.capabilities()",
+		function() {
+
+		let caps = addon.capabilities();
+
+		assert.notEqual(-1, ["avx2x4", "scalar"].indexOf(caps.kernels.keccak));
+		assert.notEqual(-1, ["avx2", "sse2", "neon", "scalar"].indexOf(
+			caps.kernels.keystream));
+		assert.equal(caps.cpu.avx2, caps.kernels.keccak === "avx2x4");
+		assert.equal("boolean", typeof caps.build.optimized);
+		assert.equal(true, caps.build.cryptopp >= 565);
+	});
 });